@@ -82,6 +82,7 @@ SECTIONS
 #endif
     .data           :   > SRAM
     .bss            :   > SRAM
+    .TI.noinit      :   > SRAM      /* supervisor.c retained record */
     .sysmem         :   > SRAM
     .stack          :   > SRAM (HIGH)
     .nonretenvar    :   > SRAM
@@ -0,0 +1,82 @@
+/*
+ * aggregate.c
+ *
+ *  Windowed Welford statistics and deadband reports, see aggregate.h.
+ */
+
+#include "aggregate.h"
+
+// Division rounded half away from zero
+static int64_t divRound(int64_t num, uint32_t den) {
+    return num >= 0 ? (num + den / 2) / (int64_t)den : -((-num + den / 2) / (int64_t)den);
+}
+
+static void restart(Aggregate *a, uint32_t now_ms) {
+    a->start_ms = now_ms;
+    a->count = 0;
+    a->mean = 0;
+    a->m2 = 0;
+}
+
+void aggregate_init(Aggregate *a, uint32_t window_ms, int32_t deadband) {
+    a->window_ms = window_ms;
+    a->deadband = deadband;
+    a->haveReported = 0;
+    a->reported = 0;
+    restart(a, 0);
+}
+
+void aggregate_configure(Aggregate *a, uint32_t window_ms, int32_t deadband) {
+    a->window_ms = window_ms;
+    a->deadband = deadband;
+}
+
+void aggregate_summary(const Aggregate *a, AggregateSummary *out) {
+    out->start_ms = a->start_ms;
+    out->count = a->count;
+    out->min = a->count > 0 ? a->min : 0;
+    out->max = a->count > 0 ? a->max : 0;
+    out->mean = (int32_t)divRound(a->mean, 1UL << AGGREGATE_FRAC);
+    out->variance = 0;
+    if (a->count > 1) {
+        // Values 2^23 apart reach 2^46, more than the field holds
+        uint64_t v = (a->m2 / (a->count - 1) + (1UL << (AGGREGATE_FRAC - 1))) >> AGGREGATE_FRAC;
+        out->variance = v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+    }
+}
+
+uint8_t aggregate_add(Aggregate *a, int32_t value, uint32_t now_ms, AggregateSummary *closed) {
+    int64_t x = (int64_t)value << AGGREGATE_FRAC;
+    int64_t delta;
+    int32_t distance;
+    uint8_t flags = 0;
+
+    if (a->count > 0 && (now_ms - a->start_ms >= a->window_ms || a->count == UINT16_MAX)) {
+        aggregate_summary(a, closed);
+        flags |= AGGREGATE_WINDOW;
+        restart(a, now_ms);
+    } else if (a->count == 0) {
+        a->start_ms = now_ms;
+    }
+
+    // Welford: the mean moves by delta / n, the sum of squared deviations
+    // grows by delta times the distance to the new mean
+    a->count++;
+    delta = x - a->mean;
+    a->mean += divRound(delta, a->count);
+    a->m2 += (uint64_t)((delta * (x - a->mean)) >> AGGREGATE_FRAC);
+    if (a->count == 1 || value < a->min) {
+        a->min = value;
+    }
+    if (a->count == 1 || value > a->max) {
+        a->max = value;
+    }
+
+    distance = value - a->reported;
+    if (a->deadband > 0 && (!a->haveReported || distance > a->deadband || distance < -a->deadband)) {
+        a->reported = value;
+        a->haveReported = 1;
+        flags |= AGGREGATE_CHANGE;
+    }
+    return flags;
+}
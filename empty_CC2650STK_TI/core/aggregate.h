@@ -0,0 +1,78 @@
+/*
+ * aggregate.h
+ *
+ *  Windowed summaries of a slow sensor channel, so only summaries and
+ *  significant changes have to leave the board.
+ *
+ *  Each value updates the window's count, minimum, maximum, mean and sum
+ *  of squared deviations with Welford's method, in integer arithmetic:
+ *  the mean is kept with AGGREGATE_FRAC fraction bits, the sum in 64 bits
+ *  at the same scale, so no sum of squares of raw values can overflow or
+ *  cancel. A window closes with the first value at or after window_ms
+ *  from its start.
+ *
+ *  Deadband: a value more than deadband away from the last one reported
+ *  is a change, and becomes the last reported. The first value always is.
+ *
+ *  Values are within +-2^23 (whole lux, Pa, hundredths of a degree).
+ *  Not locked, one context adds, see aggregate_add().
+ *
+ *  Shared with the host tools (host/morsecap), keep it free of TI-RTOS
+ *  dependencies.
+ */
+
+#ifndef AGGREGATE_H_
+#define AGGREGATE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AGGREGATE_FRAC      8
+
+// aggregate_add() results
+#define AGGREGATE_CHANGE    0x01    // beyond the deadband of the last report
+#define AGGREGATE_WINDOW    0x02    // a window closed, its summary is out
+
+typedef struct {
+    uint32_t start_ms;
+    uint16_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean;           // rounded
+    uint32_t variance;      // sample variance, rounded, 0 below two values, saturates
+} AggregateSummary;
+
+typedef struct {
+    uint32_t window_ms;
+    int32_t deadband;       // 0: no change reports
+    uint32_t start_ms;
+    uint16_t count;
+    int32_t min;
+    int32_t max;
+    int64_t mean;           // AGGREGATE_FRAC fraction bits
+    uint64_t m2;            // sum of squared deviations, same scale
+    int32_t reported;
+    uint8_t haveReported;
+} Aggregate;
+
+void aggregate_init(Aggregate *a, uint32_t window_ms, int32_t deadband);
+
+// Takes effect with the next window, the deadband at once
+void aggregate_configure(Aggregate *a, uint32_t window_ms, int32_t deadband);
+
+// Adds a value taken at now_ms. Returns AGGREGATE_* flags; with
+// AGGREGATE_WINDOW the closed window is in *closed, the value starts the
+// next one.
+uint8_t aggregate_add(Aggregate *a, int32_t value, uint32_t now_ms, AggregateSummary *closed);
+
+// The open window so far
+void aggregate_summary(const Aggregate *a, AggregateSummary *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AGGREGATE_H_ */
@@ -0,0 +1,246 @@
+/*
+ * audio.c
+ */
+
+#include <string.h>
+
+#include "audio.h"
+#include "fsm.h"
+
+// 2 cos(2 pi f / AUDIO_RATE) of each bin, Q14
+static const int32_t coefs[AUDIO_BINS] = {
+    32365, 32258, 32138, 32007, 31863, 31706, 31538, 31357, 31164, 30959, 30743, 30514, 30274,
+};
+
+static uint32_t isqrt64(uint64_t v) {
+    uint64_t root = 0, bit = 1ULL << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// |X| of a completed window, s1^2 + s2^2 - c s1 s2
+static uint32_t amplitude(int32_t coef, const int32_t *s) {
+    int64_t power = (int64_t)s[0] * s[0] + (int64_t)s[1] * s[1] - (((int64_t)coef * s[0]) >> 14) * s[1];
+
+    return power > 0 ? isqrt64((uint64_t)power) : 0;
+}
+
+void audio_init(AudioDecoder *d, void (*emit)(int event, uint32_t at_us)) {
+    memset(d, 0, sizeof(*d));
+    d->emit = emit;
+    d->dot_us = 60000;      // 20 wpm until the first dash
+    d->gaps = 2;            // no letter open
+}
+
+static void classify(AudioDecoder *d, uint32_t mark, uint32_t at_us) {
+    uint32_t lo = mark, hi = mark, threshold, sum[2], n[2];
+    uint8_t i, pass;
+    int dash;
+
+    d->history[d->historyNext] = mark;
+    d->historyNext = (d->historyNext + 1) % AUDIO_HISTORY;
+    if (d->historyCount < AUDIO_HISTORY) {
+        d->historyCount++;
+    }
+    for (i = 0; i < d->historyCount; i++) {
+        lo = d->history[i] < lo ? d->history[i] : lo;
+        hi = d->history[i] > hi ? d->history[i] : hi;
+    }
+
+    if (hi >= 2 * lo) {
+        // Dots and dashes both in sight: two clusters, starting from the
+        // extremes, a few rounds settle them
+        threshold = (lo + hi) / 2;
+        for (pass = 0; pass < 3; pass++) {
+            sum[0] = sum[1] = n[0] = n[1] = 0;
+            for (i = 0; i < d->historyCount; i++) {
+                dash = d->history[i] >= threshold;
+                sum[dash] += d->history[i];
+                n[dash]++;
+            }
+            if (n[0] == 0 || n[1] == 0) {
+                break;
+            }
+            threshold = (sum[0] / n[0] + sum[1] / n[1]) / 2;
+        }
+        dash = mark >= threshold;
+        d->dot_us = (sum[0] + sum[1] / 3) / d->historyCount;
+    } else {
+        dash = mark >= 2 * d->dot_us;
+        d->dot_us += ((int32_t)(dash ? mark / 3 : mark) - (int32_t)d->dot_us) / 4;
+    }
+    if (d->dot_us < AUDIO_DOT_MIN_US) {
+        d->dot_us = AUDIO_DOT_MIN_US;
+    } else if (d->dot_us > AUDIO_DOT_MAX_US) {
+        d->dot_us = AUDIO_DOT_MAX_US;
+    }
+
+    d->stats.marks++;
+    d->emit(dash ? FSM_EV_DASH : FSM_EV_DOT, at_us);
+}
+
+// A debounced key change at at_us. A mark only counts once it has ended
+// and was long enough, a glitch leaves the space it fell into running.
+static void keyChange(AudioDecoder *d, uint8_t down, uint32_t at_us) {
+    if (down) {
+        d->mark_us = at_us;
+        return;
+    }
+    if (at_us - d->mark_us < AUDIO_DOT_MIN_US / 2) {
+        d->stats.glitches++;
+        return;
+    }
+    classify(d, at_us - d->mark_us, at_us);
+    d->edge_us = at_us;
+    d->gaps = 0;
+}
+
+static void envelope(AudioDecoder *d, uint32_t env, uint32_t t_us) {
+    uint32_t span, debounce = d->dot_us / 4 / AUDIO_HOP_US;
+    uint8_t want;
+
+    // Signal attacks fast and follows the marks, noise is the average of
+    // what is below the middle while the key is up. Marks the squelch
+    // holds back so stay out of it.
+    span = d->signal > d->noise ? d->signal - d->noise : 0;
+    if (env > d->signal) {
+        d->signal += (env - d->signal) >> 1;
+    } else if (d->key) {
+        d->signal -= (d->signal - env) >> 4;
+    }
+    d->signal -= d->signal >> 9;
+    if (!d->key && env < d->noise + span / 2) {
+        d->noise += ((int32_t)env - (int32_t)d->noise) >> 4;
+    }
+
+    span = d->signal > d->noise ? d->signal - d->noise : 0;
+    if (d->signal <= AUDIO_SQUELCH * d->noise) {
+        want = 0;
+    } else if (d->key) {
+        want = env > d->noise + span * 3 / 8;
+    } else {
+        want = env > d->noise + span * 5 / 8;
+    }
+
+    if (debounce < AUDIO_DEBOUNCE) {
+        debounce = AUDIO_DEBOUNCE;
+    }
+    if (want == d->key) {
+        d->held = 0;
+    } else if (d->held == 0 || d->candidate != want) {
+        d->candidate = want;
+        d->candidate_us = t_us;
+        d->held = 1;
+    } else if (++d->held >= debounce) {
+        d->key = want;
+        d->held = 0;
+        keyChange(d, want, d->candidate_us);
+    }
+}
+
+// Letter and word ends, while the key is up
+static void spacing(AudioDecoder *d, uint32_t t_us) {
+    uint32_t space = t_us - d->edge_us;
+
+    if (d->key || d->gaps >= 2) {
+        return;
+    }
+    if ((d->gaps == 0 && space >= 2 * d->dot_us) || (d->gaps == 1 && space >= 5 * d->dot_us)) {
+        d->gaps++;
+        d->emit(FSM_EV_GAP, t_us);
+    }
+}
+
+// One window completed, t_us is the time of its last sample
+static void hop(AudioDecoder *d, uint32_t t_us) {
+    uint32_t amps[AUDIO_BINS];
+    uint8_t b, best = 0;
+
+    for (b = 0; b < AUDIO_BINS; b++) {
+        int32_t *s = d->state[b][d->window];
+
+        amps[b] = amplitude(coefs[b], s);
+        s[0] = 0;
+        s[1] = 0;
+        d->level[b] += ((int32_t)amps[b] - (int32_t)d->level[b]) >> 6;
+        if (d->level[b] > d->level[best]) {
+            best = b;
+        }
+    }
+    d->window ^= 1;
+
+    // Levels settle before anything is keyed
+    if (++d->stats.hops < AUDIO_SETTLE) {
+        return;
+    }
+    if (d->stats.hops == AUDIO_SETTLE) {
+        d->bin = best;
+        d->signal = d->noise = d->level[best];
+    } else if (d->level[best] > d->level[d->bin] + d->level[d->bin] / 4) {
+        d->bin = best;
+    }
+    envelope(d, amps[d->bin], t_us);
+    spacing(d, t_us);
+}
+
+void audio_process(AudioDecoder *d, const int16_t *pcm, uint16_t count, uint32_t t_us) {
+    uint16_t i;
+    uint8_t b;
+
+    for (i = 0; i < count; i++) {
+        int32_t x = pcm[i] - (d->dc >> 8);
+
+        d->dc += x;
+        for (b = 0; b < AUDIO_BINS; b++) {
+            int32_t *s0 = d->state[b][0];
+            int32_t *s1 = d->state[b][1];
+            int32_t next;
+
+            next = x + (int32_t)(((int64_t)coefs[b] * s0[0]) >> 14) - s0[1];
+            s0[1] = s0[0];
+            s0[0] = next;
+            next = x + (int32_t)(((int64_t)coefs[b] * s1[0]) >> 14) - s1[1];
+            s1[1] = s1[0];
+            s1[0] = next;
+        }
+        if (++d->fill == AUDIO_HOP) {
+            d->fill = 0;
+            hop(d, t_us + (uint32_t)((uint64_t)i * 1000000 / AUDIO_RATE));
+        }
+    }
+}
+
+void audio_stats(const AudioDecoder *d, AudioStats *stats) {
+    uint8_t b = d->bin;
+    int64_t lo, mid, hi, den;
+    int32_t freq = AUDIO_FREQ_MIN + b * AUDIO_FREQ_STEP;
+
+    *stats = d->stats;
+    stats->signal = d->signal;
+    stats->noise = d->noise;
+    stats->wpm = 1200000 / d->dot_us;
+
+    // Parabola through the levels around the tracked bin
+    if (b > 0 && b < AUDIO_BINS - 1) {
+        lo = d->level[b - 1];
+        mid = d->level[b];
+        hi = d->level[b + 1];
+        den = 2 * (lo - 2 * mid + hi);
+        if (den < 0) {
+            freq += (int32_t)(AUDIO_FREQ_STEP * (lo - hi) / den);
+        }
+    }
+    stats->freq_hz = d->stats.hops >= AUDIO_SETTLE ? (uint16_t)freq : 0;
+}
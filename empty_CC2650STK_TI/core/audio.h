@@ -0,0 +1,104 @@
+/*
+ * audio.h
+ *
+ *  CW receive from the microphone. 16 kHz PCM goes through a bank of
+ *  Goertzel filters spaced AUDIO_FREQ_STEP apart over the usual CW pitches.
+ *  Each bin runs two windows of AUDIO_WINDOW samples staggered by a hop, so
+ *  every AUDIO_HOP samples one of them completes and gives the bin's
+ *  amplitude. The bin with the highest average amplitude is tracked, its
+ *  amplitude is the envelope. Signal and noise levels follow the envelope
+ *  while keyed and unkeyed, the key goes down above the middle of the two
+ *  and up below it, with hysteresis and a debounce of a quarter dot.
+ *
+ *  Mark lengths are classified against the recent ones: with both dots and
+ *  dashes among the last AUDIO_HISTORY marks they are split in two
+ *  clusters and the threshold is between them, else at twice the dot
+ *  length, so the speed is followed from the first dash on. Spaces of two
+ *  and five dot lengths end the letter and the word. The results are
+ *  FsmEvents (fsm.h), keyed by the same state machine as the button and
+ *  tilts.
+ *
+ *  Integer arithmetic only. The caller passes the time of the first
+ *  sample, so the board and the host harness (host/morsecap/audio.cpp) run
+ *  the same code. Not reentrant.
+ *
+ *  Shared with the host tools, keep it free of TI-RTOS dependencies.
+ */
+
+#ifndef AUDIO_H_
+#define AUDIO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_RATE          16000
+#define AUDIO_HOP           64      // samples between envelope values, 4 ms
+#define AUDIO_WINDOW        (2 * AUDIO_HOP)
+#define AUDIO_HOP_US        (AUDIO_HOP * 1000000 / AUDIO_RATE)
+#define AUDIO_BINS          13
+#define AUDIO_FREQ_MIN      400     // Hz, bins up to 1000 Hz
+#define AUDIO_FREQ_STEP     50
+#define AUDIO_SETTLE        64      // hops of levels before keying, 256 ms
+#define AUDIO_DEBOUNCE      2       // hops a key change has to last, at least
+#define AUDIO_SQUELCH       4       // signal to noise amplitude ratio to key at all
+#define AUDIO_HISTORY       8       // marks the dot/dash threshold looks back on
+#define AUDIO_DOT_MIN_US    20000   // 60 wpm, shorter marks are ignored below half of it
+#define AUDIO_DOT_MAX_US    240000  // 5 wpm
+
+typedef struct {
+    uint32_t hops;
+    uint32_t marks;
+    uint32_t glitches;      // marks too short to be keyed
+    uint16_t freq_hz;       // tracked tone, interpolated between bins
+    uint16_t wpm;
+    uint32_t signal;        // envelope levels, Goertzel amplitude
+    uint32_t noise;
+} AudioStats;
+
+typedef struct {
+    void (*emit)(int event, uint32_t at_us);    // FsmEvent at the time it was decided
+
+    // Filter bank
+    int32_t dc;                                 // input mean, Q8
+    int32_t state[AUDIO_BINS][2][2];            // [bin][window] s1, s2
+    uint8_t window;                             // the one that completes next
+    uint16_t fill;                              // samples into the hop
+    uint32_t level[AUDIO_BINS];                 // average amplitude, 256 ms
+    uint8_t bin;
+
+    // Envelope
+    uint32_t signal;
+    uint32_t noise;
+    uint8_t key;
+    uint8_t candidate;
+    uint8_t held;                               // hops the candidate has lasted
+    uint32_t candidate_us;
+
+    // Timing
+    uint32_t mark_us;                           // start of the current mark
+    uint32_t edge_us;                           // end of the last mark
+    uint32_t dot_us;
+    uint8_t gaps;                               // GAP events sent in this space
+    uint32_t history[AUDIO_HISTORY];
+    uint8_t historyCount;
+    uint8_t historyNext;
+
+    AudioStats stats;
+} AudioDecoder;
+
+void audio_init(AudioDecoder *d, void (*emit)(int event, uint32_t at_us));
+
+// Runs count samples, the first of them taken at t_us. Blocks need not be
+// hop aligned.
+void audio_process(AudioDecoder *d, const int16_t *pcm, uint16_t count, uint32_t t_us);
+
+void audio_stats(const AudioDecoder *d, AudioStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUDIO_H_ */
@@ -0,0 +1,93 @@
+/*
+ * baro.c
+ *
+ *  Altitude gesture detector, see baro.h.
+ */
+
+#include "baro.h"
+#include "fsm.h"
+
+#define BASE_SHIFT  16
+
+// Moves value toward target by dt / tau, at most all the way
+static int64_t follow(int64_t value, int64_t target, uint32_t dt, uint32_t tau) {
+    return dt >= tau ? target : value + (target - value) * dt / tau;
+}
+
+static int32_t baseline(const BaroDetector *d) {
+    return (int32_t)(d->base >> BASE_SHIFT);
+}
+
+// Critically damped level and trend: a steady drift is followed without lag
+static void track(BaroDetector *d, uint32_t dt) {
+    int64_t e = ((int64_t)d->fast << BASE_SHIFT) - d->base;
+
+    d->base += d->slope * dt + 2 * e * dt / BARO_BASE_MS;
+    d->slope += e * dt / ((int64_t)BARO_BASE_MS * BARO_BASE_MS);
+}
+
+void baro_init(BaroDetector *d) {
+    d->fast = 0;
+    d->base = 0;
+    d->slope = 0;
+    d->last_ms = 0;
+    d->start_ms = 0;
+    d->direction = 0;
+    d->primed = 0;
+    d->gestures = 0;
+    d->rejected = 0;
+}
+
+int32_t baro_threshold(int32_t cm) {
+    return cm * (BARO_PA_PER_M << BARO_FRAC) / 100;
+}
+
+int baro_update(BaroDetector *d, uint32_t now_ms, int32_t pressure, int32_t threshold) {
+    uint32_t dt = now_ms - d->last_ms;
+    int32_t delta, release = threshold / 2;
+    uint32_t length;
+    int event = -1;
+
+    d->last_ms = now_ms;
+    if (!d->primed || dt >= BARO_BASE_MS) {
+        d->fast = pressure;
+        d->base = (int64_t)pressure << BASE_SHIFT;
+        d->slope = 0;
+        d->direction = 0;
+        d->primed = 1;
+        return -1;
+    }
+    d->fast = (int32_t)follow(d->fast, pressure, dt, BARO_FAST_MS);
+    delta = d->fast - baseline(d);
+
+    if (d->direction == 0) {
+        if (delta <= -threshold || delta >= threshold) {
+            d->direction = delta < 0 ? 1 : -1;
+            d->start_ms = now_ms;
+        } else {
+            track(d, dt);
+        }
+        return -1;
+    }
+
+    d->base += d->slope * dt;     // the drift goes on under the gesture
+    length = now_ms - d->start_ms;
+    if (length > BARO_MAX_MS) {
+        d->base = (int64_t)d->fast << BASE_SHIFT;   // carried elsewhere, start over there
+        d->direction = 0;
+        d->rejected++;
+    } else if (delta > -release && delta < release) {
+        if (length < BARO_MIN_MS) {
+            d->rejected++;
+        } else {
+            event = d->direction > 0 ? FSM_EV_GAP : FSM_EV_END;
+            d->gestures++;
+        }
+        d->direction = 0;
+    }
+    return event;
+}
+
+int32_t baro_height_cm(const BaroDetector *d) {
+    return (int32_t)((int64_t)(baseline(d) - d->fast) * 100 / (BARO_PA_PER_M << BARO_FRAC));
+}
@@ -0,0 +1,81 @@
+/*
+ * baro.h
+ *
+ *  Altitude gestures from barometric pressure. Raising the board and
+ *  bringing it back keys a gap (word space), lowering it and bringing it
+ *  back ends the message. Near sea level pressure falls about 12 Pa a
+ *  metre, so half a metre is some 6 Pa against a reading noise of well
+ *  under 1 Pa at the BMP280's fast settings.
+ *
+ *  Each reading goes through a one-pole low-pass (BARO_FAST_MS). A
+ *  baseline follows the low-passed pressure much more slowly (BARO_BASE_MS)
+ *  and carries the weather, ventilation and temperature drift, so the
+ *  difference of the two is the altitude change of the last seconds. The
+ *  baseline keeps a level and a trend, critically damped, so it follows a
+ *  steady drift without falling behind; a one-pole baseline would lag a
+ *  drift of r Pa/s by r * BARO_BASE_MS / 1000 Pa, a false half metre at
+ *  0.6 Pa/s.
+ *
+ *  A gesture starts when the difference passes the threshold and ends when
+ *  it comes back within half of it; meanwhile the baseline only goes on
+ *  along its trend.
+ *  The event comes at the end, so a lift and return is one gap, not a gap
+ *  and an end of message.
+ *  Shorter than BARO_MIN_MS is a pressure transient (a door), longer than
+ *  BARO_MAX_MS is the board being carried elsewhere (stairs, a lift): no
+ *  event for either, and after the long one the baseline starts over at
+ *  the new level.
+ *
+ *  After a pause of BARO_BASE_MS or more between readings the filters start
+ *  over. The caller passes the time, so the board and the host evaluation run
+ *  the same code. Not reentrant.
+ *
+ *  Shared with the host tools (host/morsecap), keep it free of TI-RTOS
+ *  dependencies.
+ */
+
+#ifndef BARO_H_
+#define BARO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BARO_FRAC       8       // fraction bits of pressures, as the BMP280 compensation gives them
+#define BARO_PA_PER_M   12
+#define BARO_FAST_MS    150     // low-pass time constant
+#define BARO_BASE_MS    10000   // baseline time constant
+#define BARO_MIN_MS     250
+#define BARO_MAX_MS     4000
+
+typedef struct {
+    int32_t fast;           // Pa, BARO_FRAC fraction bits
+    int64_t base;           // Pa, BARO_FRAC + 16 fraction bits, it moves slowly
+    int64_t slope;          // of the baseline, same scale a millisecond
+    uint32_t last_ms;
+    uint32_t start_ms;      // of the excursion
+    int8_t direction;       // 1 up (pressure below the baseline), -1 down, 0 none
+    uint8_t primed;         // the filters hold a reading
+    uint32_t gestures;
+    uint32_t rejected;      // excursions too short or too long
+} BaroDetector;
+
+void baro_init(BaroDetector *d);
+
+// The threshold for a height in cm
+int32_t baro_threshold(int32_t cm);
+
+// One reading at now_ms, pressure and threshold in Pa with BARO_FRAC
+// fraction bits. Returns FSM_EV_GAP, FSM_EV_END or -1.
+int baro_update(BaroDetector *d, uint32_t now_ms, int32_t pressure, int32_t threshold);
+
+// Height over the baseline in cm, positive up
+int32_t baro_height_cm(const BaroDetector *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BARO_H_ */
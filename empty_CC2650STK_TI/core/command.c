@@ -0,0 +1,146 @@
+/*
+ * command.c
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "command.h"
+
+void command_init(CommandShell *sh, const Command *table, uint8_t count, CommandWriteFxn write) {
+    memset(sh, 0, sizeof(*sh));
+    sh->commands = table;
+    sh->count = count;
+    sh->write = write;
+}
+
+void command_print(CommandShell *sh, const char *text) {
+    sh->write(text, strlen(text));
+}
+
+// A line cut short still ends like the format does, the host splits the
+// replies on line ends
+void command_printf(CommandShell *sh, const char *fmt, ...) {
+    char buf[CMD_PRINTF_MAX];
+    size_t end = strlen(fmt);
+    va_list args;
+    int n;
+
+    va_start(args, fmt);
+    n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (n >= (int)sizeof(buf)) {
+        n = sizeof(buf) - 1;
+        if (end >= 2 && fmt[end - 2] == '\r' && fmt[end - 1] == '\n') {
+            buf[n - 2] = '\r';
+            buf[n - 1] = '\n';
+        }
+    }
+    if (n > 0) {
+        sh->write(buf, n);
+    }
+}
+
+int command_parse_int(const char *text, int32_t *value) {
+    int32_t v = 0;
+    int negative = 0;
+
+    if (*text == '-') {
+        negative = 1;
+        text++;
+    }
+    if (*text == '\0') {
+        return -1;
+    }
+    while (*text) {
+        if (*text < '0' || *text > '9' || v > 100000000) {
+            return -1;
+        }
+        v = v * 10 + (*text++ - '0');
+    }
+    *value = negative ? -v : v;
+    return 0;
+}
+
+void command_help(CommandShell *sh, int argc, char **argv) {
+    uint8_t i;
+
+    for (i = 0; i < sh->count; i++) {
+        command_printf(sh, "%-8s %s\r\n", sh->commands[i].name, sh->commands[i].help);
+    }
+}
+
+static void dispatch(CommandShell *sh) {
+    char *argv[CMD_MAX_ARGS + 1];
+    int argc = 0;
+    char *p = sh->line;
+    uint8_t i;
+
+    // Split in place on spaces
+    while (*p) {
+        while (*p == ' ') {
+            *p++ = '\0';
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (argc == CMD_MAX_ARGS + 1) {
+            command_print(sh, "ERR too many arguments\r\n");
+            sh->errors++;
+            return;
+        }
+        argv[argc++] = p;
+        while (*p && *p != ' ') {
+            p++;
+        }
+    }
+    if (argc == 0) {
+        return;
+    }
+
+    sh->lines++;
+    for (i = 0; i < sh->count; i++) {
+        const Command *cmd = &sh->commands[i];
+        if (strcmp(cmd->name, argv[0]) == 0) {
+            if (argc - 1 < cmd->minArgs || argc - 1 > cmd->maxArgs) {
+                command_printf(sh, "ERR usage: %s %s\r\n", cmd->name, cmd->help);
+                sh->errors++;
+            } else {
+                cmd->handler(sh, argc, argv);
+            }
+            return;
+        }
+    }
+    command_print(sh, "ERR unknown command\r\n");
+    sh->errors++;
+}
+
+void command_feed(CommandShell *sh, char c) {
+    if (c == '\t') {
+        c = ' ';
+    }
+
+    if (c == '\r' || c == '\n') {
+        if (sh->overflow) {
+            command_print(sh, "ERR line too long\r\n");
+            sh->errors++;
+        } else {
+            sh->line[sh->len] = '\0';
+            dispatch(sh);
+        }
+        sh->len = 0;
+        sh->overflow = 0;
+    } else if (c == '\b' || c == 0x7F) {
+        if (sh->len > 0 && !sh->overflow) {
+            sh->len--;
+        }
+    } else if (c >= ' ' && c <= '~') {
+        if (sh->len < CMD_LINE_MAX - 1) {
+            sh->line[sh->len++] = c;
+        } else {
+            sh->overflow = 1;
+        }
+    }
+}
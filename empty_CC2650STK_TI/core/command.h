@@ -0,0 +1,61 @@
+/*
+ * command.h
+ *
+ *  Line oriented command interpreter for the UART RX path. Bytes are fed
+ *  one at a time as they arrive, a complete line is split in place into
+ *  words and dispatched through a const command table. No allocation.
+ */
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CMD_LINE_MAX    48
+#define CMD_MAX_ARGS    4
+#define CMD_PRINTF_MAX  96      // command_printf() output, longer lines are cut
+
+typedef struct CommandShell CommandShell;
+
+typedef void (*CommandWriteFxn)(const char *text, uint16_t len);
+
+typedef struct {
+    const char *name;
+    uint8_t minArgs;    // not counting the command name itself
+    uint8_t maxArgs;
+    void (*handler)(CommandShell *sh, int argc, char **argv);
+    const char *help;
+} Command;
+
+struct CommandShell {
+    const Command *commands;
+    uint8_t count;
+    CommandWriteFxn write;
+    char line[CMD_LINE_MAX];
+    uint8_t len;
+    uint8_t overflow;
+    uint32_t lines;
+    uint32_t errors;
+};
+
+void command_init(CommandShell *sh, const Command *table, uint8_t count, CommandWriteFxn write);
+void command_feed(CommandShell *sh, char c);
+
+void command_print(CommandShell *sh, const char *text);
+void command_printf(CommandShell *sh, const char *fmt, ...);
+
+// Strict decimal parse, returns 0 on success
+int command_parse_int(const char *text, int32_t *value);
+
+// Built-in "help" handler, lists the table the shell was created with
+void command_help(CommandShell *sh, int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMMAND_H_ */
@@ -0,0 +1,68 @@
+/*
+ * evtrace.c
+ */
+
+#include "evtrace.h"
+
+const char *const evtraceSourceNames[EVTRACE_SRC_COUNT] = {
+    "sensor", "app", "button", "uart_rx", "button_clock", "indicator", "idle_clock",
+    "sensor_clock", "i2c", "uart_tx", "audio",
+};
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    p = put16(p, v & 0xFFFF);
+    return put16(p, v >> 16);
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+uint16_t evtrace_pack_dump(uint8_t *payload, uint32_t freq_hz, uint16_t total, uint16_t first,
+                           const EvtraceRecord *records, uint8_t count) {
+    uint8_t *p = payload;
+    uint8_t i;
+
+    p = put32(p, freq_hz);
+    p = put16(p, total);
+    p = put16(p, first);
+    for (i = 0; i < count; i++) {
+        p = put32(p, records[i].time);
+        p = put16(p, records[i].id);
+        p = put16(p, records[i].arg);
+    }
+    return p - payload;
+}
+
+int evtrace_parse_dump(const uint8_t *payload, uint16_t len, uint32_t *freq_hz, uint16_t *total,
+                       uint16_t *first, EvtraceRecord *records) {
+    const uint8_t *p = payload + EVTRACE_DUMP_HDR;
+    int count, i;
+
+    if (len < EVTRACE_DUMP_HDR || (len - EVTRACE_DUMP_HDR) % EVTRACE_RECORD_LEN != 0) {
+        return -1;
+    }
+    count = (len - EVTRACE_DUMP_HDR) / EVTRACE_RECORD_LEN;
+    *freq_hz = get32(payload);
+    *total = get16(payload + 4);
+    *first = get16(payload + 6);
+    if (count > EVTRACE_DUMP_MAX || *freq_hz == 0 || *first + count > *total) {
+        return -1;
+    }
+    for (i = 0; i < count; i++, p += EVTRACE_RECORD_LEN) {
+        records[i].time = get32(p);
+        records[i].id = get16(p + 4);
+        records[i].arg = get16(p + 6);
+    }
+    return count;
+}
@@ -0,0 +1,81 @@
+/*
+ * evtrace.h
+ *
+ *  Event trace format. The board's monitor (monitor.h) records stage,
+ *  interrupt, I2C and UART activity as fixed size records in a RAM ring
+ *  and dumps the ring as PROTO_MSG_EVTRACE frames; morsecap turns a dump
+ *  into Chrome/Perfetto trace JSON.
+ *
+ *  Record: time(4) id(2) arg(2)
+ *      time    Timestamp counts, wraps at 32 bits
+ *      id      phase (high byte) | source (low byte)
+ *      arg     per source, see EvtraceSource
+ *
+ *  Dump payload: freq_hz(4) total(2) first(2) record*
+ *  A dump of total records, oldest first, is split over as many frames as
+ *  it takes; first is the position of the frame's first record in it.
+ *  Fields are little-endian.
+ *
+ *  Shared with the host tools (host/morsecap), keep it free of TI-RTOS
+ *  dependencies.
+ */
+
+#ifndef EVTRACE_H_
+#define EVTRACE_H_
+
+#include <stdint.h>
+
+#include "protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVTRACE_RECORD_LEN      8
+#define EVTRACE_DUMP_HDR        8
+#define EVTRACE_DUMP_MAX        ((PROTO_MAX_PAYLOAD - EVTRACE_DUMP_HDR) / EVTRACE_RECORD_LEN)
+
+// Phases
+#define EVTRACE_BEGIN           0x0100
+#define EVTRACE_END             0x0200
+
+#define EVTRACE_PHASE(id)       ((id) & 0xFF00)
+#define EVTRACE_SOURCE(id)      ((id) & 0x00FF)
+
+typedef enum {
+    EVTRACE_SRC_SENSOR = 0,     // sensor stage, in the sensor task or job
+    EVTRACE_SRC_APP,            // app stage, in the UART task or job
+    EVTRACE_SRC_BUTTON,         // button pin interrupt
+    EVTRACE_SRC_UART_RX,        // UART read callback and RX wake pin
+    EVTRACE_SRC_BUTTON_CLOCK,
+    EVTRACE_SRC_INDICATOR,      // indicator timeline timer
+    EVTRACE_SRC_IDLE_CLOCK,     // UART idle timeout
+    EVTRACE_SRC_SENSOR_CLOCK,
+    EVTRACE_SRC_I2C,            // arg: slave address, on the end 0x100 if it failed
+    EVTRACE_SRC_UART_TX,        // arg: bytes
+    EVTRACE_SRC_AUDIO,          // audio stage, microphone blocks
+    EVTRACE_SRC_COUNT
+} EvtraceSource;
+
+typedef struct {
+    uint32_t time;
+    uint16_t id;
+    uint16_t arg;
+} EvtraceRecord;
+
+extern const char *const evtraceSourceNames[EVTRACE_SRC_COUNT];
+
+// Returns the payload length, count is at most EVTRACE_DUMP_MAX
+uint16_t evtrace_pack_dump(uint8_t *payload, uint32_t freq_hz, uint16_t total, uint16_t first,
+                           const EvtraceRecord *records, uint8_t count);
+
+// Fills records (EVTRACE_DUMP_MAX of them) and returns their number, or
+// -1 if the payload is malformed
+int evtrace_parse_dump(const uint8_t *payload, uint16_t len, uint32_t *freq_hz, uint16_t *total,
+                       uint16_t *first, EvtraceRecord *records);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVTRACE_H_ */
@@ -0,0 +1,114 @@
+/*
+ * fsm.c
+ */
+
+#include <stddef.h>
+
+#include "fsm.h"
+
+static int hasRoom(const Fsm *fsm) {
+    return fsm->length < MORSE_MAX_SYMBOLS;
+}
+
+static void append(Fsm *fsm, char symbol) {
+    fsm->letter[fsm->length++] = symbol;
+    fsm->letter[fsm->length] = '\0';
+    fsm->emitSymbol(symbol);
+}
+
+static void appendDot(Fsm *fsm) {
+    append(fsm, '.');
+}
+
+static void appendDash(Fsm *fsm) {
+    append(fsm, '-');
+}
+
+static void endLetter(Fsm *fsm) {
+    fsm->emitSymbol(' ');
+    fsm->emitText(decodeMorse(fsm->letter));
+}
+
+static void wordSpace(Fsm *fsm) {
+    fsm->emitSymbol(' ');
+    fsm->emitText(' ');
+}
+
+// Three spaces in a row with the letter's end the message, a newline
+// ends its text
+static void endMessage(Fsm *fsm) {
+    fsm->emitSymbol(' ');
+    fsm->emitSymbol(' ');
+    fsm->emitText('\n');
+}
+
+static void endLetterAndMessage(Fsm *fsm) {
+    endLetter(fsm);
+    endMessage(fsm);
+}
+
+static void clearLetter(Fsm *fsm) {
+    fsm->length = 0;
+    fsm->letter[0] = '\0';
+}
+
+const FsmStateInfo fsmStates[FSM_STATE_COUNT] = {
+    [FSM_NONE]   = {"none",   NULL,        NULL},
+    [FSM_IDLE]   = {"idle",   clearLetter, NULL},
+    [FSM_LETTER] = {"letter", NULL,        NULL},
+};
+
+const FsmTransition fsmTransitions[FSM_STATE_COUNT][FSM_EVENT_COUNT] = {
+    [FSM_IDLE] = {
+        [FSM_EV_DOT]   = {NULL,    appendDot,  FSM_LETTER},
+        [FSM_EV_DASH]  = {NULL,    appendDash, FSM_LETTER},
+        [FSM_EV_GAP]   = {NULL,    wordSpace,  FSM_IDLE},
+        [FSM_EV_RESET] = {NULL,    NULL,       FSM_IDLE},
+        [FSM_EV_END]   = {NULL,    endMessage, FSM_IDLE},
+    },
+    [FSM_LETTER] = {
+        [FSM_EV_DOT]   = {hasRoom, appendDot,  FSM_LETTER},
+        [FSM_EV_DASH]  = {hasRoom, appendDash, FSM_LETTER},
+        [FSM_EV_GAP]   = {NULL,    endLetter,  FSM_IDLE},
+        [FSM_EV_RESET] = {NULL,    NULL,       FSM_IDLE},
+        [FSM_EV_END]   = {NULL,    endLetterAndMessage, FSM_IDLE},
+    },
+};
+
+void fsm_init(Fsm *fsm, void (*emitSymbol)(char), void (*emitText)(char)) {
+    fsm->emitSymbol = emitSymbol;
+    fsm->emitText = emitText;
+    fsm->rejected = 0;
+    fsm->state = FSM_IDLE;
+    clearLetter(fsm);
+}
+
+int fsm_dispatch(Fsm *fsm, FsmEvent event) {
+    const FsmTransition *t;
+
+    if (event >= FSM_EVENT_COUNT || fsm->state >= FSM_STATE_COUNT) {
+        fsm->rejected++;
+        return 0;
+    }
+
+    t = &fsmTransitions[fsm->state][event];
+    if (t->next == FSM_NONE || (t->guard && !t->guard(fsm))) {
+        fsm->rejected++;
+        return 0;
+    }
+
+    // Exit and entry only run when the state actually changes
+    if (t->next != fsm->state && fsmStates[fsm->state].exit) {
+        fsmStates[fsm->state].exit(fsm);
+    }
+    if (t->action) {
+        t->action(fsm);
+    }
+    if (t->next != fsm->state) {
+        fsm->state = t->next;
+        if (fsmStates[fsm->state].entry) {
+            fsmStates[fsm->state].entry(fsm);
+        }
+    }
+    return 1;
+}
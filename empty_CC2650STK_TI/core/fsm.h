@@ -0,0 +1,77 @@
+/*
+ * fsm.h
+ *
+ *  Keying state machine. States, events, guards and entry/exit actions are
+ *  const tables (flash), fsm_dispatch() looks the transition up by
+ *  [state][event] in constant time.
+ *
+ *  fsm_dispatch() is not reentrant; all events go through the mailbox and
+ *  are dispatched from uartTaskFxn() only.
+ */
+
+#ifndef FSM_H_
+#define FSM_H_
+
+#include <stdint.h>
+
+#include "morse.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    FSM_NONE = 0,       // "no transition" marker in the table
+    FSM_IDLE,           // between letters
+    FSM_LETTER,         // collecting the symbols of a letter
+    FSM_STATE_COUNT
+} FsmState;
+
+typedef enum {
+    FSM_EV_DOT = 0,
+    FSM_EV_DASH,
+    FSM_EV_GAP,         // ends the current letter, or a word space when idle
+    FSM_EV_RESET,
+    FSM_EV_END,         // ends the letter and the message
+    FSM_EVENT_COUNT
+} FsmEvent;
+
+typedef struct Fsm Fsm;
+
+typedef int (*FsmGuard)(const Fsm *fsm);
+typedef void (*FsmAction)(Fsm *fsm);
+
+typedef struct {
+    FsmGuard guard;     // NULL = always
+    FsmAction action;   // run between exit and entry
+    uint8_t next;       // FsmState, FSM_NONE = event not handled here
+} FsmTransition;
+
+typedef struct {
+    const char *name;
+    FsmAction entry;
+    FsmAction exit;
+} FsmStateInfo;
+
+struct Fsm {
+    uint8_t state;
+    char letter[MORSE_MAX_SYMBOLS + 1];
+    uint8_t length;
+    void (*emitSymbol)(char symbol);    // keyed symbol echo
+    void (*emitText)(char c);           // decoded text
+    uint32_t rejected;                  // unhandled or guarded-out events
+};
+
+extern const FsmTransition fsmTransitions[FSM_STATE_COUNT][FSM_EVENT_COUNT];
+extern const FsmStateInfo fsmStates[FSM_STATE_COUNT];
+
+void fsm_init(Fsm *fsm, void (*emitSymbol)(char), void (*emitText)(char));
+
+// Returns 1 if the event caused a transition, 0 if it was rejected
+int fsm_dispatch(Fsm *fsm, FsmEvent event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FSM_H_ */
@@ -0,0 +1,19 @@
+/*
+ * gesture.c
+ */
+
+#include "fsm.h"
+#include "gesture.h"
+
+int gesture_classify(const float *accel, int32_t tilt_mg) {
+    float tilt = tilt_mg / 1000.0f;
+
+    if (accel[0] > tilt) {
+        return FSM_EV_DOT;
+    } else if (accel[0] < -tilt) {
+        return FSM_EV_DASH;
+    } else if (accel[2] > tilt) {
+        return FSM_EV_GAP;
+    }
+    return -1;
+}
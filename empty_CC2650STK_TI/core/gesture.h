@@ -0,0 +1,24 @@
+/*
+ * gesture.h
+ *
+ *  Tilt gesture classifier, shared by the board and the host replay tool
+ *  so recorded sessions go through the same thresholds.
+ */
+
+#ifndef GESTURE_H_
+#define GESTURE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// accel is x, y, z in g. Returns an FsmEvent, or -1 for no gesture.
+int gesture_classify(const float *accel, int32_t tilt_mg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GESTURE_H_ */
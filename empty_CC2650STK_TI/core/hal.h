@@ -0,0 +1,57 @@
+/*
+ * hal.h
+ *
+ *  Hardware abstraction for the portable core (this directory). The board
+ *  implements it in hal_tirtos.c on top of TI-RTOS and the TI drivers,
+ *  host builds link host/hal/hal_posix.c instead. Nothing in core/ may
+ *  include a TI header, everything platform specific goes through here.
+ */
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Platform setup, before any other hal_ call
+void hal_init(void);
+
+// Free running microsecond time, wraps at 32 bits. An interval between
+// two readings may come out short by up to HAL_TIME_SKEW_US, so a timer
+// set to wake at a hal_time_us() deadline waits that much longer.
+uint32_t hal_time_us(void);
+
+#define HAL_TIME_SKEW_US 62
+
+// CPU cycles, wraps at 32 bits. Only for timing a stretch of code that
+// does not block, the count need not run while the CPU sleeps.
+uint32_t hal_cycles(void);
+
+// Critical section against all other contexts including interrupts.
+// Nests, the key from hal_lock() goes back to hal_unlock().
+uint32_t hal_lock(void);
+void hal_unlock(uint32_t key);
+
+// The indicator LED, fully on or off or dimmed to a level of 255
+void hal_led_set(int on);
+int hal_led_get(void);
+void hal_led_level(uint8_t level);
+
+// The buzzer at a pitch in Hz, 0 silences it
+void hal_tone(uint16_t hz);
+
+// Write then read on the sensor bus, either length may be 0.
+// Returns 0 on success, -1 on a bus error.
+int hal_i2c_transfer(uint8_t address, const uint8_t *tx, uint16_t txLen, uint8_t *rx, uint16_t rxLen);
+
+// Serial link output, returns the number of bytes written
+int hal_uart_write(const void *buf, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_H_ */
@@ -0,0 +1,150 @@
+/*
+ * indicator.c
+ */
+
+#include "hal.h"
+#include "indicator.h"
+#include "morse.h"
+
+typedef struct {
+    uint16_t ms;
+    uint8_t level;      // LED brightness
+    uint8_t tone;       // buzzer on
+} IndicatorStep;
+
+static IndicatorStep steps[INDICATOR_STEPS];
+static uint8_t head;
+static uint8_t count;
+static uint8_t playing;
+static uint16_t toneHz;
+static uint8_t onLevel = 255;
+
+// Adjacent gaps merge into one step, empty steps are left out. Returns 0,
+// or -1 when full.
+static int push(uint16_t ms, uint8_t level, uint8_t tone) {
+    IndicatorStep *last = &steps[(head + count + INDICATOR_STEPS - 1) % INDICATOR_STEPS];
+
+    if (ms == 0) {
+        return 0;
+    }
+    if (count > 0 && !level && !tone && !last->level && !last->tone && last->ms + ms <= UINT16_MAX) {
+        last->ms += ms;
+        return 0;
+    }
+    if (count == INDICATOR_STEPS) {
+        return -1;
+    }
+    last = &steps[(head + count) % INDICATOR_STEPS];
+    last->ms = ms;
+    last->level = level;
+    last->tone = tone;
+    count++;
+    return 0;
+}
+
+// Undoes a pattern that did not fit, called under the lock with the queue
+// as it was before. Returns what the pattern functions return.
+static int finish(int error, uint8_t oldCount, uint16_t oldLastMs) {
+    if (error) {
+        count = oldCount;
+        if (count > 0) {
+            steps[(head + count - 1) % INDICATOR_STEPS].ms = oldLastMs;
+        }
+        return -1;
+    }
+    return !playing;
+}
+
+static uint16_t lastMs(void) {
+    return count > 0 ? steps[(head + count - 1) % INDICATOR_STEPS].ms : 0;
+}
+
+int indicator_flash(uint16_t ms) {
+    return indicator_blink(1, ms, 0);
+}
+
+int indicator_blink(uint8_t times, uint16_t on_ms, uint16_t off_ms) {
+    uint32_t key = hal_lock();
+    uint8_t oldCount = count;
+    uint16_t oldLastMs = lastMs();
+    int error = 0, result;
+    uint8_t i;
+
+    for (i = 0; i < times && !error; i++) {
+        error = push(on_ms, onLevel, 1) || push(off_ms, 0, 0);
+    }
+    result = finish(error, oldCount, oldLastMs);
+    hal_unlock(key);
+    return result;
+}
+
+int indicator_text(const char *text, uint16_t unit_ms) {
+    char code[MORSE_MAX_SYMBOLS + 1];
+    uint32_t key = hal_lock();
+    uint8_t oldCount = count;
+    uint16_t oldLastMs = lastMs();
+    int error = 0, result;
+    int i, n;
+
+    for (; *text != '\0' && !error; text++) {
+        if (*text == ' ') {
+            error = push(4 * unit_ms, 0, 0);  // after a letter gap of 3
+            continue;
+        }
+        n = encodeMorse(*text, code);
+        for (i = 0; i < n && !error; i++) {
+            error = push(code[i] == '-' ? 3 * unit_ms : unit_ms, onLevel, 1) ||
+                    push(i == n - 1 ? 3 * unit_ms : unit_ms, 0, 0);
+        }
+    }
+    result = finish(error, oldCount, oldLastMs);
+    hal_unlock(key);
+    return result;
+}
+
+int indicator_fade(uint8_t from, uint8_t to, uint16_t ms) {
+    uint32_t key = hal_lock();
+    uint8_t oldCount = count;
+    uint16_t oldLastMs = lastMs();
+    int error = 0, result;
+    int i;
+
+    for (i = 0; i < INDICATOR_FADE_STEPS && !error; i++) {
+        error = push(ms / INDICATOR_FADE_STEPS, from + (to - from) * i / (INDICATOR_FADE_STEPS - 1), 0);
+    }
+    result = finish(error, oldCount, oldLastMs);
+    hal_unlock(key);
+    return result;
+}
+
+void indicator_clear(void) {
+    uint32_t key = hal_lock();
+
+    count = 0;
+    hal_unlock(key);
+}
+
+void indicator_tone(uint16_t hz) {
+    toneHz = hz;
+}
+
+void indicator_level(uint8_t level) {
+    onLevel = level;
+}
+
+uint32_t indicator_run(void) {
+    uint32_t key = hal_lock();
+    IndicatorStep step = {0, 0, 0};
+
+    playing = count > 0;
+    if (playing) {
+        step = steps[head];
+        head = (head + 1) % INDICATOR_STEPS;
+        count--;
+    }
+    hal_unlock(key);
+
+    hal_led_level(step.level);
+    hal_tone(step.tone ? toneHz : 0);
+    return playing ? (uint32_t)step.ms * 1000 : 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * indicator.h
+ *
+ *  LED and buzzer feedback played in the background. Patterns are queued
+ *  as on/off steps and played in order by indicator_run(), which the
+ *  platform calls from a one-shot timer after the time it returned, so
+ *  nothing that shows a pattern waits for it. An "on" step lights the LED
+ *  at the indicator_level() brightness and sounds the buzzer at the
+ *  indicator_tone() pitch, both from the same step so light and sound
+ *  stay in step. Fades dim the LED without sound.
+ *
+ *  Callable from tasks, Swis and Hwis.
+ */
+
+#ifndef INDICATOR_H_
+#define INDICATOR_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INDICATOR_STEPS         64
+#define INDICATOR_FADE_STEPS    16
+
+// Each returns 1 if the player was idle and the timer has to be started,
+// 0 if it is already playing, -1 if the pattern does not fit the queue
+// (nothing of it is queued)
+int indicator_flash(uint16_t ms);
+int indicator_blink(uint8_t times, uint16_t on_ms, uint16_t off_ms);
+
+// Morse with the standard 1:3:7 timing, characters without a code are
+// skipped
+int indicator_text(const char *text, uint16_t unit_ms);
+
+// LED brightness from one level to another, silent
+int indicator_fade(uint8_t from, uint8_t to, uint16_t ms);
+
+// Drops what is queued, the step being played runs out
+void indicator_clear(void);
+
+// Buzzer pitch for the steps from now on, 0 = LED only
+void indicator_tone(uint16_t hz);
+
+// LED brightness of "on" steps queued from now on, 255 = full
+void indicator_level(uint8_t level);
+
+// Plays the next step. Returns the microseconds until the next call, or 0
+// when the queue is empty and the outputs are off.
+uint32_t indicator_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INDICATOR_H_ */
@@ -0,0 +1,58 @@
+/*
+ * keyer.c
+ */
+
+#include "fsm.h"
+#include "gesture.h"
+#include "keyer.h"
+
+// Time comparisons survive the 32-bit wrap as long as the intervals stay
+// below half of it, about 35 minutes
+static int reached(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+void keyer_init(Keyer *k) {
+    k->clicks = 0;
+    k->holding = 0;
+    k->clickDeadline = 0;
+    k->holdUntil = 0;
+}
+
+void keyer_click(Keyer *k, uint32_t now_us, uint32_t click_us) {
+    if (k->clicks < 0xFF) {
+        k->clicks++;
+    }
+    k->clickDeadline = now_us + click_us;
+}
+
+int keyer_expire(Keyer *k, uint32_t now_us) {
+    uint8_t clicks = k->clicks;
+
+    if (clicks == 0 || !reached(now_us, k->clickDeadline)) {
+        return -1;
+    }
+    k->clicks = 0;
+    if (clicks > 3) {
+        return -1;  // no meaning, dropped like a stray click
+    }
+    return FSM_EV_DOT + clicks - 1;
+}
+
+int keyer_tilt(Keyer *k, uint32_t now_us, const float *accel, int32_t tilt_mg, uint32_t hold_us) {
+    int event;
+
+    if (k->holding) {
+        if (!reached(now_us, k->holdUntil)) {
+            return -1;
+        }
+        k->holding = 0;
+    }
+
+    event = gesture_classify(accel, tilt_mg);
+    if (event >= 0) {
+        k->holding = 1;
+        k->holdUntil = now_us + hold_us;
+    }
+    return event;
+}
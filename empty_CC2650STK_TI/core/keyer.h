@@ -0,0 +1,46 @@
+/*
+ * keyer.h
+ *
+ *  Keying classifier, turns button clicks and tilt gestures into keying
+ *  events for the state machine (fsm.h). Clicks on the keying button are
+ *  grouped until none follows within the click timeout, then one, two or
+ *  three clicks key a dot, a dash or a gap. After a gesture new gestures
+ *  are ignored for the hold time, so one tilt keys one symbol.
+ *
+ *  The caller passes the time, so the board and host replay run the same
+ *  code. Not reentrant, the board calls it with interrupts disabled.
+ */
+
+#ifndef KEYER_H_
+#define KEYER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t clicks;
+    uint8_t holding;
+    uint32_t clickDeadline;     // us, valid while clicks > 0
+    uint32_t holdUntil;         // us, valid while holding
+} Keyer;
+
+void keyer_init(Keyer *k);
+
+// One press of the keying button, the group closes click_us after the last
+void keyer_click(Keyer *k, uint32_t now_us, uint32_t click_us);
+
+// Returns the FsmEvent of a click group that closed by now_us, or -1
+int keyer_expire(Keyer *k, uint32_t now_us);
+
+// accel is x, y, z in g. Returns an FsmEvent, or -1 for no gesture or
+// while the previous one is held.
+int keyer_tilt(Keyer *k, uint32_t now_us, const float *accel, int32_t tilt_mg, uint32_t hold_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_H_ */
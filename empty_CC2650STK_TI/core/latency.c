@@ -0,0 +1,81 @@
+/*
+ * latency.c
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "latency.h"
+
+const char *const latencyStageNames[LATENCY_STAGE_COUNT] = {
+    "read", "classify", "detect", "queue", "output", "total",
+};
+
+static LatencyHistogram stages[LATENCY_STAGE_COUNT];
+
+static uint8_t bucketOf(uint32_t us) {
+    uint8_t bucket = 0;
+
+    while (us > 1 && bucket < LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void latency_reset(void) {
+    uint32_t key = hal_lock();
+
+    memset(stages, 0, sizeof(stages));
+    hal_unlock(key);
+}
+
+void latency_record(LatencyStage stage, uint32_t start_us, uint32_t end_us) {
+    uint32_t us = end_us - start_us;  // wrap safe
+    LatencyHistogram *h = &stages[stage];
+    uint8_t bucket = bucketOf(us);
+    uint32_t key = hal_lock();
+
+    if (h->count == 0 || us < h->min_us) {
+        h->min_us = us;
+    }
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+    h->count++;
+    h->sum_us += us;
+    h->buckets[bucket]++;
+    hal_unlock(key);
+}
+
+void latency_snapshot(LatencyStage stage, LatencyHistogram *out) {
+    uint32_t key = hal_lock();
+
+    *out = stages[stage];
+    hal_unlock(key);
+}
+
+uint32_t latency_bucket_floor(uint8_t bucket) {
+    return bucket == 0 ? 0 : (uint32_t)1 << bucket;
+}
+
+uint32_t latency_percentile(const LatencyHistogram *h, uint8_t percent) {
+    uint32_t rank, seen = 0;
+    uint8_t i;
+
+    if (h->count == 0) {
+        return 0;
+    }
+    rank = (uint32_t)(((uint64_t)h->count * percent + 99) / 100);
+    for (i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            break;
+        }
+    }
+    // The open last bucket and any bucket past the maximum report the maximum
+    if (i == LATENCY_BUCKETS - 1 || latency_bucket_floor(i + 1) - 1 > h->max_us) {
+        return h->max_us;
+    }
+    return latency_bucket_floor(i + 1) - 1;
+}
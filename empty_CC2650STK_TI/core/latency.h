@@ -0,0 +1,64 @@
+/*
+ * latency.h
+ *
+ *  Latency histograms of the keying path, from the motion sample or the
+ *  button click to the symbol written on the UART. Each stage keeps a
+ *  count, sum, minimum, maximum and power-of-two buckets, so percentiles
+ *  come out within a factor of two at a fixed few hundred bytes of RAM.
+ *
+ *  Times are hal_time_us() values. Recording takes hal_lock(), it is
+ *  callable from tasks, Swis and Hwis.
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LATENCY_READ = 0,       // one IMU sample over I2C
+    LATENCY_CLASSIFY,       // gesture classification of one sample
+    LATENCY_DETECT,         // sample or last click to the keying event posted
+    LATENCY_QUEUE,          // posted to picked up by the app stage
+    LATENCY_OUTPUT,         // picked up to the symbol written on the UART
+    LATENCY_TOTAL,          // sample or last click to the symbol written
+    LATENCY_STAGE_COUNT
+} LatencyStage;
+
+// Bucket 0 holds 0..1 us, bucket i >= 1 holds 2^i..2^(i+1)-1 us, the last
+// one everything from about a second up
+#define LATENCY_BUCKETS 21
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[LATENCY_BUCKETS];
+} LatencyHistogram;
+
+extern const char *const latencyStageNames[LATENCY_STAGE_COUNT];
+
+// Clears all stages
+void latency_reset(void);
+
+void latency_record(LatencyStage stage, uint32_t start_us, uint32_t end_us);
+
+// Consistent copy of one stage
+void latency_snapshot(LatencyStage stage, LatencyHistogram *out);
+
+// Upper bound of the bucket holding the given percentile, 0 if empty
+uint32_t latency_percentile(const LatencyHistogram *h, uint8_t percent);
+
+// Smallest value that falls in the bucket
+uint32_t latency_bucket_floor(uint8_t bucket);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_H_ */
@@ -0,0 +1,433 @@
+/*
+ * logstore.c
+ */
+
+#include <string.h>
+
+#include "logstore.h"
+#include "protocol.h"
+
+#define ERASED  0xFF
+
+typedef struct {
+    uint32_t seq;
+    uint32_t erases;
+    uint32_t first_ms;
+} SectorHeader;
+
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static uint16_t recordCrc(const uint8_t *hdr, const uint8_t *payload) {
+    return protocol_crc16(payload, hdr[0], protocol_crc16(hdr, 6, 0xFFFF));
+}
+
+static uint32_t sectorAddr(const LogStore *store, uint16_t sector) {
+    return store->base + (uint32_t)sector * LOGSTORE_SECTOR;
+}
+
+// Physical sector of a sequence number within a lap of writePage
+static uint16_t sectorOf(const LogStore *store, uint32_t seq) {
+    uint32_t back = (store->writePage / LOGSTORE_PAGES - seq) % store->sectors;
+
+    return (uint16_t)((store->writeSector + store->sectors - back) % store->sectors);
+}
+
+static uint32_t startPage(const LogStore *store) {
+    if (store->used == 0) {
+        return store->writePage;
+    }
+    return (store->headSeq - store->used + 1) * LOGSTORE_PAGES;
+}
+
+static uint32_t endPage(const LogStore *store) {
+    return store->writePage + store->sealed + (store->count > 0);
+}
+
+static uint16_t firstOffset(uint32_t page) {
+    return page % LOGSTORE_PAGES == 0 ? LOGSTORE_SECTOR_HDR : 0;
+}
+
+// 1 if the sector holds a valid header, 0 if not, -1 on a read error
+static int readHeader(LogStore *store, uint16_t sector, SectorHeader *h) {
+    uint8_t raw[LOGSTORE_SECTOR_HDR];
+
+    if (store->flash->read(sectorAddr(store, sector), raw, sizeof(raw)) != 0) {
+        store->stats.errors++;
+        return -1;
+    }
+    if (get16(raw) != LOGSTORE_MAGIC || get16(raw + 14) != protocol_crc16(raw, 14, 0xFFFF)) {
+        return 0;
+    }
+    h->seq = get32(raw + 2);
+    h->erases = get32(raw + 6);
+    h->first_ms = get32(raw + 10);
+    return 1;
+}
+
+// Reads a page of the log, from the page buffers while it is there
+static int readAt(const LogStore *store, uint32_t page, uint16_t offset, void *out, uint16_t len) {
+    uint32_t addr;
+
+    if (store->sealed && page == store->writePage) {
+        memcpy(out, store->buf[store->open ^ 1] + offset, len);
+        return 0;
+    }
+    if (store->count > 0 && page == store->writePage + store->sealed) {
+        memcpy(out, store->buf[store->open] + offset, len);
+        return 0;
+    }
+    addr = sectorAddr(store, sectorOf(store, page / LOGSTORE_PAGES));
+    return store->flash->read(addr + (page % LOGSTORE_PAGES) * LOGSTORE_PAGE + offset, out, len);
+}
+
+// The time of the last intact record in a page read into buf
+static int lastTime(const uint8_t *buf, uint16_t offset, uint32_t *time_ms) {
+    int found = 0;
+
+    while (offset + LOGSTORE_RECORD_HDR <= LOGSTORE_PAGE && buf[offset] != ERASED) {
+        const uint8_t *hdr = buf + offset;
+
+        if (offset + LOGSTORE_RECORD_HDR + hdr[0] > LOGSTORE_PAGE
+            || get16(hdr + 6) != recordCrc(hdr, hdr + LOGSTORE_RECORD_HDR)) {
+            break;
+        }
+        *time_ms = get32(hdr + 2);
+        found = 1;
+        offset += LOGSTORE_RECORD_HDR + hdr[0];
+    }
+    return found;
+}
+
+int logstore_mount(LogStore *store, const LogFlash *flash, uint32_t base, uint16_t sectors, uint32_t now_ms) {
+    SectorHeader h;
+    uint16_t s, head = 0;
+    uint32_t last_ms = 0;
+    int valid, found = 0;
+    int16_t page, end = -1;
+    uint16_t i;
+
+    if (sectors < 2 || sectors > LOGSTORE_MAX_SECTORS) {
+        return -1;
+    }
+    memset(store, 0, sizeof(*store));
+    store->flash = flash;
+    store->base = base;
+    store->sectors = sectors;
+
+    // The newest sector, then back along the sequence for the rest
+    for (s = 0; s < sectors; s++) {
+        valid = readHeader(store, s, &h);
+        store->stats.mountReads++;
+        if (valid < 0) {
+            return -1;
+        }
+        if (valid && (!found || h.seq > store->headSeq)) {
+            head = s;
+            store->headSeq = h.seq;
+            store->erases = h.erases;
+            last_ms = h.first_ms;
+            found = 1;
+        }
+    }
+    if (!found) {
+        // Blank or foreign, sector 0 starts the log
+        store->writePage = LOGSTORE_PAGES;
+        store->erases = 1;
+        store->offset_ms = -(int32_t)now_ms;
+        return 0;
+    }
+    store->firstMs[head] = last_ms;
+    store->used = 1;
+    while (store->used < sectors) {
+        s = (uint16_t)((head + sectors - store->used) % sectors);
+        valid = readHeader(store, s, &h);
+        store->stats.mountReads++;
+        if (valid < 0) {
+            return -1;
+        }
+        if (!valid || h.seq != store->headSeq - store->used) {
+            break;
+        }
+        store->firstMs[s] = h.first_ms;
+        store->used++;
+    }
+
+    // The log ends after the last page of the head sector that is not
+    // blank. A torn one is not blank either, it is skipped, and the time
+    // goes on from the last intact record before it.
+    for (page = LOGSTORE_PAGES - 1; page >= 0; page--) {
+        uint8_t *buf = store->buf[0];
+
+        if (flash->read(sectorAddr(store, head) + (uint32_t)page * LOGSTORE_PAGE, buf, LOGSTORE_PAGE) != 0) {
+            store->stats.errors++;
+            return -1;
+        }
+        store->stats.mountReads++;
+        for (i = 0; i < LOGSTORE_PAGE && buf[i] == ERASED; i++) {
+        }
+        if (i == LOGSTORE_PAGE) {
+            continue;
+        }
+        if (end < 0) {
+            end = page;
+        }
+        if (lastTime(buf, firstOffset((uint32_t)page), &last_ms)) {
+            break;
+        }
+    }
+    if (end + 1 < LOGSTORE_PAGES) {
+        store->writePage = store->headSeq * LOGSTORE_PAGES + (uint32_t)(end + 1);
+        store->writeSector = head;
+        store->erased = 1;
+    } else {
+        store->writePage = (store->headSeq + 1) * LOGSTORE_PAGES;
+        store->writeSector = (uint16_t)((head + 1) % sectors);
+    }
+    store->last_ms = last_ms;
+    store->offset_ms = (int32_t)(last_ms - now_ms);
+    return 0;
+}
+
+static int seal(LogStore *store) {
+    if (store->count == 0) {
+        return 0;
+    }
+    if (store->sealed) {
+        return -1;
+    }
+    store->sealed = 1;
+    store->sealedLen = store->fill;
+    store->open ^= 1;
+    store->count = 0;
+    store->fill = 0;
+    return 1;
+}
+
+int logstore_append(LogStore *store, uint8_t type, const void *payload, uint8_t len, uint32_t now_ms) {
+    uint32_t time_ms = now_ms + (uint32_t)store->offset_ms;
+    uint8_t *p;
+    int result = 0;
+
+    if (len > LOGSTORE_MAX_PAYLOAD) {
+        store->stats.dropped++;
+        return -1;
+    }
+    if (store->count > 0 && store->fill + LOGSTORE_RECORD_HDR + len > LOGSTORE_PAGE) {
+        result = seal(store);
+        if (result < 0) {
+            store->stats.dropped++;
+            return -1;
+        }
+    }
+    if (store->count == 0) {
+        // A sector's first page leaves room for its header
+        memset(store->buf[store->open], ERASED, LOGSTORE_PAGE);
+        store->fill = firstOffset(store->writePage + store->sealed);
+    }
+
+    // Time never goes back, a clock that does moves the offset instead
+    if ((int32_t)(time_ms - store->last_ms) < 0) {
+        store->offset_ms += (int32_t)(store->last_ms - time_ms);
+        time_ms = store->last_ms;
+    }
+    store->last_ms = time_ms;
+
+    p = store->buf[store->open] + store->fill;
+    p[0] = len;
+    p[1] = type;
+    put32(p + 2, time_ms);
+    memcpy(p + LOGSTORE_RECORD_HDR, payload, len);
+    put16(p + 6, recordCrc(p, p + LOGSTORE_RECORD_HDR));
+    store->fill += LOGSTORE_RECORD_HDR + len;
+    store->count++;
+    store->stats.appended++;
+
+    // A page that cannot take another record goes now
+    if (store->fill + LOGSTORE_RECORD_HDR > LOGSTORE_PAGE && seal(store) > 0) {
+        result = 1;
+    }
+    return result;
+}
+
+int logstore_commit(LogStore *store) {
+    return seal(store);
+}
+
+int logstore_work(LogStore *store) {
+    const LogFlash *flash = store->flash;
+    uint32_t addr = sectorAddr(store, store->writeSector);
+    uint32_t seq = store->writePage / LOGSTORE_PAGES;
+    uint16_t index = store->writePage % LOGSTORE_PAGES;
+    uint8_t *page = store->buf[store->open ^ 1];
+    SectorHeader h;
+
+    if (flash->busy()) {
+        return LOGSTORE_BUSY;
+    }
+    if (!store->sealed) {
+        return LOGSTORE_IDLE;
+    }
+
+    if (index == 0 && !store->erased) {
+        // A full ring gives up its oldest sector, the one to be erased
+        if (readHeader(store, store->writeSector, &h) > 0) {
+            store->erases = h.erases + 1;
+        }
+        if (flash->erase(addr) != 0) {
+            store->stats.errors++;
+            return LOGSTORE_BUSY;
+        }
+        if (store->used == store->sectors) {
+            store->used--;
+        }
+        store->erased = 1;
+        store->stats.erases++;
+        return LOGSTORE_BUSY;
+    }
+
+    if (index == 0) {
+        put16(page, LOGSTORE_MAGIC);
+        put32(page + 2, seq);
+        put32(page + 6, store->erases);
+        put32(page + 10, get32(page + LOGSTORE_SECTOR_HDR + 2));
+        put16(page + 14, protocol_crc16(page, 14, 0xFFFF));
+    }
+    if (flash->program(addr + (uint32_t)index * LOGSTORE_PAGE, page, store->sealedLen) != 0) {
+        store->stats.errors++;
+    } else {
+        store->stats.pages++;
+    }
+    if (index == 0) {
+        store->firstMs[store->writeSector] = get32(page + 10);
+        store->headSeq = seq;
+        store->used++;
+    }
+
+    // The page is spent either way, it is never programmed twice
+    store->sealed = 0;
+    store->writePage++;
+    if (store->writePage % LOGSTORE_PAGES == 0) {
+        store->writeSector = (uint16_t)((store->writeSector + 1) % store->sectors);
+        store->erased = 0;
+    }
+    return LOGSTORE_BUSY;
+}
+
+int logstore_seek(const LogStore *store, uint32_t from_ms, LogCursor *cursor) {
+    uint32_t start = startPage(store), end = endPage(store), lo, hi, mid;
+    uint8_t hdr[LOGSTORE_RECORD_HDR];
+
+    if (start == end) {
+        return -1;
+    }
+
+    // The last sector that starts at or before from_ms
+    cursor->page = start;
+    if (store->used > 0) {
+        lo = store->headSeq - store->used + 1;
+        hi = store->headSeq;
+        while (lo < hi) {
+            mid = lo + (hi - lo + 1) / 2;
+            if ((int32_t)(store->firstMs[sectorOf(store, mid)] - from_ms) <= 0) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        cursor->page = lo * LOGSTORE_PAGES;
+    }
+    cursor->offset = firstOffset(cursor->page);
+
+    // and the record in it, by the headers; next() checks the CRCs
+    while (cursor->page != end) {
+        if (cursor->offset + LOGSTORE_RECORD_HDR > LOGSTORE_PAGE
+            || readAt(store, cursor->page, cursor->offset, hdr, sizeof(hdr)) != 0 || hdr[0] == ERASED
+            || cursor->offset + LOGSTORE_RECORD_HDR + hdr[0] > LOGSTORE_PAGE) {
+            cursor->page++;
+            cursor->offset = firstOffset(cursor->page);
+            continue;
+        }
+        if ((int32_t)(get32(hdr + 2) - from_ms) >= 0) {
+            break;
+        }
+        cursor->offset += LOGSTORE_RECORD_HDR + hdr[0];
+    }
+    return 0;
+}
+
+int logstore_next(LogStore *store, LogCursor *cursor, LogRecord *record, uint8_t *payload) {
+    uint32_t start = startPage(store), end = endPage(store);
+    uint8_t hdr[LOGSTORE_RECORD_HDR];
+
+    for (;;) {
+        // Behind the tail, the sector is gone: carry on from the oldest
+        if ((int32_t)(cursor->page - start) < 0) {
+            cursor->page = start;
+            cursor->offset = 0;
+        }
+        if ((int32_t)(cursor->page - end) >= 0) {
+            return 0;
+        }
+        if (cursor->offset < firstOffset(cursor->page)) {
+            cursor->offset = firstOffset(cursor->page);
+        }
+
+        if (cursor->offset + LOGSTORE_RECORD_HDR <= LOGSTORE_PAGE
+            && readAt(store, cursor->page, cursor->offset, hdr, sizeof(hdr)) == 0 && hdr[0] != ERASED) {
+            if (cursor->offset + LOGSTORE_RECORD_HDR + hdr[0] <= LOGSTORE_PAGE
+                && readAt(store, cursor->page, cursor->offset + LOGSTORE_RECORD_HDR, payload, hdr[0]) == 0
+                && get16(hdr + 6) == recordCrc(hdr, payload)) {
+                record->type = hdr[1];
+                record->len = hdr[0];
+                record->time_ms = get32(hdr + 2);
+                cursor->offset += LOGSTORE_RECORD_HDR + hdr[0];
+                return 1;
+            }
+            store->stats.corrupt++;
+        }
+        cursor->page++;
+        cursor->offset = 0;
+    }
+}
+
+int logstore_wear(LogStore *store, uint16_t *used, uint32_t *minErases, uint32_t *maxErases) {
+    SectorHeader h;
+    uint16_t s;
+    int valid, found = 0;
+
+    *used = store->used;
+    *minErases = *maxErases = 0;
+    for (s = 0; s < store->sectors; s++) {
+        valid = readHeader(store, s, &h);
+        if (valid < 0) {
+            return -1;
+        }
+        if (!valid) {
+            continue;
+        }
+        if (!found || h.erases < *minErases) {
+            *minErases = h.erases;
+        }
+        if (!found || h.erases > *maxErases) {
+            *maxErases = h.erases;
+        }
+        found = 1;
+    }
+    return 0;
+}
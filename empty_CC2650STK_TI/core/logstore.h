@@ -0,0 +1,165 @@
+/*
+ * logstore.h
+ *
+ *  Append-only record log on SPI NOR flash, a ring of erase sectors.
+ *  Records are collected in a RAM page and programmed a whole page at a
+ *  time, each page exactly once; a page that is committed before it is
+ *  full keeps its erased tail. The ring wraps by erasing the oldest
+ *  sector, so every sector is erased once per lap and the wear is even;
+ *  sector headers keep the erase counts.
+ *
+ *  Sector: header(16) page data...
+ *      magic(2) seq(4) erases(4) first_ms(4) crc(2)
+ *      seq counts the sectors ever written, the newest has the highest;
+ *      first_ms is the time of the sector's first record. The header goes
+ *      out with the sector's first page.
+ *  Record: len(1) type(1) time_ms(4) crc(2) payload(len)
+ *      crc is CRC-16 (protocol_crc16) over the rest of the header and the
+ *      payload. Records do not cross pages, len 0xFF (erased) ends a page.
+ *  Fields are little-endian.
+ *
+ *  Power loss: a record is durable once the page holding it is
+ *  programmed, logstore_commit() seals the page early. A page or header
+ *  torn by a power cut fails its CRC and is skipped when read, a page is
+ *  never programmed twice, so nothing written before is at risk. Mounting
+ *  finds the newest sector by the headers and its first blank page.
+ *
+ *  Times are the caller's milliseconds, offset so they continue from the
+ *  end of the log across resets and never go back. The first_ms of the
+ *  sectors, kept in RAM, find a time in a binary search and a scan of one
+ *  sector.
+ *
+ *  Flash operations are started by logstore_work() one at a time and
+ *  never waited for, the caller calls it again while it returns
+ *  LOGSTORE_BUSY. Not reentrant.
+ *
+ *  Shared with the host tools (host/morsecap), keep it free of TI-RTOS
+ *  dependencies.
+ */
+
+#ifndef LOGSTORE_H_
+#define LOGSTORE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOGSTORE_PAGE           256
+#define LOGSTORE_SECTOR         4096
+#define LOGSTORE_PAGES          (LOGSTORE_SECTOR / LOGSTORE_PAGE)
+#define LOGSTORE_MAX_SECTORS    128     // RAM index, 512 KB of flash
+#define LOGSTORE_SECTOR_HDR     16
+#define LOGSTORE_RECORD_HDR     8
+#define LOGSTORE_MAX_PAYLOAD    (LOGSTORE_PAGE - LOGSTORE_SECTOR_HDR - LOGSTORE_RECORD_HDR)
+
+#define LOGSTORE_MAGIC          0x474C  // "LG"
+
+// Record types of the board's log
+#define LOGSTORE_REC_BOOT       0x01    // cause(1), SupervisorCause
+#define LOGSTORE_REC_TEXT       0x02    // decoded text, one word
+#define LOGSTORE_REC_IMU        0x03    // raw counts ax..gz, 6 * int16
+
+// logstore_work() results
+#define LOGSTORE_IDLE           0       // nothing sealed, all committed
+#define LOGSTORE_BUSY           1       // call again once the flash may be done
+
+// The flash, addresses from the start of the chip. Each returns 0, or -1
+// on an error. read() waits for a program or erase to finish, program()
+// and erase() only start one.
+typedef struct {
+    int (*read)(uint32_t addr, void *buf, uint16_t len);
+    int (*program)(uint32_t addr, const void *buf, uint16_t len);   // within one page
+    int (*erase)(uint32_t addr);                                    // the sector at addr
+    int (*busy)(void);                                              // 1 while one runs
+} LogFlash;
+
+typedef struct {
+    uint8_t type;
+    uint8_t len;
+    uint32_t time_ms;
+} LogRecord;
+
+typedef struct {
+    uint32_t appended;
+    uint32_t dropped;       // both page buffers full
+    uint32_t pages;         // programmed
+    uint32_t erases;
+    uint32_t errors;        // flash operations that failed
+    uint32_t corrupt;       // records that failed their CRC when read
+    uint32_t mountReads;
+} LogStats;
+
+// Pages are numbered seq * LOGSTORE_PAGES + page in the sector, so a
+// cursor left behind by the ring wrapping is recognized
+typedef struct {
+    uint32_t page;
+    uint16_t offset;
+} LogCursor;
+
+typedef struct {
+    const LogFlash *flash;
+    uint32_t base;
+    uint16_t sectors;
+
+    // Ring of sectors in use, the newest is headSeq
+    uint16_t used;
+    uint32_t headSeq;
+    uint32_t firstMs[LOGSTORE_MAX_SECTORS];     // by physical sector
+
+    // Where the next page is programmed, and the sector erase before it
+    uint32_t writePage;     // numbered like LogCursor.page
+    uint16_t writeSector;   // physical sector of writePage
+    uint8_t erased;         // that sector is erased
+    uint32_t erases;        // and how often, for its header
+
+    // Page buffers: one filling, one sealed until programmed
+    uint8_t buf[2][LOGSTORE_PAGE];
+    uint8_t open;
+    uint8_t count;          // records in the open page
+    uint16_t fill;          // its length
+    uint8_t sealed;         // buf[open ^ 1] waits for writePage
+    uint16_t sealedLen;
+
+    int32_t offset_ms;      // added to the caller's time
+    uint32_t last_ms;
+
+    LogStats stats;
+} LogStore;
+
+// Reads the headers and the newest sector to find where the log ends.
+// The region starts on a sector, sectors <= LOGSTORE_MAX_SECTORS. now_ms
+// is the caller's time. Returns 0, or -1 if the flash cannot be read.
+int logstore_mount(LogStore *store, const LogFlash *flash, uint32_t base, uint16_t sectors, uint32_t now_ms);
+
+// Queues a record at now_ms. Returns 1 if it sealed a page and
+// logstore_work() has to run, 0 if it went into the open page, -1 if it
+// is too long or no page buffer is free (counted as dropped).
+int logstore_append(LogStore *store, uint8_t type, const void *payload, uint8_t len, uint32_t now_ms);
+
+// Seals the open page if it holds anything. Returns like
+// logstore_append(), -1 if the other buffer is still sealed.
+int logstore_commit(LogStore *store);
+
+// One flash step: erases the next sector or programs the sealed page
+int logstore_work(LogStore *store);
+
+// The first record at or after from_ms, including those still in RAM.
+// Returns 0, or -1 if the log is empty.
+int logstore_seek(const LogStore *store, uint32_t from_ms, LogCursor *cursor);
+
+// Reads the record at the cursor and moves past it. payload holds
+// LOGSTORE_MAX_PAYLOAD bytes. Returns 1, or 0 at the end of the log.
+// Records that fail their CRC are skipped with the rest of their page.
+int logstore_next(LogStore *store, LogCursor *cursor, LogRecord *record, uint8_t *payload);
+
+// Sectors in use and the lowest and highest erase count of the region,
+// from its headers
+int logstore_wear(LogStore *store, uint16_t *used, uint32_t *minErases, uint32_t *maxErases);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOGSTORE_H_ */
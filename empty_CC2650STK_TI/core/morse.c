@@ -0,0 +1,55 @@
+/*
+ * morse.c
+ */
+
+#include "morse.h"
+
+// Codes as paths in a binary tree stored heap style: the root is 1, a dot
+// goes from node i to 2i and a dash to 2i + 1. One row per code length,
+// '?' where no letter has that code. Decoding walks the code once
+// instead of comparing it against every entry of a table.
+static const char morseTree[] =
+    "?"
+    "?"
+    "ET"
+    "IANM"
+    "SURWDKGO"
+    "HVF?L?PJBXCYZQ??"
+    "54?3???2???????16???????7???8?90";
+
+char decodeMorse(const char *morse) {
+    unsigned int node = 1;
+    int i;
+
+    for (i = 0; morse[i] != '\0'; i++) {
+        if (i == MORSE_MAX_SYMBOLS || (morse[i] != '.' && morse[i] != '-')) {
+            return '?'; // Unknown symbol
+        }
+        node = 2 * node + (morse[i] == '-');
+    }
+    return morseTree[node];
+}
+
+// The path to the letter's node, read from the bits of its index below
+// the leading one
+int encodeMorse(char letter, char *out) {
+    unsigned int node;
+    int length, i;
+
+    if (letter >= 'a' && letter <= 'z') {
+        letter -= 'a' - 'A';
+    }
+    for (node = 2; morseTree[node] != '\0' && morseTree[node] != letter; node++) {
+    }
+    if (letter == '?' || morseTree[node] == '\0') {
+        out[0] = '\0';
+        return 0;
+    }
+    for (length = 0; (node >> (length + 1)) != 0; length++) {
+    }
+    for (i = 0; i < length; i++) {
+        out[i] = (node >> (length - 1 - i)) & 1 ? '-' : '.';
+    }
+    out[length] = '\0';
+    return length;
+}
@@ -0,0 +1,28 @@
+/*
+ * morse.h
+ *
+ *  Morse code table, letter decoding and encoding.
+ */
+
+#ifndef MORSE_H_
+#define MORSE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest code in the table (digits)
+#define MORSE_MAX_SYMBOLS 5
+
+// Returns the letter for a code such as ".-", '?' if unknown
+char decodeMorse(const char *morse);
+
+// Writes the code of a letter or digit, either case, to out (at least
+// MORSE_MAX_SYMBOLS + 1 chars). Returns its length, 0 if there is none.
+int encodeMorse(char letter, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MORSE_H_ */
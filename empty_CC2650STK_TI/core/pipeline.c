@@ -0,0 +1,77 @@
+/*
+ * pipeline.c
+ */
+
+#include <stddef.h>
+
+#include "hal.h"
+#include "pipeline.h"
+#include "pool.h"
+
+static SampleSubscriber subscribers[PIPELINE_MAX_SUBSCRIBERS];
+static uint8_t subscriberCount;
+static PipelineStats stats;
+
+void pipeline_init(void) {
+    subscriberCount = 0;
+    stats.published = 0;
+    stats.drops = 0;
+}
+
+int pipeline_subscribe(SampleSubscriber fxn) {
+    if (subscriberCount == PIPELINE_MAX_SUBSCRIBERS) {
+        return -1;
+    }
+    subscribers[subscriberCount++] = fxn;
+    return 0;
+}
+
+// The counters are shared by every producer, so they change under the lock
+Sample *pipeline_acquire(uint32_t timestamp_us) {
+    Sample *sample = pool_alloc(sizeof(Sample));
+    uint32_t key;
+
+    if (sample == NULL) {
+        key = hal_lock();
+        stats.drops++;
+        hal_unlock(key);
+        return NULL;
+    }
+    sample->refs = 1;
+    sample->timestamp_us = timestamp_us;
+    return sample;
+}
+
+void pipeline_publish(Sample *sample) {
+    uint8_t i;
+    uint32_t key = hal_lock();
+
+    stats.published++;
+    hal_unlock(key);
+    for (i = 0; i < subscriberCount; i++) {
+        subscribers[i](sample);
+    }
+    pipeline_release(sample);
+}
+
+void pipeline_retain(Sample *sample) {
+    uint32_t key = hal_lock();
+
+    sample->refs++;
+    hal_unlock(key);
+}
+
+void pipeline_release(Sample *sample) {
+    uint8_t refs;
+    uint32_t key = hal_lock();
+
+    refs = --sample->refs;
+    hal_unlock(key);
+    if (refs == 0) {
+        pool_free(sample);
+    }
+}
+
+const PipelineStats *pipeline_stats(void) {
+    return &stats;
+}
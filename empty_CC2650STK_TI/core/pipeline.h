@@ -0,0 +1,58 @@
+/*
+ * pipeline.h
+ *
+ *  Sample distribution without copies. The acquisition stage takes a
+ *  pooled Sample, reads the sensor straight into it and publishes it.
+ *  Every subscriber is called with the same buffer; one that needs the
+ *  sample after returning takes a reference with pipeline_retain() and
+ *  drops it with pipeline_release(). The block goes back to the pool when
+ *  the last reference is released.
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <stdint.h>
+
+#include "protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIPELINE_MAX_SUBSCRIBERS 4
+
+typedef struct {
+    uint8_t refs;
+    uint32_t timestamp_us;
+    int16_t raw[PROTO_IMU_AXES];    // ax, ay, az, gx, gy, gz counts
+} Sample;
+
+typedef void (*SampleSubscriber)(Sample *sample);
+
+typedef struct {
+    uint32_t published;
+    uint32_t drops;     // no free buffer at acquisition
+} PipelineStats;
+
+void pipeline_init(void);
+
+// Subscribers are called in registration order. Returns -1 if full.
+int pipeline_subscribe(SampleSubscriber fxn);
+
+// Returns a buffer holding one reference, or NULL if the pool is empty
+Sample *pipeline_acquire(uint32_t timestamp_us);
+
+// Hands the sample to every subscriber and drops the producer's reference
+void pipeline_publish(Sample *sample);
+
+void pipeline_retain(Sample *sample);
+void pipeline_release(Sample *sample);
+
+const PipelineStats *pipeline_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIPELINE_H_ */
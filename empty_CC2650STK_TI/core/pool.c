@@ -0,0 +1,114 @@
+/*
+ * pool.c
+ */
+
+#include <stddef.h>
+
+#include "hal.h"
+#include "pool.h"
+
+#define WORDS(size) (((size) + 3) / 4)
+
+typedef struct PoolBlock {
+    struct PoolBlock *next;
+} PoolBlock;
+
+typedef struct {
+    uint32_t *storage;
+    uint16_t words;     // block size in 32-bit words
+    uint16_t count;
+    PoolBlock *free;
+    uint16_t used;
+    uint16_t peak;
+    uint32_t failures;
+} PoolClass;
+
+static uint32_t smallStorage[POOL_SMALL_COUNT * WORDS(POOL_SMALL_SIZE)];
+static uint32_t audioStorage[POOL_AUDIO_COUNT * WORDS(POOL_AUDIO_SIZE)];
+static uint32_t frameStorage[POOL_FRAME_COUNT * WORDS(POOL_FRAME_SIZE)];
+
+static PoolClass classes[POOL_CLASS_COUNT] = {
+    {smallStorage, WORDS(POOL_SMALL_SIZE), POOL_SMALL_COUNT},
+    {audioStorage, WORDS(POOL_AUDIO_SIZE), POOL_AUDIO_COUNT},
+    {frameStorage, WORDS(POOL_FRAME_SIZE), POOL_FRAME_COUNT},
+};
+
+void pool_init(void) {
+    uint8_t c;
+    uint16_t i;
+
+    for (c = 0; c < POOL_CLASS_COUNT; c++) {
+        PoolClass *pc = &classes[c];
+
+        pc->free = NULL;
+        for (i = pc->count; i > 0; i--) {
+            PoolBlock *block = (PoolBlock *)(pc->storage + (i - 1) * pc->words);
+            block->next = pc->free;
+            pc->free = block;
+        }
+        pc->used = 0;
+        pc->peak = 0;
+        pc->failures = 0;
+    }
+}
+
+void *pool_alloc(uint16_t size) {
+    PoolClass *pc = NULL;
+    PoolBlock *block;
+    uint8_t c;
+    uint32_t key;
+
+    for (c = 0; c < POOL_CLASS_COUNT; c++) {
+        if (size <= classes[c].words * 4) {
+            pc = &classes[c];
+            break;
+        }
+    }
+    if (pc == NULL) {
+        return NULL;
+    }
+
+    key = hal_lock();
+    block = pc->free;
+    if (block != NULL) {
+        pc->free = block->next;
+        if (++pc->used > pc->peak) {
+            pc->peak = pc->used;
+        }
+    } else {
+        pc->failures++;
+    }
+    hal_unlock(key);
+    return block;
+}
+
+void pool_free(void *block) {
+    uint32_t *p = block;
+    uint8_t c;
+    uint32_t key;
+
+    for (c = 0; c < POOL_CLASS_COUNT; c++) {
+        PoolClass *pc = &classes[c];
+
+        if (p >= pc->storage && p < pc->storage + pc->count * pc->words) {
+            key = hal_lock();
+            ((PoolBlock *)block)->next = pc->free;
+            pc->free = block;
+            pc->used--;
+            hal_unlock(key);
+            return;
+        }
+    }
+}
+
+void pool_stats(uint8_t cls, PoolStats *stats) {
+    const PoolClass *pc = &classes[cls];
+    uint32_t key = hal_lock();
+
+    stats->blockSize = pc->words * 4;
+    stats->count = pc->count;
+    stats->used = pc->used;
+    stats->peak = pc->peak;
+    stats->failures = pc->failures;
+    hal_unlock(key);
+}
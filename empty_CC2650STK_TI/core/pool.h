@@ -0,0 +1,53 @@
+/*
+ * pool.h
+ *
+ *  Fixed-block memory pools. Each size class is a static array of equal
+ *  blocks threaded on a free list, so alloc and free are O(1), never
+ *  fragment and can be called from tasks, Swis and Hwis.
+ *
+ *  pool_alloc() returns a block from the smallest class that fits, or NULL
+ *  when that class is exhausted (larger classes are not borrowed from).
+ */
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stdint.h>
+
+#include "protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size classes, smallest first. Sizes are rounded up to whole words.
+#define POOL_SMALL_SIZE     32
+#define POOL_SMALL_COUNT    16
+#define POOL_AUDIO_SIZE     132     // one PDM buffer, 64 samples and metadata
+#define POOL_AUDIO_COUNT    6
+#define POOL_FRAME_SIZE     PROTO_MAX_FRAME
+#define POOL_FRAME_COUNT    4
+
+#define POOL_CLASS_COUNT    3
+
+typedef struct {
+    uint16_t blockSize;
+    uint16_t count;
+    uint16_t used;
+    uint16_t peak;
+    uint32_t failures;
+} PoolStats;
+
+void pool_init(void);
+
+void *pool_alloc(uint16_t size);
+void pool_free(void *block);
+
+// Snapshot of one size class, class 0 is the smallest
+void pool_stats(uint8_t cls, PoolStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POOL_H_ */
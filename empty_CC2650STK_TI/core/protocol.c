@@ -0,0 +1,183 @@
+/*
+ * protocol.c
+ *
+ *  COBS framing, CRC-16 and payload packing for the binary UART stream.
+ */
+
+#include <string.h>
+
+#include "protocol.h"
+#include "tscodec.h"
+
+static uint8_t txSeq = 0;
+
+uint16_t protocol_crc16(const uint8_t *data, uint16_t len, uint16_t crc) {
+    uint16_t i;
+    uint8_t bit;
+
+    for (i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (bit = 0; bit < 8; bit++) {
+            if (crc & 0x8000) {
+                crc = (crc << 1) ^ 0x1021;
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+// Consistent Overhead Byte Stuffing, no trailing delimiter is written
+uint16_t protocol_cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    uint16_t in = 0;
+    uint16_t out = 1;
+    uint16_t codeIndex = 0;
+    uint8_t code = 1;
+
+    while (in < len) {
+        if (src[in] == 0) {
+            dst[codeIndex] = code;
+            codeIndex = out++;
+            code = 1;
+        } else {
+            dst[out++] = src[in];
+            code++;
+            if (code == 0xFF) {
+                dst[codeIndex] = code;
+                codeIndex = out++;
+                code = 1;
+            }
+        }
+        in++;
+    }
+    dst[codeIndex] = code;
+    return out;
+}
+
+// Returns decoded length, 0 if the input is not valid COBS
+uint16_t protocol_cobs_decode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    uint16_t in = 0;
+    uint16_t out = 0;
+    uint8_t code, i;
+
+    while (in < len) {
+        code = src[in++];
+        if (code == 0 || in + code - 1 > len) {
+            return 0;
+        }
+        for (i = 1; i < code; i++) {
+            dst[out++] = src[in++];
+        }
+        if (code != 0xFF && in < len) {
+            dst[out++] = 0;
+        }
+    }
+    return out;
+}
+
+uint16_t protocol_build_frame(uint8_t type, const uint8_t *payload, uint16_t len, uint8_t *out) {
+    uint8_t raw[PROTO_MAX_RAW];
+    uint16_t crc, n;
+
+    if (len > PROTO_MAX_PAYLOAD) {
+        return 0;
+    }
+
+    raw[0] = type;
+    raw[1] = txSeq++;
+    memcpy(&raw[PROTO_HEADER_LEN], payload, len);
+    crc = protocol_crc16(raw, PROTO_HEADER_LEN + len, 0xFFFF);
+    raw[PROTO_HEADER_LEN + len] = crc & 0xFF;
+    raw[PROTO_HEADER_LEN + len + 1] = crc >> 8;
+
+    n = protocol_cobs_encode(raw, PROTO_HEADER_LEN + len + PROTO_CRC_LEN, out);
+    out[n++] = 0x00;
+    return n;
+}
+
+int16_t protocol_parse_frame(const uint8_t *raw, uint16_t len, uint8_t *type, uint8_t *seq, const uint8_t **payload) {
+    uint16_t crc;
+
+    if (len < PROTO_HEADER_LEN + PROTO_CRC_LEN || len > PROTO_MAX_RAW) {
+        return -1;
+    }
+    crc = protocol_crc16(raw, len - PROTO_CRC_LEN, 0xFFFF);
+    if (raw[len - 2] != (crc & 0xFF) || raw[len - 1] != (crc >> 8)) {
+        return -1;
+    }
+
+    *type = raw[0];
+    *seq = raw[1];
+    *payload = &raw[PROTO_HEADER_LEN];
+    return len - PROTO_HEADER_LEN - PROTO_CRC_LEN;
+}
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+uint16_t protocol_pack_imu_batch(uint8_t *payload, uint32_t timestamp_us, uint16_t period_us,
+                                 const int16_t *const *samples, uint8_t count) {
+    uint8_t *p = payload;
+    uint8_t i, axis;
+
+    if (count > PROTO_IMU_MAX_SAMPLES) {
+        count = PROTO_IMU_MAX_SAMPLES;
+    }
+
+    p = put32(p, timestamp_us);
+    p = put16(p, period_us);
+    *p++ = count;
+    for (i = 0; i < count; i++) {
+        for (axis = 0; axis < PROTO_IMU_AXES; axis++) {
+            p = put16(p, (uint16_t)samples[i][axis]);
+        }
+    }
+    return p - payload;
+}
+
+uint16_t protocol_pack_imu_packed(uint8_t *payload, uint32_t timestamp_us, uint16_t period_us,
+                                  const int16_t *const *samples, uint8_t count) {
+    uint16_t len;
+
+    put16(put32(payload, timestamp_us), period_us);
+    len = tscodec_encode16(payload + PROTO_IMU_PACKED_HDR, PROTO_MAX_PAYLOAD - PROTO_IMU_PACKED_HDR,
+                           samples, PROTO_IMU_AXES, count);
+    return len > 0 ? PROTO_IMU_PACKED_HDR + len : 0;
+}
+
+uint16_t protocol_pack_telemetry(uint8_t *payload, uint32_t uptime_ms, uint32_t samples,
+                                 uint32_t frames, uint32_t tx_errors) {
+    uint8_t *p = payload;
+
+    p = put32(p, uptime_ms);
+    p = put32(p, samples);
+    p = put32(p, frames);
+    p = put32(p, tx_errors);
+    return p - payload;
+}
+
+uint16_t protocol_pack_env(uint8_t *payload, uint8_t channel, uint8_t kind, const AggregateSummary *s) {
+    uint8_t *p = payload;
+
+    p = put32(p, s->start_ms);
+    *p++ = channel;
+    *p++ = kind;
+    p = put16(p, s->count);
+    p = put32(p, (uint32_t)s->min);
+    p = put32(p, (uint32_t)s->max);
+    p = put32(p, (uint32_t)s->mean);
+    p = put32(p, s->variance);
+    return p - payload;
+}
@@ -0,0 +1,95 @@
+/*
+ * protocol.h
+ *
+ *  Binary framing for the UART link.
+ *
+ *  Frame on the wire: COBS( type | seq | payload | crc16_lo | crc16_hi ) 0x00
+ *  CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) is computed over type, seq
+ *  and payload. All multi-byte payload fields are little-endian.
+ *
+ *  This file is shared with the host decoder (host/morsecap), keep it
+ *  free of TI-RTOS dependencies.
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include <stdint.h>
+
+#include "aggregate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Message types
+#define PROTO_MSG_IMU_BATCH     0x01
+#define PROTO_MSG_SYMBOL        0x02
+#define PROTO_MSG_TEXT          0x03
+#define PROTO_MSG_TELEMETRY     0x04
+#define PROTO_MSG_REPLY         0x05    // command shell output, plain text
+#define PROTO_MSG_TRACE         0x06    // one trace block, see trace.h
+#define PROTO_MSG_EVTRACE       0x07    // part of an event trace dump, see evtrace.h
+#define PROTO_MSG_IMU_PACKED    0x08    // IMU batch as a tscodec.h block
+#define PROTO_MSG_ENV           0x09    // environmental summary or change
+
+#define PROTO_HEADER_LEN        2
+#define PROTO_CRC_LEN           2
+#define PROTO_MAX_PAYLOAD       160
+#define PROTO_MAX_RAW           (PROTO_HEADER_LEN + PROTO_MAX_PAYLOAD + PROTO_CRC_LEN)
+// COBS adds one byte per started 254 byte block, plus the 0x00 delimiter
+#define PROTO_MAX_FRAME         (PROTO_MAX_RAW + PROTO_MAX_RAW / 254 + 2)
+
+// IMU batch payload: timestamp_us(4) period_us(2) count(1) count * 6 * int16
+// Samples are raw sensor counts in order ax, ay, az, gx, gy, gz.
+#define PROTO_IMU_AXES          6
+#define PROTO_IMU_BATCH_HDR     7
+#define PROTO_IMU_MAX_SAMPLES   ((PROTO_MAX_PAYLOAD - PROTO_IMU_BATCH_HDR) / (PROTO_IMU_AXES * 2))
+
+// Packed IMU batch payload: timestamp_us(4) period_us(2) block
+// The block (tscodec.h) holds the same samples, PROTO_IMU_AXES channels.
+#define PROTO_IMU_PACKED_HDR    6
+
+// Telemetry payload: uptime_ms(4) samples(4) frames(4) tx_errors(4)
+#define PROTO_TELEMETRY_LEN     16
+
+// Environment payload: time_ms(4) channel(1) kind(1) count(2) min(4) max(4)
+// mean(4) variance(4). A summary covers the window from time_ms, a change
+// is one reading at time_ms (count 1, min = max = mean). Channels: light in
+// lux, pressure in Pa, air and object temperature in 0.01 C.
+#define PROTO_ENV_LEN           24
+#define PROTO_ENV_CHANGE        1
+#define PROTO_ENV_SUMMARY       2
+#define PROTO_ENV_LIGHT         0
+#define PROTO_ENV_PRESSURE      1
+#define PROTO_ENV_AIR           2
+#define PROTO_ENV_OBJECT        3
+#define PROTO_ENV_CHANNELS      4
+
+uint16_t protocol_crc16(const uint8_t *data, uint16_t len, uint16_t crc);
+uint16_t protocol_cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst);
+uint16_t protocol_cobs_decode(const uint8_t *src, uint16_t len, uint8_t *dst);
+
+// Builds a complete, delimited frame into out (PROTO_MAX_FRAME bytes).
+// Returns the frame length, or 0 if the payload is too long.
+uint16_t protocol_build_frame(uint8_t type, const uint8_t *payload, uint16_t len, uint8_t *out);
+
+// Checks and strips a decoded (un-COBSed) frame. Returns the payload length
+// and fills type/seq/payload pointer, or -1 on CRC or length error.
+int16_t protocol_parse_frame(const uint8_t *raw, uint16_t len, uint8_t *type, uint8_t *seq, const uint8_t **payload);
+
+// samples[i] points to the PROTO_IMU_AXES counts of sample i
+uint16_t protocol_pack_imu_batch(uint8_t *payload, uint32_t timestamp_us, uint16_t period_us,
+                                 const int16_t *const *samples, uint8_t count);
+// Returns 0 if the samples do not fit one payload, try fewer
+uint16_t protocol_pack_imu_packed(uint8_t *payload, uint32_t timestamp_us, uint16_t period_us,
+                                  const int16_t *const *samples, uint8_t count);
+uint16_t protocol_pack_telemetry(uint8_t *payload, uint32_t uptime_ms, uint32_t samples,
+                                 uint32_t frames, uint32_t tx_errors);
+uint16_t protocol_pack_env(uint8_t *payload, uint8_t channel, uint8_t kind, const AggregateSummary *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROTOCOL_H_ */
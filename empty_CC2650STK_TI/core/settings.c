@@ -0,0 +1,70 @@
+/*
+ * settings.c
+ */
+
+#include <string.h>
+
+#include "settings.h"
+
+Settings settings = {
+    .tilt_mg = 1000,
+    .sample_ms = 1000,
+    .hold_ms = 500,
+    .click_ms = 500,
+    .stream = 0,
+    .trace = 0,
+    .idle_ms = 10000,
+    .tone_hz = 0,
+    .led_level = 255,
+    .echo_wpm = 0,
+    .log_ms = 10000,
+    .env_ms = 0,
+    .env_win_s = 60,
+    .dead_lux = 100,
+    .dead_pa = 50,
+    .dead_cc = 50,
+    .baro_ms = 0,
+    .lift_cm = 40,
+};
+
+const SettingsParam settingsParams[] = {
+    {"tilt_mg",   &settings.tilt_mg,   100, 4000},
+    {"sample_ms", &settings.sample_ms, 10,  10000},
+    {"hold_ms",   &settings.hold_ms,   0,   5000},
+    {"click_ms",  &settings.click_ms,  100, 5000},
+    {"stream",    &settings.stream,    0,   2},
+    {"trace",     &settings.trace,     0,   1},
+    {"idle_ms",   &settings.idle_ms,   0,   600000},
+    {"tone_hz",   &settings.tone_hz,   0,   8000},
+    {"led_level", &settings.led_level, 1,   255},
+    {"echo_wpm",  &settings.echo_wpm,  0,   40},
+    {"log_ms",    &settings.log_ms,    0,   3600000},
+    {"env_ms",    &settings.env_ms,    0,   3600000},
+    {"env_win_s", &settings.env_win_s, 1,   86400},
+    {"dead_lux",  &settings.dead_lux,  0,   100000},
+    {"dead_pa",   &settings.dead_pa,   0,   10000},
+    {"dead_cc",   &settings.dead_cc,   0,   10000},
+    {"baro_ms",   &settings.baro_ms,   0,   1000},
+    {"lift_cm",   &settings.lift_cm,   10,  300},
+};
+
+const uint8_t settingsParamCount = sizeof(settingsParams) / sizeof(settingsParams[0]);
+
+const SettingsParam *settings_find(const char *name) {
+    uint8_t i;
+
+    for (i = 0; i < settingsParamCount; i++) {
+        if (strcmp(settingsParams[i].name, name) == 0) {
+            return &settingsParams[i];
+        }
+    }
+    return NULL;
+}
+
+int settings_set(const SettingsParam *param, int32_t value) {
+    if (value < param->min || value > param->max) {
+        return -1;
+    }
+    *param->value = value;
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * settings.h
+ *
+ *  Runtime tunable parameters. Defaults are the former compile-time
+ *  constants, the UART command shell can read and change them by name.
+ */
+
+#ifndef SETTINGS_H_
+#define SETTINGS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Settings.stream
+#define STREAM_OFF      0
+#define STREAM_RAW      1   // PROTO_MSG_IMU_BATCH frames
+#define STREAM_PACKED   2   // PROTO_MSG_IMU_PACKED frames
+
+typedef struct {
+    int32_t tilt_mg;    // accelerometer threshold for a gesture, milli-g
+    int32_t sample_ms;  // sensor loop period when not streaming
+    int32_t hold_ms;    // LED hold time after a symbol
+    int32_t click_ms;   // button click grouping timeout
+    int32_t stream;     // binary IMU streaming (protocol.h), STREAM_*
+    int32_t trace;      // 1 = record a trace (trace.h), needs stream
+    int32_t idle_ms;    // UART RX inactivity before the link sleeps, 0 = never
+    int32_t tone_hz;    // buzzer pitch of the indicator, 0 = LED only
+    int32_t led_level;  // indicator LED brightness, 255 = full
+    int32_t echo_wpm;   // Morse echo of decoded letters on the indicator, 0 = off
+    int32_t log_ms;     // IMU history period in the flash log, 0 = off
+    int32_t env_ms;     // light, pressure and temperature period, 0 = off
+    int32_t env_win_s;  // summary window of the environmental readings
+    int32_t dead_lux;   // light change reported at once, 0 = summaries only
+    int32_t dead_pa;    // pressure change reported at once, 0 = summaries only
+    int32_t dead_cc;    // temperature change in 0.01 C, 0 = summaries only
+    int32_t baro_ms;    // pressure period of the altitude gestures, 0 = off
+    int32_t lift_cm;    // height of an altitude gesture
+} Settings;
+
+typedef struct {
+    const char *name;
+    int32_t *value;
+    int32_t min;
+    int32_t max;
+} SettingsParam;
+
+extern Settings settings;
+extern const SettingsParam settingsParams[];
+extern const uint8_t settingsParamCount;
+
+const SettingsParam *settings_find(const char *name);
+
+// Returns 0 on success, -1 if the value is out of range
+int settings_set(const SettingsParam *param, int32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SETTINGS_H_ */
@@ -0,0 +1,230 @@
+/*
+ * trace.c
+ *
+ *  Encoder and decoder for trace blocks, see trace.h for the layout.
+ */
+
+#include <string.h>
+
+#include "trace.h"
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    p = put16(p, v & 0xFFFF);
+    return put16(p, v >> 16);
+}
+
+static uint8_t *putVarint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+static int getVarint(TraceReader *r, uint32_t *v) {
+    uint32_t result = 0;
+    uint8_t shift = 0;
+
+    while (r->p < r->end && shift < 35) {
+        uint8_t b = *r->p++;
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+void trace_writer_start(TraceWriter *w, uint8_t *buf, uint16_t size, uint32_t base_us) {
+    w->buf = buf;
+    w->size = size;
+    w->last_us = base_us;
+    memset(w->prev, 0, sizeof(w->prev));
+    w->prevPressure = 0;
+    put32(buf, base_us);
+    w->len = TRACE_BLOCK_HEADER_LEN;
+}
+
+// Encodes tag and dt into tmp, returns the write position
+static uint8_t *begin(TraceWriter *w, uint8_t *tmp, uint8_t tag, uint32_t timestamp_us) {
+    *tmp = tag;
+    return putVarint(tmp + 1, timestamp_us - w->last_us);
+}
+
+static int commit(TraceWriter *w, const uint8_t *tmp, uint16_t len, uint32_t timestamp_us) {
+    if (w->len + len > w->size) {
+        return -1;
+    }
+    memcpy(w->buf + w->len, tmp, len);
+    w->len += len;
+    w->last_us = timestamp_us;
+    return 0;
+}
+
+int trace_put_config(TraceWriter *w, uint32_t timestamp_us, const TraceConfig *config) {
+    uint8_t tmp[TRACE_MAX_RECORD];
+    uint8_t *p = begin(w, tmp, TRACE_REC_CONFIG, timestamp_us);
+    uint8_t i;
+
+    *p++ = config->version;
+    p = put16(p, config->period_us);
+    p = put32(p, config->accel_ng);
+    p = put32(p, config->gyro_udps);
+    for (i = 0; i < 3; i++) {
+        p = put16(p, (uint16_t)config->accel_bias_mg[i]);
+    }
+    return commit(w, tmp, p - tmp, timestamp_us);
+}
+
+int trace_put_imu(TraceWriter *w, uint32_t timestamp_us, const int16_t *raw) {
+    uint8_t tmp[TRACE_MAX_RECORD];
+    uint8_t *p = begin(w, tmp, TRACE_REC_IMU, timestamp_us);
+    uint8_t axis;
+
+    for (axis = 0; axis < TRACE_AXES; axis++) {
+        p = putVarint(p, zigzag((int32_t)raw[axis] - w->prev[axis]));
+    }
+    if (commit(w, tmp, p - tmp, timestamp_us) != 0) {
+        return -1;
+    }
+    memcpy(w->prev, raw, sizeof(w->prev));
+    return 0;
+}
+
+int trace_put_button(TraceWriter *w, uint32_t timestamp_us, uint8_t button, uint8_t level) {
+    uint8_t tmp[TRACE_MAX_RECORD];
+    uint8_t *p = begin(w, tmp, TRACE_REC_BUTTON, timestamp_us);
+
+    *p++ = button;
+    *p++ = level;
+    return commit(w, tmp, p - tmp, timestamp_us);
+}
+
+int trace_put_note(TraceWriter *w, uint32_t timestamp_us, const char *text) {
+    uint8_t tmp[TRACE_MAX_RECORD];
+    uint8_t *p = begin(w, tmp, TRACE_REC_NOTE, timestamp_us);
+    size_t len = strlen(text);
+
+    if (len > TRACE_MAX_NOTE) {
+        len = TRACE_MAX_NOTE;
+    }
+    *p++ = len;
+    memcpy(p, text, len);
+    return commit(w, tmp, p + len - tmp, timestamp_us);
+}
+
+int trace_put_pressure(TraceWriter *w, uint32_t timestamp_us, int32_t pressure) {
+    uint8_t tmp[TRACE_MAX_RECORD];
+    uint8_t *p = begin(w, tmp, TRACE_REC_PRESSURE, timestamp_us);
+
+    p = putVarint(p, zigzag(pressure - w->prevPressure));
+    if (commit(w, tmp, p - tmp, timestamp_us) != 0) {
+        return -1;
+    }
+    w->prevPressure = pressure;
+    return 0;
+}
+
+int trace_reader_start(TraceReader *r, const uint8_t *block, uint16_t len) {
+    if (len < TRACE_BLOCK_HEADER_LEN) {
+        return -1;
+    }
+    r->last_us = get32(block);
+    r->p = block + TRACE_BLOCK_HEADER_LEN;
+    r->end = block + len;
+    memset(r->prev, 0, sizeof(r->prev));
+    r->prevPressure = 0;
+    return 0;
+}
+
+int trace_next(TraceReader *r, TraceRecord *rec) {
+    uint32_t dt, v;
+    uint8_t i;
+
+    if (r->p == r->end) {
+        return 0;
+    }
+    rec->type = *r->p++;
+    if (getVarint(r, &dt) != 0) {
+        return -1;
+    }
+    rec->timestamp_us = r->last_us + dt;
+
+    switch (rec->type) {
+    case TRACE_REC_CONFIG:
+        if (r->end - r->p < 17) {
+            return -1;
+        }
+        rec->u.config.version = r->p[0];
+        rec->u.config.period_us = get16(r->p + 1);
+        rec->u.config.accel_ng = get32(r->p + 3);
+        rec->u.config.gyro_udps = get32(r->p + 7);
+        for (i = 0; i < 3; i++) {
+            rec->u.config.accel_bias_mg[i] = (int16_t)get16(r->p + 11 + 2 * i);
+        }
+        r->p += 17;
+        break;
+    case TRACE_REC_IMU:
+        for (i = 0; i < TRACE_AXES; i++) {
+            if (getVarint(r, &v) != 0) {
+                return -1;
+            }
+            r->prev[i] = (int16_t)(r->prev[i] + unzigzag(v));
+            rec->u.imu[i] = r->prev[i];
+        }
+        break;
+    case TRACE_REC_BUTTON:
+        if (r->end - r->p < 2) {
+            return -1;
+        }
+        rec->u.button.button = r->p[0];
+        rec->u.button.level = r->p[1];
+        r->p += 2;
+        break;
+    case TRACE_REC_NOTE:
+        if (r->p == r->end || r->p[0] > TRACE_MAX_NOTE || r->end - r->p - 1 < r->p[0]) {
+            return -1;
+        }
+        rec->u.note.len = r->p[0];
+        memcpy(rec->u.note.text, r->p + 1, rec->u.note.len);
+        rec->u.note.text[rec->u.note.len] = '\0';
+        r->p += 1 + rec->u.note.len;
+        break;
+    case TRACE_REC_PRESSURE:
+        if (getVarint(r, &v) != 0) {
+            return -1;
+        }
+        r->prevPressure += unzigzag(v);
+        rec->u.pressure = r->prevPressure;
+        break;
+    default:
+        return -1;
+    }
+    r->last_us = rec->timestamp_us;
+    return 1;
+}
@@ -0,0 +1,118 @@
+/*
+ * trace.h
+ *
+ *  Record/replay trace format for IMU, button and pressure input sessions.
+ *
+ *  A trace is a sequence of self-contained blocks. The board sends each
+ *  block as one PROTO_MSG_TRACE payload; a trace file is
+ *
+ *      "MTRC" version(1) reserved(3) { len(2) block(len) }*
+ *
+ *  Block: base_us(4) record*
+ *  Record: tag(1) dt(varint) body
+ *      TRACE_REC_CONFIG  version(1) period_us(2) accel_ng(4) gyro_udps(4)
+ *                        accel_bias_mg(3 * 2)
+ *      TRACE_REC_IMU     6 * zigzag varint, raw counts ax..gz as a delta
+ *                        to the previous IMU record of the block
+ *      TRACE_REC_BUTTON  button(1) level(1)
+ *      TRACE_REC_NOTE    len(1) text(len)
+ *      TRACE_REC_PRESSURE  zigzag varint, pressure in Pa with 8 fraction
+ *                        bits as a delta to the previous one of the block
+ *
+ *  dt is in microseconds since the previous record, or since base_us for
+ *  the first one. Fixed size fields are little-endian. Delta state starts
+ *  over in every block, so a lost block does not corrupt the next one.
+ *
+ *  Shared with the host tools (host/morsecap), keep it free of TI-RTOS
+ *  dependencies.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRACE_MAGIC             "MTRC"
+#define TRACE_VERSION           1
+#define TRACE_FILE_HEADER_LEN   8
+#define TRACE_BLOCK_HEADER_LEN  4
+
+#define TRACE_REC_CONFIG        0x01
+#define TRACE_REC_IMU           0x02
+#define TRACE_REC_BUTTON        0x03
+#define TRACE_REC_NOTE          0x04
+#define TRACE_REC_PRESSURE      0x05
+
+#define TRACE_AXES              6
+#define TRACE_MAX_NOTE          24
+#define TRACE_MAX_RECORD        (1 + 5 + 1 + TRACE_MAX_NOTE)
+
+typedef struct {
+    uint8_t version;
+    uint16_t period_us;         // IMU sample period
+    uint32_t accel_ng;          // accelerometer scale, nano-g per count
+    uint32_t gyro_udps;         // gyro scale, micro-degrees per second per count
+    int16_t accel_bias_mg[3];   // subtracted after scaling, as on the board
+} TraceConfig;
+
+typedef struct {
+    uint8_t type;
+    uint32_t timestamp_us;
+    union {
+        TraceConfig config;
+        int16_t imu[TRACE_AXES];
+        struct {
+            uint8_t button;
+            uint8_t level;
+        } button;
+        struct {
+            uint8_t len;
+            char text[TRACE_MAX_NOTE + 1];
+        } note;
+        int32_t pressure;
+    } u;
+} TraceRecord;
+
+// Block encoder
+typedef struct {
+    uint8_t *buf;
+    uint16_t size;
+    uint16_t len;
+    uint32_t last_us;
+    int16_t prev[TRACE_AXES];
+    int32_t prevPressure;
+} TraceWriter;
+
+// Block decoder
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t last_us;
+    int16_t prev[TRACE_AXES];
+    int32_t prevPressure;
+} TraceReader;
+
+void trace_writer_start(TraceWriter *w, uint8_t *buf, uint16_t size, uint32_t base_us);
+
+// Each returns 0, or -1 if the record does not fit (the block is unchanged)
+int trace_put_config(TraceWriter *w, uint32_t timestamp_us, const TraceConfig *config);
+int trace_put_imu(TraceWriter *w, uint32_t timestamp_us, const int16_t *raw);
+int trace_put_button(TraceWriter *w, uint32_t timestamp_us, uint8_t button, uint8_t level);
+int trace_put_note(TraceWriter *w, uint32_t timestamp_us, const char *text);
+int trace_put_pressure(TraceWriter *w, uint32_t timestamp_us, int32_t pressure);
+
+// Returns -1 if the block is too short for its header
+int trace_reader_start(TraceReader *r, const uint8_t *block, uint16_t len);
+
+// Returns 1 with the next record, 0 at the end of the block, -1 if corrupt
+int trace_next(TraceReader *r, TraceRecord *rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,311 @@
+/*
+ * tscodec.c
+ *
+ *  Time series block encoder and decoder, see tscodec.h for the layout.
+ *
+ *  The encoder makes two passes over each channel: one to find the
+ *  residual widths of both modes, one to pack the chosen residuals. Both
+ *  are shifts, adds and ORs on 32 bit words, nothing is buffered but the
+ *  bit accumulator.
+ */
+
+#include <stddef.h>
+
+#include "tscodec.h"
+
+// The samples of one block, as 16 or 32 bit values
+typedef struct {
+    const int16_t *const *s16;
+    const int32_t *const *s32;
+} Series;
+
+typedef struct {
+    uint8_t *p;
+    uint32_t acc;
+    uint8_t bits;
+} BitWriter;
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t acc;
+    uint8_t bits;
+} BitReader;
+
+static uint32_t value(const Series *s, uint8_t i, uint8_t c) {
+    return s->s16 != NULL ? (uint32_t)(int32_t)s->s16[i][c] : (uint32_t)s->s32[i][c];
+}
+
+static uint32_t zigzag(uint32_t v) {
+    return (v << 1) ^ (uint32_t)((int32_t)v >> 31);
+}
+
+static uint32_t unzigzag(uint32_t v) {
+    return (v >> 1) ^ (0U - (v & 1));
+}
+
+// Bits needed for the largest of the values ORed into v
+static uint8_t width(uint32_t v) {
+    uint8_t n = 0;
+
+    while (v != 0) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static uint8_t varintLen(uint32_t v) {
+    uint8_t n = 1;
+
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static uint8_t *putVarint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static const uint8_t *getVarint(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+    uint32_t result = 0;
+    uint8_t shift = 0;
+
+    while (p < end && shift < 35) {
+        uint8_t b = *p++;
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return p;
+        }
+        shift += 7;
+    }
+    return NULL;
+}
+
+// Up to 32 bits; the accumulator never holds more than 7 bits between calls
+static void putBits(BitWriter *w, uint32_t v, uint8_t n) {
+    if (n > 24) {
+        putBits(w, v & 0xFFFF, 16);
+        v >>= 16;
+        n -= 16;
+    }
+    w->acc |= v << w->bits;
+    w->bits += n;
+    while (w->bits >= 8) {
+        *w->p++ = (uint8_t)w->acc;
+        w->acc >>= 8;
+        w->bits -= 8;
+    }
+}
+
+// mask is the low n bits; refills whole bytes, up to 64 bits at a time
+static uint32_t getBits(BitReader *r, uint8_t n, uint32_t mask) {
+    uint32_t v;
+
+    if (r->bits < n) {
+        while (r->bits <= 56 && r->p < r->end) {
+            r->acc |= (uint64_t)*r->p++ << r->bits;
+            r->bits += 8;
+        }
+    }
+    v = (uint32_t)r->acc & mask;
+    r->acc >>= n;
+    r->bits -= n;
+    return v;
+}
+
+static uint16_t residuals(uint8_t mode, uint8_t count) {
+    if (mode & TSCODEC_MODE_DOD) {
+        return count > 2 ? count - 2 : 0;
+    }
+    return count - 1;
+}
+
+static uint16_t encode(uint8_t *out, uint16_t size, const Series *s, uint8_t channels, uint8_t count) {
+    uint8_t modes[TSCODEC_MAX_CHANNELS];
+    uint8_t *p = out, *end = out + size;
+    uint32_t bits = 0;
+    BitWriter w;
+    uint8_t c, i;
+
+    if (channels == 0 || channels > TSCODEC_MAX_CHANNELS || count == 0 || size < TSCODEC_BLOCK_HDR) {
+        return 0;
+    }
+    *p++ = count;
+    *p++ = channels;
+
+    // Widths of both modes, the header of the cheaper one
+    for (c = 0; c < channels; c++) {
+        uint32_t first = value(s, 0, c);
+        uint32_t prev = first, delta = 0, first_delta = 0;
+        uint32_t orDelta = 0, orDod = 0;
+        uint32_t costDelta, costDod;
+        uint8_t wDelta, wDod;
+
+        if (end - p < 11) {     // mode, two varints at most
+            return 0;
+        }
+        for (i = 1; i < count; i++) {
+            uint32_t v = value(s, i, c);
+            uint32_t d = v - prev;
+
+            orDelta |= zigzag(d);
+            if (i == 1) {
+                first_delta = d;
+            } else {
+                orDod |= zigzag(d - delta);
+            }
+            delta = d;
+            prev = v;
+        }
+        wDelta = width(orDelta);
+        wDod = width(orDod);
+        costDelta = (uint32_t)(count - 1) * wDelta;
+        costDod = (uint32_t)residuals(TSCODEC_MODE_DOD, count) * wDod;
+
+        if (count > 2 && costDod + 8 * varintLen(zigzag(first_delta)) < costDelta) {
+            modes[c] = TSCODEC_MODE_DOD | wDod;
+            bits += costDod;
+            *p++ = modes[c];
+            p = putVarint(p, zigzag(first));
+            p = putVarint(p, zigzag(first_delta));
+        } else {
+            modes[c] = wDelta;
+            bits += costDelta;
+            *p++ = modes[c];
+            p = putVarint(p, zigzag(first));
+        }
+    }
+    if ((uint32_t)(p - out) + (bits + 7) / 8 > size) {
+        return 0;
+    }
+
+    w.p = p;
+    w.acc = 0;
+    w.bits = 0;
+    for (c = 0; c < channels; c++) {
+        uint8_t n = modes[c] & TSCODEC_WIDTH_MASK;
+        uint32_t prev, delta;
+
+        if (n == 0) {
+            continue;
+        }
+        prev = value(s, 0, c);
+        delta = 0;
+        for (i = 1; i < count; i++) {
+            uint32_t v = value(s, i, c);
+            uint32_t d = v - prev;
+
+            if (!(modes[c] & TSCODEC_MODE_DOD)) {
+                putBits(&w, zigzag(d), n);
+            } else if (i >= 2) {
+                putBits(&w, zigzag(d - delta), n);
+            }
+            delta = d;
+            prev = v;
+        }
+    }
+    if (w.bits > 0) {
+        *w.p++ = (uint8_t)w.acc;
+    }
+    return w.p - out;
+}
+
+uint16_t tscodec_encode16(uint8_t *out, uint16_t size, const int16_t *const *samples,
+                          uint8_t channels, uint8_t count) {
+    Series s = {samples, NULL};
+
+    return encode(out, size, &s, channels, count);
+}
+
+uint16_t tscodec_encode32(uint8_t *out, uint16_t size, const int32_t *const *samples,
+                          uint8_t channels, uint8_t count) {
+    Series s = {NULL, samples};
+
+    return encode(out, size, &s, channels, count);
+}
+
+int tscodec_peek(const uint8_t *in, uint16_t len, uint8_t *channels, uint8_t *count) {
+    if (len < TSCODEC_BLOCK_HDR || in[0] == 0 || in[1] == 0 || in[1] > TSCODEC_MAX_CHANNELS) {
+        return -1;
+    }
+    *count = in[0];
+    *channels = in[1];
+    return 0;
+}
+
+int16_t tscodec_decode(const uint8_t *in, uint16_t len, int32_t *out, uint16_t max) {
+    uint8_t modes[TSCODEC_MAX_CHANNELS];
+    uint32_t firsts[TSCODEC_MAX_CHANNELS];
+    uint32_t deltas[TSCODEC_MAX_CHANNELS];
+    const uint8_t *p = in + TSCODEC_BLOCK_HDR, *end = in + len;
+    uint8_t channels, count, c;
+    uint32_t bits = 0;
+    BitReader r;
+    uint16_t i;
+
+    if (tscodec_peek(in, len, &channels, &count) != 0 || (uint16_t)count * channels > max) {
+        return -1;
+    }
+    for (c = 0; c < channels; c++) {
+        if (p >= end) {
+            return -1;
+        }
+        modes[c] = *p++;
+        if ((modes[c] & TSCODEC_WIDTH_MASK) > 32 || (p = getVarint(p, end, &firsts[c])) == NULL) {
+            return -1;
+        }
+        firsts[c] = unzigzag(firsts[c]);
+        deltas[c] = 0;
+        if ((modes[c] & TSCODEC_MODE_DOD) && (p = getVarint(p, end, &deltas[c])) == NULL) {
+            return -1;
+        }
+        deltas[c] = unzigzag(deltas[c]);
+        bits += (uint32_t)residuals(modes[c], count) * (modes[c] & TSCODEC_WIDTH_MASK);
+    }
+    if ((uint32_t)(end - p) < (bits + 7) / 8) {
+        return -1;
+    }
+
+    r.p = p;
+    r.end = end;
+    r.acc = 0;
+    r.bits = 0;
+    for (c = 0; c < channels; c++) {
+        uint8_t n = modes[c] & TSCODEC_WIDTH_MASK;
+        uint32_t mask = n < 32 ? (1UL << n) - 1 : 0xFFFFFFFFUL;
+        uint32_t v = firsts[c];
+        int32_t *o = out + c;
+
+        *o = (int32_t)v;
+        o += channels;
+        if (modes[c] & TSCODEC_MODE_DOD) {
+            uint32_t delta = deltas[c];
+
+            if (count > 1) {
+                v += delta;
+                *o = (int32_t)v;
+                o += channels;
+            }
+            for (i = 2; i < count; i++, o += channels) {
+                delta += unzigzag(getBits(&r, n, mask));
+                v += delta;
+                *o = (int32_t)v;
+            }
+        } else {
+            for (i = 1; i < count; i++, o += channels) {
+                v += unzigzag(getBits(&r, n, mask));
+                *o = (int32_t)v;
+            }
+        }
+    }
+    return count;
+}
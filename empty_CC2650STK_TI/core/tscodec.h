@@ -0,0 +1,66 @@
+/*
+ * tscodec.h
+ *
+ *  Block compressor for sensor time series: a block is count samples of
+ *  the same channels, each channel coded on its own as a first value and
+ *  bit-packed residuals.
+ *
+ *  Block: count(1) channels(1) channel_header* residual_bits
+ *  Channel header: mode_width(1) first(varint) [delta(varint)]
+ *      mode_width  bit 7 set: delta-of-delta, clear: delta
+ *                  bits 5..0: residual width in bits, 0..32
+ *      first       the channel's first value
+ *      delta       delta-of-delta only, second value minus first
+ *  Residual bits: the residuals of channel 0, then channel 1 and so on,
+ *  each zigzag coded in width bits, least significant bit first, the last
+ *  byte padded with zeros. A delta channel has count - 1 residuals, the
+ *  differences to the previous value; a delta-of-delta channel count - 2,
+ *  the changes of that difference. Varints are zigzag coded, 7 bits a
+ *  byte, low group first.
+ *
+ *  The encoder picks the cheaper mode per channel and block: delta for
+ *  noisy axes, delta-of-delta for slow ramps like pressure or temperature.
+ *  A channel that does not change costs its header and no bits. Values
+ *  are 32 bits and differences wrap, so any int32 series round-trips.
+ *  Blocks are independent of each other, a lost one does not corrupt the
+ *  next.
+ *
+ *  Shared with the host tools (host/morsecap), keep it free of TI-RTOS
+ *  dependencies.
+ */
+
+#ifndef TSCODEC_H_
+#define TSCODEC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TSCODEC_MAX_CHANNELS    8
+#define TSCODEC_BLOCK_HDR       2
+#define TSCODEC_MODE_DOD        0x80
+#define TSCODEC_WIDTH_MASK      0x3F
+
+// Each encoder returns the block length, or 0 if it does not fit size
+// bytes (the buffer is then undefined). samples[i] points to the channels
+// values of sample i.
+uint16_t tscodec_encode16(uint8_t *out, uint16_t size, const int16_t *const *samples,
+                          uint8_t channels, uint8_t count);
+uint16_t tscodec_encode32(uint8_t *out, uint16_t size, const int32_t *const *samples,
+                          uint8_t channels, uint8_t count);
+
+// Reads the block header. Returns 0, or -1 if it is not a block.
+int tscodec_peek(const uint8_t *in, uint16_t len, uint8_t *channels, uint8_t *count);
+
+// Decodes a block into out, count * channels values sample after sample,
+// at most max values. Returns the number of samples, or -1 if the block is
+// corrupt or does not fit.
+int16_t tscodec_decode(const uint8_t *in, uint16_t len, int32_t *out, uint16_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TSCODEC_H_ */
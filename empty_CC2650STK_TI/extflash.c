@@ -0,0 +1,151 @@
+/*
+ * extflash.c
+ */
+
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/SPI.h>
+#include <driverlib/cpu.h>
+
+#include "Board.h"
+#include "extflash.h"
+
+#define CMD_WREN        0x06
+#define CMD_RDSR        0x05
+#define CMD_READ        0x03
+#define CMD_PP          0x02
+#define CMD_SE          0x20
+#define CMD_JEDEC_ID    0x9F
+#define CMD_RES         0xAB    // release from deep power-down
+
+#define STATUS_WIP      0x01
+
+#define MFG_MACRONIX    0xC2
+#define MFG_WINBOND     0xEF
+
+// tRES1 of the MX25R, 35 us; CPUdelay() takes 3 cycles per loop at 48 MHz
+#define WAKE_DELAY      560
+
+static SPI_Handle spi = NULL;
+static PIN_Handle csPin = NULL;
+static PIN_State csState;
+static uint32_t size = 0;
+
+static PIN_Config csConfig[] = {
+    Board_SPI_FLASH_CS | PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH | PIN_PUSHPULL | PIN_DRVSTR_MIN,
+    PIN_TERMINATE
+};
+
+// One command with the chip selected: the command bytes out, then len
+// bytes out of tx or into rx
+static int command(const uint8_t *cmd, uint8_t cmdLen, const void *tx, void *rx, uint16_t len) {
+    SPI_Transaction t;
+    bool ok;
+
+    PIN_setOutputValue(csPin, Board_SPI_FLASH_CS, Board_FLASH_CS_ON);
+    t.count = cmdLen;
+    t.txBuf = (void *)cmd;
+    t.rxBuf = NULL;
+    ok = SPI_transfer(spi, &t);
+    if (ok && len > 0) {
+        t.count = len;
+        t.txBuf = (void *)tx;
+        t.rxBuf = rx;
+        ok = SPI_transfer(spi, &t);
+    }
+    PIN_setOutputValue(csPin, Board_SPI_FLASH_CS, Board_FLASH_CS_OFF);
+    return ok ? 0 : -1;
+}
+
+static int addressed(uint8_t op, uint32_t addr, const void *tx, void *rx, uint16_t len) {
+    uint8_t cmd[4] = {op, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+
+    return command(cmd, sizeof(cmd), tx, rx, len);
+}
+
+static int writeEnable(void) {
+    uint8_t cmd = CMD_WREN;
+
+    return command(&cmd, 1, NULL, NULL, 0);
+}
+
+int extflash_open(void) {
+    SPI_Params params;
+    uint8_t cmd, id[3];
+
+    if (spi != NULL) {
+        return 0;
+    }
+    csPin = PIN_open(&csState, csConfig);
+    if (csPin == NULL) {
+        return -1;
+    }
+    SPI_Params_init(&params);
+    params.bitRate = EXTFLASH_BITRATE;
+    params.frameFormat = SPI_POL0_PHA0;
+    spi = SPI_open(Board_SPI0, &params);
+    if (spi == NULL) {
+        PIN_close(csPin);
+        csPin = NULL;
+        return -1;
+    }
+
+    cmd = CMD_RES;
+    command(&cmd, 1, NULL, NULL, 0);
+    CPUdelay(WAKE_DELAY);
+    cmd = CMD_JEDEC_ID;
+    if (command(&cmd, 1, NULL, id, sizeof(id)) != 0 || (id[0] != MFG_MACRONIX && id[0] != MFG_WINBOND)
+        || id[2] < 16 || id[2] > 24) {
+        SPI_close(spi);
+        PIN_close(csPin);
+        spi = NULL;
+        csPin = NULL;
+        return -1;
+    }
+    size = 1UL << id[2];
+    return 0;
+}
+
+uint32_t extflash_size(void) {
+    return size;
+}
+
+int extflash_busy(void) {
+    uint8_t cmd = CMD_RDSR, status;
+
+    if (command(&cmd, 1, NULL, &status, 1) != 0) {
+        return 0;
+    }
+    return (status & STATUS_WIP) != 0;
+}
+
+// Sleeps a millisecond at a time while an erase or program runs
+int extflash_read(uint32_t addr, void *buf, uint16_t len) {
+    while (extflash_busy()) {
+        Task_sleep(1000 / Clock_tickPeriod);
+    }
+    return addressed(CMD_READ, addr, NULL, buf, len);
+}
+
+int extflash_program(uint32_t addr, const void *buf, uint16_t len) {
+    if (writeEnable() != 0) {
+        return -1;
+    }
+    return addressed(CMD_PP, addr, buf, NULL, len);
+}
+
+int extflash_erase(uint32_t addr) {
+    if (writeEnable() != 0) {
+        return -1;
+    }
+    return addressed(CMD_SE, addr, NULL, NULL, 0);
+}
+
+const LogFlash extflash_log = {
+    extflash_read,
+    extflash_program,
+    extflash_erase,
+    extflash_busy,
+};
@@ -0,0 +1,38 @@
+/*
+ * extflash.h
+ *
+ *  The SensorTag's external SPI NOR flash on SPI0, a Macronix MX25R8035F
+ *  (1 MB) or on early boards a Winbond W25X40CL (512 KB); both take the
+ *  same commands. The chip select is driven by hand around the SPI
+ *  driver's transfers, which run on its DMA in blocking mode: a page
+ *  program is the command and up to 256 bytes in one burst.
+ *
+ *  Program and erase only start the chip, extflash_busy() polls its
+ *  status; a read waits for it to finish. extflash_log is the same as a
+ *  LogFlash (core/logstore.h). Task context only.
+ */
+
+#ifndef EXTFLASH_H_
+#define EXTFLASH_H_
+
+#include <stdint.h>
+
+#include "core/logstore.h"
+
+#define EXTFLASH_BITRATE    4000000
+
+// Opens SPI0, wakes the chip and reads its ID. Returns 0, or -1 if there
+// is no known flash.
+int extflash_open(void);
+
+// Bytes, 0 before extflash_open()
+uint32_t extflash_size(void);
+
+int extflash_read(uint32_t addr, void *buf, uint16_t len);
+int extflash_program(uint32_t addr, const void *buf, uint16_t len);
+int extflash_erase(uint32_t addr);
+int extflash_busy(void);
+
+extern const LogFlash extflash_log;
+
+#endif /* EXTFLASH_H_ */
@@ -0,0 +1,173 @@
+/*
+ * hal_tirtos.c
+ *
+ *  The core HAL (core/hal.h) on TI-RTOS. hal_uart_write() belongs to the
+ *  serial link in project_main.c, which opens and closes the UART driver.
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/pin/PINCC26XX.h>
+#include <ti/drivers/timer/GPTimerCC26XX.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+#include <inc/hw_cpu_scs.h>
+#include <driverlib/aon_rtc.h>
+
+#include "Board.h"
+#include "buzzer.h"
+#include "core/hal.h"
+#include "sensors/i2cbus.h"
+#include "standby.h"
+
+#define LED_PWM_PERIOD 48000    // 1 kHz from the 48 MHz system clock
+#define CYCLES_US 48            // system clock cycles a microsecond
+#define RTC_STEP_US 31          // 32768 Hz RTC period, rounded up
+
+static PIN_Handle ledHandle;
+static PIN_State ledState;
+static PIN_Config ledConfig[] = {
+    Board_LED0 | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MAX,
+    Board_BUZZER | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MAX,
+    PIN_TERMINATE
+};
+static uint16_t toneHz;
+static GPTimerCC26XX_Handle ledTimer;
+static uint8_t ledLevel;
+static uint32_t timeUs;         // the last hal_time_us()
+static uint32_t timeCycles;     // hal_cycles() at timeUs
+
+void hal_init(void) {
+    GPTimerCC26XX_Params params;
+
+    ledHandle = PIN_open(&ledState, ledConfig);
+    if (!ledHandle) {
+        System_abort("Error initializing LED pins\n");
+    }
+
+    GPTimerCC26XX_Params_init(&params);
+    params.width = GPT_CONFIG_16BIT;
+    params.mode = GPT_MODE_PWM;
+    params.debugStallMode = GPTimerCC26XX_DEBUG_STALL_OFF;
+    ledTimer = GPTimerCC26XX_open(Board_GPTIMER1A, &params);
+    if (ledTimer == NULL) {
+        System_abort("Error initializing the LED timer\n");
+    }
+    GPTimerCC26XX_setLoadValue(ledTimer, LED_PWM_PERIOD - 1);
+}
+
+// The RTC keeps time through standby but moves in 30.5 us steps, the
+// cycle counter resolves between them. It stops while the CPU sleeps, so
+// when it falls behind the RTC the time starts again from the RTC, and
+// it may not run more than a step ahead of it. An interval without sleep
+// in between is exact to the cycle, any other one to a step either way.
+uint32_t hal_time_us(void) {
+    uint32_t key = Hwi_disable();
+    uint64_t rtc = AONRTCCurrent64BitValueGet();
+    uint32_t rtcUs = (uint32_t)(rtc >> 32) * 1000000 + (uint32_t)(((rtc & 0xFFFFFFFF) * 1000000) >> 32);
+    uint32_t cycles = hal_cycles();
+    uint32_t elapsed = (cycles - timeCycles) / CYCLES_US;
+    uint32_t ahead = timeUs + elapsed - rtcUs;
+    uint32_t us;
+
+    if ((int32_t)ahead < 0) {
+        timeUs = rtcUs;
+        timeCycles = cycles;
+    } else if (ahead >= RTC_STEP_US) {
+        timeUs = rtcUs + RTC_STEP_US - 1;
+        timeCycles = cycles;
+    } else {
+        timeUs += elapsed;
+        timeCycles += elapsed * CYCLES_US;
+    }
+    us = timeUs;
+    Hwi_restore(key);
+    return us;
+}
+
+// The DWT cycle counter. The CPU domain loses it in standby, so it is
+// switched on again whenever it is found off.
+uint32_t hal_cycles(void) {
+    if (!(HWREG(CPU_DWT_BASE + CPU_DWT_O_CTRL) & CPU_DWT_CTRL_CYCCNTENA)) {
+        HWREG(CPU_SCS_BASE + CPU_SCS_O_DEMCR) |= CPU_SCS_DEMCR_TRCENA;
+        HWREG(CPU_DWT_BASE + CPU_DWT_O_CTRL) |= CPU_DWT_CTRL_CYCCNTENA;
+    }
+    return HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT);
+}
+
+uint32_t hal_lock(void) {
+    return Hwi_disable();
+}
+
+void hal_unlock(uint32_t key) {
+    Hwi_restore(key);
+}
+
+void hal_led_set(int on) {
+    hal_led_level(on ? 255 : 0);
+}
+
+int hal_led_get(void) {
+    return ledLevel != 0;
+}
+
+// Full on and off are plain GPIO, only the levels in between run the GPT1
+// PWM, which stops in standby and so holds it off while it dims
+void hal_led_level(uint8_t level) {
+    uint32_t key = Hwi_disable();
+    int dimmed = ledLevel != 0 && ledLevel != 255;
+
+    if (level == 0 || level == 255) {
+        PIN_setOutputValue(ledHandle, Board_LED0, level != 0);
+        if (dimmed) {
+            PINCC26XX_setMux(ledHandle, Board_LED0, IOC_PORT_GPIO);
+            GPTimerCC26XX_stop(ledTimer);
+            standby_release(STANDBY_LED);
+        }
+    } else {
+        // Counting down, the output is high from the load to the match
+        GPTimerCC26XX_setMatchValue(ledTimer, LED_PWM_PERIOD - (uint32_t)LED_PWM_PERIOD * level / 255);
+        if (!dimmed) {
+            standby_hold(STANDBY_LED);
+            GPTimerCC26XX_start(ledTimer);
+            PINCC26XX_setMux(ledHandle, Board_LED0, GPTimerCC26XX_getPinMux(ledTimer));
+        }
+    }
+    ledLevel = level;
+    Hwi_restore(key);
+}
+
+// GPT0 PWM, open only while it sounds so standby is held no longer
+void hal_tone(uint16_t hz) {
+    if (hz != 0 && hz < BUZZER_FREQ_MIN) {
+        hz = BUZZER_FREQ_MIN;
+    }
+    if (hz == toneHz) {
+        return;
+    }
+    if (hz == 0) {
+        buzzerClose();
+    } else {
+        if (toneHz == 0) {
+            buzzerOpen(ledHandle);
+        }
+        buzzerSetFrequency(hz);
+    }
+    toneHz = hz;
+}
+
+// Through the bus health layer, so core drivers get recovery too
+int hal_i2c_transfer(uint8_t address, const uint8_t *tx, uint16_t txLen, uint8_t *rx, uint16_t rxLen) {
+    I2C_Transaction t;
+
+    t.slaveAddress = address;
+    t.writeBuf = (uint8_t *)tx;
+    t.writeCount = txLen;
+    t.readBuf = rx;
+    t.readCount = rxLen;
+    return i2cbus_transfer(i2cbus_handle(), &t) ? 0 : -1;
+}
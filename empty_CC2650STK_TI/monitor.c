@@ -0,0 +1,144 @@
+/*
+ * monitor.c
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/Timestamp.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "monitor.h"
+
+volatile uint32_t monitorIrqCount[MONITOR_IRQ_COUNT];
+
+static MonitorStats stats;
+static uint32_t busy[MONITOR_STAGE_COUNT];  // timestamp counts in the current window
+static uint32_t windowStart;
+static Clock_Struct monitorClockStruct;
+
+volatile Bool monitorEventsOn = FALSE;
+static EvtraceRecord events[MONITOR_EVENTS];
+static uint32_t eventCount;     // ever recorded, the low bits index the ring
+
+static const uint8_t stageSources[MONITOR_STAGE_COUNT] = {
+    [MONITOR_STAGE_SENSOR] = EVTRACE_SRC_SENSOR,
+    [MONITOR_STAGE_APP] = EVTRACE_SRC_APP,
+    [MONITOR_STAGE_AUDIO] = EVTRACE_SRC_AUDIO,
+};
+
+static uint16_t perMille(uint32_t part, uint32_t total) {
+    if (total == 0) {
+        return 0;
+    }
+    return (uint16_t)((uint64_t)part * 1000 / total);
+}
+
+static void monitorClockFxn(UArg arg) {
+    uint32_t now = Timestamp_get32();
+    uint32_t window = now - windowStart;
+    uint32_t total = 0;
+    Hwi_StackInfo hwiStack;
+    Task_Stat taskStat;
+    UInt key;
+    uint8_t i;
+
+    key = Hwi_disable();
+    for (i = 0; i < MONITOR_STAGE_COUNT; i++) {
+        stats.load[i] = perMille(busy[i], window);
+        total += busy[i];
+        busy[i] = 0;
+    }
+    windowStart = now;
+    Hwi_restore(key);
+
+    stats.idle = total < window ? 1000 - perMille(total, window) : 0;
+
+    for (i = 0; i < stats.stackCount; i++) {
+        Task_stat(stats.stacks[i].task, &taskStat);
+        stats.stacks[i].size = taskStat.stackSize;
+        stats.stacks[i].used = taskStat.used;
+    }
+
+    Hwi_getStackInfo(&hwiStack, TRUE);
+    stats.hwiStackSize = hwiStack.hwiStackSize;
+    stats.hwiStackUsed = hwiStack.hwiStackPeak;
+
+    for (i = 0; i < MONITOR_IRQ_COUNT; i++) {
+        stats.irqs[i] = monitorIrqCount[i];
+    }
+}
+
+void monitor_init(void) {
+    Clock_Params clockParams;
+    windowStart = Timestamp_get32();
+
+    monitor_add_task(Task_getIdleTask(), "idle");
+
+    Clock_Params_init(&clockParams);
+    clockParams.period = MONITOR_PERIOD_MS * 1000 / Clock_tickPeriod;
+    clockParams.startFlag = TRUE;
+    Clock_construct(&monitorClockStruct, (Clock_FuncPtr)monitorClockFxn, clockParams.period, &clockParams);
+}
+
+void monitor_add_task(Task_Handle task, const char *name) {
+    if (task == NULL || stats.stackCount == MONITOR_MAX_STACKS) {
+        return;
+    }
+    stats.stacks[stats.stackCount].name = name;
+    stats.stacks[stats.stackCount].task = task;
+    stats.stackCount++;
+}
+
+uint32_t monitor_start(MonitorStage stage) {
+    monitor_event(EVTRACE_BEGIN, stageSources[stage], 0);
+    return Timestamp_get32();
+}
+
+void monitor_stop(MonitorStage stage, uint32_t start) {
+    uint32_t elapsed = Timestamp_get32() - start;
+    UInt key = Hwi_disable();
+
+    busy[stage] += elapsed;
+    Hwi_restore(key);
+    monitor_event(EVTRACE_END, stageSources[stage], 0);
+}
+
+const MonitorStats *monitor_stats(void) {
+    return &stats;
+}
+
+void monitor_event_put(uint16_t id, uint16_t arg) {
+    UInt key = Hwi_disable();
+    EvtraceRecord *r = &events[eventCount++ & (MONITOR_EVENTS - 1)];
+
+    r->time = Timestamp_get32();
+    r->id = id;
+    r->arg = arg;
+    Hwi_restore(key);
+}
+
+void monitor_events_enable(Bool on) {
+    UInt key = Hwi_disable();
+
+    if (on && !monitorEventsOn) {
+        eventCount = 0;
+    }
+    monitorEventsOn = on;
+    Hwi_restore(key);
+}
+
+uint16_t monitor_events_read(uint16_t first, EvtraceRecord *out, uint16_t max, uint16_t *total) {
+    UInt key = Hwi_disable();
+    uint32_t held = eventCount < MONITOR_EVENTS ? eventCount : MONITOR_EVENTS;
+    uint32_t oldest = eventCount - held;
+    uint16_t n = 0;
+
+    while (n < max && first + n < held) {
+        out[n] = events[(oldest + first + n) & (MONITOR_EVENTS - 1)];
+        n++;
+    }
+    Hwi_restore(key);
+    *total = held;
+    return n;
+}
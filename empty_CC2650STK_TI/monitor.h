@@ -0,0 +1,98 @@
+/*
+ * monitor.h
+ *
+ *  Runtime instrumentation: task stack high-water marks, per stage CPU
+ *  time and interrupt counts, refreshed once a second.
+ *
+ *  Stack usage comes from Task_stat() and Hwi_getStackInfo(), which scan
+ *  the stacks SYS/BIOS fills with a known pattern at creation. Busy time is
+ *  measured explicitly around each stage with the Timestamp provider; the
+ *  ROM kernel does not allow Task switch hooks. Idle is what is left of
+ *  the window, Hwi and Swi time is included in the stage that was running.
+ *
+ *  The event trace keeps the last MONITOR_EVENTS stage, interrupt, I2C
+ *  and UART begin/end records (core/evtrace.h) while it is on. Without
+ *  switch hooks the stages stand in for the tasks. A record is a call, a
+ *  Timestamp read and two stores with interrupts off, nothing at all while
+ *  the trace is off.
+ */
+
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include <stdint.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "core/evtrace.h"
+
+#define MONITOR_MAX_STACKS  4
+#define MONITOR_PERIOD_MS   1000
+#define MONITOR_EVENTS      128     // event trace ring, a power of two
+
+typedef enum {
+    MONITOR_STAGE_SENSOR = 0,
+    MONITOR_STAGE_APP,
+    MONITOR_STAGE_AUDIO,    // microphone blocks, in the app task or job
+    MONITOR_STAGE_COUNT
+} MonitorStage;
+
+typedef enum {
+    MONITOR_IRQ_BUTTON = 0,
+    MONITOR_IRQ_UART_RX,
+    MONITOR_IRQ_CLOCK,
+    MONITOR_IRQ_TIMER,      // GPTimer callbacks
+    MONITOR_IRQ_COUNT
+} MonitorIrq;
+
+typedef struct {
+    const char *name;
+    Task_Handle task;
+    uint32_t size;
+    uint32_t used;      // high-water mark
+} MonitorStack;
+
+typedef struct {
+    MonitorStack stacks[MONITOR_MAX_STACKS];
+    uint8_t stackCount;
+    uint32_t hwiStackSize;
+    uint32_t hwiStackUsed;
+    uint16_t load[MONITOR_STAGE_COUNT];     // per mille of the last window
+    uint16_t idle;                          // per mille of the last window
+    uint32_t irqs[MONITOR_IRQ_COUNT];
+} MonitorStats;
+
+extern volatile uint32_t monitorIrqCount[MONITOR_IRQ_COUNT];
+
+extern volatile Bool monitorEventsOn;
+
+#define monitor_irq(id) (monitorIrqCount[(id)]++)
+
+// One event trace record, phase EVTRACE_BEGIN or EVTRACE_END
+#define monitor_event(phase, source, arg) \
+    do { \
+        if (monitorEventsOn) { \
+            monitor_event_put((phase) | (source), (arg)); \
+        } \
+    } while (0)
+
+void monitor_init(void);
+void monitor_add_task(Task_Handle task, const char *name);
+
+// Brackets one run of a stage: t = monitor_start(stage); ... monitor_stop(stage, t);
+uint32_t monitor_start(MonitorStage stage);
+void monitor_stop(MonitorStage stage, uint32_t start);
+
+const MonitorStats *monitor_stats(void);
+
+void monitor_event_put(uint16_t id, uint16_t arg);
+
+// Turning the trace on starts it over
+void monitor_events_enable(Bool on);
+
+// Copies up to max records, oldest first, from position first of what the
+// ring holds. Returns the number copied, *total is what the ring holds.
+uint16_t monitor_events_read(uint16_t first, EvtraceRecord *out, uint16_t max, uint16_t *total);
+
+#endif /* MONITOR_H_ */
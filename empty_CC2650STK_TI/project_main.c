@@ -1,226 +1,1826 @@
-/* C Standard library */
-#include <stdio.h>
-#include <string.h>
-
-/* XDCtools files */
-#include <xdc/std.h>
-#include <xdc/runtime/System.h>
-
-/* BIOS Header files */
-#include <ti/sysbios/BIOS.h>
-#include <ti/sysbios/knl/Clock.h>
-#include <ti/sysbios/knl/Task.h>
-#include <ti/drivers/PIN.h>
-#include <ti/drivers/pin/PINCC26XX.h>
-#include <ti/drivers/I2C.h>
-#include <ti/drivers/Power.h>
-#include <ti/drivers/power/PowerCC26XX.h>
-#include <ti/drivers/UART.h>
-
-/* Board Header files */
-#include "Board.h"
-#include "sensors/opt3001.h"
-#include "sensors/mpu9250.h"
-
-// Task
-#define STACKSIZE 2048
-Char sensorTaskStack[STACKSIZE];
-Char uartTaskStack[STACKSIZE];
-
-// State machine states
-enum state { WAITING=1, DATA_READY, DOT, DASH, SPACE, SOS, MAYDAY };
-enum state programState = WAITING;
-
-// Global variables
-double ambientLight = -1000.0;
-float ax, ay, az, gx, gy, gz;
-UART_Handle uart;
-I2C_Handle i2c;
-
-// Button and LED configuration
-static PIN_Handle buttonHandle;
-static PIN_State buttonState;
-static PIN_Handle ledHandle;
-static PIN_State ledState;
-PIN_Config buttonConfig[] = {
-    Board_BUTTON0 | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
-    Board_BUTTON1 | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
-    PIN_TERMINATE
-};
-PIN_Config ledConfig[] = {
-    Board_LED0 | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MAX,
-    PIN_TERMINATE
-};
-
-static int buttonPressCount = 0;
-static Clock_Handle buttonClockHandle;
-static Clock_Struct buttonClockStruct;
-
-void buttonClockFxn(UArg arg) {
-    if (buttonPressCount == 1) {
-        programState = DOT;
-    } else if (buttonPressCount == 2) {
-        programState = DASH;
-    } else if (buttonPressCount == 3) {
-        programState = SPACE;
-    }
-    buttonPressCount = 0;
-}
-
-void buttonFxn(PIN_Handle handle, PIN_Id pinId) {
-    if (pinId == Board_BUTTON1) {
-        buttonPressCount++;
-        Clock_start(buttonClockHandle);
-    } else if (pinId == Board_BUTTON0) {
-        PIN_setOutputValue(ledHandle, Board_LED0, !PIN_getOutputValue(Board_LED0));
-    }
-}
-
-// Morse code mapping
-typedef struct {
-    char *code;
-    char letter;
-} MorseCode;
-
-MorseCode morseMap[] = {
-    {".-", 'A'}, {"-...", 'B'}, {"-.-.", 'C'}, {"-..", 'D'}, {".", 'E'},
-    {"..-.", 'F'}, {"--.", 'G'}, {"....", 'H'}, {"..", 'I'}, {".---", 'J'},
-    {"-.-", 'K'}, {".-..", 'L'}, {"--", 'M'}, {"-.", 'N'}, {"---", 'O'},
-    {".--.", 'P'}, {"--.-", 'Q'}, {".-.", 'R'}, {"...", 'S'}, {"-", 'T'},
-    {"..-", 'U'}, {"...-", 'V'}, {".--", 'W'}, {"-..-", 'X'}, {"-.--", 'Y'},
-    {"--..", 'Z'}, {"-----", '0'}, {".----", '1'}, {"..---", '2'}, {"...--", '3'},
-    {"....-", '4'}, {".....", '5'}, {"-....", '6'}, {"--...", '7'}, {"---..", '8'},
-    {"----.", '9'}, {NULL, '\0'}
-};
-
-char decodeMorse(char *morse) {
-    int i;
-    for (i = 0; morseMap[i].code != NULL; i++) {
-        if (strcmp(morseMap[i].code, morse) == 0) {
-            return morseMap[i].letter;
-        }
-    }
-    return '?'; // Unknown symbol
-}
-
-Void uartTaskFxn(UArg arg0, UArg arg1) {
-    UART_Params uartParams;
-    UART_Params_init(&uartParams);
-    uartParams.baudRate = 9600;
-    uart = UART_open(Board_UART0, &uartParams);
-    if (uart == NULL) {
-        System_abort("Error opening the UART");
-    }
-
-    while (1) {
-        if (programState == DOT) {
-            char symbol[3] = {'.', '\r', '\n'};
-            UART_write(uart, symbol, 3);
-            programState = WAITING;
-        } else if (programState == DASH) {
-            char symbol[3] = {'-', '\r', '\n'};
-            UART_write(uart, symbol, 3);
-            programState = WAITING;
-        } else if (programState == SPACE) {
-            char symbol[3] = {' ', '\r', '\n'};
-            UART_write(uart, symbol, 3);
-            programState = WAITING;
-        }
-
-        Task_sleep(100000 / Clock_tickPeriod); // Check every 100 ms
-    }
-}
-
-Void sensorTaskFxn(UArg arg0, UArg arg1) {
-    I2C_Params i2cParams;
-    I2C_Params_init(&i2cParams);
-    i2c = I2C_open(Board_I2C, &i2cParams);
-    if (i2c == NULL) {
-        System_abort("Error Initializing I2C\n");
-    }
-
-    mpu9250_setup(&i2c);
-
-    while (1) {
-        mpu9250_get_data(&i2c, &ax, &ay, &az, &gx, &gy, &gz);
-
-        if (ax > 1.0) {
-            programState = DOT;
-        } else if (ax < -1.0) {
-            programState = DASH;
-        } else if (az > 1.0) {
-            programState = SPACE;
-        } else {
-            programState = WAITING;
-        }
-
-        if (programState != WAITING) {
-            PIN_setOutputValue(ledHandle, Board_LED0, 1);  // LED on
-
-            char symbol[4];  // Buffer size 4 characters (symbol + CR + LF + null-terminator)
-
-            // Send UART message based on state
-            if (programState == DOT) {
-                snprintf(symbol, sizeof(symbol), ".\r\n"); // Dot
-                UART_write(uart, symbol, strlen(symbol));
-            } else if (programState == DASH) {
-                snprintf(symbol, sizeof(symbol), "-\r\n"); // Dash
-                UART_write(uart, symbol, strlen(symbol));
-            } else if (programState == SPACE) {
-                snprintf(symbol, sizeof(symbol), " \r\n"); // Space
-                UART_write(uart, symbol, strlen(symbol));
-            }
-
-            Task_sleep(500000 / Clock_tickPeriod);  // 500 ms delay
-            PIN_setOutputValue(ledHandle, Board_LED0, 0);  // LED off
-        }
-
-        System_printf("ax: %f, ay: %f, az: %f, gx: %f, gy: %f, gz: %f\n", ax, ay, az, gx, gy, gz);
-        System_flush();
-
-        Task_sleep(1000000 / Clock_tickPeriod);  // 1 second delay before next read
-    }
-}
-
-Int main(void) {
-    Task_Params sensorTaskParams;
-    Task_Params uartTaskParams;
-    Clock_Params clockParams;
-
-    Board_initGeneral();
-    I2C_init();
-    UART_init();
-
-    buttonHandle = PIN_open(&buttonState, buttonConfig);
-    if (!buttonHandle) {
-        System_abort("Error initializing button pins\n");
-    }
-    if (PIN_registerIntCb(buttonHandle, &buttonFxn) != 0) {
-        System_abort("Error registering button callback function");
-    }
-    ledHandle = PIN_open(&ledState, ledConfig);
-    if (!ledHandle) {
-        System_abort("Error initializing LED pins\n");
-    }
-
-    Clock_Params_init(&clockParams);
-    clockParams.period = 0;
-    clockParams.startFlag = FALSE;
-    Clock_construct(&buttonClockStruct, (Clock_FuncPtr)buttonClockFxn, 500000 / Clock_tickPeriod, &clockParams);
-    buttonClockHandle = Clock_handle(&buttonClockStruct);
-
-    Task_Params_init(&sensorTaskParams);
-    sensorTaskParams.stackSize = STACKSIZE;
-    sensorTaskParams.stack = &sensorTaskStack;
-    sensorTaskParams.priority = 2;
-    Task_create(sensorTaskFxn, &sensorTaskParams, NULL);
-
-    Task_Params_init(&uartTaskParams);
-    uartTaskParams.stackSize = STACKSIZE;
-    uartTaskParams.stack = &uartTaskStack;
-    uartTaskParams.priority = 2;
-    Task_create(uartTaskFxn, &uartTaskParams, NULL);
-
-    BIOS_start();
-    return 0;
-}
+/* C Standard library */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* XDCtools files */
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Timestamp.h>
+
+/* BIOS Header files */
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Mailbox.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/pin/PINCC26XX.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/SPI.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+#include <ti/drivers/UART.h>
+#include <ti/drivers/Watchdog.h>
+#include <ti/drivers/timer/GPTimerCC26XX.h>
+#include <ti/drivers/pdm/PDMCC26XX.h>
+
+/* Board Header files */
+#include "Board.h"
+#include "sensors/opt3001.h"
+#include "sensors/bmp280.h"
+#include "sensors/tmp007.h"
+#include "sensors/mpu9250.h"
+#include "sensors/i2cbus.h"
+#include "core/hal.h"
+#include "core/protocol.h"
+#include "core/command.h"
+#include "core/settings.h"
+#include "core/fsm.h"
+#include "core/keyer.h"
+#include "core/pool.h"
+#include "core/pipeline.h"
+#include "core/trace.h"
+#include "core/latency.h"
+#include "core/evtrace.h"
+#include "core/indicator.h"
+#include "core/audio.h"
+#include "core/logstore.h"
+#include "core/aggregate.h"
+#include "core/baro.h"
+#include "sched.h"
+#include "monitor.h"
+#include "standby.h"
+#include "supervisor.h"
+#include "extflash.h"
+
+// 1 = run the sensor, keying and output stages as run-to-completion jobs on
+// one task (sched.c), which saves a whole task stack. 0 = separate sensor
+// and UART tasks. The host build compiles both for its RAM report.
+#ifndef SINGLE_TASK
+#define SINGLE_TASK 0
+#endif
+
+// Task
+#define STACKSIZE 2048
+#if SINGLE_TASK
+Char mainTaskStack[STACKSIZE];
+
+enum job { JOB_SENSOR = 0, JOB_APP, JOB_COUNT };  // in priority order
+static Clock_Struct sensorClockStruct;
+static Clock_Handle sensorClockHandle;
+#else
+Char sensorTaskStack[STACKSIZE];
+Char uartTaskStack[STACKSIZE];
+#endif
+
+// Work for uartTaskFxn(), posted by the sensor task, the button clock, the
+// UART read callback, the PDM driver and the store clock. One queue keeps
+// everything in arrival order.
+enum msgType { MSG_EVENT = 1, MSG_RX_BYTE, MSG_UART_IDLE, MSG_UART_WAKE, MSG_PING, MSG_AUDIO, MSG_STORE,
+               MSG_ENV };
+typedef struct {
+    uint8_t type;
+    char value;  // FsmEvent or received byte
+    uint32_t posted_us;
+    uint32_t origin_us;  // the sample or click behind an event, see latency.h
+} AppMsg;
+
+#define MAILBOX_SIZE 32
+static Mailbox_Struct mailboxStruct;
+static Mailbox_Handle mailbox;
+static uint8_t mailboxBuffer[MAILBOX_SIZE * (sizeof(Mailbox_MbxElem) + sizeof(AppMsg))];
+static uint32_t mailboxDrops = 0;
+
+// Keying state machine, dispatched from uartTaskFxn() only
+static Fsm fsm;
+
+// Click grouping and gesture hold, shared by the button Hwi, the button
+// Clock and the sensor stage, so only under hal_lock()
+static Keyer keyer;
+
+// UART link
+#define UART_BAUDRATE 115200
+
+// Binary IMU streaming (see protocol.h), raw 6-axis samples at the full ODR
+#define IMU_PERIOD_US 5000  // 200 Hz, SMPLRT_DIV in initMPU9250()
+#define IMU_BATCH 10        // samples per PROTO_MSG_IMU_BATCH frame
+#define PACK_BATCH 25       // samples per block of the packed stream, 125 ms
+#define TELEMETRY_PERIOD_US 1000000
+
+// LED and buzzer feedback
+#define INDICATOR_TICKS_PER_US 48   // GPT2 runs from the 48 MHz system clock
+#define INDICATOR_WPM 15            // "morse" when echo_wpm is 0
+#define READY_FADE_MS 300
+
+// CW from the microphone (core/audio.h)
+#define AUDIO_PDM_BLOCK 64          // samples per PDM buffer, one hop
+#define AUDIO_BLOCK_US (AUDIO_PDM_BLOCK * 1000000 / AUDIO_RATE)
+
+// Log store (logstore.h) on the external flash, after the first 128 KB
+// that firmware images use. 384 KB fits the smaller W25X40CL as well.
+#define STORE_BASE 0x20000
+#define STORE_SECTORS 96
+#define STORE_POLL_MS 1             // flash busy, look again
+#define STORE_DUMP_MAX 20           // records per "log dump"
+
+// Global variables
+double ambientLight = -1000.0;
+UART_Handle uart;
+I2C_Handle i2c;
+static volatile Bool calibrateRequest = FALSE;
+
+// UART receive, bytes are posted to the mailbox by the read callback
+static uint8_t rxByte;
+static CommandShell shell;
+
+// Serializes UART_write() between the UART task and IMU streaming
+static Semaphore_Struct uartLockStruct;
+static Semaphore_Handle uartLock;
+
+// The link sleeps after settings.idle_ms without traffic: the driver is
+// closed, since its pending read keeps the device out of standby, and a
+// falling edge on RX opens it again. The byte that wakes it is lost.
+static volatile Bool uartAwake = FALSE;
+static PIN_Handle rxWakeHandle = NULL;
+static PIN_State rxWakeState;
+PIN_Config rxWakeConfig[] = {
+    Board_UART_RX | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
+    PIN_TERMINATE
+};
+static Clock_Handle uartIdleClockHandle;
+static Clock_Struct uartIdleClockStruct;
+
+// Stream statistics, reported in PROTO_MSG_TELEMETRY
+static uint32_t samplesRead = 0;
+static uint32_t framesSent = 0;
+static uint32_t txErrors = 0;
+
+// Button configuration, the LED is in hal_tirtos.c
+static PIN_Handle buttonHandle;
+static PIN_State buttonState;
+PIN_Config buttonConfig[] = {
+    Board_BUTTON0 | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
+    Board_BUTTON1 | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
+    PIN_TERMINATE
+};
+
+static Clock_Handle buttonClockHandle;
+static Clock_Struct buttonClockStruct;
+// One-shot, times the steps of the indicator patterns
+static GPTimerCC26XX_Handle indicatorTimer;
+
+// Microphone, open only while decoding. The driver fills buffers from the
+// audio pool class, the app stage decodes them in order.
+static PDMCC26XX_Handle pdm = NULL;
+static AudioDecoder audioDecoder;
+static volatile Bool audioPending = FALSE;
+static uint32_t audioStart_us;
+static uint32_t audioBlocks = 0;
+static uint32_t audioOverflows = 0;
+
+// Log store, worked in the app stage only. The sensor stage leaves an IMU
+// sample for the history under hal_lock().
+static LogStore store;
+static Bool storeOpen = FALSE;
+static Clock_Struct storeClockStruct;
+static Clock_Handle storeClockHandle;
+static char storeWord[LOGSTORE_MAX_PAYLOAD];
+static uint8_t storeWordLen = 0;
+static volatile Bool historyPending = FALSE;
+static int16_t historyRaw[PROTO_IMU_AXES];
+
+// Environmental summaries, added to by the sensor stage and sent by the
+// app stage, so only under hal_lock(). Pending bit 2 * channel + kind - 1
+// says envReport[channel][kind - 1] is waiting to be sent.
+static Aggregate env[PROTO_ENV_CHANNELS];
+static AggregateSummary envReport[PROTO_ENV_CHANNELS][2];
+static uint8_t envPending = 0;
+static uint32_t envDeadline = 0;    // ms
+static uint32_t envReadings = 0;
+static uint32_t envReportsSent = 0;
+static uint32_t envBytes = 0;
+static const char *const envNames[PROTO_ENV_CHANNELS] = {"light", "pressure", "air", "object"};
+
+// Altitude gestures, read and detected in the sensor stage, the detector
+// under hal_lock() for the shell
+static BaroDetector baro;
+static Bool baroFast = FALSE;       // the BMP280 runs at BMP280_CONFIG_FAST
+static int32_t baroPressure = 0;    // last reading, Pa << BARO_FRAC
+static uint32_t baroReads = 0;
+
+// Due times of the IMU and pressure reads in the sensor step, in us
+static uint32_t imuDeadline = 0;
+static uint32_t baroDeadline = 0;
+
+// Next sensor step in Clock ticks, see sensorWaitTicks()
+static uint32_t sensorDeadline = 0;
+
+// Samples held by the streamer until a batch is full
+static Sample *streamBatch[IMU_BATCH];
+static uint8_t streamCount = 0;
+
+// The packed stream copies its longer batches out of the pipeline rather
+// than holding that many sample buffers
+static int16_t packRaw[PACK_BATCH][PROTO_IMU_AXES];
+static uint32_t packTime = 0;
+static uint8_t packCount = 0;
+static uint32_t packSamples = 0;
+static uint32_t packBytes = 0;
+static uint32_t packCycles = 0;     // CPU cycles spent encoding
+
+// Trace recording (trace.h), written from the sensor stage, the button
+// Hwi and the shell, so only with interrupts disabled
+static uint8_t traceBlock[PROTO_MAX_PAYLOAD];
+static TraceWriter traceWriter;
+static Bool traceOpen = FALSE;
+static Bool traceConfigSent = FALSE;
+static uint32_t traceDrops = 0;
+
+// Callable from tasks, Swis and Hwis, never blocks
+static Bool postMessageFrom(uint8_t type, char value, uint32_t origin_us) {
+    AppMsg msg;
+
+    msg.type = type;
+    msg.value = value;
+    msg.posted_us = hal_time_us();
+    msg.origin_us = origin_us;
+    if (!Mailbox_post(mailbox, &msg, BIOS_NO_WAIT)) {
+        mailboxDrops++;
+        return FALSE;
+    }
+#if SINGLE_TASK
+    sched_post(JOB_APP);
+#endif
+    return TRUE;
+}
+
+Bool postMessage(uint8_t type, char value) {
+    return postMessageFrom(type, value, hal_time_us());
+}
+
+// A keying event caused by the sample or button click at origin_us
+void postEvent(int event, uint32_t origin_us) {
+    latency_record(LATENCY_DETECT, origin_us, hal_time_us());
+    postMessageFrom(MSG_EVENT, event, origin_us);
+}
+
+// Runs once the click timeout after the last press has passed
+void buttonClockFxn(UArg arg) {
+    uint32_t key, lastClick;
+    int event;
+
+    monitor_irq(MONITOR_IRQ_CLOCK);
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_BUTTON_CLOCK, 0);
+    key = hal_lock();
+    lastClick = keyer.clickDeadline - settings.click_ms * 1000;
+    event = keyer_expire(&keyer, hal_time_us());
+    hal_unlock(key);
+    if (event >= 0) {
+        postEvent(event, lastClick);
+    }
+    monitor_event(EVTRACE_END, EVTRACE_SRC_BUTTON_CLOCK, 0);
+}
+
+// Plays the indicator patterns (core/indicator.h), one step per timeout.
+// LED and buzzer change together here in the interrupt, no task or Clock
+// tick is involved. The timer stops in standby, so it is held off while a
+// pattern plays.
+void indicatorTimerFxn(GPTimerCC26XX_Handle handle, GPTimerCC26XX_IntMask mask) {
+    uint32_t key, delay;
+
+    monitor_irq(MONITOR_IRQ_TIMER);
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_INDICATOR, 0);
+    key = hal_lock();
+    delay = indicator_run();
+    if (delay > 0) {
+        GPTimerCC26XX_setLoadValue(indicatorTimer, delay * INDICATOR_TICKS_PER_US);
+        GPTimerCC26XX_start(indicatorTimer);
+    } else {
+        standby_release(STANDBY_INDICATOR);
+    }
+    hal_unlock(key);
+    monitor_event(EVTRACE_END, EVTRACE_SRC_INDICATOR, 0);
+}
+
+// Takes what an indicator_ pattern function returned, from any context
+void indicatorShow(int result) {
+    uint32_t key;
+
+    if (result == 1) {
+        key = hal_lock();
+        standby_hold(STANDBY_INDICATOR);
+        GPTimerCC26XX_setLoadValue(indicatorTimer, INDICATOR_TICKS_PER_US);
+        GPTimerCC26XX_start(indicatorTimer);
+        hal_unlock(key);
+    }
+}
+
+// Pitch and brightness from the settings for the patterns queued next
+void indicatorStyle(void) {
+    indicator_tone(settings.tone_hz);
+    indicator_level(settings.led_level);
+}
+
+// PDM driver callback. One MSG_AUDIO at a time is enough, audioDrain()
+// takes every block that is ready.
+void pdmFxn(PDMCC26XX_Handle handle, PDMCC26XX_StreamNotification *notification) {
+    if (notification->status == PDMCC26XX_STREAM_BLOCK_READY_BUT_PDM_OVERFLOW) {
+        audioOverflows++;
+    } else if (notification->status != PDMCC26XX_STREAM_BLOCK_READY) {
+        return;
+    }
+    if (!audioPending) {
+        audioPending = postMessage(MSG_AUDIO, 0);
+    }
+}
+
+// Sample times count from the start of the stream, a block lost to an
+// overflow shifts the ones after it
+void audioDrain(void) {
+    PDMCC26XX_BufferRequest request;
+    PDMCC26XX_BufferRelease release;
+
+    audioPending = FALSE;
+    while (pdm != NULL && PDMCC26XX_requestBuffer(pdm, &request)) {
+        audio_process(&audioDecoder, request.buffer->pBuffer, AUDIO_PDM_BLOCK,
+                      audioStart_us + audioBlocks * AUDIO_BLOCK_US);
+        audioBlocks++;
+        release.bufferHandle = request.buffer;
+        PDMCC26XX_releaseBuffer(pdm, &release);
+    }
+}
+
+static void *pdmAlloc(size_t size) {
+    return pool_alloc(size);
+}
+
+static void pdmFree(void *block, size_t size) {
+    pool_free(block);
+}
+
+// Decoded marks and spaces go through postEvent() like the button's
+Bool audioStart(void) {
+    PDMCC26XX_Params params;
+
+    if (pdm != NULL) {
+        return TRUE;
+    }
+    PDMCC26XX_Params_init(&params);
+    params.callbackFxn = pdmFxn;
+    params.micGain = PDMCC26XX_GAIN_18;
+    params.applyCompression = false;
+    params.retBufSizeInBytes = AUDIO_PDM_BLOCK * sizeof(int16_t) + sizeof(PDMCC26XX_metaData);
+    params.mallocFxn = pdmAlloc;
+    params.freeFxn = pdmFree;
+    pdm = PDMCC26XX_open(&params);
+    if (pdm == NULL) {
+        return FALSE;
+    }
+    audio_init(&audioDecoder, postEvent);
+    audioBlocks = 0;
+    audioOverflows = 0;
+    audioStart_us = hal_time_us();
+    if (!PDMCC26XX_startStream(pdm)) {
+        PDMCC26XX_close(pdm);
+        pdm = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void audioStop(void) {
+    if (pdm != NULL) {
+        PDMCC26XX_stopStream(pdm);
+        PDMCC26XX_close(pdm);
+        pdm = NULL;
+    }
+}
+
+void traceButton(uint8_t button, uint8_t level);
+
+void buttonFxn(PIN_Handle handle, PIN_Id pinId) {
+    uint32_t key;
+
+    monitor_irq(MONITOR_IRQ_BUTTON);
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_BUTTON, 0);
+    traceButton(pinId == Board_BUTTON1, 0);
+    if (pinId == Board_BUTTON1) {
+        key = hal_lock();
+        keyer_click(&keyer, hal_time_us(), settings.click_ms * 1000);
+        hal_unlock(key);
+        Clock_stop(buttonClockHandle);
+        Clock_setTimeout(buttonClockHandle, (settings.click_ms * 1000 + HAL_TIME_SKEW_US) / Clock_tickPeriod + 1);
+        Clock_start(buttonClockHandle);
+    } else if (pinId == Board_BUTTON0) {
+        hal_led_set(!hal_led_get());
+    }
+    monitor_event(EVTRACE_END, EVTRACE_SRC_BUTTON, 0);
+}
+
+void uartIdleClockFxn(UArg arg) {
+    monitor_irq(MONITOR_IRQ_CLOCK);
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_IDLE_CLOCK, 0);
+    postMessage(MSG_UART_IDLE, 0);
+    monitor_event(EVTRACE_END, EVTRACE_SRC_IDLE_CLOCK, 0);
+}
+
+void rxWakeFxn(PIN_Handle handle, PIN_Id pinId) {
+    monitor_irq(MONITOR_IRQ_UART_RX);
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_UART_RX, 0);
+    postMessage(MSG_UART_WAKE, 0);
+    monitor_event(EVTRACE_END, EVTRACE_SRC_UART_RX, 0);
+}
+
+void uartIdleRestart(void) {
+    Clock_stop(uartIdleClockHandle);
+    if (settings.idle_ms > 0) {
+        Clock_setTimeout(uartIdleClockHandle, settings.idle_ms * (1000 / Clock_tickPeriod));
+        Clock_start(uartIdleClockHandle);
+    }
+}
+
+void uartReadFxn(UART_Handle handle, void *buf, size_t count);
+
+// Opens the link if it sleeps and restarts the idle timeout, uartLock held
+static void uartWakeLocked(void) {
+    UART_Params uartParams;
+
+    if (!uartAwake) {
+        if (rxWakeHandle != NULL) {
+            PIN_close(rxWakeHandle);
+            rxWakeHandle = NULL;
+        }
+
+        UART_Params_init(&uartParams);
+        uartParams.baudRate = UART_BAUDRATE;
+        uartParams.readMode = UART_MODE_CALLBACK;
+        uartParams.readCallback = uartReadFxn;
+        uartParams.readDataMode = UART_DATA_BINARY;
+        uartParams.readEcho = UART_ECHO_OFF;
+        uart = UART_open(Board_UART0, &uartParams);
+        if (uart == NULL) {
+            System_abort("Error opening the UART");
+        }
+
+        standby_hold(STANDBY_UART);
+        uartAwake = TRUE;
+        UART_read(uart, &rxByte, 1);
+    }
+    uartIdleRestart();
+}
+
+void uartWake(void) {
+    Semaphore_pend(uartLock, BIOS_WAIT_FOREVER);
+    uartWakeLocked();
+    Semaphore_post(uartLock);
+}
+
+// Never while streaming, the host may just be listening
+void uartSleep(void) {
+    Semaphore_pend(uartLock, BIOS_WAIT_FOREVER);
+    if (uartAwake && settings.idle_ms > 0 && !settings.stream) {
+        uartAwake = FALSE;  // before UART_close(), the cancelled read must not rearm
+        UART_close(uart);
+        uart = NULL;
+        standby_release(STANDBY_UART);
+
+        rxWakeHandle = PIN_open(&rxWakeState, rxWakeConfig);
+        if (!rxWakeHandle || PIN_registerIntCb(rxWakeHandle, &rxWakeFxn) != 0) {
+            System_abort("Error registering the UART wake pin");
+        }
+    } else if (uartAwake) {
+        uartIdleRestart();
+    }
+    Semaphore_post(uartLock);
+}
+
+// The HAL serial output (core/hal.h)
+int hal_uart_write(const void *buf, uint16_t len) {
+    int n;
+
+    Semaphore_pend(uartLock, BIOS_WAIT_FOREVER);
+    uartWakeLocked();
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_UART_TX, len);
+    n = UART_write(uart, buf, len);
+    monitor_event(EVTRACE_END, EVTRACE_SRC_UART_TX, len);
+    Semaphore_post(uartLock);
+    return n;
+}
+
+// Frames are built in a pool block rather than on the caller's stack
+void sendFrame(uint8_t type, const uint8_t *payload, uint16_t len) {
+    uint8_t *frame = pool_alloc(PROTO_MAX_FRAME);
+    uint16_t n;
+
+    if (frame == NULL) {
+        txErrors++;
+        return;
+    }
+    n = protocol_build_frame(type, payload, len, frame);
+    if (n > 0 && hal_uart_write(frame, n) == n) {
+        framesSent++;
+    } else {
+        txErrors++;
+    }
+    pool_free(frame);
+}
+
+uint32_t storeNow(void) {
+    return (uint64_t)Clock_getTicks() * Clock_tickPeriod / 1000;
+}
+
+void storeClockFxn(UArg arg) {
+    postMessage(MSG_STORE, 0);
+}
+
+// Programs what the store has sealed. The flash is never waited for, the
+// store clock looks again while it is busy.
+void storeWork(void) {
+    if (storeOpen && logstore_work(&store) == LOGSTORE_BUSY) {
+        Clock_start(storeClockHandle);
+    }
+}
+
+void storeAppend(uint8_t type, const void *payload, uint8_t len) {
+    if (storeOpen && logstore_append(&store, type, payload, len, storeNow()) > 0) {
+        storeWork();
+    }
+}
+
+// Made durable right away, unlike the history records that fill pages
+void storeCommit(void) {
+    if (storeOpen && logstore_commit(&store) > 0) {
+        storeWork();
+    }
+}
+
+// Decoded text goes in a word at a time
+void storeText(char c) {
+    Bool end = c == ' ' || c == '\n';
+
+    if (!end && storeWordLen < sizeof(storeWord)) {
+        storeWord[storeWordLen++] = c;
+    }
+    if ((end || storeWordLen == sizeof(storeWord)) && storeWordLen > 0) {
+        storeAppend(LOGSTORE_REC_TEXT, storeWord, storeWordLen);
+        storeWordLen = 0;
+        storeCommit();
+    }
+}
+
+void handleStore(void) {
+    int16_t raw[PROTO_IMU_AXES];
+    uint32_t key;
+
+    if (historyPending) {
+        key = hal_lock();
+        memcpy(raw, historyRaw, sizeof(raw));
+        historyPending = FALSE;
+        hal_unlock(key);
+        storeAppend(LOGSTORE_REC_IMU, raw, sizeof(raw));
+    }
+    storeWork();
+}
+
+void storeSetup(void) {
+    uint8_t cause = supervisor_last()->cause;
+
+    if (extflash_open() != 0 || logstore_mount(&store, &extflash_log, STORE_BASE, STORE_SECTORS, storeNow()) != 0) {
+        System_printf("No log store on the external flash\n");
+        System_flush();
+        return;
+    }
+    storeOpen = TRUE;
+    storeAppend(LOGSTORE_REC_BOOT, &cause, 1);
+    storeCommit();
+}
+
+// Symbols go out as a "<symbol>\r\n" line, or as a frame while streaming
+void sendSymbol(char symbol) {
+    if (settings.stream) {
+        sendFrame(PROTO_MSG_SYMBOL, (uint8_t *)&symbol, 1);
+    } else {
+        char line[3] = {symbol, '\r', '\n'};
+        hal_uart_write(line, 3);
+    }
+}
+
+// Decoded letters are only sent while streaming, the plain text link
+// keeps its one-symbol-per-line format. The indicator can echo them.
+void sendText(char c) {
+    char text[2] = {c, '\0'};
+
+    storeText(c);
+    if (settings.echo_wpm > 0) {
+        indicatorStyle();
+        indicatorShow(indicator_text(text, 1200 / settings.echo_wpm));
+    }
+    if (settings.stream) {
+        sendFrame(PROTO_MSG_TEXT, (uint8_t *)&c, 1);
+    }
+}
+
+void sendTelemetry(void) {
+    uint8_t payload[PROTO_TELEMETRY_LEN];
+    uint32_t uptime = (uint64_t)Clock_getTicks() * Clock_tickPeriod / 1000;
+
+    protocol_pack_telemetry(payload, uptime, samplesRead, framesSent, txErrors);
+    sendFrame(PROTO_MSG_TELEMETRY, payload, PROTO_TELEMETRY_LEN);
+}
+
+// One environmental report, a PROTO_MSG_ENV frame while streaming or else
+// a text line: "env <channel> <value>" for a change, the statistics for a
+// summary
+void sendEnv(uint8_t channel, uint8_t kind, const AggregateSummary *s) {
+    uint8_t payload[PROTO_ENV_LEN];
+    char line[96];      // a summary of 8-letter channel and widest values is 86
+    int n;
+
+    if (settings.stream) {
+        n = protocol_pack_env(payload, channel, kind, s);
+        sendFrame(PROTO_MSG_ENV, payload, n);
+    } else {
+        if (kind == PROTO_ENV_CHANGE) {
+            n = snprintf(line, sizeof(line), "env %s %ld\r\n", envNames[channel], (long)s->mean);
+        } else {
+            n = snprintf(line, sizeof(line), "env %s n=%u min=%ld max=%ld mean=%ld var=%lu\r\n",
+                         envNames[channel], s->count, (long)s->min, (long)s->max, (long)s->mean,
+                         (unsigned long)s->variance);
+        }
+        if (n < 0) {
+            return;
+        }
+        if (n >= (int)sizeof(line)) {
+            n = sizeof(line) - 1;   // cut short, still never past the buffer
+        }
+        n = hal_uart_write(line, n);
+        if (n < 0) {
+            return;
+        }
+    }
+    envReportsSent++;
+    envBytes += n;
+}
+
+void handleEnv(void) {
+    AggregateSummary report;
+    uint8_t bit;
+    uint32_t key;
+
+    for (bit = 0; bit < 2 * PROTO_ENV_CHANNELS; bit++) {
+        key = hal_lock();
+        if (!(envPending & (1 << bit))) {
+            hal_unlock(key);
+            continue;
+        }
+        envPending &= ~(1 << bit);
+        report = envReport[bit / 2][bit % 2];
+        hal_unlock(key);
+        sendEnv(bit / 2, bit % 2 + 1, &report);
+    }
+}
+
+// Sends the packed batch in as few frames as it fits: the whole block
+// while the axes are quiet, halves of it and so on while they move
+void sendPacked(void) {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    const int16_t *raw[PACK_BATCH];
+    uint32_t start;
+    uint16_t len;
+    uint8_t first = 0, n, i;
+
+    for (i = 0; i < packCount; i++) {
+        raw[i] = packRaw[i];
+    }
+    while (first < packCount) {
+        n = packCount - first;
+        start = hal_cycles();
+        while ((len = protocol_pack_imu_packed(payload, packTime + (uint32_t)first * IMU_PERIOD_US,
+                                               IMU_PERIOD_US, &raw[first], n)) == 0) {
+            n = (n + 1) / 2;
+        }
+        packCycles += hal_cycles() - start;
+        packBytes += len;
+        sendFrame(PROTO_MSG_IMU_PACKED, payload, len);
+        first += n;
+    }
+    packSamples += packCount;
+    packCount = 0;
+}
+
+static void releaseBatch(void) {
+    uint8_t i;
+
+    for (i = 0; i < streamCount; i++) {
+        pipeline_release(streamBatch[i]);
+    }
+    streamCount = 0;
+}
+
+// Streamer subscriber, keeps references until a batch is full and sends
+// it as a single frame straight from the sample buffers. The packed stream
+// copies the samples instead, its batches are longer. The trace carries
+// the samples while it is recording.
+void streamSample(Sample *sample) {
+    static uint32_t telemetryTick = 0;
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    const int16_t *raw[IMU_BATCH];
+    uint16_t len;
+    uint8_t i;
+
+    if (!settings.stream || settings.trace) {
+        releaseBatch();
+        packCount = 0;
+        return;
+    }
+
+    if (settings.stream == STREAM_PACKED) {
+        releaseBatch();
+        if (packCount == 0) {
+            packTime = sample->timestamp_us;
+        }
+        memcpy(packRaw[packCount], sample->raw, sizeof(packRaw[0]));
+        if (++packCount < PACK_BATCH) {
+            return;
+        }
+        sendPacked();
+    } else {
+        packCount = 0;
+        pipeline_retain(sample);
+        streamBatch[streamCount] = sample;
+        if (++streamCount < IMU_BATCH) {
+            return;
+        }
+
+        for (i = 0; i < IMU_BATCH; i++) {
+            raw[i] = streamBatch[i]->raw;
+        }
+        len = protocol_pack_imu_batch(payload, streamBatch[0]->timestamp_us, IMU_PERIOD_US, raw, IMU_BATCH);
+        releaseBatch();
+        sendFrame(PROTO_MSG_IMU_BATCH, payload, len);
+    }
+
+    if ((int32_t)(Clock_getTicks() - telemetryTick) >= 0) {
+        sendTelemetry();
+        telemetryTick = Clock_getTicks() + TELEMETRY_PERIOD_US / Clock_tickPeriod;
+    }
+}
+
+static Bool tracing(void) {
+    return settings.trace && settings.stream;
+}
+
+static void traceStartLocked(uint32_t timestamp_us) {
+    TraceConfig config;
+    float accelRes, gyroRes, gyro[3], accel[3];
+    uint8_t i;
+
+    trace_writer_start(&traceWriter, traceBlock, sizeof(traceBlock), timestamp_us);
+    traceOpen = TRUE;
+
+    if (!traceConfigSent) {
+        mpu9250_get_scale(&accelRes, &gyroRes);
+        mpu9250_get_bias(gyro, accel);
+        config.version = TRACE_VERSION;
+        config.period_us = IMU_PERIOD_US;
+        config.accel_ng = accelRes * 1e9f;
+        config.gyro_udps = gyroRes * 1e6f;
+        for (i = 0; i < 3; i++) {
+            config.accel_bias_mg[i] = accel[i] * 1000.0f;
+        }
+        trace_put_config(&traceWriter, timestamp_us, &config);
+        traceConfigSent = TRUE;
+    }
+}
+
+// Closes the current block and copies it out, returns its length
+static uint16_t traceTakeLocked(uint8_t *out) {
+    uint16_t len = traceWriter.len;
+
+    memcpy(out, traceBlock, len);
+    traceOpen = FALSE;
+    return len;
+}
+
+// Callable from any context
+void traceButton(uint8_t button, uint8_t level) {
+    UInt key;
+
+    if (!tracing()) {
+        return;
+    }
+    key = Hwi_disable();
+    if (!traceOpen) {
+        traceStartLocked(hal_time_us());
+    }
+    if (trace_put_button(&traceWriter, hal_time_us(), button, level) != 0) {
+        traceDrops++;
+    }
+    Hwi_restore(key);
+}
+
+void traceNote(const char *text) {
+    UInt key;
+
+    if (!tracing()) {
+        return;
+    }
+    key = Hwi_disable();
+    if (!traceOpen) {
+        traceStartLocked(hal_time_us());
+    }
+    if (trace_put_note(&traceWriter, hal_time_us(), text) != 0) {
+        traceDrops++;
+    }
+    Hwi_restore(key);
+}
+
+// From the sensor stage, like the IMU records
+void tracePressure(uint32_t timestamp_us, int32_t pressure) {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    uint16_t len = 0;
+    UInt key;
+
+    if (!tracing()) {
+        return;
+    }
+    key = Hwi_disable();
+    if (!traceOpen) {
+        traceStartLocked(timestamp_us);
+    }
+    if (trace_put_pressure(&traceWriter, timestamp_us, pressure) != 0) {
+        traceDrops++;
+    }
+    if (traceWriter.len > sizeof(traceBlock) - TRACE_MAX_RECORD) {
+        len = traceTakeLocked(payload);
+    }
+    Hwi_restore(key);
+
+    if (len > TRACE_BLOCK_HEADER_LEN) {
+        sendFrame(PROTO_MSG_TRACE, payload, len);
+    }
+}
+
+// Trace subscriber, a block goes out once the next record might not fit.
+// When tracing stops the rest is sent and the next session starts with a
+// new config record.
+void traceSample(Sample *sample) {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    uint16_t len = 0;
+    UInt key = Hwi_disable();
+
+    if (!tracing()) {
+        if (traceOpen) {
+            len = traceTakeLocked(payload);
+        }
+        traceConfigSent = FALSE;
+    } else {
+        if (!traceOpen) {
+            traceStartLocked(sample->timestamp_us);
+        }
+        if (trace_put_imu(&traceWriter, sample->timestamp_us, sample->raw) != 0) {
+            traceDrops++;
+        }
+        if (traceWriter.len > sizeof(traceBlock) - TRACE_MAX_RECORD) {
+            len = traceTakeLocked(payload);
+        }
+    }
+    Hwi_restore(key);
+
+    if (len > TRACE_BLOCK_HEADER_LEN) {
+        sendFrame(PROTO_MSG_TRACE, payload, len);
+    }
+}
+
+// Classifier subscriber, a tilt past the threshold becomes a keying event.
+// The LED stays on for the hold time, no new symbol is keyed meanwhile.
+void classifySample(Sample *sample) {
+    float value[3];
+    uint32_t key, start;
+    int event;
+
+    if (settings.stream) {
+        return;
+    }
+
+    start = hal_time_us();
+    mpu9250_convert_accel(sample->raw, value);
+    key = hal_lock();
+    event = keyer_tilt(&keyer, sample->timestamp_us, value, settings.tilt_mg, settings.hold_ms * 1000);
+    hal_unlock(key);
+    latency_record(LATENCY_CLASSIFY, start, hal_time_us());
+
+    if (event >= 0) {
+        indicatorStyle();
+        indicatorShow(indicator_flash(settings.hold_ms));
+        postEvent(event, sample->timestamp_us);
+    }
+}
+
+// Logger subscriber: a sample every log_ms to the history in the store,
+// console output at the slow sample rate only
+void logSample(Sample *sample) {
+    static uint32_t historyLast_us = 0;
+    float v[PROTO_IMU_AXES];
+    uint32_t key;
+
+    if (storeOpen && settings.log_ms > 0 && !historyPending
+        && sample->timestamp_us - historyLast_us >= (uint32_t)settings.log_ms * 1000) {
+        historyLast_us = sample->timestamp_us;
+        key = hal_lock();
+        memcpy(historyRaw, sample->raw, sizeof(historyRaw));
+        historyPending = TRUE;
+        hal_unlock(key);
+        postMessage(MSG_STORE, 0);
+    }
+    if (settings.stream) {
+        return;
+    }
+    mpu9250_convert(sample->raw, v);
+    System_printf("ax: %f, ay: %f, az: %f, gx: %f, gy: %f, gz: %f\n", v[0], v[1], v[2], v[3], v[4], v[5]);
+    System_flush();
+}
+
+// Shell replies are plain text lines, or PROTO_MSG_REPLY frames while streaming
+void shellWrite(const char *text, uint16_t len) {
+    if (settings.stream) {
+        sendFrame(PROTO_MSG_REPLY, (const uint8_t *)text, len);
+    } else {
+        hal_uart_write(text, len);
+    }
+}
+
+void cmdGet(CommandShell *sh, int argc, char **argv) {
+    const SettingsParam *param = settings_find(argv[1]);
+
+    if (param == NULL) {
+        command_print(sh, "ERR unknown parameter\r\n");
+        return;
+    }
+    command_printf(sh, "%s=%ld\r\n", param->name, (long)*param->value);
+}
+
+void cmdSet(CommandShell *sh, int argc, char **argv) {
+    const SettingsParam *param = settings_find(argv[1]);
+    int32_t value;
+
+    if (param == NULL) {
+        command_print(sh, "ERR unknown parameter\r\n");
+    } else if (command_parse_int(argv[2], &value) != 0 || settings_set(param, value) != 0) {
+        command_printf(sh, "ERR range %ld..%ld\r\n", (long)param->min, (long)param->max);
+    } else {
+        command_print(sh, "OK\r\n");
+    }
+}
+
+void cmdParams(CommandShell *sh, int argc, char **argv) {
+    uint8_t i;
+
+    for (i = 0; i < settingsParamCount; i++) {
+        command_printf(sh, "%s=%ld\r\n", settingsParams[i].name, (long)*settingsParams[i].value);
+    }
+}
+
+void cmdStream(CommandShell *sh, int argc, char **argv) {
+    if (strcmp(argv[1], "on") == 0 || strcmp(argv[1], "packed") == 0) {
+        command_print(sh, "OK\r\n");  // last plain text reply
+        settings.stream = strcmp(argv[1], "on") == 0 ? STREAM_RAW : STREAM_PACKED;
+    } else if (strcmp(argv[1], "off") == 0) {
+        settings.stream = STREAM_OFF;
+        command_print(sh, "OK\r\n");
+    } else {
+        command_print(sh, "ERR on|packed|off\r\n");
+    }
+}
+
+void cmdCal(CommandShell *sh, int argc, char **argv) {
+    calibrateRequest = TRUE;
+    command_print(sh, "OK calibrating, keep the device still\r\n");
+}
+
+void cmdStats(CommandShell *sh, int argc, char **argv) {
+    command_printf(sh, "samples=%lu frames=%lu tx_errors=%lu\r\n",
+                   (unsigned long)samplesRead, (unsigned long)framesSent, (unsigned long)txErrors);
+    command_printf(sh, "published=%lu sample_drops=%lu\r\n",
+                   (unsigned long)pipeline_stats()->published, (unsigned long)pipeline_stats()->drops);
+    command_printf(sh, "commands=%lu cmd_errors=%lu mailbox_drops=%lu\r\n",
+                   (unsigned long)sh->lines, (unsigned long)sh->errors, (unsigned long)mailboxDrops);
+    command_printf(sh, "fsm=%s rejected=%lu\r\n",
+                   fsmStates[fsm.state].name, (unsigned long)fsm.rejected);
+    if (packSamples > 0) {
+        command_printf(sh, "packed=%lu bytes=%lu cycles/sample=%lu\r\n", (unsigned long)packSamples,
+                       (unsigned long)packBytes, (unsigned long)(packCycles / packSamples));
+    }
+}
+
+// Without an argument one line per stage, with a stage name its buckets as
+// "<from_us> <count>" lines for plotting on the host
+void cmdLatency(CommandShell *sh, int argc, char **argv) {
+    LatencyHistogram h;
+    uint8_t i;
+
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        latency_reset();
+        command_print(sh, "OK\r\n");
+        return;
+    }
+    for (i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        if (argc == 2 && strcmp(argv[1], latencyStageNames[i]) == 0) {
+            break;
+        }
+    }
+    if (argc == 2 && i == LATENCY_STAGE_COUNT) {
+        command_print(sh, "ERR stage or reset\r\n");
+        return;
+    }
+
+    if (argc == 2) {
+        latency_snapshot((LatencyStage)i, &h);
+        for (i = 0; i < LATENCY_BUCKETS; i++) {
+            if (h.buckets[i] > 0) {
+                command_printf(sh, "%lu %lu\r\n", (unsigned long)latency_bucket_floor(i),
+                               (unsigned long)h.buckets[i]);
+            }
+        }
+        return;
+    }
+    for (i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        latency_snapshot((LatencyStage)i, &h);
+        command_printf(sh, "%-8s n=%lu avg=%lu min=%lu", latencyStageNames[i], (unsigned long)h.count,
+                       (unsigned long)(h.count ? h.sum_us / h.count : 0), (unsigned long)h.min_us);
+        command_printf(sh, " p50<=%lu p99<=%lu max=%lu us\r\n", (unsigned long)latency_percentile(&h, 50),
+                       (unsigned long)latency_percentile(&h, 99), (unsigned long)h.max_us);
+    }
+}
+
+// The ring goes out oldest first as PROTO_MSG_EVTRACE frames, morsecap
+// writes each dump as Chrome trace JSON. Recording stops while it is sent
+// and starts over afterwards.
+void dumpEvents(void) {
+    EvtraceRecord records[EVTRACE_DUMP_MAX];
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    Types_FreqHz freq;
+    Bool on = monitorEventsOn;
+    uint16_t first = 0, total, n;
+
+    Timestamp_getFreq(&freq);
+    monitor_events_enable(FALSE);
+    do {
+        n = monitor_events_read(first, records, EVTRACE_DUMP_MAX, &total);
+        sendFrame(PROTO_MSG_EVTRACE, payload,
+                  evtrace_pack_dump(payload, freq.lo, total, first, records, n));
+        first += n;
+    } while (first < total);
+    monitor_events_enable(on);
+}
+
+void cmdEvents(CommandShell *sh, int argc, char **argv) {
+    if (strcmp(argv[1], "on") == 0) {
+        monitor_events_enable(TRUE);
+        command_print(sh, "OK\r\n");
+    } else if (strcmp(argv[1], "off") == 0) {
+        monitor_events_enable(FALSE);
+        command_print(sh, "OK\r\n");
+    } else if (strcmp(argv[1], "dump") == 0) {
+        if (!settings.stream) {
+            command_print(sh, "ERR stream on first\r\n");
+            return;
+        }
+        dumpEvents();
+        command_print(sh, "OK\r\n");
+    } else {
+        command_print(sh, "ERR on|off|dump\r\n");
+    }
+}
+
+void cmdTasks(CommandShell *sh, int argc, char **argv) {
+    const MonitorStats *st = monitor_stats();
+    uint8_t i;
+
+    for (i = 0; i < st->stackCount; i++) {
+        command_printf(sh, "%-8s stack %lu/%lu\r\n", st->stacks[i].name,
+                       (unsigned long)st->stacks[i].used, (unsigned long)st->stacks[i].size);
+    }
+    command_printf(sh, "%-8s stack %lu/%lu\r\n", "hwi",
+                   (unsigned long)st->hwiStackUsed, (unsigned long)st->hwiStackSize);
+    command_printf(sh, "cpu sensor=%u.%u%% app=%u.%u%% audio=%u.%u%% idle=%u.%u%%\r\n",
+                   st->load[MONITOR_STAGE_SENSOR] / 10, st->load[MONITOR_STAGE_SENSOR] % 10,
+                   st->load[MONITOR_STAGE_APP] / 10, st->load[MONITOR_STAGE_APP] % 10,
+                   st->load[MONITOR_STAGE_AUDIO] / 10, st->load[MONITOR_STAGE_AUDIO] % 10,
+                   st->idle / 10, st->idle % 10);
+    command_printf(sh, "irq button=%lu uart_rx=%lu clock=%lu timer=%lu\r\n",
+                   (unsigned long)st->irqs[MONITOR_IRQ_BUTTON],
+                   (unsigned long)st->irqs[MONITOR_IRQ_UART_RX],
+                   (unsigned long)st->irqs[MONITOR_IRQ_CLOCK],
+                   (unsigned long)st->irqs[MONITOR_IRQ_TIMER]);
+}
+
+void cmdPools(CommandShell *sh, int argc, char **argv) {
+    PoolStats st;
+    uint8_t i;
+
+    for (i = 0; i < POOL_CLASS_COUNT; i++) {
+        pool_stats(i, &st);
+        command_printf(sh, "%3u B used=%u/%u peak=%u failures=%lu\r\n",
+                       st.blockSize, st.used, st.count, st.peak, (unsigned long)st.failures);
+    }
+}
+
+void cmdPower(CommandShell *sh, int argc, char **argv) {
+    StandbyStats st;
+
+    standby_stats(&st);
+    command_printf(sh, "uptime_ms=%lu standby_ms=%lu entries=%lu\r\n",
+                   (unsigned long)(st.uptime_us / 1000), (unsigned long)(st.standby_us / 1000),
+                   (unsigned long)st.entries);
+    command_printf(sh, "held=0x%02x estimate_ua=%lu\r\n", st.held,
+                   (unsigned long)standby_estimate_ua(&st, 1000 - monitor_stats()->idle));
+}
+
+void cmdHealth(CommandShell *sh, int argc, char **argv) {
+    static const char *const causes[] = {"none", "hung", "watchdog"};
+    static const char *const clients[] = {"sensor", "app"};
+    const SupervisorRecord *rec = supervisor_last();
+
+    command_printf(sh, "resets=%lu last=%s", (unsigned long)rec->resets, causes[rec->cause]);
+    if (rec->cause == SUPERVISOR_CAUSE_HUNG) {
+        command_printf(sh, " stage=%s", clients[rec->client]);
+    }
+    if (rec->cause != SUPERVISOR_CAUSE_NONE) {
+        command_printf(sh, " at_ms=%lu", (unsigned long)rec->uptime_ms);
+    }
+    command_print(sh, "\r\n");
+}
+
+void cmdI2c(CommandShell *sh, int argc, char **argv) {
+    const I2cBusStats *st = i2cbus_stats();
+
+    command_printf(sh, "transfers=%lu failures=%lu timeouts=%lu\r\n", (unsigned long)st->transfers,
+                   (unsigned long)st->failures, (unsigned long)st->timeouts);
+    command_printf(sh, "recoveries=%lu reinits=%lu last_us=%lu max_us=%lu\r\n",
+                   (unsigned long)st->recoveries, (unsigned long)st->reinits,
+                   (unsigned long)st->lastRecoveryUs, (unsigned long)st->maxRecoveryUs);
+}
+
+void cmdTrace(CommandShell *sh, int argc, char **argv) {
+    if (strcmp(argv[1], "on") == 0) {
+        command_print(sh, "OK\r\n");  // last plain text reply
+        settings.trace = 1;
+        settings.stream = STREAM_RAW;
+    } else if (strcmp(argv[1], "off") == 0) {
+        settings.trace = 0;
+        command_printf(sh, "OK drops=%lu\r\n", (unsigned long)traceDrops);
+    } else {
+        command_print(sh, "ERR on|off\r\n");
+    }
+}
+
+void cmdNote(CommandShell *sh, int argc, char **argv) {
+    char text[TRACE_MAX_NOTE + 1] = "";
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (i > 1) {
+            strncat(text, " ", TRACE_MAX_NOTE - strlen(text));
+        }
+        strncat(text, argv[i], TRACE_MAX_NOTE - strlen(text));
+    }
+    traceNote(text);
+    command_print(sh, "OK\r\n");
+}
+
+void cmdMorse(CommandShell *sh, int argc, char **argv) {
+    char text[CMD_LINE_MAX] = "";
+    int i, result;
+
+    for (i = 1; i < argc; i++) {
+        if (i > 1) {
+            strncat(text, " ", sizeof(text) - 1 - strlen(text));
+        }
+        strncat(text, argv[i], sizeof(text) - 1 - strlen(text));
+    }
+    indicatorStyle();
+    result = indicator_text(text, 1200 / (settings.echo_wpm > 0 ? settings.echo_wpm : INDICATOR_WPM));
+    if (result < 0) {
+        command_print(sh, "ERR queue full\r\n");
+        return;
+    }
+    indicatorShow(result);
+    command_print(sh, "OK\r\n");
+}
+
+void cmdAudio(CommandShell *sh, int argc, char **argv) {
+    AudioStats st;
+
+    if (strcmp(argv[1], "on") == 0) {
+        if (!audioStart()) {
+            command_print(sh, "ERR microphone\r\n");
+            return;
+        }
+        command_print(sh, "OK\r\n");
+    } else if (strcmp(argv[1], "off") == 0) {
+        audioStop();
+        command_print(sh, "OK\r\n");
+    } else if (strcmp(argv[1], "stats") == 0) {
+        audio_stats(&audioDecoder, &st);
+        command_printf(sh, "tone=%u Hz wpm=%u signal=%lu noise=%lu\r\n", st.freq_hz, st.wpm,
+                       (unsigned long)st.signal, (unsigned long)st.noise);
+        command_printf(sh, "marks=%lu glitches=%lu\r\n", (unsigned long)st.marks,
+                       (unsigned long)st.glitches);
+        command_printf(sh, "blocks=%lu overflows=%lu\r\n", (unsigned long)audioBlocks,
+                       (unsigned long)audioOverflows);
+    } else {
+        command_print(sh, "ERR on|off|stats\r\n");
+    }
+}
+
+void dumpRecord(CommandShell *sh, const LogRecord *rec, const uint8_t *payload) {
+    static const char *const causes[] = {"none", "hung", "watchdog"};
+    char text[LOGSTORE_MAX_PAYLOAD + 1];
+    const int16_t *raw = (const int16_t *)payload;
+
+    command_printf(sh, "%lu.%03lu ", (unsigned long)(rec->time_ms / 1000), (unsigned long)(rec->time_ms % 1000));
+    if (rec->type == LOGSTORE_REC_BOOT && rec->len == 1 && payload[0] <= SUPERVISOR_CAUSE_WATCHDOG) {
+        command_printf(sh, "boot %s\r\n", causes[payload[0]]);
+    } else if (rec->type == LOGSTORE_REC_TEXT) {
+        memcpy(text, payload, rec->len);
+        text[rec->len] = '\0';
+        command_print(sh, "text ");
+        command_print(sh, text);
+        command_print(sh, "\r\n");
+    } else if (rec->type == LOGSTORE_REC_IMU && rec->len == sizeof(int16_t) * PROTO_IMU_AXES) {
+        command_printf(sh, "imu %d %d %d %d %d %d\r\n", raw[0], raw[1], raw[2], raw[3], raw[4], raw[5]);
+    } else {
+        command_printf(sh, "type %u len %u\r\n", rec->type, rec->len);
+    }
+}
+
+void cmdLog(CommandShell *sh, int argc, char **argv) {
+    static uint8_t payload[LOGSTORE_MAX_PAYLOAD];
+    LogCursor cursor;
+    LogRecord rec;
+    uint16_t used;
+    uint32_t lo, hi;
+    int n = 0;
+
+    if (!storeOpen) {
+        command_print(sh, "ERR no flash\r\n");
+    } else if (strcmp(argv[1], "stats") == 0) {
+        command_printf(sh, "appended=%lu dropped=%lu pages=%lu erases=%lu\r\n",
+                       (unsigned long)store.stats.appended, (unsigned long)store.stats.dropped,
+                       (unsigned long)store.stats.pages, (unsigned long)store.stats.erases);
+        command_printf(sh, "errors=%lu corrupt=%lu\r\n", (unsigned long)store.stats.errors,
+                       (unsigned long)store.stats.corrupt);
+        if (logstore_wear(&store, &used, &lo, &hi) == 0) {
+            command_printf(sh, "sectors=%u/%u wear=%lu..%lu\r\n", used, STORE_SECTORS, (unsigned long)lo,
+                           (unsigned long)hi);
+        }
+    } else if (strcmp(argv[1], "commit") == 0) {
+        storeCommit();
+        command_print(sh, "OK\r\n");
+    } else if (strcmp(argv[1], "dump") == 0) {
+        if (logstore_seek(&store, argc > 2 ? strtoul(argv[2], NULL, 10) * 1000 : 0, &cursor) == 0) {
+            while (n < STORE_DUMP_MAX && logstore_next(&store, &cursor, &rec, payload)) {
+                dumpRecord(sh, &rec, payload);
+                n++;
+            }
+        }
+        command_printf(sh, "OK %d\r\n", n);
+    } else {
+        command_print(sh, "ERR stats|commit|dump\r\n");
+    }
+}
+
+void cmdEnv(CommandShell *sh, int argc, char **argv) {
+    AggregateSummary s;
+    uint32_t key;
+    uint8_t c;
+
+    for (c = 0; c < PROTO_ENV_CHANNELS; c++) {
+        key = hal_lock();
+        aggregate_summary(&env[c], &s);
+        hal_unlock(key);
+        command_printf(sh, "%s n=%u min=%ld max=%ld mean=%ld\r\n", envNames[c], s.count, (long)s.min,
+                       (long)s.max, (long)s.mean);
+    }
+    command_printf(sh, "readings=%lu reports=%lu bytes=%lu\r\n", (unsigned long)envReadings,
+                   (unsigned long)envReportsSent, (unsigned long)envBytes);
+}
+
+void cmdBaro(CommandShell *sh, int argc, char **argv) {
+    BaroDetector d;
+    int32_t pressure;
+    uint32_t reads, key;
+
+    key = hal_lock();
+    d = baro;
+    pressure = baroPressure;
+    reads = baroReads;
+    hal_unlock(key);
+    command_printf(sh, "pressure=%ld.%02ld height=%ldcm\r\n", (long)(pressure >> BARO_FRAC),
+                   (long)(((pressure & ((1 << BARO_FRAC) - 1)) * 100) >> BARO_FRAC), (long)baro_height_cm(&d));
+    command_printf(sh, "reads=%lu gestures=%lu rejected=%lu\r\n", (unsigned long)reads,
+                   (unsigned long)d.gestures, (unsigned long)d.rejected);
+}
+
+const Command shellCommands[] = {
+    {"help",   0, 0, command_help, "list commands"},
+    {"get",    1, 1, cmdGet,       "<param>"},
+    {"set",    2, 2, cmdSet,       "<param> <value>"},
+    {"params", 0, 0, cmdParams,    "list parameters"},
+    {"stream", 1, 1, cmdStream,    "on|packed|off"},
+    {"cal",    0, 0, cmdCal,       "recalibrate the MPU9250"},
+    {"stats",  0, 0, cmdStats,     "link and shell counters"},
+    {"latency", 0, 1, cmdLatency,  "[stage|reset], keying path latency"},
+    {"tasks",  0, 0, cmdTasks,     "stack high-water marks and CPU load"},
+    {"pools",  0, 0, cmdPools,     "memory pool usage"},
+    {"power",  0, 0, cmdPower,     "standby residency and current estimate"},
+    {"health", 0, 0, cmdHealth,    "last supervised reset"},
+    {"i2c",    0, 0, cmdI2c,       "sensor bus error and recovery counters"},
+    {"trace",  1, 1, cmdTrace,     "on|off, record IMU and buttons (trace.h)"},
+    {"note",   1, 4, cmdNote,      "<text>, annotate the trace"},
+    {"events", 1, 1, cmdEvents,    "on|off|dump, task and interrupt timeline"},
+    {"morse",  1, 4, cmdMorse,     "<text>, play on the LED and buzzer"},
+    {"audio",  1, 1, cmdAudio,     "on|off|stats, decode CW heard by the mic"},
+    {"log",    1, 2, cmdLog,       "stats|commit|dump [from_s], flash log"},
+    {"env",    0, 0, cmdEnv,       "environmental windows and reports"},
+    {"baro",   0, 0, cmdBaro,      "pressure and altitude gestures"},
+};
+
+// Runs in the UART driver's interrupt context, queue the byte and rearm
+void uartReadFxn(UART_Handle handle, void *buf, size_t count) {
+    monitor_irq(MONITOR_IRQ_UART_RX);
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_UART_RX, 0);
+    if (count == 1) {
+        postMessage(MSG_RX_BYTE, rxByte);
+    }
+    if (uartAwake) {
+        UART_read(handle, &rxByte, 1);
+    }
+    monitor_event(EVTRACE_END, EVTRACE_SRC_UART_RX, 0);
+}
+
+// The symbol is written by the time fsm_dispatch() returns
+void handleEvent(const AppMsg *msg) {
+    uint32_t start = hal_time_us();
+    uint32_t end;
+
+    fsm_dispatch(&fsm, (FsmEvent)msg->value);
+
+    end = hal_time_us();
+    latency_record(LATENCY_QUEUE, msg->posted_us, start);
+    latency_record(LATENCY_OUTPUT, start, end);
+    latency_record(LATENCY_TOTAL, msg->origin_us, end);
+}
+
+// Supervisor Clock, the app stage proves it is alive by handling this
+void supervisorPing(void) {
+    postMessage(MSG_PING, 0);
+}
+
+void handleMessage(const AppMsg *msg) {
+    if (msg->type == MSG_EVENT) {
+        handleEvent(msg);
+    } else if (msg->type == MSG_RX_BYTE) {
+        uartIdleRestart();
+        command_feed(&shell, msg->value);
+    } else if (msg->type == MSG_UART_IDLE) {
+        uartSleep();
+    } else if (msg->type == MSG_UART_WAKE) {
+        uartWake();
+    } else if (msg->type == MSG_PING) {
+        supervisor_checkin(SUPERVISOR_APP, SUPERVISOR_PERIOD_MS);
+    } else if (msg->type == MSG_AUDIO) {
+        audioDrain();
+    } else if (msg->type == MSG_STORE) {
+        handleStore();
+    } else if (msg->type == MSG_ENV) {
+        handleEnv();
+    }
+}
+
+// Decoding is accounted apart from the rest of the app stage
+MonitorStage messageStage(const AppMsg *msg) {
+    return msg->type == MSG_AUDIO ? MONITOR_STAGE_AUDIO : MONITOR_STAGE_APP;
+}
+
+void uartSetup(void) {
+    fsm_init(&fsm, sendSymbol, sendText);
+    keyer_init(&keyer);
+    command_init(&shell, shellCommands, sizeof(shellCommands) / sizeof(shellCommands[0]), shellWrite);
+    uartWake();
+    storeSetup();
+}
+
+// After a supervised reset the saved calibration is reused, which skips
+// the self test and the still period of a full calibration
+void sensorCalibrate(Bool boot) {
+    float gyro[3], accel[3];
+
+    if (boot && supervisor_fast_restart(gyro, accel)) {
+        mpu9250_setup_fast(&i2c, gyro, accel);
+        return;
+    }
+    mpu9250_setup(&i2c);
+    mpu9250_get_bias(gyro, accel);
+    supervisor_save_calibration(gyro, accel);
+}
+
+// Bus recovery reinit, the MPU9250 lost its configuration mid-transfer
+void mpuReinit(I2C_Handle *bus) {
+    float gyro[3], accel[3];
+
+    mpu9250_get_bias(gyro, accel);
+    mpu9250_setup_fast(bus, gyro, accel);
+}
+
+// The BMP280 back to the rate it ran at, set_rate() rewrites CTRL_MEAS too.
+// The trimming is kept in RAM.
+void bmpReinit(I2C_Handle *bus) {
+    bmp280_set_rate(bus, baroFast ? BMP280_CONFIG_FAST : BMP280_CONFIG_SLOW);
+}
+
+void sensorSetup(void) {
+    uint8_t c;
+
+    i2c = i2cbus_open();
+    if (i2c == NULL) {
+        System_abort("Error Initializing I2C\n");
+    }
+    i2cbus_register(Board_MPU9250_ADDR, mpuReinit);
+    i2cbus_register(Board_OPT3001_ADDR, opt3001_setup);   // the config write, continuous mode
+    i2cbus_register(Board_BMP280_ADDR, bmpReinit);
+    i2cbus_register(Board_TMP007_ADDR, tmp007_reinit);
+
+    opt3001_setup(&i2c);
+    bmp280_setup(&i2c);
+    tmp007_setup(&i2c);
+    for (c = 0; c < PROTO_ENV_CHANNELS; c++) {
+        aggregate_init(&env[c], settings.env_win_s * 1000, 0);
+    }
+    baro_init(&baro);
+
+    sensorCalibrate(TRUE);
+    sensorDeadline = Clock_getTicks();
+
+    pipeline_subscribe(classifySample);
+    pipeline_subscribe(logSample);
+    pipeline_subscribe(streamSample);
+    pipeline_subscribe(traceSample);
+
+    // Ready, the LED breathes once
+    indicatorStyle();
+    indicator_fade(0, settings.led_level, READY_FADE_MS);
+    indicatorShow(indicator_fade(settings.led_level, 0, READY_FADE_MS));
+}
+
+static int32_t roundToInt(double v) {
+    return (int32_t)(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+// Light, pressure and temperatures every env_ms, between IMU samples. The
+// readings only go into the aggregates; changes beyond the deadbands and
+// closed windows wake the app stage to send them.
+void envStep(void) {
+    const int32_t deadbands[PROTO_ENV_CHANNELS] = {
+        settings.dead_lux, settings.dead_pa, settings.dead_cc, settings.dead_cc
+    };
+    int32_t values[PROTO_ENV_CHANNELS];
+    uint8_t valid = 0, pending = 0, flags, c;
+    int32_t pressure, temperature;
+    double lux;
+    uint32_t now = storeNow();
+    AggregateSummary closed;
+    uint32_t key;
+
+    if (settings.env_ms == 0 || (int32_t)(now - envDeadline) < 0) {
+        return;
+    }
+    envDeadline = now + settings.env_ms;
+
+    // Failed reads leave -1 lux or an error, they are skipped
+    lux = opt3001_get_data(&i2c);
+    if (lux >= 0.0) {
+        values[PROTO_ENV_LIGHT] = roundToInt(lux);
+        valid |= 1 << PROTO_ENV_LIGHT;
+    }
+    if (bmp280_get_fixed(&i2c, &pressure, &temperature) == 0 && pressure > 0) {
+        values[PROTO_ENV_PRESSURE] = (pressure + 128) >> 8;
+        values[PROTO_ENV_AIR] = temperature;
+        valid |= 1 << PROTO_ENV_PRESSURE | 1 << PROTO_ENV_AIR;
+    }
+    if (tmp007_get_fixed(&i2c, &temperature) == 0) {
+        values[PROTO_ENV_OBJECT] = temperature;
+        valid |= 1 << PROTO_ENV_OBJECT;
+    }
+    envReadings++;
+
+    key = hal_lock();
+    for (c = 0; c < PROTO_ENV_CHANNELS; c++) {
+        if (!(valid & (1 << c))) {
+            continue;
+        }
+        aggregate_configure(&env[c], settings.env_win_s * 1000, deadbands[c]);
+        flags = aggregate_add(&env[c], values[c], now, &closed);
+        if (flags & AGGREGATE_WINDOW) {
+            envReport[c][PROTO_ENV_SUMMARY - 1] = closed;
+            pending |= 1 << (2 * c + PROTO_ENV_SUMMARY - 1);
+        }
+        if (flags & AGGREGATE_CHANGE) {
+            AggregateSummary *change = &envReport[c][PROTO_ENV_CHANGE - 1];
+
+            change->start_ms = now;
+            change->count = 1;
+            change->min = change->max = change->mean = values[c];
+            change->variance = 0;
+            pending |= 1 << (2 * c + PROTO_ENV_CHANGE - 1);
+        }
+    }
+    envPending |= pending;
+    hal_unlock(key);
+    if (pending) {
+        postMessage(MSG_ENV, 0);
+    }
+}
+
+// Whether a read with its own period is due in the step at now_us, to
+// within half a step. Starts over after a change of period or a stall.
+static Bool stepDue(uint32_t *deadline, uint32_t now_us, uint32_t period_us, uint32_t step_us) {
+    int32_t late = (int32_t)(now_us - *deadline);
+
+    if (late < -(int32_t)period_us || late >= (int32_t)period_us) {
+        *deadline = now_us;
+        late = 0;
+    }
+    if (late < -(int32_t)(step_us / 2)) {
+        return FALSE;
+    }
+    *deadline += period_us;
+    return TRUE;
+}
+
+// Pressure every baro_ms, after the IMU sample, through the altitude
+// gesture detector. The BMP280 runs free in normal mode while this is on,
+// so a read is one short burst that never waits for a conversion. The
+// detector keeps up while streaming, its events are dropped like tilts.
+void baroStep(uint32_t step_us) {
+    int32_t pressure, temperature;
+    uint32_t now = hal_time_us();
+    uint32_t key;
+    int event;
+
+    if ((settings.baro_ms > 0) != baroFast) {
+        if (bmp280_set_rate(&i2c, baroFast ? BMP280_CONFIG_SLOW : BMP280_CONFIG_FAST) != 0) {
+            return;
+        }
+        baroFast = !baroFast;
+        key = hal_lock();
+        baro_init(&baro);
+        hal_unlock(key);
+    }
+    if (!baroFast || !stepDue(&baroDeadline, now, settings.baro_ms * 1000, step_us)) {
+        return;
+    }
+
+    // Pa with 8 fraction bits, BARO_FRAC
+    if (bmp280_get_fixed(&i2c, &pressure, &temperature) != 0 || pressure <= 0) {
+        return;
+    }
+    tracePressure(now, pressure);
+
+    key = hal_lock();
+    baroPressure = pressure;
+    baroReads++;
+    event = baro_update(&baro, storeNow(), baroPressure, baro_threshold(settings.lift_cm));
+    hal_unlock(key);
+
+    if (event >= 0 && !settings.stream) {
+        indicatorStyle();
+        indicatorShow(indicator_flash(settings.hold_ms));
+        postEvent(event, now);
+    }
+}
+
+// One acquisition step, never blocks longer than the I2C and UART transfers.
+// The step runs at the IMU period, or at baro_ms when that is shorter and
+// the IMU is read in the steps closest to its own period. Returns the time
+// until the next step in microseconds.
+uint32_t sensorStep(void) {
+    uint32_t period = settings.stream ? IMU_PERIOD_US : settings.sample_ms * 1000;
+    uint32_t step = period;
+    Sample *sample;
+
+    if (settings.baro_ms > 0 && (uint32_t)settings.baro_ms * 1000 < step) {
+        step = settings.baro_ms * 1000;
+    }
+
+    if (calibrateRequest) {
+        sensorCalibrate(FALSE);
+        calibrateRequest = FALSE;
+        indicatorShow(indicator_blink(2, 100, 100));
+    }
+
+    if (stepDue(&imuDeadline, hal_time_us(), period, step)) {
+        sample = pipeline_acquire(hal_time_us());
+        if (sample != NULL && !mpu9250_get_raw(&i2c, sample->raw)) {
+            pipeline_release(sample);   // a failed read leaves no sample to classify
+        } else if (sample != NULL) {
+            latency_record(LATENCY_READ, sample->timestamp_us, hal_time_us());
+            samplesRead++;
+            pipeline_publish(sample);
+        }
+    }
+    envStep();
+    baroStep(step);
+
+    supervisor_checkin(SUPERVISOR_SENSOR, step / 1000);
+    return step;
+}
+
+// Advances the absolute sensor deadline so processing time and UART writes
+// do not stretch the sample period. Returns the Clock ticks to wait, >= 1.
+uint32_t sensorWaitTicks(uint32_t delayUs) {
+    uint32_t ticks = delayUs / Clock_tickPeriod;
+    uint32_t now = Clock_getTicks();
+    int32_t wait;
+
+    sensorDeadline += ticks;
+    wait = (int32_t)(sensorDeadline - now);
+    if (wait < -(int32_t)ticks) {
+        sensorDeadline = now;  // fell more than a period behind, resync
+    }
+    return wait > 0 ? wait : 1;
+}
+
+#if SINGLE_TASK
+
+void sensorClockFxn(UArg arg) {
+    monitor_irq(MONITOR_IRQ_CLOCK);
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_SENSOR_CLOCK, 0);
+    sched_post(JOB_SENSOR);
+    monitor_event(EVTRACE_END, EVTRACE_SRC_SENSOR_CLOCK, 0);
+}
+
+void sensorJob(void) {
+    uint32_t start = monitor_start(MONITOR_STAGE_SENSOR);
+    uint32_t delay = sensorStep();
+
+    monitor_stop(MONITOR_STAGE_SENSOR, start);
+    Clock_setTimeout(sensorClockHandle, sensorWaitTicks(delay));
+    Clock_start(sensorClockHandle);
+}
+
+void appJob(void) {
+    AppMsg msg;
+
+    while (Mailbox_pend(mailbox, &msg, BIOS_NO_WAIT)) {
+        MonitorStage stage = messageStage(&msg);
+        uint32_t start = monitor_start(stage);
+
+        handleMessage(&msg);
+        monitor_stop(stage, start);
+    }
+}
+
+const SchedJob jobs[JOB_COUNT] = {
+    [JOB_SENSOR] = sensorJob,
+    [JOB_APP] = appJob,
+};
+
+Void mainTaskFxn(UArg arg0, UArg arg1) {
+    uartSetup();
+    sensorSetup();
+
+    sched_post(JOB_SENSOR);
+    sched_run();
+}
+
+#else
+
+Void uartTaskFxn(UArg arg0, UArg arg1) {
+    uartSetup();
+
+    while (1) {
+        AppMsg msg;
+        MonitorStage stage;
+        uint32_t start;
+
+        // Sleeps until there is work
+        Mailbox_pend(mailbox, &msg, BIOS_WAIT_FOREVER);
+        stage = messageStage(&msg);
+        start = monitor_start(stage);
+        handleMessage(&msg);
+        monitor_stop(stage, start);
+    }
+}
+
+Void sensorTaskFxn(UArg arg0, UArg arg1) {
+    sensorSetup();
+
+    while (1) {
+        uint32_t start = monitor_start(MONITOR_STAGE_SENSOR);
+        uint32_t delay = sensorStep();
+
+        monitor_stop(MONITOR_STAGE_SENSOR, start);
+        Task_sleep(sensorWaitTicks(delay));
+    }
+}
+
+#endif
+
+Int main(void) {
+#if SINGLE_TASK
+    Task_Params mainTaskParams;
+#else
+    Task_Params sensorTaskParams;
+    Task_Params uartTaskParams;
+#endif
+    Clock_Params clockParams;
+    GPTimerCC26XX_Params timerParams;
+    Semaphore_Params semParams;
+    Mailbox_Params mailboxParams;
+
+    Board_initGeneral();
+    I2C_init();
+    SPI_init();
+    UART_init();
+    Watchdog_init();
+
+    buttonHandle = PIN_open(&buttonState, buttonConfig);
+    if (!buttonHandle) {
+        System_abort("Error initializing button pins\n");
+    }
+    if (PIN_registerIntCb(buttonHandle, &buttonFxn) != 0) {
+        System_abort("Error registering button callback function");
+    }
+    hal_init();
+
+    // Opened here, GPTimerCC26XX_open() cannot be called from the interrupts
+    // that start the patterns
+    GPTimerCC26XX_Params_init(&timerParams);
+    timerParams.width = GPT_CONFIG_32BIT;
+    timerParams.mode = GPT_MODE_ONESHOT;
+    timerParams.debugStallMode = GPTimerCC26XX_DEBUG_STALL_OFF;
+    indicatorTimer = GPTimerCC26XX_open(Board_GPTIMER2A, &timerParams);
+    if (indicatorTimer == NULL) {
+        System_abort("Error initializing the indicator timer\n");
+    }
+    GPTimerCC26XX_registerInterrupt(indicatorTimer, indicatorTimerFxn, GPT_INT_TIMEOUT);
+
+    Clock_Params_init(&clockParams);
+    clockParams.period = 0;
+    clockParams.startFlag = FALSE;
+    Clock_construct(&buttonClockStruct, (Clock_FuncPtr)buttonClockFxn, settings.click_ms * 1000 / Clock_tickPeriod, &clockParams);
+    buttonClockHandle = Clock_handle(&buttonClockStruct);
+    Clock_construct(&uartIdleClockStruct, (Clock_FuncPtr)uartIdleClockFxn, 1, &clockParams);
+    uartIdleClockHandle = Clock_handle(&uartIdleClockStruct);
+    Clock_construct(&storeClockStruct, (Clock_FuncPtr)storeClockFxn, STORE_POLL_MS * 1000 / Clock_tickPeriod,
+                    &clockParams);
+    storeClockHandle = Clock_handle(&storeClockStruct);
+
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&uartLockStruct, 1, &semParams);
+    uartLock = Semaphore_handle(&uartLockStruct);
+
+    Mailbox_Params_init(&mailboxParams);
+    mailboxParams.buf = mailboxBuffer;
+    mailboxParams.bufSize = sizeof(mailboxBuffer);
+    Mailbox_construct(&mailboxStruct, sizeof(AppMsg), MAILBOX_SIZE, &mailboxParams, NULL);
+    mailbox = Mailbox_handle(&mailboxStruct);
+
+    monitor_init();
+    standby_init();
+    pool_init();
+    pipeline_init();
+    supervisor_init(supervisorPing);
+
+#if SINGLE_TASK
+    Clock_construct(&sensorClockStruct, (Clock_FuncPtr)sensorClockFxn, 1, &clockParams);
+    sensorClockHandle = Clock_handle(&sensorClockStruct);
+    sched_init(jobs, JOB_COUNT);
+
+    Task_Params_init(&mainTaskParams);
+    mainTaskParams.stackSize = STACKSIZE;
+    mainTaskParams.stack = &mainTaskStack;
+    mainTaskParams.priority = 2;
+    monitor_add_task(Task_create(mainTaskFxn, &mainTaskParams, NULL), "main");
+#else
+    Task_Params_init(&sensorTaskParams);
+    sensorTaskParams.stackSize = STACKSIZE;
+    sensorTaskParams.stack = &sensorTaskStack;
+    sensorTaskParams.priority = 2;
+    monitor_add_task(Task_create(sensorTaskFxn, &sensorTaskParams, NULL), "sensor");
+
+    Task_Params_init(&uartTaskParams);
+    uartTaskParams.stackSize = STACKSIZE;
+    uartTaskParams.stack = &uartTaskStack;
+    uartTaskParams.priority = 2;
+    monitor_add_task(Task_create(uartTaskFxn, &uartTaskParams, NULL), "uart");
+#endif
+
+    BIOS_start();
+    return 0;
+}
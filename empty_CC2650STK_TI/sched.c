@@ -0,0 +1,66 @@
+/*
+ * sched.c
+ */
+
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#include "sched.h"
+
+static const SchedJob *schedJobs;
+static uint8_t schedJobCount;
+static volatile uint32_t pending = 0;
+static Semaphore_Struct wakeStruct;
+static Semaphore_Handle wake;
+
+void sched_init(const SchedJob *jobs, uint8_t count) {
+    Semaphore_Params semParams;
+
+    schedJobs = jobs;
+    schedJobCount = count;
+
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&wakeStruct, 0, &semParams);
+    wake = Semaphore_handle(&wakeStruct);
+}
+
+void sched_post(uint8_t job) {
+    UInt key;
+
+    if (job >= schedJobCount) {
+        return;
+    }
+    key = Hwi_disable();
+    pending |= 1UL << job;
+    Hwi_restore(key);
+    Semaphore_post(wake);
+}
+
+void sched_run(void) {
+    uint32_t work;
+    uint8_t job;
+    UInt key;
+
+    while (1) {
+        Semaphore_pend(wake, BIOS_WAIT_FOREVER);
+
+        while (1) {
+            // Take the highest priority pending job, re-check after every job
+            key = Hwi_disable();
+            work = pending;
+            if (work == 0) {
+                Hwi_restore(key);
+                break;
+            }
+            for (job = 0; !(work & (1UL << job)); job++) {
+            }
+            pending &= ~(1UL << job);
+            Hwi_restore(key);
+
+            schedJobs[job]();
+        }
+    }
+}
@@ -0,0 +1,26 @@
+/*
+ * sched.h
+ *
+ *  Run-to-completion job scheduler for running all application stages on
+ *  a single task. Jobs are posted from clocks, callbacks or other jobs and
+ *  run in table order (lowest index first) on the scheduler task.
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+
+#define SCHED_MAX_JOBS 32
+
+typedef void (*SchedJob)(void);
+
+void sched_init(const SchedJob *jobs, uint8_t count);
+
+// Marks a job pending, callable from Hwi, Swi and Task context
+void sched_post(uint8_t job);
+
+// Never returns, call from the one application task
+void sched_run(void);
+
+#endif /* SCHED_H_ */
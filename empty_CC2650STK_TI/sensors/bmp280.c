@@ -1,170 +1,243 @@
-/*
- * bmp280.c
- *
- *  Created on: 29.10.2016
- *  Author: Teemu Leppanen / UBIComp / University of Oulu
- *
- * 	Datasheet: https://ae-bst.resource.bosch.com/media/_tech/media/datasheets/BST-BMP280-DS001-12.pdf
- */
-
-#include <xdc/runtime/System.h>
-#include <stdio.h>
-#include "Board.h"
-#include "bmp280.h"
-
-// konversiovakiot
-uint16_t dig_T1;
-int16_t  dig_T2;
-int16_t  dig_T3;
-uint16_t dig_P1;
-int16_t  dig_P2;
-int16_t  dig_P3;
-int16_t  dig_P4;
-int16_t  dig_P5;
-int16_t  dig_P6;
-int16_t  dig_P7;
-int16_t  dig_P8;
-int16_t  dig_P9;
-int32_t	 t_fine = 0;
-
-// Debug-viestit
-char str[80];
-
-void bmp280_set_trimming(char *v) {
-
-	dig_T1 = (v[1] << 8) | v[0];
-	dig_T2 = (v[3] << 8) | v[2];
-	dig_T3 = (v[5] << 8) | v[4];
-	dig_P1 = (v[7] << 8) | v[6];
-	dig_P2 = (v[9] << 8) | v[8];
-	dig_P3 = (v[11] << 8) | v[10];
-	dig_P1 = (v[7] << 8) | v[6];
-	dig_P2 = (v[9] << 8) | v[8];
-	dig_P3 = (v[11] << 8) | v[10];
-	dig_P4 = (v[13] << 8) | v[12];
-	dig_P5 = (v[15] << 8) | v[14];
-	dig_P6 = (v[17] << 8) | v[16];
-	dig_P7 = (v[19] << 8) | v[18];
-	dig_P8 = (v[21] << 8) | v[20];
-	dig_P9 = (v[23] << 8) | v[22];
-}
-
-double bmp280_temp_compensation(uint32_t adc_T) {
-
-	double ret = 0.0;
-	int32_t var1, var2;
-
-	var1 = ((((adc_T>>3) - ((int32_t)dig_T1 <<1))) * ((int32_t)dig_T2)) >> 11;
-	var2 = (((((adc_T>>4) - ((int32_t)dig_T1)) * ((adc_T>>4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
-	t_fine = var1 + var2;
-
-	ret = (double)((t_fine * 5 + 128) >> 8);
-	ret /= 100.0;
-	return ret;
-}
-
-double bmp280_convert_pres(uint32_t adc_P) {
-
-	double ret = 0.0;
-	int64_t var1, var2, p;
-
-	var1 = ((int64_t)t_fine) - 128000;
-	var2 = var1 * var1 * (int64_t)dig_P6;
-	var2 = var2 + ((var1*(int64_t)dig_P5)<<17);
-	var2 = var2 + (((int64_t)dig_P4)<<35);
-	var1 = ((var1 * var1 * (int64_t)dig_P3)>>8) + ((var1 * (int64_t)dig_P2)<<12);
-	var1 = (((((int64_t)1)<<47)+var1))*((int64_t)dig_P1)>>33;
-	if (var1 == 0) {
-	    return 0.0;  // avoid exception caused by division by zero
-	}
-	p = 1048576 - adc_P;
-	p = (((p<<31) - var2)*3125) / var1;
-	var1 = (((int64_t)dig_P9) * (p>>13) * (p>>13)) >> 25;
-	var2 = (((int64_t)dig_P8) * p) >> 19;
-
-	ret = ((p + var1 + var2) >> 8) + (((int64_t)dig_P7)<<4);
-	ret /= 256.0;
-	return ret;
-}
-
-void bmp280_setup(I2C_Handle *i2c) {
-
-	I2C_Transaction i2cTransaction;
-	char itxBuffer[4];
-	char irxBuffer[24];
-
-    i2cTransaction.slaveAddress = Board_BMP280_ADDR;
-    itxBuffer[0] = BMP280_REG_CONFIG;
-    itxBuffer[1] = 0x40;
-    i2cTransaction.writeBuf = itxBuffer;
-    i2cTransaction.writeCount = 2;
-    i2cTransaction.readBuf = NULL;
-    i2cTransaction.readCount = 0;
-
-    if (I2C_transfer(*i2c, &i2cTransaction)) {
-
-        System_printf("BMP280: Config write ok\n");
-    } else {
-        System_printf("BMP280: Config write failed!\n");
-    }
-    System_flush();
-
-    i2cTransaction.slaveAddress = Board_BMP280_ADDR;
-    itxBuffer[0] = BMP280_REG_CTRL_MEAS;
-    itxBuffer[1] = 0x2F;
-    i2cTransaction.writeBuf = itxBuffer;
-    i2cTransaction.writeCount = 2;
-    i2cTransaction.readBuf = NULL;
-    i2cTransaction.readCount = 0;
-
-    if (I2C_transfer(*i2c, &i2cTransaction)) {
-
-        System_printf("BMP280: Ctrl meas write ok\n");
-    } else {
-        System_printf("BMP280: Ctrl meas write failed!\n");
-    }
-    System_flush();
-
-    i2cTransaction.slaveAddress = Board_BMP280_ADDR;
-    itxBuffer[0] = BMP280_REG_T1;
-    i2cTransaction.writeBuf = itxBuffer;
-    i2cTransaction.writeCount = 1;
-    i2cTransaction.readBuf = irxBuffer;
-    i2cTransaction.readCount = 24;
-
-    if (I2C_transfer(*i2c, &i2cTransaction)) {
-
-        System_printf("BMP280: Trimming read ok\n");
-    } else {
-        System_printf("BMP280: Trimming read failed!\n");
-    }
-    System_flush();
-
-    bmp280_set_trimming(irxBuffer);
-}
-
-/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
-
-void bmp280_get_data(I2C_Handle *i2c, double *pressure, double *temperature) {
-
-    // JTKJ: Find out the correct buffer sizes with this sensor?
-    // char txBuffer[ n ];
-    // char rxBuffer{ n ];
-
-    // JTKJ: Fill in the i2cMessage data structure with correct values
-    //       as shown in the lecture material
-    I2C_Transaction i2cMessage;
-
-    if (I2C_transfer(*i2c, &i2cMessage)) {
-
-        // JTKJ: Here the conversion from register value to unit values
-        //       Save the values to the function parameters pressure and temperature
-
-    } else {
-
-        // Oops, something went wrong..
-        System_printf("BMP280: Data read failed!\n");
-        System_flush();
-    }
-}
-
+/*
+ * bmp280.c
+ *
+ *  Created on: 29.10.2016
+ *  Author: Teemu Leppanen / UBIComp / University of Oulu
+ *
+ * 	Datasheet: https://ae-bst.resource.bosch.com/media/_tech/media/datasheets/BST-BMP280-DS001-12.pdf
+ */
+
+#include <xdc/runtime/System.h>
+#include <stdio.h>
+#include "Board.h"
+#include "bmp280.h"
+#include "i2cbus.h"
+
+// konversiovakiot
+uint16_t dig_T1;
+int16_t  dig_T2;
+int16_t  dig_T3;
+uint16_t dig_P1;
+int16_t  dig_P2;
+int16_t  dig_P3;
+int16_t  dig_P4;
+int16_t  dig_P5;
+int16_t  dig_P6;
+int16_t  dig_P7;
+int16_t  dig_P8;
+int16_t  dig_P9;
+int32_t	 t_fine = 0;
+
+// Debug-viestit
+char str[80];
+
+void bmp280_set_trimming(char *v) {
+
+	dig_T1 = (v[1] << 8) | v[0];
+	dig_T2 = (v[3] << 8) | v[2];
+	dig_T3 = (v[5] << 8) | v[4];
+	dig_P1 = (v[7] << 8) | v[6];
+	dig_P2 = (v[9] << 8) | v[8];
+	dig_P3 = (v[11] << 8) | v[10];
+	dig_P1 = (v[7] << 8) | v[6];
+	dig_P2 = (v[9] << 8) | v[8];
+	dig_P3 = (v[11] << 8) | v[10];
+	dig_P4 = (v[13] << 8) | v[12];
+	dig_P5 = (v[15] << 8) | v[14];
+	dig_P6 = (v[17] << 8) | v[16];
+	dig_P7 = (v[19] << 8) | v[18];
+	dig_P8 = (v[21] << 8) | v[20];
+	dig_P9 = (v[23] << 8) | v[22];
+}
+
+double bmp280_temp_compensation(uint32_t adc_T) {
+
+	double ret = 0.0;
+	int32_t var1, var2;
+
+	var1 = ((((adc_T>>3) - ((int32_t)dig_T1 <<1))) * ((int32_t)dig_T2)) >> 11;
+	var2 = (((((adc_T>>4) - ((int32_t)dig_T1)) * ((adc_T>>4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
+	t_fine = var1 + var2;
+
+	ret = (double)((t_fine * 5 + 128) >> 8);
+	ret /= 100.0;
+	return ret;
+}
+
+double bmp280_convert_pres(uint32_t adc_P) {
+
+	double ret = 0.0;
+	int64_t var1, var2, p;
+
+	var1 = ((int64_t)t_fine) - 128000;
+	var2 = var1 * var1 * (int64_t)dig_P6;
+	var2 = var2 + ((var1*(int64_t)dig_P5)<<17);
+	var2 = var2 + (((int64_t)dig_P4)<<35);
+	var1 = ((var1 * var1 * (int64_t)dig_P3)>>8) + ((var1 * (int64_t)dig_P2)<<12);
+	var1 = (((((int64_t)1)<<47)+var1))*((int64_t)dig_P1)>>33;
+	if (var1 == 0) {
+	    return 0.0;  // avoid exception caused by division by zero
+	}
+	p = 1048576 - adc_P;
+	p = (((p<<31) - var2)*3125) / var1;
+	var1 = (((int64_t)dig_P9) * (p>>13) * (p>>13)) >> 25;
+	var2 = (((int64_t)dig_P8) * p) >> 19;
+
+	ret = ((p + var1 + var2) >> 8) + (((int64_t)dig_P7)<<4);
+	ret /= 256.0;
+	return ret;
+}
+
+void bmp280_setup(I2C_Handle *i2c) {
+
+	I2C_Transaction i2cTransaction;
+	char itxBuffer[4];
+	char irxBuffer[24];
+
+    i2cTransaction.slaveAddress = Board_BMP280_ADDR;
+    itxBuffer[0] = BMP280_REG_CONFIG;
+    itxBuffer[1] = 0x40;
+    i2cTransaction.writeBuf = itxBuffer;
+    i2cTransaction.writeCount = 2;
+    i2cTransaction.readBuf = NULL;
+    i2cTransaction.readCount = 0;
+
+    if (i2cbus_transfer(*i2c, &i2cTransaction)) {
+
+        System_printf("BMP280: Config write ok\n");
+    } else {
+        System_printf("BMP280: Config write failed!\n");
+    }
+    System_flush();
+
+    i2cTransaction.slaveAddress = Board_BMP280_ADDR;
+    itxBuffer[0] = BMP280_REG_CTRL_MEAS;
+    itxBuffer[1] = 0x2F;
+    i2cTransaction.writeBuf = itxBuffer;
+    i2cTransaction.writeCount = 2;
+    i2cTransaction.readBuf = NULL;
+    i2cTransaction.readCount = 0;
+
+    if (i2cbus_transfer(*i2c, &i2cTransaction)) {
+
+        System_printf("BMP280: Ctrl meas write ok\n");
+    } else {
+        System_printf("BMP280: Ctrl meas write failed!\n");
+    }
+    System_flush();
+
+    i2cTransaction.slaveAddress = Board_BMP280_ADDR;
+    itxBuffer[0] = BMP280_REG_T1;
+    i2cTransaction.writeBuf = itxBuffer;
+    i2cTransaction.writeCount = 1;
+    i2cTransaction.readBuf = irxBuffer;
+    i2cTransaction.readCount = 24;
+
+    if (i2cbus_transfer(*i2c, &i2cTransaction)) {
+
+        System_printf("BMP280: Trimming read ok\n");
+    } else {
+        System_printf("BMP280: Trimming read failed!\n");
+    }
+    System_flush();
+
+    bmp280_set_trimming(irxBuffer);
+}
+
+/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
+
+// The datasheet's temperature compensation in signed arithmetic: with the
+// raw count unsigned, as in bmp280_temp_compensation(), a negative dig_T3
+// turns the second term into a logical shift of a wrapped product. Sets
+// t_fine for the pressure, returns 0.01 C.
+static int32_t bmp280_temp_fine(int32_t adc_T) {
+    int32_t var1, var2;
+
+    var1 = ((((adc_T >> 3) - ((int32_t)dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
+    var2 = (((((adc_T >> 4) - ((int32_t)dig_T1)) * ((adc_T >> 4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
+    t_fine = var1 + var2;
+    return (t_fine * 5 + 128) >> 8;
+}
+
+// bmp280_convert_pres() up to its result in Pa with 8 fraction bits,
+// without the soft-float conversion and division of the double
+int32_t bmp280_pres_q8(uint32_t adc_P) {
+    int64_t var1, var2, p;
+
+    var1 = ((int64_t)t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)dig_P6;
+    var2 = var2 + ((var1 * (int64_t)dig_P5) << 17);
+    var2 = var2 + (((int64_t)dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)dig_P3) >> 8) + ((var1 * (int64_t)dig_P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)dig_P1) >> 33;
+    if (var1 == 0) {
+        return 0;  // avoid exception caused by division by zero
+    }
+    p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)dig_P8) * p) >> 19;
+    return (int32_t)(((p + var1 + var2) >> 8) + (((int64_t)dig_P7) << 4));
+}
+
+int bmp280_get_fixed(I2C_Handle *i2c, int32_t *pressure, int32_t *temperature) {
+
+    uint8_t txBuffer[1];
+    uint8_t rxBuffer[6];    // press_msb, lsb, xlsb, temp_msb, lsb, xlsb
+    uint32_t adc_P, adc_T;
+
+    I2C_Transaction i2cMessage;
+    i2cMessage.slaveAddress = Board_BMP280_ADDR;
+    txBuffer[0] = BMP280_REG_PRES_MSB;
+    i2cMessage.writeBuf = txBuffer;
+    i2cMessage.writeCount = 1;
+    i2cMessage.readBuf = rxBuffer;
+    i2cMessage.readCount = 6;
+
+    if (!i2cbus_transfer(*i2c, &i2cMessage)) {
+        // Oops, something went wrong..
+        System_printf("BMP280: Data read failed!\n");
+        System_flush();
+        return -1;
+    }
+
+    // 20-bit readings, the temperature first: it sets t_fine for the
+    // pressure compensation
+    adc_P = ((uint32_t)rxBuffer[0] << 12) | ((uint32_t)rxBuffer[1] << 4) | (rxBuffer[2] >> 4);
+    adc_T = ((uint32_t)rxBuffer[3] << 12) | ((uint32_t)rxBuffer[4] << 4) | (rxBuffer[5] >> 4);
+
+    *temperature = bmp280_temp_fine((int32_t)adc_T);
+    *pressure = bmp280_pres_q8(adc_P);
+    return 0;
+}
+
+void bmp280_get_data(I2C_Handle *i2c, double *pressure, double *temperature) {
+
+    int32_t p, t;
+
+    if (bmp280_get_fixed(i2c, &p, &t) == 0) {
+        *temperature = t / 100.0;
+        *pressure = p / 256.0;
+    }
+}
+
+int bmp280_set_rate(I2C_Handle *i2c, uint8_t config) {
+
+    // CONFIG writes in normal mode may be ignored: sleep, CONFIG, then back
+    // to normal mode, register and value pairs in one transfer
+    uint8_t txBuffer[6] = {BMP280_REG_CTRL_MEAS, 0x2C, BMP280_REG_CONFIG, config, BMP280_REG_CTRL_MEAS, 0x2F};
+
+    I2C_Transaction i2cMessage;
+    i2cMessage.slaveAddress = Board_BMP280_ADDR;
+    i2cMessage.writeBuf = txBuffer;
+    i2cMessage.writeCount = 6;
+    i2cMessage.readBuf = NULL;
+    i2cMessage.readCount = 0;
+
+    if (!i2cbus_transfer(*i2c, &i2cMessage)) {
+        System_printf("BMP280: Config write failed!\n");
+        System_flush();
+        return -1;
+    }
+    return 0;
+}
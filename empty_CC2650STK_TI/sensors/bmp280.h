@@ -1,36 +1,55 @@
-/*
- * bmp280.h
- *
- *  Created on: 7.10.2016
- *  Author: Teemu Leppnen / UBIComp / University of Oulu
- *
- * 	Datasheet: https://ae-bst.resource.bosch.com/media/_tech/media/datasheets/BST-BMP280-DS001-12.pdf
- */
-
-#ifndef BMP280_H_
-#define BMP280_H_
-
-#include <ti/drivers/I2C.h>
-
-#define BMP280_REG_CTRL_MEAS	0xF4
-#define BMP280_REG_CONFIG		0xF5
-#define BMP280_REG_PRES_MSB		0xF7
-#define BMP280_REG_T1 			0x88
-/*
-#define BMP280_REG_T2			0x8A
-#define BMP280_REG_T3			0x8C
-#define BMP280_REG_P1			0x8E
-#define BMP280_REG_P2			0x90
-#define BMP280_REG_P3			0x92
-#define BMP280_REG_P4			0x94
-#define BMP280_REG_P5			0x96
-#define BMP280_REG_P6			0x98
-#define BMP280_REG_P7			0x9A
-#define BMP280_REG_P8			0x9C
-#define BMP280_REG_P9			0x9E
-*/
-
-void bmp280_setup(I2C_Handle *i2c);
-void bmp280_get_data(I2C_Handle *i2c, double *pressure, double *temperature);
-
-#endif /* BMP280_H_ */
+/*
+ * bmp280.h
+ *
+ *  Created on: 7.10.2016
+ *  Author: Teemu Leppnen / UBIComp / University of Oulu
+ *
+ * 	Datasheet: https://ae-bst.resource.bosch.com/media/_tech/media/datasheets/BST-BMP280-DS001-12.pdf
+ */
+
+#ifndef BMP280_H_
+#define BMP280_H_
+
+#include <ti/drivers/I2C.h>
+
+#define BMP280_REG_CTRL_MEAS	0xF4
+#define BMP280_REG_CONFIG		0xF5
+#define BMP280_REG_PRES_MSB		0xF7
+#define BMP280_REG_T1 			0x88
+/*
+#define BMP280_REG_T2			0x8A
+#define BMP280_REG_T3			0x8C
+#define BMP280_REG_P1			0x8E
+#define BMP280_REG_P2			0x90
+#define BMP280_REG_P3			0x92
+#define BMP280_REG_P4			0x94
+#define BMP280_REG_P5			0x96
+#define BMP280_REG_P6			0x98
+#define BMP280_REG_P7			0x9A
+#define BMP280_REG_P8			0x9C
+#define BMP280_REG_P9			0x9E
+*/
+
+// CONFIG values for bmp280_set_rate(): standby and IIR filter coefficient.
+// Slow is what bmp280_setup() sets, 125 ms standby and no filter. Fast is
+// the datasheet's handheld dynamic setting with a shorter filter, 0.5 ms
+// standby and coefficient 4: a reading every 11.5 ms at the 4x pressure
+// oversampling of the setup.
+#define BMP280_CONFIG_SLOW		0x40
+#define BMP280_CONFIG_FAST		0x08
+
+void bmp280_setup(I2C_Handle *i2c);
+void bmp280_get_data(I2C_Handle *i2c, double *pressure, double *temperature);
+
+// The same reading without doubles: Pa with 8 fraction bits and 0.01 C.
+// Returns 0 or -1, the pressure is 0 on a bad calibration.
+int bmp280_get_fixed(I2C_Handle *i2c, int32_t *pressure, int32_t *temperature);
+
+// Pressure compensation of a raw reading after the temperature's, Pa with
+// 8 fraction bits
+int32_t bmp280_pres_q8(uint32_t adc_P);
+
+// Switches normal mode to another CONFIG, returns 0 or -1
+int bmp280_set_rate(I2C_Handle *i2c, uint8_t config);
+
+#endif /* BMP280_H_ */
@@ -0,0 +1,165 @@
+/*
+ * i2cbus.c
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/drivers/PIN.h>
+#include <driverlib/cpu.h>
+
+#include "Board.h"
+#include "monitor.h"
+#include "sensors/i2cbus.h"
+
+// About 5 us at 48 MHz, CPUdelay() takes 3 cycles per loop
+#define HALF_PERIOD 80
+
+typedef struct {
+    uint8_t address;
+    uint8_t failed;
+    I2cBusReinitFxn reinit;
+} I2cBusDevice;
+
+static I2C_Handle bus = NULL;
+static I2cBusStats stats;
+static I2cBusDevice devices[I2CBUS_MAX_DEVICES];
+static uint8_t deviceCount = 0;
+static uint8_t consecutive = 0;
+static bool recovering = false;
+
+static PIN_Config busClearConfig[] = {
+    Board_I2C0_SDA0 | PIN_INPUT_EN | PIN_PULLUP,
+    Board_I2C0_SCL0 | PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH | PIN_OPENDRAIN | PIN_PULLUP,
+    PIN_TERMINATE
+};
+
+static uint32_t elapsedUs(uint32_t startTicks) {
+    return (Clock_getTicks() - startTicks) * Clock_tickPeriod;
+}
+
+static I2C_Handle openDriver(void) {
+    I2C_Params i2cParams;
+
+    I2C_Params_init(&i2cParams);
+    return I2C_open(Board_I2C, &i2cParams);
+}
+
+// Clocks SCL until the slave that holds SDA low has shifted out its byte,
+// at most nine times, then generates a STOP condition
+static void busClear(void) {
+    PIN_State pinState;
+    PIN_Handle pins = PIN_open(&pinState, busClearConfig);
+    uint8_t i;
+
+    if (pins == NULL) {
+        return;
+    }
+    for (i = 0; i < 9 && !PIN_getInputValue(Board_I2C0_SDA0); i++) {
+        PIN_setOutputValue(pins, Board_I2C0_SCL0, 0);
+        CPUdelay(HALF_PERIOD);
+        PIN_setOutputValue(pins, Board_I2C0_SCL0, 1);
+        CPUdelay(HALF_PERIOD);
+    }
+
+    // STOP: SDA rises while SCL is high
+    PIN_setOutputValue(pins, Board_I2C0_SCL0, 0);
+    PIN_setConfig(pins, PIN_BM_ALL, Board_I2C0_SDA0 | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_OPENDRAIN);
+    CPUdelay(HALF_PERIOD);
+    PIN_setOutputValue(pins, Board_I2C0_SCL0, 1);
+    CPUdelay(HALF_PERIOD);
+    PIN_setOutputValue(pins, Board_I2C0_SDA0, 1);
+    CPUdelay(HALF_PERIOD);
+
+    PIN_close(pins);
+}
+
+static void recover(void) {
+    uint32_t start = Clock_getTicks();
+    uint32_t duration;
+    uint8_t i;
+
+    recovering = true;
+
+    I2C_close(bus);
+    busClear();
+    bus = openDriver();
+    if (bus == NULL) {
+        System_abort("Error reopening I2C\n");
+    }
+
+    for (i = 0; i < deviceCount; i++) {
+        if (devices[i].failed) {
+            devices[i].failed = 0;
+            devices[i].reinit(&bus);
+            stats.reinits++;
+        }
+    }
+
+    duration = elapsedUs(start);
+    stats.recoveries++;
+    stats.lastRecoveryUs = duration;
+    if (duration > stats.maxRecoveryUs) {
+        stats.maxRecoveryUs = duration;
+    }
+    consecutive = 0;
+    recovering = false;
+
+    System_printf("I2C: bus recovered in %lu us\n", (unsigned long)duration);
+    System_flush();
+}
+
+I2C_Handle i2cbus_open(void) {
+    bus = openDriver();
+    return bus;
+}
+
+I2C_Handle i2cbus_handle(void) {
+    return bus;
+}
+
+void i2cbus_register(uint8_t address, I2cBusReinitFxn reinit) {
+    if (deviceCount < I2CBUS_MAX_DEVICES) {
+        devices[deviceCount].address = address;
+        devices[deviceCount].failed = 0;
+        devices[deviceCount].reinit = reinit;
+        deviceCount++;
+    }
+}
+
+bool i2cbus_transfer(I2C_Handle handle, I2C_Transaction *transaction) {
+    uint32_t start = Clock_getTicks();
+    bool ok;
+    uint8_t i;
+
+    monitor_event(EVTRACE_BEGIN, EVTRACE_SRC_I2C, transaction->slaveAddress);
+    ok = I2C_transfer(handle, transaction);
+    monitor_event(EVTRACE_END, EVTRACE_SRC_I2C, transaction->slaveAddress | (ok ? 0 : 0x100));
+
+    stats.transfers++;
+    if (ok && elapsedUs(start) <= I2CBUS_TIMEOUT_US) {
+        consecutive = 0;
+        return true;
+    }
+
+    if (ok) {
+        stats.timeouts++;
+    } else {
+        stats.failures++;
+    }
+    for (i = 0; i < deviceCount; i++) {
+        if (devices[i].address == transaction->slaveAddress) {
+            devices[i].failed = 1;
+        }
+    }
+
+    // Failures while the devices are set up again do not start another round
+    if (++consecutive >= I2CBUS_MAX_FAILURES && !recovering) {
+        recover();
+    }
+    return ok;
+}
+
+const I2cBusStats *i2cbus_stats(void) {
+    return &stats;
+}
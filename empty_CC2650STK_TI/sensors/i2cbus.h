@@ -0,0 +1,51 @@
+/*
+ * i2cbus.h
+ *
+ *  Health layer for the shared sensor I2C bus. Sensor drivers call
+ *  i2cbus_transfer() in place of I2C_transfer(). After I2CBUS_MAX_FAILURES
+ *  failed or overlong transfers in a row the bus is recovered: the driver
+ *  is closed, SCL is clocked up to nine times until the stuck slave
+ *  releases SDA, a STOP is generated and the driver is opened again.
+ *  Then only the devices whose transfers failed are set up again through
+ *  their registered reinit functions.
+ *
+ *  A transfer that never returns is not caught here, the supervisor
+ *  (supervisor.h) resets the device in that case.
+ */
+
+#ifndef I2CBUS_H_
+#define I2CBUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <ti/drivers/I2C.h>
+
+#define I2CBUS_MAX_FAILURES     3
+#define I2CBUS_TIMEOUT_US       20000   // longer transfers count as failures
+#define I2CBUS_MAX_DEVICES      4
+
+typedef void (*I2cBusReinitFxn)(I2C_Handle *i2c);
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t failures;
+    uint32_t timeouts;
+    uint32_t recoveries;
+    uint32_t reinits;
+    uint32_t lastRecoveryUs;
+    uint32_t maxRecoveryUs;
+} I2cBusStats;
+
+I2C_Handle i2cbus_open(void);
+
+// The current driver handle, it changes when the bus is recovered
+I2C_Handle i2cbus_handle(void);
+
+void i2cbus_register(uint8_t address, I2cBusReinitFxn reinit);
+
+bool i2cbus_transfer(I2C_Handle handle, I2C_Transaction *transaction);
+
+const I2cBusStats *i2cbus_stats(void);
+
+#endif /* I2CBUS_H_ */
@@ -1,521 +1,633 @@
-/* 
- * mpu9250.c
- *
- *  Created on: 8.10.2016
- *  Author: Teemu Lepp�nen / UBIComp / University of Oulu
- *  Adopted for SensorTag from https://github.com/kriswiner/MPU-9250 by Kris Winer
- *
- *  Datasheet: https://store.invensense.com/datasheets/invensense/MPU9250REV1.0.pdf
- */
-
-#include <inttypes.h>
-#include <math.h>
-
-#include <xdc/runtime/System.h>
-#include <ti/sysbios/knl/Task.h>
-#include <ti/drivers/I2C.h>
-#include <ti/sysbios/knl/Clock.h>
-
-#include "Board.h"
-#include "mpu9250.h"
-
-#define PI  3.14159265
-
-#define XG_OFFSET_H      0x13  // User-defined trim values for gyroscope
-#define XG_OFFSET_L      0x14
-#define YG_OFFSET_H      0x15
-#define YG_OFFSET_L      0x16
-#define ZG_OFFSET_H      0x17
-#define ZG_OFFSET_L      0x18
-#define SMPLRT_DIV       0x19
-#define CONFIG           0x1A
-#define GYRO_CONFIG      0x1B
-#define ACCEL_CONFIG     0x1C
-#define ACCEL_CONFIG2    0x1D
-#define FIFO_EN          0x23
-#define I2C_MST_CTRL     0x24
-#define INT_PIN_CFG      0x37
-#define INT_ENABLE       0x38
-#define ACCEL_XOUT_H     0x3B
-#define GYRO_XOUT_H      0x43
-#define USER_CTRL        0x6A  // Bit 7 enable DMP, bit 3 reset DMP
-#define PWR_MGMT_1       0x6B // Device defaults to the SLEEP mode
-#define PWR_MGMT_2       0x6C
-#define FIFO_COUNTH      0x72
-#define FIFO_COUNTL      0x73
-#define FIFO_R_W         0x74
-#define XA_OFFSET_H      0x77
-#define YA_OFFSET_H      0x7A
-#define ZA_OFFSET_H      0x7D
-
-#define SELF_TEST_X_ACCEL 0x0D
-#define SELF_TEST_Y_ACCEL 0x0E
-#define SELF_TEST_Z_ACCEL 0x0F
-#define SELF_TEST_X_GYRO 0x00
-#define SELF_TEST_Y_GYRO 0x01
-#define SELF_TEST_Z_GYRO 0x02
-#define SELF_TEST_A      0x10
-
-// Set initial input parameters
-enum Ascale {
-  AFS_2G = 0,
-  AFS_4G,
-  AFS_8G,
-  AFS_16G
-};
-
-enum Gscale {
-  GFS_250DPS = 0,
-  GFS_500DPS,
-  GFS_1000DPS,
-  GFS_2000DPS
-};
-
-// Prototypes
-void initMPU9250();
-void accelgyrocalMPU9250(float *dest1, float *dest2);
-void MPU9250SelfTest(float * destination);
-
-I2C_Handle i2c;
-
-// Specify sensor full scale
-uint8_t Gscale = GFS_250DPS;
-uint8_t Ascale = AFS_8G;
-float aRes, gRes;      // scale resolutions per LSB for the sensors
-float gyroBias[3] = {0, 0, 0}, accelBias[3] = {0, 0, 0};      // Bias corrections for gyro and accelerometer
-float SelfTest[6];
-
-void writeByte(uint8_t reg, uint8_t data) {
-
-    I2C_Transaction i2cTransaction;
-    uint8_t txBuffer[2];
-
-    txBuffer[0] = reg;
-    txBuffer[1] = data;
-    i2cTransaction.slaveAddress = Board_MPU9250_ADDR;
-    i2cTransaction.writeBuf = txBuffer;
-    i2cTransaction.writeCount = 2;
-    i2cTransaction.readBuf = NULL;
-    i2cTransaction.readCount = 0;
-
-    if (!I2C_transfer(i2c, &i2cTransaction)) {
-        System_printf("MPU9250: write=%x data=%x FAILED\n",reg,data);
-    }
-    System_flush();
-}
-
-void readByte(uint8_t reg, uint8_t count, uint8_t *data) {
-
-    I2C_Transaction i2cTransaction;
-    uint8_t txBuffer[1];
-
-    txBuffer[0] = reg;
-    i2cTransaction.slaveAddress = Board_MPU9250_ADDR;
-    i2cTransaction.writeBuf = txBuffer;
-    i2cTransaction.writeCount = 1;
-    i2cTransaction.readBuf = data;
-    i2cTransaction.readCount = count;
-
-    if (!I2C_transfer(i2c, &i2cTransaction)) {
-        System_printf("MPU9250: read=%x count=%x FAILED\n",reg,count);
-    }
-    System_flush();
-}
-
-void delay(uint16_t delay) {
-
-    Task_sleep(delay*1000 / Clock_tickPeriod);
-}
-
-void getGres() {
-
-  switch (Gscale) {
-        // Possible gyro scales (and their register bit settings) are:
-        // 250 DPS (00), 500 DPS (01), 1000 DPS (10), and 2000 DPS  (11).
-        // Here's a bit of an algorith to calculate DPS/(ADC tick) based on that 2-bit value:
-    case GFS_250DPS:
-          gRes = 250.0/32768.0;
-          break;
-    case GFS_500DPS:
-          gRes = 500.0/32768.0;
-          break;
-    case GFS_1000DPS:
-          gRes = 1000.0/32768.0;
-          break;
-    case GFS_2000DPS:
-          gRes = 2000.0/32768.0;
-          break;
-  }
-}
-
-void getAres() {
-
-  switch (Ascale) {
-          // Possible accelerometer scales (and their register bit settings) are:
-          // 2 Gs (00), 4 Gs (01), 8 Gs (10), and 16 Gs  (11).
-          // Here's a bit of an algorith to calculate DPS/(ADC tick) based on that 2-bit value:
-    case AFS_2G:
-          aRes = 2.0/32768.0;
-          break;
-    case AFS_4G:
-          aRes = 4.0/32768.0;
-          break;
-    case AFS_8G:
-          aRes = 8.0/32768.0;
-          break;
-    case AFS_16G:
-          aRes = 16.0/32768.0;
-          break;
-  }
-}
-
-void mpu9250_setup(I2C_Handle *i2c_orig) {
-
-    i2c = *i2c_orig;
-
-    System_printf("MPU9250: Setup start...\n");
-    System_flush();
-
-    // Read the WHO_AM_I register, this is a good test of communication
-    // uint8_t c;
-    // readByte( WHO_AM_I_MPU9250, 1, &c);  // Read WHO_AM_I register for MPU-9250
-    // delay(100);
-
-    MPU9250SelfTest(SelfTest); // Start by performing self test and reporting values
-    delay(100);
-
-    // get sensor resolutions, only need to do this once
-    getAres();
-    getGres();
-
-    accelgyrocalMPU9250(gyroBias, accelBias); // Calibrate gyro and accelerometers, load biases in bias registers
-    delay(100);
-
-    initMPU9250();
-    delay(100);
-
-    System_printf("MPU9250: Setup OK\n");
-    System_flush();
-}
-
-void initMPU9250() {
-
-    // wake up device
-    writeByte(PWR_MGMT_1, 0x00); // Clear sleep mode bit (6), enable all sensors
-    delay(100); // Wait for all registers to reset
-
-    // get stable time source
-    writeByte(PWR_MGMT_1, 0x01);  // Auto select clock source to be PLL gyroscope reference if ready else
-    delay(200);
-
-    // Configure Gyro and Thermometer
-    // Disable FSYNC and set thermometer and gyro bandwidth to 41 and 42 Hz, respectively;
-    // minimum delay time for this setting is 5.9 ms, which means sensor fusion update rates cannot
-    // be higher than 1 / 0.0059 = 170 Hz
-    // DLPF_CFG = bits 2:0 = 011; this limits the sample rate to 1000 Hz for both
-    // With the MPU9250, it is possible to get gyro sample rates of 32 kHz (!), 8 kHz, or 1 kHz
-    writeByte(CONFIG, 0x03);
-
-    // Set sample rate = gyroscope output rate/(1 + SMPLRT_DIV)
-    writeByte(SMPLRT_DIV, 0x04);    // Use a 200 Hz rate; a rate consistent with the filter update rate
-                                                    // determined inset in CONFIG above
-
-    // Set gyroscope full scale range
-    // Range selects FS_SEL and AFS_SEL are 0 - 3, so 2-bit values are left-shifted into positions 4:3
-    uint8_t c;
-    readByte( GYRO_CONFIG, 1, &c); // get current GYRO_CONFIG register value
-    // c = c & ~0xE0; // Clear self-test bits [7:5]
-    c = c & ~0x02; // Clear Fchoice bits [1:0]
-    c = c & ~0x18; // Clear AFS bits [4:3]
-    c = c | Gscale << 3; // Set full scale range for the gyro
-    // c =| 0x00; // Set Fchoice for the gyro to 11 by writing its inverse to bits 1:0 of GYRO_CONFIG
-    writeByte(GYRO_CONFIG, c ); // Write new GYRO_CONFIG value to register
-
-    // Set accelerometer full-scale range configuration
-    readByte( ACCEL_CONFIG,1,&c); // get current ACCEL_CONFIG register value
-    // c = c & ~0xE0; // Clear self-test bits [7:5]
-    c = c & ~0x18;  // Clear AFS bits [4:3]
-    c = c | Ascale << 3; // Set full scale range for the accelerometer
-    writeByte(ACCEL_CONFIG, c); // Write new ACCEL_CONFIG register value
-
-    // Set accelerometer sample rate configuration
-    // It is possible to get a 4 kHz sample rate from the accelerometer by choosing 1 for
-    // accel_fchoice_b bit [3]; in this case the bandwidth is 1.13 kHz
-    readByte( ACCEL_CONFIG2, 1, &c); // get current ACCEL_CONFIG2 register value
-    c = c & ~0x0F; // Clear accel_fchoice_b (bit 3) and A_DLPFG (bits [2:0])
-    c = c | 0x03;  // Set accelerometer rate to 1 kHz and bandwidth to 41 Hz
-    writeByte( ACCEL_CONFIG2, c); // Write new ACCEL_CONFIG2 register value
-
-    // The accelerometer, gyro, and thermometer are set to 1 kHz sample rates,
-    // but all these rates are further reduced by a factor of 5 to 200 Hz because of the SMPLRT_DIV setting
-
-    // Configure Interrupts and Bypass Enable
-    // Set interrupt pin active high, push-pull, hold interrupt pin level HIGH until interrupt cleared,
-    // clear on read of INT_STATUS, and enable I2C_BYPASS_EN so additional chips
-    // can join the I2C bus and all can be controlled by the Arduino as master
-    //   writeByte( INT_PIN_CFG, 0x22);
-    writeByte( INT_PIN_CFG, 0x12);  // INT is 50 microsecond pulse and any read to clear
-    writeByte( INT_ENABLE, 0x01);  // Enable data ready (bit 0) interrupt
-    delay(100);
-}
-
-
-// Function which accumulates gyro and accelerometer data after device initialization. It calculates the average
-// of the at-rest readings and then loads the resulting offsets into accelerometer and gyro bias registers.
-void accelgyrocalMPU9250(float *dest1, float *dest2) {
-
-    uint8_t data[12]; // data array to hold accelerometer and gyro x, y, z, data
-    uint16_t ii, packet_count, fifo_count;
-    int32_t gyro_bias[3]  = {0, 0, 0}, accel_bias[3] = {0, 0, 0};
-
-    // reset device
-    writeByte( PWR_MGMT_1, 0x80); // Write a one to bit 7 reset bit; toggle reset device
-    delay(100);
-
-    // get stable time source; Auto select clock source to be PLL gyroscope reference if ready
-    // else use the internal oscillator, bits 2:0 = 001
-    writeByte( PWR_MGMT_1, 0x01);
-    writeByte( PWR_MGMT_2, 0x00);
-    delay(200);
-
-    // Configure device for bias calculation
-    writeByte( INT_ENABLE, 0x00);   // Disable all interrupts
-    writeByte( FIFO_EN, 0x00);      // Disable FIFO
-    writeByte( PWR_MGMT_1, 0x00);   // Turn on internal clock source
-    writeByte( I2C_MST_CTRL, 0x00); // Disable I2C master
-    writeByte( USER_CTRL, 0x00);    // Disable FIFO and I2C master modes
-    writeByte( USER_CTRL, 0x0C);    // Reset FIFO and DMP
-    delay(15);
-
-    // Configure MPU6050 gyro and accelerometer for bias calculation
-    writeByte( CONFIG, 0x01);      // Set low-pass filter to 188 Hz
-    writeByte( SMPLRT_DIV, 0x00);  // Set sample rate to 1 kHz
-    writeByte( GYRO_CONFIG, 0x00);  // Set gyro full-scale to 250 degrees per second, maximum sensitivity
-    writeByte( ACCEL_CONFIG, 0x00); // Set accelerometer full-scale to 2 g, maximum sensitivity
-
-    uint16_t  gyrosensitivity  = 131;   // = 131 LSB/degrees/sec
-    uint16_t  accelsensitivity = 16384;  // = 16384 LSB/g
-
-    // Configure FIFO to capture accelerometer and gyro data for bias calculation
-    writeByte( USER_CTRL, 0x40);   // Enable FIFO
-    writeByte( FIFO_EN, 0x78);     // Enable gyro and accelerometer sensors for FIFO  (max size 512 bytes in MPU-9150)
-    delay(40); // accumulate 40 samples in 40 milliseconds = 480 bytes
-
-    // At end of sample accumulation, turn off FIFO sensor read
-    writeByte( FIFO_EN, 0x00);        // Disable gyro and accelerometer sensors for FIFO
-    readByte( FIFO_COUNTH, 2, &data[0]); // read FIFO sample count
-    fifo_count = ((uint16_t)data[0] << 8) | data[1];
-    packet_count = fifo_count/12;// How many sets of full gyro and accelerometer data for averaging
-
-    for (ii = 0; ii < packet_count; ii++) {
-        int16_t accel_temp[3] = {0, 0, 0}, gyro_temp[3] = {0, 0, 0};
-        readByte( FIFO_R_W, 12, &data[0]); // read data for averaging
-        accel_temp[0] = (int16_t) (((int16_t)data[0] << 8) | data[1]  ) ;  // Form signed 16-bit integer for each sample in FIFO
-        accel_temp[1] = (int16_t) (((int16_t)data[2] << 8) | data[3]  ) ;
-        accel_temp[2] = (int16_t) (((int16_t)data[4] << 8) | data[5]  ) ;
-        gyro_temp[0]  = (int16_t) (((int16_t)data[6] << 8) | data[7]  ) ;
-        gyro_temp[1]  = (int16_t) (((int16_t)data[8] << 8) | data[9]  ) ;
-        gyro_temp[2]  = (int16_t) (((int16_t)data[10] << 8) | data[11]) ;
-
-        accel_bias[0] += (int32_t) accel_temp[0]; // Sum individual signed 16-bit biases to get accumulated signed 32-bit biases
-        accel_bias[1] += (int32_t) accel_temp[1];
-        accel_bias[2] += (int32_t) accel_temp[2];
-        gyro_bias[0]  += (int32_t) gyro_temp[0];
-        gyro_bias[1]  += (int32_t) gyro_temp[1];
-        gyro_bias[2]  += (int32_t) gyro_temp[2];
-    }
-
-    accel_bias[0] /= (int32_t) packet_count; // Normalize sums to get average count biases
-    accel_bias[1] /= (int32_t) packet_count;
-    accel_bias[2] /= (int32_t) packet_count;
-    gyro_bias[0]  /= (int32_t) packet_count;
-    gyro_bias[1]  /= (int32_t) packet_count;
-    gyro_bias[2]  /= (int32_t) packet_count;
-
-    if(accel_bias[2] > 0L) {accel_bias[2] -= (int32_t) accelsensitivity;}  // Remove gravity from the z-axis accelerometer bias calculation
-    else {accel_bias[2] += (int32_t) accelsensitivity;}
-
-    // Construct the gyro biases for push to the hardware gyro bias registers, which are reset to zero upon device startup
-    data[0] = (-gyro_bias[0]/4  >> 8) & 0xFF; // Divide by 4 to get 32.9 LSB per deg/s to conform to expected bias input format
-    data[1] = (-gyro_bias[0]/4)       & 0xFF; // Biases are additive, so change sign on calculated average gyro biases
-    data[2] = (-gyro_bias[1]/4  >> 8) & 0xFF;
-    data[3] = (-gyro_bias[1]/4)       & 0xFF;
-    data[4] = (-gyro_bias[2]/4  >> 8) & 0xFF;
-    data[5] = (-gyro_bias[2]/4)       & 0xFF;
-
-    // Push gyro biases to hardware registers
-    writeByte( XG_OFFSET_H, data[0]);
-    writeByte( XG_OFFSET_L, data[1]);
-    writeByte( YG_OFFSET_H, data[2]);
-    writeByte( YG_OFFSET_L, data[3]);
-    writeByte( ZG_OFFSET_H, data[4]);
-    writeByte( ZG_OFFSET_L, data[5]);
-
-    // Output scaled gyro biases for display in the main program
-    dest1[0] = (float) gyro_bias[0]/(float) gyrosensitivity;
-    dest1[1] = (float) gyro_bias[1]/(float) gyrosensitivity;
-    dest1[2] = (float) gyro_bias[2]/(float) gyrosensitivity;
-
-    // Construct the accelerometer biases for push to the hardware accelerometer bias registers. These registers contain
-    // factory trim values which must be added to the calculated accelerometer biases; on boot up these registers will hold
-    // non-zero values. In addition, bit 0 of the lower byte must be preserved since it is used for temperature
-    // compensation calculations. Accelerometer bias registers expect bias input as 2048 LSB per g, so that
-    // the accelerometer biases calculated above must be divided by 8.
-    int32_t accel_bias_reg[3] = {0, 0, 0}; // A place to hold the factory accelerometer trim biases
-    readByte( XA_OFFSET_H, 2, &data[0]); // Read factory accelerometer trim values
-    accel_bias_reg[0] = (int32_t) (((int16_t)data[0] << 8) | data[1]);
-    readByte( YA_OFFSET_H, 2, &data[0]);
-    accel_bias_reg[1] = (int32_t) (((int16_t)data[0] << 8) | data[1]);
-    readByte( ZA_OFFSET_H, 2, &data[0]);
-    accel_bias_reg[2] = (int32_t) (((int16_t)data[0] << 8) | data[1]);
-
-    uint32_t mask = 1uL; // Define mask for temperature compensation bit 0 of lower byte of accelerometer bias registers
-    uint8_t mask_bit[3] = {0, 0, 0}; // Define array to hold mask bit for each accelerometer bias axis
-
-    for(ii = 0; ii < 3; ii++) {
-        if((accel_bias_reg[ii] & mask)) mask_bit[ii] = 0x01; // If temperature compensation bit is set, record that fact in mask_bit
-    }
-
-    // Construct total accelerometer bias, including calculated average accelerometer bias from above
-    accel_bias_reg[0] -= (accel_bias[0]/8); // Subtract calculated averaged accelerometer bias scaled to 2048 LSB/g (16 g full scale)
-    accel_bias_reg[1] -= (accel_bias[1]/8);
-    accel_bias_reg[2] -= (accel_bias[2]/8);
-
-    data[0] = (accel_bias_reg[0] >> 8) & 0xFF;
-    data[1] = (accel_bias_reg[0])      & 0xFF;
-    data[1] = data[1] | mask_bit[0]; // preserve temperature compensation bit when writing back to accelerometer bias registers
-    data[2] = (accel_bias_reg[1] >> 8) & 0xFF;
-    data[3] = (accel_bias_reg[1])      & 0xFF;
-    data[3] = data[3] | mask_bit[1]; // preserve temperature compensation bit when writing back to accelerometer bias registers
-    data[4] = (accel_bias_reg[2] >> 8) & 0xFF;
-    data[5] = (accel_bias_reg[2])      & 0xFF;
-    data[5] = data[5] | mask_bit[2]; // preserve temperature compensation bit when writing back to accelerometer bias registers
-
-    // Apparently this is not working for the acceleration biases in the MPU-9250
-    // Are we handling the temperature correction bit properly?
-    // Push accelerometer biases to hardware registers
-    /*  writeByte( XA_OFFSET_H, data[0]);
-      writeByte( XA_OFFSET_L, data[1]);
-      writeByte( YA_OFFSET_H, data[2]);
-      writeByte( YA_OFFSET_L, data[3]);
-      writeByte( ZA_OFFSET_H, data[4]);
-      writeByte( ZA_OFFSET_L, data[5]);
-     */
-    // Output scaled accelerometer biases for display in the main program
-    dest2[0] = (float)accel_bias[0]/(float)accelsensitivity;
-    dest2[1] = (float)accel_bias[1]/(float)accelsensitivity;
-    dest2[2] = (float)accel_bias[2]/(float)accelsensitivity;
-}
-
-// Accelerometer and gyroscope self test; check calibration wrt factory settings
-void MPU9250SelfTest(float * destination) // Should return percent deviation from factory trim values, +/- 14 or less deviation is a pass
-{
-    uint8_t rawData[6] = {0, 0, 0, 0, 0, 0};
-    uint8_t selfTest[6];
-    uint16_t i,ii;
-    int32_t gAvg[3] = {0}, aAvg[3] = {0}, aSTAvg[3] = {0}, gSTAvg[3] = {0};
-    float factoryTrim[6];
-    uint8_t FS = 0;
-
-    writeByte( SMPLRT_DIV, 0x00);    // Set gyro sample rate to 1 kHz
-    writeByte( CONFIG, 0x02);        // Set gyro sample rate to 1 kHz and DLPF to 92 Hz
-    writeByte( GYRO_CONFIG, FS<<3);  // Set full scale range for the gyro to 250 dps
-    writeByte( ACCEL_CONFIG2, 0x02); // Set accelerometer rate to 1 kHz and bandwidth to 92 Hz
-    writeByte( ACCEL_CONFIG, FS<<3); // Set full scale range for the accelerometer to 2 g
-
-    for(ii = 0; ii < 200; ii++) {  // get average current values of gyro and acclerometer
-
-        readByte( ACCEL_XOUT_H, 6, &rawData[0]);        // Read the six raw data registers into data array
-        aAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
-        aAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
-        aAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
-
-        readByte( GYRO_XOUT_H, 6, &rawData[0]);       // Read the six raw data registers sequentially into data array
-        gAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
-        gAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
-        gAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
-    }
-
-    for (ii =0; ii < 3; ii++) {  // Get average of 200 values and store as average current readings
-        aAvg[ii] /= 200;
-        gAvg[ii] /= 200;
-    }
-
-    // Configure the accelerometer for self-test
-    writeByte( ACCEL_CONFIG, 0xE0); // Enable self test on all three axes and set accelerometer range to +/- 2 g
-    writeByte( GYRO_CONFIG,  0xE0); // Enable self test on all three axes and set gyro range to +/- 250 degrees/s
-    delay(25);  // Delay a while to let the device stabilize
-
-    for(ii = 0; ii < 200; ii++) {  // get average self-test values of gyro and acclerometer
-
-        readByte( ACCEL_XOUT_H, 6, &rawData[0]);  // Read the six raw data registers into data array
-        aSTAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
-        aSTAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
-        aSTAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
-
-        readByte( GYRO_XOUT_H, 6, &rawData[0]);  // Read the six raw data registers sequentially into data array
-        gSTAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
-        gSTAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
-        gSTAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
-    }
-
-    for (ii =0; ii < 3; ii++) {  // Get average of 200 values and store as average self-test readings
-        aSTAvg[ii] /= 200;
-        gSTAvg[ii] /= 200;
-    }
-
-    // Configure the gyro and accelerometer for normal operation
-    writeByte( ACCEL_CONFIG, 0x00);
-    writeByte( GYRO_CONFIG,  0x00);
-    delay(25);  // Delay a while to let the device stabilize
-
-    // Retrieve accelerometer and gyro factory Self-Test Code from USR_Reg
-    readByte( SELF_TEST_X_ACCEL,1, &selfTest[0]); // X-axis accel self-test results
-    readByte( SELF_TEST_Y_ACCEL,1, &selfTest[1]); // Y-axis accel self-test results
-    readByte( SELF_TEST_Z_ACCEL,1, &selfTest[2]); // Z-axis accel self-test results
-    readByte( SELF_TEST_X_GYRO,1, &selfTest[3]);  // X-axis gyro self-test results
-    readByte( SELF_TEST_Y_GYRO,1, &selfTest[4]);  // Y-axis gyro self-test results
-    readByte( SELF_TEST_Z_GYRO,1, &selfTest[5]);  // Z-axis gyro self-test results
-
-    // Retrieve factory self-test value from self-test code reads
-    factoryTrim[0] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[0] - 1.0) )); // FT[Xa] factory trim calculation
-    factoryTrim[1] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[1] - 1.0) )); // FT[Ya] factory trim calculation
-    factoryTrim[2] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[2] - 1.0) )); // FT[Za] factory trim calculation
-    factoryTrim[3] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[3] - 1.0) )); // FT[Xg] factory trim calculation
-    factoryTrim[4] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[4] - 1.0) )); // FT[Yg] factory trim calculation
-    factoryTrim[5] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[5] - 1.0) )); // FT[Zg] factory trim calculation
-
-    // Report results as a ratio of (STR - FT)/FT; the change from Factory Trim of the Self-Test Response
-    // To get percent, must multiply by 100
-    for (i = 0; i < 3; i++) {
-        destination[i]   = 100.0*((float)(aSTAvg[i] - aAvg[i]))/factoryTrim[i] - 100.;   // Report percent differences
-        destination[i+3] = 100.0*((float)(gSTAvg[i] - gAvg[i]))/factoryTrim[i+3] - 100.; // Report percent differences
-    }
-}
-
-/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
-
-void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *gx, float *gy, float *gz) {
-    uint8_t rawData[14]; // Register data
-
-    // Read register values into array rawData
-    readByte(ACCEL_XOUT_H, 14, rawData);
-
-    // Convert the 8-bit values (the _h and _l registers) in the array rawData into 16-bit values
-    int16_t nx = (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]);
-    int16_t ny = (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]);
-    int16_t nz = (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]);
-    int16_t mx = (int16_t)(((int16_t)rawData[8] << 8) | rawData[9]);
-    int16_t my = (int16_t)(((int16_t)rawData[10] << 8) | rawData[11]);
-    int16_t mz = (int16_t)(((int16_t)rawData[12] << 8) | rawData[13]);
-
-    // Convert the 16-bit register values into g
-    *ax = (float)nx * aRes - accelBias[0];
-    *ay = (float)ny * aRes - accelBias[1];
-    *az = (float)nz * aRes - accelBias[2];
-
-    // Convert g values mx, my, mz into degrees per second
-    *gx = (float)mx * gRes;
-    *gy = (float)my * gRes;
-    *gz = (float)mz * gRes;
-}
+/* 
+ * mpu9250.c
+ *
+ *  Created on: 8.10.2016
+ *  Author: Teemu Lepp�nen / UBIComp / University of Oulu
+ *  Adopted for SensorTag from https://github.com/kriswiner/MPU-9250 by Kris Winer
+ *
+ *  Datasheet: https://store.invensense.com/datasheets/invensense/MPU9250REV1.0.pdf
+ */
+
+#include <inttypes.h>
+#include <math.h>
+
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/drivers/I2C.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "Board.h"
+#include "mpu9250.h"
+#include "i2cbus.h"
+
+#define PI  3.14159265
+
+#define XG_OFFSET_H      0x13  // User-defined trim values for gyroscope
+#define XG_OFFSET_L      0x14
+#define YG_OFFSET_H      0x15
+#define YG_OFFSET_L      0x16
+#define ZG_OFFSET_H      0x17
+#define ZG_OFFSET_L      0x18
+#define SMPLRT_DIV       0x19
+#define CONFIG           0x1A
+#define GYRO_CONFIG      0x1B
+#define ACCEL_CONFIG     0x1C
+#define ACCEL_CONFIG2    0x1D
+#define FIFO_EN          0x23
+#define I2C_MST_CTRL     0x24
+#define INT_PIN_CFG      0x37
+#define INT_ENABLE       0x38
+#define ACCEL_XOUT_H     0x3B
+#define GYRO_XOUT_H      0x43
+#define USER_CTRL        0x6A  // Bit 7 enable DMP, bit 3 reset DMP
+#define PWR_MGMT_1       0x6B // Device defaults to the SLEEP mode
+#define PWR_MGMT_2       0x6C
+#define FIFO_COUNTH      0x72
+#define FIFO_COUNTL      0x73
+#define FIFO_R_W         0x74
+#define XA_OFFSET_H      0x77
+#define YA_OFFSET_H      0x7A
+#define ZA_OFFSET_H      0x7D
+
+#define SELF_TEST_X_ACCEL 0x0D
+#define SELF_TEST_Y_ACCEL 0x0E
+#define SELF_TEST_Z_ACCEL 0x0F
+#define SELF_TEST_X_GYRO 0x00
+#define SELF_TEST_Y_GYRO 0x01
+#define SELF_TEST_Z_GYRO 0x02
+#define SELF_TEST_A      0x10
+
+// Set initial input parameters
+enum Ascale {
+  AFS_2G = 0,
+  AFS_4G,
+  AFS_8G,
+  AFS_16G
+};
+
+enum Gscale {
+  GFS_250DPS = 0,
+  GFS_500DPS,
+  GFS_1000DPS,
+  GFS_2000DPS
+};
+
+// Prototypes
+void initMPU9250();
+void accelgyrocalMPU9250(float *dest1, float *dest2);
+void MPU9250SelfTest(float * destination);
+
+I2C_Handle i2c;
+
+// Specify sensor full scale
+uint8_t Gscale = GFS_250DPS;
+uint8_t Ascale = AFS_8G;
+float aRes, gRes;      // scale resolutions per LSB for the sensors
+float gyroBias[3] = {0, 0, 0}, accelBias[3] = {0, 0, 0};      // Bias corrections for gyro and accelerometer
+float SelfTest[6];
+
+void writeByte(uint8_t reg, uint8_t data) {
+
+    I2C_Transaction i2cTransaction;
+    uint8_t txBuffer[2];
+
+    txBuffer[0] = reg;
+    txBuffer[1] = data;
+    i2cTransaction.slaveAddress = Board_MPU9250_ADDR;
+    i2cTransaction.writeBuf = txBuffer;
+    i2cTransaction.writeCount = 2;
+    i2cTransaction.readBuf = NULL;
+    i2cTransaction.readCount = 0;
+
+    if (!i2cbus_transfer(i2c, &i2cTransaction)) {
+        System_printf("MPU9250: write=%x data=%x FAILED\n",reg,data);
+    }
+    System_flush();
+}
+
+bool readByte(uint8_t reg, uint8_t count, uint8_t *data) {
+
+    I2C_Transaction i2cTransaction;
+    uint8_t txBuffer[1];
+    bool ok;
+
+    txBuffer[0] = reg;
+    i2cTransaction.slaveAddress = Board_MPU9250_ADDR;
+    i2cTransaction.writeBuf = txBuffer;
+    i2cTransaction.writeCount = 1;
+    i2cTransaction.readBuf = data;
+    i2cTransaction.readCount = count;
+
+    ok = i2cbus_transfer(i2c, &i2cTransaction);
+    if (!ok) {
+        System_printf("MPU9250: read=%x count=%x FAILED\n",reg,count);
+    }
+    System_flush();
+    return ok;
+}
+
+void delay(uint16_t delay) {
+
+    Task_sleep(delay*1000 / Clock_tickPeriod);
+}
+
+void getGres() {
+
+  switch (Gscale) {
+        // Possible gyro scales (and their register bit settings) are:
+        // 250 DPS (00), 500 DPS (01), 1000 DPS (10), and 2000 DPS  (11).
+        // Here's a bit of an algorith to calculate DPS/(ADC tick) based on that 2-bit value:
+    case GFS_250DPS:
+          gRes = 250.0/32768.0;
+          break;
+    case GFS_500DPS:
+          gRes = 500.0/32768.0;
+          break;
+    case GFS_1000DPS:
+          gRes = 1000.0/32768.0;
+          break;
+    case GFS_2000DPS:
+          gRes = 2000.0/32768.0;
+          break;
+  }
+}
+
+void getAres() {
+
+  switch (Ascale) {
+          // Possible accelerometer scales (and their register bit settings) are:
+          // 2 Gs (00), 4 Gs (01), 8 Gs (10), and 16 Gs  (11).
+          // Here's a bit of an algorith to calculate DPS/(ADC tick) based on that 2-bit value:
+    case AFS_2G:
+          aRes = 2.0/32768.0;
+          break;
+    case AFS_4G:
+          aRes = 4.0/32768.0;
+          break;
+    case AFS_8G:
+          aRes = 8.0/32768.0;
+          break;
+    case AFS_16G:
+          aRes = 16.0/32768.0;
+          break;
+  }
+}
+
+void mpu9250_setup(I2C_Handle *i2c_orig) {
+
+    i2c = *i2c_orig;
+
+    System_printf("MPU9250: Setup start...\n");
+    System_flush();
+
+    // Read the WHO_AM_I register, this is a good test of communication
+    // uint8_t c;
+    // readByte( WHO_AM_I_MPU9250, 1, &c);  // Read WHO_AM_I register for MPU-9250
+    // delay(100);
+
+    MPU9250SelfTest(SelfTest); // Start by performing self test and reporting values
+    delay(100);
+
+    // get sensor resolutions, only need to do this once
+    getAres();
+    getGres();
+
+    accelgyrocalMPU9250(gyroBias, accelBias); // Calibrate gyro and accelerometers, load biases in bias registers
+    delay(100);
+
+    initMPU9250();
+    delay(100);
+
+    System_printf("MPU9250: Setup OK\n");
+    System_flush();
+}
+
+void initMPU9250() {
+
+    // wake up device
+    writeByte(PWR_MGMT_1, 0x00); // Clear sleep mode bit (6), enable all sensors
+    delay(100); // Wait for all registers to reset
+
+    // get stable time source
+    writeByte(PWR_MGMT_1, 0x01);  // Auto select clock source to be PLL gyroscope reference if ready else
+    delay(200);
+
+    // Configure Gyro and Thermometer
+    // Disable FSYNC and set thermometer and gyro bandwidth to 41 and 42 Hz, respectively;
+    // minimum delay time for this setting is 5.9 ms, which means sensor fusion update rates cannot
+    // be higher than 1 / 0.0059 = 170 Hz
+    // DLPF_CFG = bits 2:0 = 011; this limits the sample rate to 1000 Hz for both
+    // With the MPU9250, it is possible to get gyro sample rates of 32 kHz (!), 8 kHz, or 1 kHz
+    writeByte(CONFIG, 0x03);
+
+    // Set sample rate = gyroscope output rate/(1 + SMPLRT_DIV)
+    writeByte(SMPLRT_DIV, 0x04);    // Use a 200 Hz rate; a rate consistent with the filter update rate
+                                                    // determined inset in CONFIG above
+
+    // Set gyroscope full scale range
+    // Range selects FS_SEL and AFS_SEL are 0 - 3, so 2-bit values are left-shifted into positions 4:3
+    uint8_t c;
+    readByte( GYRO_CONFIG, 1, &c); // get current GYRO_CONFIG register value
+    // c = c & ~0xE0; // Clear self-test bits [7:5]
+    c = c & ~0x02; // Clear Fchoice bits [1:0]
+    c = c & ~0x18; // Clear AFS bits [4:3]
+    c = c | Gscale << 3; // Set full scale range for the gyro
+    // c =| 0x00; // Set Fchoice for the gyro to 11 by writing its inverse to bits 1:0 of GYRO_CONFIG
+    writeByte(GYRO_CONFIG, c ); // Write new GYRO_CONFIG value to register
+
+    // Set accelerometer full-scale range configuration
+    readByte( ACCEL_CONFIG,1,&c); // get current ACCEL_CONFIG register value
+    // c = c & ~0xE0; // Clear self-test bits [7:5]
+    c = c & ~0x18;  // Clear AFS bits [4:3]
+    c = c | Ascale << 3; // Set full scale range for the accelerometer
+    writeByte(ACCEL_CONFIG, c); // Write new ACCEL_CONFIG register value
+
+    // Set accelerometer sample rate configuration
+    // It is possible to get a 4 kHz sample rate from the accelerometer by choosing 1 for
+    // accel_fchoice_b bit [3]; in this case the bandwidth is 1.13 kHz
+    readByte( ACCEL_CONFIG2, 1, &c); // get current ACCEL_CONFIG2 register value
+    c = c & ~0x0F; // Clear accel_fchoice_b (bit 3) and A_DLPFG (bits [2:0])
+    c = c | 0x03;  // Set accelerometer rate to 1 kHz and bandwidth to 41 Hz
+    writeByte( ACCEL_CONFIG2, c); // Write new ACCEL_CONFIG2 register value
+
+    // The accelerometer, gyro, and thermometer are set to 1 kHz sample rates,
+    // but all these rates are further reduced by a factor of 5 to 200 Hz because of the SMPLRT_DIV setting
+
+    // Configure Interrupts and Bypass Enable
+    // Set interrupt pin active high, push-pull, hold interrupt pin level HIGH until interrupt cleared,
+    // clear on read of INT_STATUS, and enable I2C_BYPASS_EN so additional chips
+    // can join the I2C bus and all can be controlled by the Arduino as master
+    //   writeByte( INT_PIN_CFG, 0x22);
+    writeByte( INT_PIN_CFG, 0x12);  // INT is 50 microsecond pulse and any read to clear
+    writeByte( INT_ENABLE, 0x01);  // Enable data ready (bit 0) interrupt
+    delay(100);
+}
+
+
+// Function which accumulates gyro and accelerometer data after device initialization. It calculates the average
+// of the at-rest readings and then loads the resulting offsets into accelerometer and gyro bias registers.
+void accelgyrocalMPU9250(float *dest1, float *dest2) {
+
+    uint8_t data[12]; // data array to hold accelerometer and gyro x, y, z, data
+    uint16_t ii, packet_count, fifo_count;
+    int32_t gyro_bias[3]  = {0, 0, 0}, accel_bias[3] = {0, 0, 0};
+
+    // reset device
+    writeByte( PWR_MGMT_1, 0x80); // Write a one to bit 7 reset bit; toggle reset device
+    delay(100);
+
+    // get stable time source; Auto select clock source to be PLL gyroscope reference if ready
+    // else use the internal oscillator, bits 2:0 = 001
+    writeByte( PWR_MGMT_1, 0x01);
+    writeByte( PWR_MGMT_2, 0x00);
+    delay(200);
+
+    // Configure device for bias calculation
+    writeByte( INT_ENABLE, 0x00);   // Disable all interrupts
+    writeByte( FIFO_EN, 0x00);      // Disable FIFO
+    writeByte( PWR_MGMT_1, 0x00);   // Turn on internal clock source
+    writeByte( I2C_MST_CTRL, 0x00); // Disable I2C master
+    writeByte( USER_CTRL, 0x00);    // Disable FIFO and I2C master modes
+    writeByte( USER_CTRL, 0x0C);    // Reset FIFO and DMP
+    delay(15);
+
+    // Configure MPU6050 gyro and accelerometer for bias calculation
+    writeByte( CONFIG, 0x01);      // Set low-pass filter to 188 Hz
+    writeByte( SMPLRT_DIV, 0x00);  // Set sample rate to 1 kHz
+    writeByte( GYRO_CONFIG, 0x00);  // Set gyro full-scale to 250 degrees per second, maximum sensitivity
+    writeByte( ACCEL_CONFIG, 0x00); // Set accelerometer full-scale to 2 g, maximum sensitivity
+
+    uint16_t  gyrosensitivity  = 131;   // = 131 LSB/degrees/sec
+    uint16_t  accelsensitivity = 16384;  // = 16384 LSB/g
+
+    // Configure FIFO to capture accelerometer and gyro data for bias calculation
+    writeByte( USER_CTRL, 0x40);   // Enable FIFO
+    writeByte( FIFO_EN, 0x78);     // Enable gyro and accelerometer sensors for FIFO  (max size 512 bytes in MPU-9150)
+    delay(40); // accumulate 40 samples in 40 milliseconds = 480 bytes
+
+    // At end of sample accumulation, turn off FIFO sensor read
+    writeByte( FIFO_EN, 0x00);        // Disable gyro and accelerometer sensors for FIFO
+    readByte( FIFO_COUNTH, 2, &data[0]); // read FIFO sample count
+    fifo_count = ((uint16_t)data[0] << 8) | data[1];
+    packet_count = fifo_count/12;// How many sets of full gyro and accelerometer data for averaging
+
+    for (ii = 0; ii < packet_count; ii++) {
+        int16_t accel_temp[3] = {0, 0, 0}, gyro_temp[3] = {0, 0, 0};
+        readByte( FIFO_R_W, 12, &data[0]); // read data for averaging
+        accel_temp[0] = (int16_t) (((int16_t)data[0] << 8) | data[1]  ) ;  // Form signed 16-bit integer for each sample in FIFO
+        accel_temp[1] = (int16_t) (((int16_t)data[2] << 8) | data[3]  ) ;
+        accel_temp[2] = (int16_t) (((int16_t)data[4] << 8) | data[5]  ) ;
+        gyro_temp[0]  = (int16_t) (((int16_t)data[6] << 8) | data[7]  ) ;
+        gyro_temp[1]  = (int16_t) (((int16_t)data[8] << 8) | data[9]  ) ;
+        gyro_temp[2]  = (int16_t) (((int16_t)data[10] << 8) | data[11]) ;
+
+        accel_bias[0] += (int32_t) accel_temp[0]; // Sum individual signed 16-bit biases to get accumulated signed 32-bit biases
+        accel_bias[1] += (int32_t) accel_temp[1];
+        accel_bias[2] += (int32_t) accel_temp[2];
+        gyro_bias[0]  += (int32_t) gyro_temp[0];
+        gyro_bias[1]  += (int32_t) gyro_temp[1];
+        gyro_bias[2]  += (int32_t) gyro_temp[2];
+    }
+
+    accel_bias[0] /= (int32_t) packet_count; // Normalize sums to get average count biases
+    accel_bias[1] /= (int32_t) packet_count;
+    accel_bias[2] /= (int32_t) packet_count;
+    gyro_bias[0]  /= (int32_t) packet_count;
+    gyro_bias[1]  /= (int32_t) packet_count;
+    gyro_bias[2]  /= (int32_t) packet_count;
+
+    if(accel_bias[2] > 0L) {accel_bias[2] -= (int32_t) accelsensitivity;}  // Remove gravity from the z-axis accelerometer bias calculation
+    else {accel_bias[2] += (int32_t) accelsensitivity;}
+
+    // Construct the gyro biases for push to the hardware gyro bias registers, which are reset to zero upon device startup
+    data[0] = (-gyro_bias[0]/4  >> 8) & 0xFF; // Divide by 4 to get 32.9 LSB per deg/s to conform to expected bias input format
+    data[1] = (-gyro_bias[0]/4)       & 0xFF; // Biases are additive, so change sign on calculated average gyro biases
+    data[2] = (-gyro_bias[1]/4  >> 8) & 0xFF;
+    data[3] = (-gyro_bias[1]/4)       & 0xFF;
+    data[4] = (-gyro_bias[2]/4  >> 8) & 0xFF;
+    data[5] = (-gyro_bias[2]/4)       & 0xFF;
+
+    // Push gyro biases to hardware registers
+    writeByte( XG_OFFSET_H, data[0]);
+    writeByte( XG_OFFSET_L, data[1]);
+    writeByte( YG_OFFSET_H, data[2]);
+    writeByte( YG_OFFSET_L, data[3]);
+    writeByte( ZG_OFFSET_H, data[4]);
+    writeByte( ZG_OFFSET_L, data[5]);
+
+    // Output scaled gyro biases for display in the main program
+    dest1[0] = (float) gyro_bias[0]/(float) gyrosensitivity;
+    dest1[1] = (float) gyro_bias[1]/(float) gyrosensitivity;
+    dest1[2] = (float) gyro_bias[2]/(float) gyrosensitivity;
+
+    // Construct the accelerometer biases for push to the hardware accelerometer bias registers. These registers contain
+    // factory trim values which must be added to the calculated accelerometer biases; on boot up these registers will hold
+    // non-zero values. In addition, bit 0 of the lower byte must be preserved since it is used for temperature
+    // compensation calculations. Accelerometer bias registers expect bias input as 2048 LSB per g, so that
+    // the accelerometer biases calculated above must be divided by 8.
+    int32_t accel_bias_reg[3] = {0, 0, 0}; // A place to hold the factory accelerometer trim biases
+    readByte( XA_OFFSET_H, 2, &data[0]); // Read factory accelerometer trim values
+    accel_bias_reg[0] = (int32_t) (((int16_t)data[0] << 8) | data[1]);
+    readByte( YA_OFFSET_H, 2, &data[0]);
+    accel_bias_reg[1] = (int32_t) (((int16_t)data[0] << 8) | data[1]);
+    readByte( ZA_OFFSET_H, 2, &data[0]);
+    accel_bias_reg[2] = (int32_t) (((int16_t)data[0] << 8) | data[1]);
+
+    uint32_t mask = 1uL; // Define mask for temperature compensation bit 0 of lower byte of accelerometer bias registers
+    uint8_t mask_bit[3] = {0, 0, 0}; // Define array to hold mask bit for each accelerometer bias axis
+
+    for(ii = 0; ii < 3; ii++) {
+        if((accel_bias_reg[ii] & mask)) mask_bit[ii] = 0x01; // If temperature compensation bit is set, record that fact in mask_bit
+    }
+
+    // Construct total accelerometer bias, including calculated average accelerometer bias from above
+    accel_bias_reg[0] -= (accel_bias[0]/8); // Subtract calculated averaged accelerometer bias scaled to 2048 LSB/g (16 g full scale)
+    accel_bias_reg[1] -= (accel_bias[1]/8);
+    accel_bias_reg[2] -= (accel_bias[2]/8);
+
+    data[0] = (accel_bias_reg[0] >> 8) & 0xFF;
+    data[1] = (accel_bias_reg[0])      & 0xFF;
+    data[1] = data[1] | mask_bit[0]; // preserve temperature compensation bit when writing back to accelerometer bias registers
+    data[2] = (accel_bias_reg[1] >> 8) & 0xFF;
+    data[3] = (accel_bias_reg[1])      & 0xFF;
+    data[3] = data[3] | mask_bit[1]; // preserve temperature compensation bit when writing back to accelerometer bias registers
+    data[4] = (accel_bias_reg[2] >> 8) & 0xFF;
+    data[5] = (accel_bias_reg[2])      & 0xFF;
+    data[5] = data[5] | mask_bit[2]; // preserve temperature compensation bit when writing back to accelerometer bias registers
+
+    // Apparently this is not working for the acceleration biases in the MPU-9250
+    // Are we handling the temperature correction bit properly?
+    // Push accelerometer biases to hardware registers
+    /*  writeByte( XA_OFFSET_H, data[0]);
+      writeByte( XA_OFFSET_L, data[1]);
+      writeByte( YA_OFFSET_H, data[2]);
+      writeByte( YA_OFFSET_L, data[3]);
+      writeByte( ZA_OFFSET_H, data[4]);
+      writeByte( ZA_OFFSET_L, data[5]);
+     */
+    // Output scaled accelerometer biases for display in the main program
+    dest2[0] = (float)accel_bias[0]/(float)accelsensitivity;
+    dest2[1] = (float)accel_bias[1]/(float)accelsensitivity;
+    dest2[2] = (float)accel_bias[2]/(float)accelsensitivity;
+}
+
+// Accelerometer and gyroscope self test; check calibration wrt factory settings
+void MPU9250SelfTest(float * destination) // Should return percent deviation from factory trim values, +/- 14 or less deviation is a pass
+{
+    uint8_t rawData[6] = {0, 0, 0, 0, 0, 0};
+    uint8_t selfTest[6];
+    uint16_t i,ii;
+    int32_t gAvg[3] = {0}, aAvg[3] = {0}, aSTAvg[3] = {0}, gSTAvg[3] = {0};
+    float factoryTrim[6];
+    uint8_t FS = 0;
+
+    writeByte( SMPLRT_DIV, 0x00);    // Set gyro sample rate to 1 kHz
+    writeByte( CONFIG, 0x02);        // Set gyro sample rate to 1 kHz and DLPF to 92 Hz
+    writeByte( GYRO_CONFIG, FS<<3);  // Set full scale range for the gyro to 250 dps
+    writeByte( ACCEL_CONFIG2, 0x02); // Set accelerometer rate to 1 kHz and bandwidth to 92 Hz
+    writeByte( ACCEL_CONFIG, FS<<3); // Set full scale range for the accelerometer to 2 g
+
+    for(ii = 0; ii < 200; ii++) {  // get average current values of gyro and acclerometer
+
+        readByte( ACCEL_XOUT_H, 6, &rawData[0]);        // Read the six raw data registers into data array
+        aAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
+        aAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
+        aAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
+
+        readByte( GYRO_XOUT_H, 6, &rawData[0]);       // Read the six raw data registers sequentially into data array
+        gAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
+        gAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
+        gAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
+    }
+
+    for (ii =0; ii < 3; ii++) {  // Get average of 200 values and store as average current readings
+        aAvg[ii] /= 200;
+        gAvg[ii] /= 200;
+    }
+
+    // Configure the accelerometer for self-test
+    writeByte( ACCEL_CONFIG, 0xE0); // Enable self test on all three axes and set accelerometer range to +/- 2 g
+    writeByte( GYRO_CONFIG,  0xE0); // Enable self test on all three axes and set gyro range to +/- 250 degrees/s
+    delay(25);  // Delay a while to let the device stabilize
+
+    for(ii = 0; ii < 200; ii++) {  // get average self-test values of gyro and acclerometer
+
+        readByte( ACCEL_XOUT_H, 6, &rawData[0]);  // Read the six raw data registers into data array
+        aSTAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
+        aSTAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
+        aSTAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
+
+        readByte( GYRO_XOUT_H, 6, &rawData[0]);  // Read the six raw data registers sequentially into data array
+        gSTAvg[0] += (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]) ;  // Turn the MSB and LSB into a signed 16-bit value
+        gSTAvg[1] += (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]) ;
+        gSTAvg[2] += (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]) ;
+    }
+
+    for (ii =0; ii < 3; ii++) {  // Get average of 200 values and store as average self-test readings
+        aSTAvg[ii] /= 200;
+        gSTAvg[ii] /= 200;
+    }
+
+    // Configure the gyro and accelerometer for normal operation
+    writeByte( ACCEL_CONFIG, 0x00);
+    writeByte( GYRO_CONFIG,  0x00);
+    delay(25);  // Delay a while to let the device stabilize
+
+    // Retrieve accelerometer and gyro factory Self-Test Code from USR_Reg
+    readByte( SELF_TEST_X_ACCEL,1, &selfTest[0]); // X-axis accel self-test results
+    readByte( SELF_TEST_Y_ACCEL,1, &selfTest[1]); // Y-axis accel self-test results
+    readByte( SELF_TEST_Z_ACCEL,1, &selfTest[2]); // Z-axis accel self-test results
+    readByte( SELF_TEST_X_GYRO,1, &selfTest[3]);  // X-axis gyro self-test results
+    readByte( SELF_TEST_Y_GYRO,1, &selfTest[4]);  // Y-axis gyro self-test results
+    readByte( SELF_TEST_Z_GYRO,1, &selfTest[5]);  // Z-axis gyro self-test results
+
+    // Retrieve factory self-test value from self-test code reads
+    factoryTrim[0] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[0] - 1.0) )); // FT[Xa] factory trim calculation
+    factoryTrim[1] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[1] - 1.0) )); // FT[Ya] factory trim calculation
+    factoryTrim[2] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[2] - 1.0) )); // FT[Za] factory trim calculation
+    factoryTrim[3] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[3] - 1.0) )); // FT[Xg] factory trim calculation
+    factoryTrim[4] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[4] - 1.0) )); // FT[Yg] factory trim calculation
+    factoryTrim[5] = (float)(2620/1<<FS)*(pow( 1.01 , ((float)selfTest[5] - 1.0) )); // FT[Zg] factory trim calculation
+
+    // Report results as a ratio of (STR - FT)/FT; the change from Factory Trim of the Self-Test Response
+    // To get percent, must multiply by 100
+    for (i = 0; i < 3; i++) {
+        destination[i]   = 100.0*((float)(aSTAvg[i] - aAvg[i]))/factoryTrim[i] - 100.;   // Report percent differences
+        destination[i+3] = 100.0*((float)(gSTAvg[i] - gAvg[i]))/factoryTrim[i+3] - 100.; // Report percent differences
+    }
+}
+
+/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
+
+void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *gx, float *gy, float *gz) {
+    uint8_t rawData[14]; // Register data
+
+    // Read register values into array rawData
+    readByte(ACCEL_XOUT_H, 14, rawData);
+
+    // Convert the 8-bit values (the _h and _l registers) in the array rawData into 16-bit values
+    int16_t nx = (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]);
+    int16_t ny = (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]);
+    int16_t nz = (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]);
+    int16_t mx = (int16_t)(((int16_t)rawData[8] << 8) | rawData[9]);
+    int16_t my = (int16_t)(((int16_t)rawData[10] << 8) | rawData[11]);
+    int16_t mz = (int16_t)(((int16_t)rawData[12] << 8) | rawData[13]);
+
+    // Convert the 16-bit register values into g
+    *ax = (float)nx * aRes - accelBias[0];
+    *ay = (float)ny * aRes - accelBias[1];
+    *az = (float)nz * aRes - accelBias[2];
+
+    // Convert g values mx, my, mz into degrees per second
+    *gx = (float)mx * gRes;
+    *gy = (float)my * gRes;
+    *gz = (float)mz * gRes;
+}
+
+// Raw sensor counts in order ax, ay, az, gx, gy, gz, one burst read.
+// Returns false and leaves raw alone when the read fails.
+bool mpu9250_get_raw(I2C_Handle *i2c, int16_t *raw) {
+    uint8_t rawData[14];
+
+    if (!readByte(ACCEL_XOUT_H, 14, rawData)) {
+        return false;
+    }
+
+    raw[0] = (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]);
+    raw[1] = (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]);
+    raw[2] = (int16_t)(((int16_t)rawData[4] << 8) | rawData[5]);
+    raw[3] = (int16_t)(((int16_t)rawData[8] << 8) | rawData[9]);
+    raw[4] = (int16_t)(((int16_t)rawData[10] << 8) | rawData[11]);
+    raw[5] = (int16_t)(((int16_t)rawData[12] << 8) | rawData[13]);
+    return true;
+}
+
+// Raw counts from mpu9250_get_raw() to g and degrees per second, same
+// scaling and bias as mpu9250_get_data()
+void mpu9250_convert(const int16_t *raw, float *out) {
+    out[0] = (float)raw[0] * aRes - accelBias[0];
+    out[1] = (float)raw[1] * aRes - accelBias[1];
+    out[2] = (float)raw[2] * aRes - accelBias[2];
+    out[3] = (float)raw[3] * gRes;
+    out[4] = (float)raw[4] * gRes;
+    out[5] = (float)raw[5] * gRes;
+}
+
+// The accelerometer half of mpu9250_convert(), all the tilt classifier
+// reads: three soft-float conversions and multiplies instead of six
+void mpu9250_convert_accel(const int16_t *raw, float *accel) {
+    accel[0] = (float)raw[0] * aRes - accelBias[0];
+    accel[1] = (float)raw[1] * aRes - accelBias[1];
+    accel[2] = (float)raw[2] * aRes - accelBias[2];
+}
+
+// Calibration from the last mpu9250_setup(), gyro in dps and accel in g
+void mpu9250_get_bias(float *gyro, float *accel) {
+    uint8_t i;
+
+    for (i = 0; i < 3; i++) {
+        gyro[i] = gyroBias[i];
+        accel[i] = accelBias[i];
+    }
+}
+
+// Up to six consecutive registers in one transfer, the register pointer
+// auto-increments. Saves the address and register bytes of each
+// separate writeByte().
+static void writeBytes(uint8_t reg, uint8_t count, const uint8_t *data) {
+    I2C_Transaction i2cTransaction;
+    uint8_t txBuffer[7];
+    uint8_t i;
+
+    txBuffer[0] = reg;
+    for (i = 0; i < count; i++) {
+        txBuffer[1 + i] = data[i];
+    }
+    i2cTransaction.slaveAddress = Board_MPU9250_ADDR;
+    i2cTransaction.writeBuf = txBuffer;
+    i2cTransaction.writeCount = 1 + count;
+    i2cTransaction.readBuf = NULL;
+    i2cTransaction.readCount = 0;
+
+    if (!i2cbus_transfer(i2c, &i2cTransaction)) {
+        System_printf("MPU9250: write=%x count=%x FAILED\n", reg, count);
+    }
+}
+
+// Setup without self test and calibration, restores biases saved earlier
+// with mpu9250_get_bias()
+void mpu9250_setup_fast(I2C_Handle *i2c_orig, const float *gyro, const float *accel) {
+    uint8_t offsets[6];
+    int32_t bias;
+    uint8_t i;
+
+    i2c = *i2c_orig;
+
+    writeByte(PWR_MGMT_1, 0x80);  // reset, clears the gyro offset registers
+    delay(100);
+
+    getAres();
+    getGres();
+
+    for (i = 0; i < 3; i++) {
+        gyroBias[i] = gyro[i];
+        accelBias[i] = accel[i];
+
+        // Same format as accelgyrocalMPU9250(): 32.9 LSB per dps, additive
+        bias = -(int32_t)(gyro[i] * 131.0f) / 4;
+        offsets[2 * i] = (bias >> 8) & 0xFF;
+        offsets[2 * i + 1] = bias & 0xFF;
+    }
+    writeBytes(XG_OFFSET_H, sizeof(offsets), offsets);
+
+    initMPU9250();
+
+    System_printf("MPU9250: Fast setup OK\n");
+    System_flush();
+}
+
+// Scale of the raw counts, g and degrees per second per LSB
+void mpu9250_get_scale(float *accel, float *gyro) {
+    *accel = aRes;
+    *gyro = gRes;
+}
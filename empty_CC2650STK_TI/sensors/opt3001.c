@@ -1,96 +1,99 @@
-/*
- * opt3001.c
- *
- *  Created on: 22.7.2016
- *  Author: Teemu Leppanen / UBIComp / University of Oulu
- *
- *  Datakirja: http://www.ti.com/lit/ds/symlink/opt3001.pdf
- */
-
-#include <string.h>
-#include <math.h>
-
-#include <xdc/runtime/System.h>
-
-#include "sensors/opt3001.h"
-#include "Board.h"
-
-void opt3001_setup(I2C_Handle *i2c) {
-
-    I2C_Transaction i2cTransaction;
-    char itxBuffer[3];
-
-    i2cTransaction.slaveAddress = Board_OPT3001_ADDR;
-    itxBuffer[0] = OPT3001_REG_CONFIG;
-    itxBuffer[1] = 0xCE; // continuous mode s.22
-    itxBuffer[2] = 0x02;
-    i2cTransaction.writeBuf = itxBuffer;
-    i2cTransaction.writeCount = 3;
-    i2cTransaction.readBuf = NULL;
-    i2cTransaction.readCount = 0;
-
-    if (I2C_transfer(*i2c, &i2cTransaction)) {
-
-        System_printf("OPT3001: Config write ok\n");
-    } else {
-        System_printf("OPT3001: Config write failed!\n");
-    }
-    System_flush();
-
-}
-
-uint16_t opt3001_get_status(I2C_Handle *i2c) {
-
-    uint16_t e=0;
-    I2C_Transaction i2cTransaction;
-    char itxBuffer[1];
-    char irxBuffer[2];
-
-    /* Read sensor state */
-    i2cTransaction.slaveAddress = Board_OPT3001_ADDR;
-    itxBuffer[0] = OPT3001_REG_CONFIG;
-    i2cTransaction.writeBuf = itxBuffer;
-    i2cTransaction.writeCount = 1;
-    i2cTransaction.readBuf = irxBuffer;
-    i2cTransaction.readCount = 2;
-
-    if (I2C_transfer(*i2c, &i2cTransaction)) {
-
-        e = (irxBuffer[0] << 8) | irxBuffer[1];
-    } else {
-
-        e = 0;
-    }
-    return e;
-}
-
-/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
-
-double opt3001_get_data(I2C_Handle *i2c) {
-    double lux = -1.0; // return value of the function
-    uint8_t txBuffer[1];
-    uint8_t rxBuffer[2];
-
-    I2C_Transaction i2cMessage;
-    i2cMessage.slaveAddress = Board_OPT3001_ADDR;
-    txBuffer[0] = OPT3001_REG_RESULT;
-    i2cMessage.writeBuf = txBuffer;
-    i2cMessage.writeCount = 1;
-    i2cMessage.readBuf = rxBuffer;
-    i2cMessage.readCount = 2;
-
-    if (I2C_transfer(*i2c, &i2cMessage)) {
-        uint16_t rekisteri = rxBuffer[0] << 8;
-        rekisteri = rekisteri | rxBuffer[1];
-
-        uint8_t E = (rekisteri >> 12) & 0x0F;
-        uint16_t R = rekisteri & 0x0FFF;
-
-        lux = 0.01 * pow(2, E) * R;
-    } else {
-        System_printf("OPT3001: Data read failed!\n");
-        System_flush();
-    }
-
-    return lux;
-}
+/*
+ * opt3001.c
+ *
+ *  Created on: 22.7.2016
+ *  Author: Teemu Leppanen / UBIComp / University of Oulu
+ *
+ *  Datakirja: http://www.ti.com/lit/ds/symlink/opt3001.pdf
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include <xdc/runtime/System.h>
+
+#include "sensors/opt3001.h"
+#include "sensors/i2cbus.h"
+#include "Board.h"
+
+void opt3001_setup(I2C_Handle *i2c) {
+
+    I2C_Transaction i2cTransaction;
+    char itxBuffer[3];
+
+    i2cTransaction.slaveAddress = Board_OPT3001_ADDR;
+    itxBuffer[0] = OPT3001_REG_CONFIG;
+    itxBuffer[1] = 0xCE; // continuous mode s.22
+    itxBuffer[2] = 0x02;
+    i2cTransaction.writeBuf = itxBuffer;
+    i2cTransaction.writeCount = 3;
+    i2cTransaction.readBuf = NULL;
+    i2cTransaction.readCount = 0;
+
+    if (i2cbus_transfer(*i2c, &i2cTransaction)) {
+
+        System_printf("OPT3001: Config write ok\n");
+    } else {
+        System_printf("OPT3001: Config write failed!\n");
+    }
+    System_flush();
+
+}
+
+uint16_t opt3001_get_status(I2C_Handle *i2c) {
+
+    uint16_t e=0;
+    I2C_Transaction i2cTransaction;
+    char itxBuffer[1];
+    char irxBuffer[2];
+
+    /* Read sensor state */
+    i2cTransaction.slaveAddress = Board_OPT3001_ADDR;
+    itxBuffer[0] = OPT3001_REG_CONFIG;
+    i2cTransaction.writeBuf = itxBuffer;
+    i2cTransaction.writeCount = 1;
+    i2cTransaction.readBuf = irxBuffer;
+    i2cTransaction.readCount = 2;
+
+    if (i2cbus_transfer(*i2c, &i2cTransaction)) {
+
+        e = (irxBuffer[0] << 8) | irxBuffer[1];
+    } else {
+
+        e = 0;
+    }
+    return e;
+}
+
+/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
+
+double opt3001_get_data(I2C_Handle *i2c) {
+    double lux = -1.0; // return value of the function
+    uint8_t txBuffer[1];
+    uint8_t rxBuffer[2];
+
+    I2C_Transaction i2cMessage;
+    i2cMessage.slaveAddress = Board_OPT3001_ADDR;
+    txBuffer[0] = OPT3001_REG_RESULT;
+    i2cMessage.writeBuf = txBuffer;
+    i2cMessage.writeCount = 1;
+    i2cMessage.readBuf = rxBuffer;
+    i2cMessage.readCount = 2;
+
+    if (i2cbus_transfer(*i2c, &i2cMessage)) {
+        uint16_t rekisteri = rxBuffer[0] << 8;
+        rekisteri = rekisteri | rxBuffer[1];
+
+        uint8_t E = (rekisteri >> 12) & 0x0F;
+        uint16_t R = rekisteri & 0x0FFF;
+
+        // 0.01 lux * 2^E * R, the power of two as a shift instead of a
+        // soft-float pow() call. R << E fits 27 bits.
+        lux = (double)((uint32_t)R << E) / 100.0;
+    } else {
+        System_printf("OPT3001: Data read failed!\n");
+        System_flush();
+    }
+
+    return lux;
+}
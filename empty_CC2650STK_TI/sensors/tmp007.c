@@ -1,45 +1,81 @@
-/*
- * tmp007.c
- *
- *  Created on: 28.9.2016
- *  Author: Teemu Leppanen / UBIComp / University of Oulu
- *
- *  Datakirja: http://www.ti.com/lit/ds/symlink/tmp007.pdf
- */
-
-#include <xdc/runtime/System.h>
-#include <string.h>
-#include "Board.h"
-#include "tmp007.h"
-
-void tmp007_setup(I2C_Handle *i2c) {
-
-	System_printf("TMP007: Config OK!\n");
-    System_flush();
-}
-
-/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
-
-double tmp007_get_data(I2C_Handle *i2c) {
-
-	double temperature = 0.0; // return value of the function
-    // JTKJ: Find out the correct buffer sizes with this sensor?
-    // char txBuffer[ n ];
-    // char rxBuffer{ n ];
-
-    // JTKJ: Fill in the i2cMessage data structure with correct values
-    //       as shown in the lecture material
-    I2C_Transaction i2cMessage;
-
-	if (I2C_transfer(*i2c, &i2cMessage)) {
-
-        // JTKJ: Here the conversion from register value to temperature
-
-	} else {
-
-		System_printf("TMP007: Data read failed!\n");
-		System_flush();
-	}
-
-	return temperature;
-}
+/*
+ * tmp007.c
+ *
+ *  Created on: 28.9.2016
+ *  Author: Teemu Leppanen / UBIComp / University of Oulu
+ *
+ *  Datakirja: http://www.ti.com/lit/ds/symlink/tmp007.pdf
+ */
+
+#include <xdc/runtime/System.h>
+#include <string.h>
+#include "Board.h"
+#include "tmp007.h"
+#include "i2cbus.h"
+
+void tmp007_setup(I2C_Handle *i2c) {
+
+	System_printf("TMP007: Config OK!\n");
+    System_flush();
+}
+
+/**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
+
+int tmp007_get_fixed(I2C_Handle *i2c, int32_t *temperature) {
+
+    uint8_t txBuffer[1];
+    uint8_t rxBuffer[2];
+    int16_t rekisteri;
+    int32_t v;
+
+    I2C_Transaction i2cMessage;
+    i2cMessage.slaveAddress = Board_TMP007_ADDR;
+    txBuffer[0] = TMP007_REG_TEMP;
+    i2cMessage.writeBuf = txBuffer;
+    i2cMessage.writeCount = 1;
+    i2cMessage.readBuf = rxBuffer;
+    i2cMessage.readCount = 2;
+
+    if (!i2cbus_transfer(*i2c, &i2cMessage)) {
+        System_printf("TMP007: Data read failed!\n");
+        System_flush();
+        return -1;
+    }
+
+    // 14-bit two's complement in the high bits, 0.03125 C a count: 25/8 of
+    // a hundredth, rounded half away from zero
+    rekisteri = (int16_t)((rxBuffer[0] << 8) | rxBuffer[1]);
+    v = (int32_t)(rekisteri >> 2) * 25;
+    *temperature = (v + (v < 0 ? -4 : 4)) / 8;
+    return 0;
+}
+
+double tmp007_get_data(I2C_Handle *i2c) {
+
+    int32_t t;
+
+    if (tmp007_get_fixed(i2c, &t) != 0) {
+        return 0.0;
+    }
+    return t / 100.0;
+}
+
+// Bus recovery reinit. The setup leaves the TMP007 at its power-on
+// configuration, which is written back here in case a brown-out or a
+// reset in the middle of a transfer changed it.
+void tmp007_reinit(I2C_Handle *i2c) {
+
+    uint8_t txBuffer[3] = {TMP007_REG_CONFIG, TMP007_CONFIG_DEFAULT >> 8, TMP007_CONFIG_DEFAULT & 0xFF};
+
+    I2C_Transaction i2cMessage;
+    i2cMessage.slaveAddress = Board_TMP007_ADDR;
+    i2cMessage.writeBuf = txBuffer;
+    i2cMessage.writeCount = 3;
+    i2cMessage.readBuf = NULL;
+    i2cMessage.readCount = 0;
+
+    if (!i2cbus_transfer(*i2c, &i2cMessage)) {
+        System_printf("TMP007: Config write failed!\n");
+        System_flush();
+    }
+}
@@ -1,20 +1,31 @@
-/*
- * tmp007.h
- *
- *  Created on: 28.9.2016
- *  Author: Teemu Leppanen / UBIComp / University of Oulu
- *
- *  Datakirja: http://www.ti.com/lit/ds/symlink/tmp007.pdf
- */
-
-#ifndef TMP007_H_
-#define TMP007_H_
-
-#include <ti/drivers/I2C.h>
-
-#define TMP007_REG_TEMP	0x03
-
-void tmp007_setup(I2C_Handle *i2c);
-double tmp007_get_data(I2C_Handle *i2c);
-
-#endif /* TMP007_H_ */
+/*
+ * tmp007.h
+ *
+ *  Created on: 28.9.2016
+ *  Author: Teemu Leppanen / UBIComp / University of Oulu
+ *
+ *  Datakirja: http://www.ti.com/lit/ds/symlink/tmp007.pdf
+ */
+
+#ifndef TMP007_H_
+#define TMP007_H_
+
+#include <stdint.h>
+#include <ti/drivers/I2C.h>
+
+#define TMP007_REG_TEMP	0x03
+#define TMP007_REG_CONFIG	0x02
+
+// Continuous conversion, 4 averages: the power-on value
+#define TMP007_CONFIG_DEFAULT	0x1440
+
+void tmp007_setup(I2C_Handle *i2c);
+double tmp007_get_data(I2C_Handle *i2c);
+
+// The object temperature in 0.01 C without doubles. Returns 0 or -1.
+int tmp007_get_fixed(I2C_Handle *i2c, int32_t *temperature);
+
+// Writes the configuration back after an I2C bus recovery
+void tmp007_reinit(I2C_Handle *i2c);
+
+#endif /* TMP007_H_ */
@@ -0,0 +1,98 @@
+/*
+ * standby.c
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+
+#include "standby.h"
+
+static Power_NotifyObj notifyObj;
+static uint8_t held = 0;
+static uint32_t timestampFreq;
+static uint64_t bootTime;
+static uint64_t standbyStart;
+static uint64_t standbyTime = 0;    // Timestamp counts
+static uint32_t entries = 0;
+
+static uint64_t now64(void) {
+    Types_Timestamp64 t;
+
+    Timestamp_get64(&t);
+    return ((uint64_t)t.hi << 32) | t.lo;
+}
+
+static int standbyNotifyFxn(unsigned int eventType, uintptr_t eventArg, uintptr_t clientArg) {
+    if (eventType == PowerCC26XX_ENTERING_STANDBY) {
+        standbyStart = now64();
+        entries++;
+    } else if (eventType == PowerCC26XX_AWAKE_STANDBY) {
+        standbyTime += now64() - standbyStart;
+    }
+    return Power_NOTIFYDONE;
+}
+
+void standby_init(void) {
+    Types_FreqHz freq;
+
+    Timestamp_getFreq(&freq);
+    timestampFreq = freq.lo;
+    bootTime = now64();
+
+    Power_registerNotify(&notifyObj, PowerCC26XX_ENTERING_STANDBY | PowerCC26XX_AWAKE_STANDBY,
+                         (Power_NotifyFxn)standbyNotifyFxn, 0);
+}
+
+void standby_hold(StandbyClient client) {
+    UInt key = Hwi_disable();
+
+    if (!(held & (1 << client))) {
+        if (held == 0) {
+            Power_setConstraint(PowerCC26XX_SB_DISALLOW);
+        }
+        held |= 1 << client;
+    }
+    Hwi_restore(key);
+}
+
+void standby_release(StandbyClient client) {
+    UInt key = Hwi_disable();
+
+    if (held & (1 << client)) {
+        held &= ~(1 << client);
+        if (held == 0) {
+            Power_releaseConstraint(PowerCC26XX_SB_DISALLOW);
+        }
+    }
+    Hwi_restore(key);
+}
+
+void standby_stats(StandbyStats *stats) {
+    UInt key = Hwi_disable();
+
+    stats->uptime_us = (now64() - bootTime) * 1000000 / timestampFreq;
+    stats->standby_us = standbyTime * 1000000 / timestampFreq;
+    stats->entries = entries;
+    stats->held = held;
+    Hwi_restore(key);
+}
+
+uint32_t standby_estimate_ua(const StandbyStats *stats, uint16_t active) {
+    uint32_t sleep;
+    uint32_t idle;
+
+    if (stats->uptime_us == 0) {
+        return STANDBY_ACTIVE_UA;
+    }
+    sleep = (uint32_t)(stats->standby_us * 1000 / stats->uptime_us);
+    if (active + sleep > 1000) {
+        active = 1000 - sleep;
+    }
+    idle = 1000 - active - sleep;
+
+    return (active * STANDBY_ACTIVE_UA + idle * STANDBY_IDLE_UA + sleep * STANDBY_SLEEP_UA) / 1000;
+}
@@ -0,0 +1,48 @@
+/*
+ * standby.h
+ *
+ *  Standby power policy. Peripherals that cannot tolerate standby hold
+ *  a client reference while they are busy; the PowerCC26XX standby
+ *  constraint is set only while at least one client holds it, so the
+ *  policy can enter standby whenever every task is blocked.
+ *
+ *  Standby entries and residency are counted through Power notifications
+ *  using the RTC based Timestamp, which keeps running in standby.
+ */
+
+#ifndef STANDBY_H_
+#define STANDBY_H_
+
+#include <stdint.h>
+
+// Typical CC2650 supply currents for the estimate, MCU only (datasheet)
+#define STANDBY_ACTIVE_UA   2900    // CPU running at 48 MHz
+#define STANDBY_IDLE_UA     550     // CPU in WFI, peripheral domain on
+#define STANDBY_SLEEP_UA    1       // standby with RTC and RAM retention
+
+typedef enum {
+    STANDBY_UART = 0,   // RX armed, link awake
+    STANDBY_BUZZER,     // GPT0 PWM running
+    STANDBY_LED,        // GPT1 PWM dimming the LED
+    STANDBY_INDICATOR,  // GPT2 timing an indicator pattern
+    STANDBY_CLIENT_COUNT
+} StandbyClient;
+
+typedef struct {
+    uint64_t uptime_us;
+    uint64_t standby_us;
+    uint32_t entries;
+    uint8_t held;       // bit per StandbyClient
+} StandbyStats;
+
+void standby_init(void);
+
+void standby_hold(StandbyClient client);
+void standby_release(StandbyClient client);
+
+void standby_stats(StandbyStats *stats);
+
+// Average current in microamps, active is the CPU busy share in per mille
+uint32_t standby_estimate_ua(const StandbyStats *stats, uint16_t active);
+
+#endif /* STANDBY_H_ */
@@ -0,0 +1,144 @@
+/*
+ * supervisor.c
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/drivers/Watchdog.h>
+
+#include "Board.h"
+#include "supervisor.h"
+
+#define RECORD_MAGIC 0x53555056  // "SUPV"
+
+// Not zeroed at startup, keeps its contents over a watchdog reset
+#if defined(__TI_COMPILER_VERSION__)
+#pragma NOINIT(retained)
+static SupervisorRecord retained;
+#else
+static SupervisorRecord retained __attribute__((section(".noinit")));
+#endif
+
+static SupervisorRecord last;
+static Watchdog_Handle watchdog;
+static Clock_Struct supervisorClockStruct;
+static SupervisorPingFxn pingFxn;
+static uint32_t deadline[SUPERVISOR_CLIENT_COUNT];
+static uint8_t active = 0;
+static Bool failed = FALSE;
+
+static uint32_t recordCheck(const SupervisorRecord *rec) {
+    const uint8_t *p = (const uint8_t *)rec;
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for (i = 0; i < offsetof(SupervisorRecord, check); i++) {
+        sum = (sum << 1 | sum >> 31) ^ p[i];
+    }
+    return sum;
+}
+
+static void recordFailure(SupervisorCause cause, uint8_t client) {
+    retained.resets++;
+    retained.cause = cause;
+    retained.client = client;
+    retained.uptime_ms = (uint64_t)Clock_getTicks() * Clock_tickPeriod / 1000;
+    retained.check = recordCheck(&retained);
+}
+
+// First watchdog timeout, the next one resets the device
+static void watchdogFxn(UArg arg) {
+    if (!failed) {
+        failed = TRUE;
+        recordFailure(SUPERVISOR_CAUSE_WATCHDOG, 0);
+    }
+}
+
+static void supervisorClockFxn(UArg arg) {
+    uint32_t now = Clock_getTicks();
+    uint8_t i;
+
+    if (failed) {
+        return;  // let the watchdog reset the device
+    }
+
+    for (i = 0; i < SUPERVISOR_CLIENT_COUNT; i++) {
+        if ((active & (1 << i)) && (int32_t)(now - deadline[i]) > 0) {
+            failed = TRUE;
+            recordFailure(SUPERVISOR_CAUSE_HUNG, i);
+            return;
+        }
+    }
+
+    Watchdog_clear(watchdog);
+    if (pingFxn != NULL) {
+        pingFxn();
+    }
+}
+
+void supervisor_init(SupervisorPingFxn ping) {
+    Watchdog_Params watchdogParams;
+    Clock_Params clockParams;
+
+    if (retained.magic != RECORD_MAGIC || retained.check != recordCheck(&retained)) {
+        memset(&retained, 0, sizeof(retained));
+        retained.magic = RECORD_MAGIC;
+    }
+    last = retained;
+    retained.cause = SUPERVISOR_CAUSE_NONE;  // an unsupervised reset must not look like this one
+    retained.check = recordCheck(&retained);
+
+    pingFxn = ping;
+
+    Watchdog_Params_init(&watchdogParams);
+    watchdogParams.callbackFxn = watchdogFxn;
+    watchdogParams.resetMode = Watchdog_RESET_ON;
+    watchdogParams.debugStallMode = Watchdog_DEBUG_STALL_ON;
+    watchdog = Watchdog_open(Board_WATCHDOG0, &watchdogParams);
+    if (watchdog == NULL) {
+        System_abort("Error opening the watchdog");
+    }
+
+    Clock_Params_init(&clockParams);
+    clockParams.period = SUPERVISOR_PERIOD_MS * 1000 / Clock_tickPeriod;
+    clockParams.startFlag = TRUE;
+    Clock_construct(&supervisorClockStruct, (Clock_FuncPtr)supervisorClockFxn, clockParams.period, &clockParams);
+}
+
+void supervisor_checkin(SupervisorClient client, uint32_t nextMs) {
+    uint32_t ticks = (nextMs + SUPERVISOR_MARGIN_MS) * (1000 / Clock_tickPeriod);
+    UInt key = Hwi_disable();
+
+    deadline[client] = Clock_getTicks() + ticks;
+    active |= 1 << client;
+    Hwi_restore(key);
+}
+
+const SupervisorRecord *supervisor_last(void) {
+    return &last;
+}
+
+void supervisor_save_calibration(const float *gyro, const float *accel) {
+    UInt key = Hwi_disable();
+
+    memcpy(retained.gyroBias, gyro, sizeof(retained.gyroBias));
+    memcpy(retained.accelBias, accel, sizeof(retained.accelBias));
+    retained.calibrated = 1;
+    retained.check = recordCheck(&retained);
+    Hwi_restore(key);
+}
+
+// Only after a supervised reset, a power cycle always recalibrates
+Bool supervisor_fast_restart(float *gyro, float *accel) {
+    if (last.cause == SUPERVISOR_CAUSE_NONE || !last.calibrated) {
+        return FALSE;
+    }
+    memcpy(gyro, last.gyroBias, sizeof(last.gyroBias));
+    memcpy(accel, last.accelBias, sizeof(last.accelBias));
+    return TRUE;
+}
@@ -0,0 +1,63 @@
+/*
+ * supervisor.h
+ *
+ *  Task health supervision on top of the hardware watchdog. Every
+ *  supervised stage checks in and says when it will check in next; a
+ *  periodic Clock kicks the watchdog only while no stage is overdue.
+ *
+ *  The reason for a supervised reset and the MPU9250 calibration survive
+ *  the reset in a retained RAM record, so the next boot can report the
+ *  cause and skip the self test and calibration.
+ */
+
+#ifndef SUPERVISOR_H_
+#define SUPERVISOR_H_
+
+#include <stdint.h>
+
+#include <xdc/std.h>
+
+#define SUPERVISOR_PERIOD_MS    500     // watchdog reload is 1000 ms (CC2650STK.c)
+#define SUPERVISOR_MARGIN_MS    2000    // slack on top of a stage's own period
+
+typedef enum {
+    SUPERVISOR_SENSOR = 0,
+    SUPERVISOR_APP,
+    SUPERVISOR_CLIENT_COUNT
+} SupervisorClient;
+
+typedef enum {
+    SUPERVISOR_CAUSE_NONE = 0,  // power on or external reset
+    SUPERVISOR_CAUSE_HUNG,      // a stage missed its check-in
+    SUPERVISOR_CAUSE_WATCHDOG,  // the supervisor itself stopped running
+} SupervisorCause;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t resets;        // supervised resets since power on
+    uint8_t cause;          // SupervisorCause of the last reset
+    uint8_t client;         // stage that hung
+    uint8_t calibrated;
+    uint32_t uptime_ms;     // at the failure
+    float gyroBias[3];
+    float accelBias[3];
+    uint32_t check;
+} SupervisorRecord;
+
+// Called periodically from the supervisor Clock, should make the app stage
+// check in (it blocks while there is no work)
+typedef void (*SupervisorPingFxn)(void);
+
+void supervisor_init(SupervisorPingFxn ping);
+
+// Promises the next check-in within nextMs plus SUPERVISOR_MARGIN_MS
+void supervisor_checkin(SupervisorClient client, uint32_t nextMs);
+
+// The retained record as it was at boot
+const SupervisorRecord *supervisor_last(void);
+
+// Calibration kept across supervised resets
+void supervisor_save_calibration(const float *gyro, const float *accel);
+Bool supervisor_fast_restart(float *gyro, float *accel);
+
+#endif /* SUPERVISOR_H_ */
@@ -0,0 +1,382 @@
+/*
+ * corebench.cpp
+ *
+ *  Micro-benchmarks of the core library on the host: the decoder, the
+ *  keying classifier, the gesture engine and the protocol code. Host
+ *  timings only rank changes against each other, the board is around
+ *  two orders of magnitude slower.
+ *
+ *  BM_SampleCopies and BM_SamplePipeline hand IMU samples to 1 to 3
+ *  consumers (classifier, logger, streamer) the way the firmware did
+ *  before core/pipeline.c and the way it does now. copied_bytes counts
+ *  the sample data each sample costs in copies.
+ *
+ *  Usage: corebench [--benchmark_filter=regex] ...
+ */
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "fsm.h"
+#include "gesture.h"
+#include "keyer.h"
+#include "morse.h"
+#include "pipeline.h"
+#include "pool.h"
+#include "protocol.h"
+#include "tscodec.h"
+
+namespace {
+
+const char *const kCodes[] = {
+    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---", "-.-", ".-..", "--",
+    "-.", "---", ".--.", "--.-", ".-.", "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..",
+};
+
+void BM_DecodeMorse(benchmark::State &state) {
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decodeMorse(kCodes[i]));
+        i = (i + 1) % (sizeof(kCodes) / sizeof(kCodes[0]));
+    }
+}
+BENCHMARK(BM_DecodeMorse);
+
+void BM_EncodeMorse(benchmark::State &state) {
+    char out[8];
+    char letter = 'A';
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encodeMorse(letter, out));
+        letter = letter == 'Z' ? 'A' : letter + 1;
+    }
+}
+BENCHMARK(BM_EncodeMorse);
+
+void ignore(char) {}
+
+// One letter through the state machine: symbols, then the gap
+void BM_FsmLetter(benchmark::State &state) {
+    Fsm fsm;
+    fsm_init(&fsm, ignore, ignore);
+    for (auto _ : state) {
+        fsm_dispatch(&fsm, FSM_EV_DASH);
+        fsm_dispatch(&fsm, FSM_EV_DOT);
+        fsm_dispatch(&fsm, FSM_EV_DASH);
+        fsm_dispatch(&fsm, FSM_EV_DOT);
+        fsm_dispatch(&fsm, FSM_EV_GAP);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FsmLetter);
+
+void BM_KeyerClick(benchmark::State &state) {
+    Keyer k;
+    uint32_t now = 0;
+    keyer_init(&k);
+    for (auto _ : state) {
+        keyer_click(&k, now, 500000);
+        benchmark::DoNotOptimize(keyer_expire(&k, now));
+        now += 600000;
+    }
+}
+BENCHMARK(BM_KeyerClick);
+
+// Accelerometer samples at rest and tilted each way, in g
+const float kAccel[][3] = {
+    {0.0f, 0.0f, 1.0f}, {0.8f, 0.0f, 0.6f}, {-0.8f, 0.0f, 0.6f}, {0.0f, 0.0f, -1.0f}, {0.1f, 0.7f, 0.7f},
+};
+
+void BM_GestureClassify(benchmark::State &state) {
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gesture_classify(kAccel[i], 500));
+        i = (i + 1) % (sizeof(kAccel) / sizeof(kAccel[0]));
+    }
+}
+BENCHMARK(BM_GestureClassify);
+
+void BM_KeyerTilt(benchmark::State &state) {
+    Keyer k;
+    uint32_t now = 0;
+    size_t i = 0;
+    keyer_init(&k);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(keyer_tilt(&k, now, kAccel[i], 500, 200000));
+        now += 10000;
+        i = (i + 1) % (sizeof(kAccel) / sizeof(kAccel[0]));
+    }
+}
+BENCHMARK(BM_KeyerTilt);
+
+std::vector<uint8_t> randomBytes(size_t n) {
+    std::mt19937 rng(1);
+    std::vector<uint8_t> v(n);
+    for (uint8_t &b : v) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return v;
+}
+
+void BM_Crc16(benchmark::State &state) {
+    std::vector<uint8_t> data = randomBytes(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(protocol_crc16(data.data(), data.size(), 0xFFFF));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Crc16)->Arg(16)->Arg(PROTO_MAX_PAYLOAD);
+
+void BM_CobsEncode(benchmark::State &state) {
+    std::vector<uint8_t> data = randomBytes(state.range(0));
+    std::vector<uint8_t> out(data.size() + data.size() / 254 + 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(protocol_cobs_encode(data.data(), data.size(), out.data()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CobsEncode)->Arg(16)->Arg(PROTO_MAX_PAYLOAD);
+
+void BM_CobsDecode(benchmark::State &state) {
+    std::vector<uint8_t> data = randomBytes(state.range(0));
+    std::vector<uint8_t> coded(data.size() + data.size() / 254 + 2);
+    std::vector<uint8_t> out(data.size());
+    uint16_t n = protocol_cobs_encode(data.data(), data.size(), coded.data());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(protocol_cobs_decode(coded.data(), n, out.data()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CobsDecode)->Arg(16)->Arg(PROTO_MAX_PAYLOAD);
+
+void BM_BuildFrame(benchmark::State &state) {
+    std::vector<uint8_t> payload = randomBytes(state.range(0));
+    uint8_t frame[PROTO_MAX_FRAME];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(protocol_build_frame(PROTO_MSG_TEXT, payload.data(), payload.size(), frame));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BuildFrame)->Arg(16)->Arg(PROTO_MAX_PAYLOAD);
+
+// IMU samples of a board held still, with sensor noise
+struct ImuBlock {
+    int16_t raw[PROTO_IMU_MAX_SAMPLES][PROTO_IMU_AXES];
+    const int16_t *rows[PROTO_IMU_MAX_SAMPLES];
+
+    ImuBlock() {
+        std::mt19937 rng(2);
+        std::normal_distribution<float> noise(0.0f, 20.0f);
+        const int16_t rest[PROTO_IMU_AXES] = {0, 0, 16384, 0, 0, 0};
+        for (int i = 0; i < PROTO_IMU_MAX_SAMPLES; i++) {
+            for (int a = 0; a < PROTO_IMU_AXES; a++) {
+                raw[i][a] = static_cast<int16_t>(rest[a] + noise(rng));
+            }
+            rows[i] = raw[i];
+        }
+    }
+};
+
+void BM_PackImuBatch(benchmark::State &state) {
+    ImuBlock block;
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(protocol_pack_imu_batch(payload, 0, 10000, block.rows, PROTO_IMU_MAX_SAMPLES));
+    }
+    state.SetItemsProcessed(state.iterations() * PROTO_IMU_MAX_SAMPLES);
+}
+BENCHMARK(BM_PackImuBatch);
+
+void BM_PackImuPacked(benchmark::State &state) {
+    ImuBlock block;
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(protocol_pack_imu_packed(payload, 0, 10000, block.rows, PROTO_IMU_MAX_SAMPLES));
+    }
+    state.SetItemsProcessed(state.iterations() * PROTO_IMU_MAX_SAMPLES);
+}
+BENCHMARK(BM_PackImuPacked);
+
+void BM_TscodecDecode(benchmark::State &state) {
+    ImuBlock block;
+    uint8_t coded[PROTO_MAX_PAYLOAD];
+    int32_t out[PROTO_IMU_MAX_SAMPLES * PROTO_IMU_AXES];
+    uint16_t n = tscodec_encode16(coded, sizeof(coded), block.rows, PROTO_IMU_AXES, PROTO_IMU_MAX_SAMPLES);
+    if (n == 0) {
+        state.SkipWithError("block does not fit");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tscodec_decode(coded, n, out, PROTO_IMU_MAX_SAMPLES * PROTO_IMU_AXES));
+    }
+    state.SetItemsProcessed(state.iterations() * PROTO_IMU_MAX_SAMPLES);
+}
+BENCHMARK(BM_TscodecDecode);
+
+// A sensor read: the burst the MPU9250 returns, in counts
+struct ImuSource {
+    ImuBlock block;
+    int next = 0;
+
+    const int16_t *read() {
+        const int16_t *raw = block.raw[next];
+        next = (next + 1) % PROTO_IMU_MAX_SAMPLES;
+        return raw;
+    }
+};
+
+constexpr float kAccelRes = 2.0f / 32768.0f;
+constexpr float kGyroRes = 250.0f / 32768.0f;
+
+void convert(const int16_t *raw, float *out) {
+    for (int a = 0; a < PROTO_IMU_AXES; a++) {
+        out[a] = raw[a] * (a < 3 ? kAccelRes : kGyroRes);
+    }
+}
+
+// Before: the sensor step converted into globals through out-pointers,
+// every consumer took its own copy and the streamer gathered a batch
+float gAx, gAy, gAz, gGx, gGy, gGz;
+
+void getData(const int16_t *burst, float *ax, float *ay, float *az, float *gx, float *gy, float *gz) {
+    int16_t raw[PROTO_IMU_AXES];
+    float v[PROTO_IMU_AXES];
+
+    std::memcpy(raw, burst, sizeof(raw));
+    convert(raw, v);
+    *ax = v[0];
+    *ay = v[1];
+    *az = v[2];
+    *gx = v[3];
+    *gy = v[4];
+    *gz = v[5];
+}
+
+void BM_SampleCopies(benchmark::State &state) {
+    ImuSource source;
+    Keyer keyer;
+    uint32_t now = 0;
+    int64_t copied = 0;
+    float history[PROTO_IMU_AXES];
+    int16_t batch[PROTO_IMU_MAX_SAMPLES][PROTO_IMU_AXES];
+    const int16_t *rows[PROTO_IMU_MAX_SAMPLES];
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    int count = 0;
+    const int consumers = static_cast<int>(state.range(0));
+
+    keyer_init(&keyer);
+    for (int i = 0; i < PROTO_IMU_MAX_SAMPLES; i++) {
+        rows[i] = batch[i];
+    }
+    for (auto _ : state) {
+        const int16_t *burst = source.read();
+        getData(burst, &gAx, &gAy, &gAz, &gGx, &gGy, &gGz);
+        copied += PROTO_IMU_AXES * (sizeof(int16_t) + sizeof(float));
+
+        float accel[PROTO_IMU_AXES] = {gAx, gAy, gAz, gGx, gGy, gGz};
+        copied += sizeof(accel);
+        benchmark::DoNotOptimize(keyer_tilt(&keyer, now, accel, 500, 200000));
+        if (consumers > 1) {
+            const float v[PROTO_IMU_AXES] = {gAx, gAy, gAz, gGx, gGy, gGz};
+            std::memcpy(history, v, sizeof(history));
+            copied += sizeof(history);
+            benchmark::DoNotOptimize(history);
+        }
+        if (consumers > 2) {
+            // The raw counts are gone by now, so they were kept aside too
+            std::memcpy(batch[count], burst, sizeof(batch[0]));
+            copied += sizeof(batch[0]);
+            if (++count == PROTO_IMU_MAX_SAMPLES) {
+                benchmark::DoNotOptimize(protocol_pack_imu_batch(payload, now, 10000, rows, count));
+                count = 0;
+            }
+        }
+        now += 10000;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["copied_bytes"] = benchmark::Counter(copied, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SampleCopies)->DenseRange(1, 3);
+
+// Now: one pooled buffer read in place, shared by reference
+Keyer pipelineKeyer;
+Sample *streamBatch[PROTO_IMU_MAX_SAMPLES];
+int streamCount;
+
+void classifySample(Sample *sample) {
+    float value[PROTO_IMU_AXES];
+
+    convert(sample->raw, value);
+    benchmark::DoNotOptimize(keyer_tilt(&pipelineKeyer, sample->timestamp_us, value, 500, 200000));
+}
+
+void logSample(Sample *sample) {
+    float value[PROTO_IMU_AXES];
+
+    convert(sample->raw, value);
+    benchmark::DoNotOptimize(value);
+}
+
+void streamSample(Sample *sample) {
+    const int16_t *rows[PROTO_IMU_MAX_SAMPLES];
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+
+    pipeline_retain(sample);
+    streamBatch[streamCount] = sample;
+    if (++streamCount < PROTO_IMU_MAX_SAMPLES) {
+        return;
+    }
+    for (int i = 0; i < streamCount; i++) {
+        rows[i] = streamBatch[i]->raw;
+    }
+    benchmark::DoNotOptimize(
+        protocol_pack_imu_batch(payload, streamBatch[0]->timestamp_us, 10000, rows, streamCount));
+    for (int i = 0; i < streamCount; i++) {
+        pipeline_release(streamBatch[i]);
+    }
+    streamCount = 0;
+}
+
+void BM_SamplePipeline(benchmark::State &state) {
+    const SampleSubscriber subscribers[] = {classifySample, logSample, streamSample};
+    ImuSource source;
+    uint32_t now = 0;
+    int64_t copied = 0;
+
+    pool_init();
+    pipeline_init();
+    keyer_init(&pipelineKeyer);
+    streamCount = 0;
+    for (int i = 0; i < state.range(0); i++) {
+        pipeline_subscribe(subscribers[i]);
+    }
+    for (auto _ : state) {
+        Sample *sample = pipeline_acquire(now);
+        if (!sample) {
+            state.SkipWithError("pool empty");
+            break;
+        }
+        // The I2C burst lands in the buffer, the one copy there is
+        std::memcpy(sample->raw, source.read(), sizeof(sample->raw));
+        copied += sizeof(sample->raw);
+        pipeline_publish(sample);
+        now += 10000;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["copied_bytes"] = benchmark::Counter(copied, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SamplePipeline)->DenseRange(1, 3);
+
+void BM_PoolAllocFree(benchmark::State &state) {
+    pool_init();
+    for (auto _ : state) {
+        void *block = pool_alloc(static_cast<uint16_t>(state.range(0)));
+        benchmark::DoNotOptimize(block);
+        pool_free(block);
+    }
+}
+BENCHMARK(BM_PoolAllocFree)->Arg(16)->Arg(sizeof(Sample));
+
+} // namespace
@@ -0,0 +1,81 @@
+/*
+ * hal_posix.c
+ *
+ *  The core HAL (core/hal.h) for host tools on Linux. Real time from the
+ *  monotonic clock, no sensor bus, the LED and buzzer are variables and
+ *  the serial link is stdout. The lock is one mutex, taken by the
+ *  outermost hal_lock() of a thread, so the host stress tests can run the
+ *  core from several threads like tasks, Swis and Hwis share it on the
+ *  board.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "hal.h"
+
+static struct timespec start;
+static int led;
+static uint16_t tone;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread uint32_t lockDepth;
+
+void hal_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+}
+
+uint32_t hal_time_us(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - start.tv_sec) * 1000000LL + (now.tv_nsec - start.tv_nsec) / 1000);
+}
+
+// Nanoseconds stand in for cycles, the host has no portable cycle counter
+uint32_t hal_cycles(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - start.tv_sec) * 1000000000LL + (now.tv_nsec - start.tv_nsec));
+}
+
+uint32_t hal_lock(void) {
+    if (lockDepth == 0) {
+        pthread_mutex_lock(&lock);
+    }
+    return lockDepth++;
+}
+
+void hal_unlock(uint32_t key) {
+    assert(key + 1 == lockDepth);
+    lockDepth = key;
+    if (lockDepth == 0) {
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+void hal_led_set(int on) {
+    led = on ? 255 : 0;
+}
+
+int hal_led_get(void) {
+    return led != 0;
+}
+
+void hal_led_level(uint8_t level) {
+    led = level;
+}
+
+void hal_tone(uint16_t hz) {
+    tone = hz;
+}
+
+int hal_i2c_transfer(uint8_t address, const uint8_t *tx, uint16_t txLen, uint8_t *rx, uint16_t rxLen) {
+    return -1;
+}
+
+int hal_uart_write(const void *buf, uint16_t len) {
+    return (int)fwrite(buf, 1, len, stdout);
+}
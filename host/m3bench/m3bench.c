@@ -0,0 +1,338 @@
+/*
+ * m3bench.c
+ *
+ *  m3bench: instructions per call of the firmware's hot paths and of
+ *  their replacements on a Cortex-M3 with soft float, under QEMU with
+ *  instruction counting (-icount). Built and run by CMakeLists.txt in
+ *  this directory, which adds the code size of each function from the
+ *  symbol table and prints both as one table.
+ *
+ *  Each group pairs the code as it was (before) with what replaced it
+ *  (after). First checks that each pair gives the same results, exits
+ *  with 1 if not. Then runs every function RUNS times between two reads
+ *  of SysTick, less the cost of an empty call, and prints a line
+ *      m3bench <group> <before|after> <symbols> <instructions x 100>
+ *  for each. With -icount shift=S QEMU counts 2^S ns an instruction
+ *  and SysTick runs at the board's 25 MHz, so a tick is 40 >> S
+ *  instructions.
+ *
+ *  QEMU does not model the pipeline: a Cortex-M3 takes one cycle for
+ *  most instructions, two for loads, two to four for taken branches and
+ *  up to twelve for a divide, so cycles are these counts times 1.2 to
+ *  1.5. The before and after columns compare like with like.
+ *
+ *  The firmware files are compiled with the simulator's TI-RTOS headers
+ *  (host/sim/include); the stand-ins below are never called.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "m3bench.h"
+#include "morse.h"
+#include "sensors/bmp280.h"
+#include "sensors/i2cbus.h"
+#include "sensors/mpu9250.h"
+
+#ifndef M3BENCH_CLOCK_HZ
+#define M3BENCH_CLOCK_HZ    25000000    // mps2-an385 system clock
+#endif
+#ifndef M3BENCH_ICOUNT_SHIFT
+#define M3BENCH_ICOUNT_SHIFT 0
+#endif
+
+#define RUNS    1000
+
+#define SYST_CSR    (*(volatile uint32_t *)0xE000E010)
+#define SYST_RVR    (*(volatile uint32_t *)0xE000E014)
+#define SYST_CVR    (*(volatile uint32_t *)0xE000E018)
+#define SYST_24BIT  0xFFFFFF
+
+/* Stand-ins for what bmp280.c and mpu9250.c call besides the benchmarked code */
+
+UInt32 Clock_tickPeriod = 10;
+
+Int System_printf(const char *fmt, ...) {
+    return 0;
+}
+
+void System_flush(void) {
+}
+
+void Task_sleep(UInt32 nticks) {
+}
+
+bool i2cbus_transfer(I2C_Handle handle, I2C_Transaction *transaction) {
+    return false;
+}
+
+/* Driver internals the drivers' headers do not declare */
+
+extern float aRes, gRes, accelBias[3];
+void bmp280_set_trimming(char *v);
+double bmp280_temp_compensation(uint32_t adc_T);
+double bmp280_convert_pres(uint32_t adc_P);
+
+/* The code as it was */
+
+typedef struct {
+    const char *code;
+    char letter;
+} MorseCode;
+
+static const MorseCode morseMap[] = {
+    {".-", 'A'}, {"-...", 'B'}, {"-.-.", 'C'}, {"-..", 'D'}, {".", 'E'},
+    {"..-.", 'F'}, {"--.", 'G'}, {"....", 'H'}, {"..", 'I'}, {".---", 'J'},
+    {"-.-", 'K'}, {".-..", 'L'}, {"--", 'M'}, {"-.", 'N'}, {"---", 'O'},
+    {".--.", 'P'}, {"--.-", 'Q'}, {".-.", 'R'}, {"...", 'S'}, {"-", 'T'},
+    {"..-", 'U'}, {"...-", 'V'}, {".--", 'W'}, {"-..-", 'X'}, {"-.--", 'Y'},
+    {"--..", 'Z'}, {"-----", '0'}, {".----", '1'}, {"..---", '2'}, {"...--", '3'},
+    {"....-", '4'}, {".....", '5'}, {"-....", '6'}, {"--...", '7'}, {"---..", '8'},
+    {"----.", '9'}, {NULL, '\0'}
+};
+
+// decodeMorse() before the tree, a scan of the table
+__attribute__((noinline)) char decodeMorse_table(const char *morse) {
+    int i;
+    for (i = 0; morseMap[i].code != NULL; i++) {
+        if (strcmp(morseMap[i].code, morse) == 0) {
+            return morseMap[i].letter;
+        }
+    }
+    return '?';
+}
+
+// The conversion of opt3001_get_data() before and after pow() went
+__attribute__((noinline)) double opt3001_lux_pow(uint16_t rekisteri) {
+    uint8_t E = (rekisteri >> 12) & 0x0F;
+    uint16_t R = rekisteri & 0x0FFF;
+
+    return 0.01 * pow(2, E) * R;
+}
+
+__attribute__((noinline)) double opt3001_lux_shift(uint16_t rekisteri) {
+    uint8_t E = (rekisteri >> 12) & 0x0F;
+    uint16_t R = rekisteri & 0x0FFF;
+
+    return (double)((uint32_t)R << E) / 100.0;
+}
+
+/* Inputs */
+
+static const char *const codes[] = {
+    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---", "-.-", ".-..", "--",
+    "-.", "---", ".--.", "--.-", ".-.", "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..",
+    "-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----.",
+    "......", ".-.-", "x",
+};
+#define CODES (sizeof(codes) / sizeof(codes[0]))
+
+// Datasheet example trimming, little endian as the BMP280 sends it
+static char trimming[24] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,                     // T1 27504, T2 26435, T3 -1000
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B,         // P1 36477, P2 -10685, P3 3024, P4 2855
+    0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6,         // P5 140, P6 -7, P7 15500, P8 -14600
+    0x70, 0x17,                                             // P9 6000
+};
+#define ADC_T   519888
+#define ADC_P   415148
+
+static const int16_t imu[4][6] = {
+    {0, 0, 4096, 0, 0, 0},
+    {5120, -300, 2048, 120, -45, 3},
+    {-6000, 800, 1500, -2000, 900, -15},
+    {200, 4100, -300, 32767, -32768, 1},
+};
+
+static volatile char sinkChar;
+static volatile double sinkDouble;
+static volatile int32_t sinkInt;
+static volatile float sinkFloat;
+
+static void runNothing(unsigned i) {
+    sinkInt = i;
+}
+
+static void runDecodeTable(unsigned i) {
+    sinkChar = decodeMorse_table(codes[i % CODES]);
+}
+
+static void runDecodeTree(unsigned i) {
+    sinkChar = decodeMorse(codes[i % CODES]);
+}
+
+static uint16_t optRegister(unsigned i) {
+    return (uint16_t)((i % 12) << 12 | ((i * 37) & 0xFFF));
+}
+
+static void runLuxPow(unsigned i) {
+    sinkDouble = opt3001_lux_pow(optRegister(i));
+}
+
+static void runLuxShift(unsigned i) {
+    sinkDouble = opt3001_lux_shift(optRegister(i));
+}
+
+static void runPresDouble(unsigned i) {
+    sinkDouble = bmp280_convert_pres(ADC_P + (i & 255) * 16);
+}
+
+static void runPresFixed(unsigned i) {
+    sinkInt = bmp280_pres_q8(ADC_P + (i & 255) * 16);
+}
+
+static void runConvertAll(unsigned i) {
+    float out[6];
+
+    mpu9250_convert(imu[i & 3], out);
+    sinkFloat = out[0];
+}
+
+static void runConvertAccel(unsigned i) {
+    float out[3];
+
+    mpu9250_convert_accel(imu[i & 3], out);
+    sinkFloat = out[0];
+}
+
+typedef struct {
+    const char *group;
+    const char *when;
+    const char *symbols;        // whose sizes make up the code size, '+' between
+    void (*run)(unsigned i);
+} Bench;
+
+static const Bench benches[] = {
+    {"decode", "before", "decodeMorse_table+strcmp", runDecodeTable},
+    {"decode", "after", "decodeMorse", runDecodeTree},
+    {"opt3001_lux", "before", "opt3001_lux_pow+pow", runLuxPow},
+    {"opt3001_lux", "after", "opt3001_lux_shift", runLuxShift},
+    {"bmp280_pressure", "before", "bmp280_convert_pres+__aeabi_l2d+__aeabi_ddiv", runPresDouble},
+    {"bmp280_pressure", "after", "bmp280_pres_q8", runPresFixed},
+    {"mpu9250_classify", "before", "mpu9250_convert", runConvertAll},
+    {"mpu9250_classify", "after", "mpu9250_convert_accel", runConvertAccel},
+};
+
+/* Output without printf, which would pull in most of newlib */
+
+static char *putText(char *p, const char *s) {
+    while (*s) {
+        *p++ = *s++;
+    }
+    return p;
+}
+
+static char *putUint(char *p, uint32_t v) {
+    char digits[10];
+    int n = 0;
+
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+static void fail(const char *what, uint32_t i) {
+    char line[80];
+    char *p = putText(line, "m3bench: ");
+
+    p = putText(p, what);
+    p = putText(p, " differ at input ");
+    p = putUint(p, i);
+    p = putText(p, "\n");
+    *p = '\0';
+    m3_print(line);
+    m3_exit(1);
+}
+
+// The replacements must give what the code before them gave
+static void check(void) {
+    float all[6], accel[3];
+    unsigned i;
+
+    for (i = 0; i < CODES; i++) {
+        if (decodeMorse_table(codes[i]) != decodeMorse(codes[i])) {
+            fail("decodeMorse", i);
+        }
+    }
+    for (i = 0; i < 12 * 64; i++) {
+        double before = opt3001_lux_pow(optRegister(i));
+        if (fabs(opt3001_lux_shift(optRegister(i)) - before) > before * 1e-12) {
+            fail("opt3001 lux", i);
+        }
+    }
+    for (i = 0; i < 256; i++) {
+        if (bmp280_pres_q8(ADC_P + i * 16) / 256.0 != bmp280_convert_pres(ADC_P + i * 16)) {
+            fail("bmp280 pressure", i);
+        }
+    }
+    for (i = 0; i < 4; i++) {
+        mpu9250_convert(imu[i], all);
+        mpu9250_convert_accel(imu[i], accel);
+        if (memcmp(all, accel, sizeof(accel)) != 0) {
+            fail("mpu9250 accel", i);
+        }
+    }
+}
+
+// SysTick ticks of RUNS calls
+static uint32_t measure(void (*run)(unsigned)) {
+    uint32_t start, ticks;
+    unsigned i;
+
+    SYST_CSR = 0;
+    SYST_RVR = SYST_24BIT;
+    SYST_CVR = 0;
+    SYST_CSR = 5;   // processor clock, no interrupt
+    start = SYST_CVR;
+    for (i = 0; i < RUNS; i++) {
+        run(i);
+    }
+    ticks = (start - SYST_CVR) & SYST_24BIT;
+    SYST_CSR = 0;
+    return ticks;
+}
+
+int main(void) {
+    uint32_t overhead;
+    unsigned b;
+
+    bmp280_set_trimming(trimming);
+    bmp280_temp_compensation(ADC_T);    // sets t_fine
+    aRes = 8.0f / 32768.0f;             // AFS_8G and GFS_250DPS, as mpu9250_setup() sets them
+    gRes = 250.0f / 32768.0f;
+    accelBias[0] = 0.012f;
+    accelBias[1] = -0.03f;
+    accelBias[2] = 0.004f;
+
+    check();
+
+    overhead = measure(runNothing);
+    for (b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        uint32_t ticks = measure(benches[b].run);
+        uint64_t ns = (uint64_t)(ticks > overhead ? ticks - overhead : 0) * (1000000000u / M3BENCH_CLOCK_HZ);
+        char line[128];
+        char *p = putText(line, "m3bench ");
+
+        p = putText(p, benches[b].group);
+        p = putText(p, " ");
+        p = putText(p, benches[b].when);
+        p = putText(p, " ");
+        p = putText(p, benches[b].symbols);
+        p = putText(p, " ");
+        p = putUint(p, (uint32_t)((ns >> M3BENCH_ICOUNT_SHIFT) * 100 / RUNS));
+        p = putText(p, "\n");
+        *p = '\0';
+        m3_print(line);
+    }
+    return 0;
+}
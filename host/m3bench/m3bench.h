@@ -0,0 +1,13 @@
+/*
+ * m3bench.h
+ *
+ *  What startup.c gives the benchmark: semihosting output and exit.
+ */
+
+#ifndef M3BENCH_H_
+#define M3BENCH_H_
+
+void m3_print(const char *text);
+void m3_exit(int status);
+
+#endif /* M3BENCH_H_ */
@@ -0,0 +1,113 @@
+# m3table.cmake
+#
+#  Runs m3bench under QEMU and makes its lines into a table with the code
+#  size of each function from the symbol table:
+#
+#      cmake -DQEMU=qemu-system-arm -DNM=arm-none-eabi-nm -DELF=<m3bench.elf>
+#            -DSHIFT=<icount shift> [-DOUT=<file>] -P m3table.cmake
+#
+#  Instructions per call are QEMU's counts (see m3bench.c), bytes are the
+#  sizes of the symbols each line names, helpers such as pow() or the
+#  soft-float division included. Fails if m3bench does, e.g. when a
+#  replacement no longer gives what the code before it gave.
+#
+#  Run by the m3table target of CMakeLists.txt in this directory.
+
+execute_process(
+    COMMAND ${QEMU} -M mps2-an385 -cpu cortex-m3 -nographic -monitor none -serial none
+        -semihosting-config enable=on,target=native -icount shift=${SHIFT} -kernel ${ELF}
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+    RESULT_VARIABLE status
+    TIMEOUT 300)
+if(NOT status EQUAL 0)
+    message(FATAL_ERROR "m3bench failed (${status}):\n${output}")
+endif()
+
+execute_process(COMMAND ${NM} -S -t d ${ELF} OUTPUT_VARIABLE listing RESULT_VARIABLE status)
+if(NOT status EQUAL 0)
+    message(FATAL_ERROR "nm failed on ${ELF}")
+endif()
+string(REPLACE "\n" ";" lines "${listing}")
+foreach(line IN LISTS lines)
+    # value size type name, code only
+    if(line MATCHES "^[0-9]+ ([0-9]+) [tTwW] (.+)$")
+        math(EXPR size_${CMAKE_MATCH_2} "${CMAKE_MATCH_1}")
+    endif()
+endforeach()
+
+# Hundredths to a fixed point string
+function(centi value out)
+    math(EXPR whole "${value} / 100")
+    math(EXPR frac "${value} % 100")
+    if(frac LESS 10)
+        set(frac "0${frac}")
+    endif()
+    set(${out} "${whole}.${frac}" PARENT_SCOPE)
+endfunction()
+
+# Right aligned in width, left aligned with a negative width
+function(pad text width out)
+    string(LENGTH "${text}" n)
+    if(width LESS 0)
+        math(EXPR width "-${width}")
+        set(left TRUE)
+    endif()
+    while(n LESS width)
+        if(left)
+            string(APPEND text " ")
+        else()
+            string(PREPEND text " ")
+        endif()
+        math(EXPR n "${n} + 1")
+    endwhile()
+    set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+set(groups "")
+string(REPLACE "\n" ";" lines "${output}")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^m3bench ([a-z0-9_]+) (before|after) ([^ ]+) ([0-9]+)")
+        set(group ${CMAKE_MATCH_1})
+        set(when ${CMAKE_MATCH_2})
+        list(APPEND groups ${group})
+        set(${group}_${when}_insns ${CMAKE_MATCH_4})
+        set(bytes 0)
+        string(REPLACE "+" ";" symbols "${CMAKE_MATCH_3}")
+        foreach(symbol IN LISTS symbols)
+            if(DEFINED size_${symbol})
+                math(EXPR bytes "${bytes} + ${size_${symbol}}")
+            endif()
+        endforeach()
+        set(${group}_${when}_bytes ${bytes})
+    endif()
+endforeach()
+list(REMOVE_DUPLICATES groups)
+if(NOT groups)
+    message(FATAL_ERROR "no results from m3bench:\n${output}")
+endif()
+
+set(report "Cortex-M3, soft float, QEMU -icount shift=${SHIFT}: instructions per call and bytes of code\n\n")
+string(APPEND report "group                 before   bytes      after   bytes   insns\n")
+foreach(group IN LISTS groups)
+    centi(${${group}_before_insns} before)
+    centi(${${group}_after_insns} after)
+    if(${group}_before_insns GREATER 0)
+        math(EXPR change "(${${group}_after_insns} - ${${group}_before_insns}) * 100 / ${${group}_before_insns}")
+        set(change "${change}%")
+    else()
+        set(change "-")
+    endif()
+    pad("${group}" -18 g)
+    pad("${before}" 10 before)
+    pad("${${group}_before_bytes}" 8 bb)
+    pad("${after}" 11 after)
+    pad("${${group}_after_bytes}" 8 ab)
+    pad("${change}" 8 change)
+    string(APPEND report "${g}${before}${bb}${after}${ab}${change}\n")
+endforeach()
+
+message("${report}")
+if(OUT)
+    file(WRITE ${OUT} "${report}")
+endif()
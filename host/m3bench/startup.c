@@ -0,0 +1,68 @@
+/*
+ * startup.c
+ *
+ *  Bare-metal start of m3bench on QEMU's mps2-an385: the vector table,
+ *  .data and .bss set up, then main(). Output and exit go through ARM
+ *  semihosting, which QEMU serves with -semihosting-config enable=on.
+ */
+
+#include <stdint.h>
+
+#include "m3bench.h"
+
+#define SYS_WRITE0      0x04
+#define SYS_EXIT        0x18
+#define ADP_EXIT        0x20026     // application exit, QEMU exits with 0
+#define ADP_ERROR       0x20023     // run time error, QEMU exits with 1
+
+extern uint32_t __data_load[], __data_start[], __data_end[];
+extern uint32_t __bss_start[], __bss_end[];
+extern uint32_t __stack_top[];
+
+int main(void);
+
+static uint32_t semihost(uint32_t op, const void *arg) {
+    register uint32_t r0 __asm__("r0") = op;
+    register const void *r1 __asm__("r1") = arg;
+
+    __asm__ volatile("bkpt 0xab" : "+r"(r0) : "r"(r1) : "memory");
+    return r0;
+}
+
+void m3_print(const char *text) {
+    semihost(SYS_WRITE0, text);
+}
+
+void m3_exit(int status) {
+    semihost(SYS_EXIT, (const void *)(uintptr_t)(status ? ADP_ERROR : ADP_EXIT));
+    for (;;) {
+    }
+}
+
+void resetHandler(void) {
+    uint32_t *src = __data_load, *dst;
+
+    for (dst = __data_start; dst < __data_end; dst++) {
+        *dst = *src++;
+    }
+    for (dst = __bss_start; dst < __bss_end; dst++) {
+        *dst = 0;
+    }
+    m3_exit(main());
+}
+
+static void faultHandler(void) {
+    m3_print("m3bench: fault\n");
+    m3_exit(1);
+}
+
+__attribute__((section(".vectors"), used))
+static void (*const vectors[16])(void) = {
+    (void (*)(void))__stack_top,
+    resetHandler,
+    faultHandler,   // NMI
+    faultHandler,   // hard fault
+    faultHandler,   // memory management
+    faultHandler,   // bus fault
+    faultHandler,   // usage fault
+};
@@ -0,0 +1,303 @@
+/*
+ * audio.cpp
+ *
+ *  morseaudio: run the board's CW audio decoder (audio.h) over WAV files,
+ *  or over generated signals to measure its accuracy.
+ *
+ *  Usage: morseaudio <file.wav> [-t text] [-v]
+ *         morseaudio -s [-t text] [-w wpm,...] [-n snr,...] [-f hz] [-r seed] [-o dir] [-v]
+ *
+ *  A file is resampled to 16 kHz if it is not, fed to the decoder in the
+ *  board's PDM block size and the events through fsm_dispatch(). Prints the
+ *  decoded text and what the decoder tracked; with -t also the character
+ *  accuracy against the expected text. -v prints every event with its time.
+ *
+ *  -s sweeps generated CW of the text over speeds (-w, wpm) and signal to
+ *  noise ratios (-n, dB in 2500 Hz, white noise) at one pitch (-f) and
+ *  prints the accuracy for each. -o also writes the signals as WAV files
+ *  to dir, to listen to or to decode again.
+ *
+ *  Build: see CMakeLists.txt at the top of the repository.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "audio.h"
+#include "fsm.h"
+#include "morse.h"
+#include "wav_file.h"
+
+using namespace morsecap;
+
+namespace {
+
+constexpr uint16_t kBlock = 64;         // PDM block on the board
+constexpr double kAmplitude = 2000;     // tone peak, leaves room for the noise
+constexpr double kNoiseBandHz = 2500;   // the usual bandwidth for CW SNR figures
+constexpr double kEdgeS = 0.005;        // raised cosine keying edges
+
+const char *const kDefaultText = "CQ CQ DE OH2JTK THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 73";
+
+bool verbose = false;
+Fsm fsm;
+std::string text;
+double busyS = 0;
+
+void emitSymbol(char) {
+}
+
+void emitText(char c) {
+    text += c;
+}
+
+void emitEvent(int event, uint32_t at_us) {
+    static const char *const names[] = {"dot", "dash", "gap", "reset", "end"};
+
+    if (verbose) {
+        std::printf("%10.3f %s\n", at_us / 1e6, names[event]);
+    }
+    fsm_dispatch(&fsm, static_cast<FsmEvent>(event));
+}
+
+// Linear interpolation, enough for tones well below either Nyquist
+std::vector<int16_t> resample(const Wav &wav) {
+    std::vector<int16_t> out;
+
+    if (wav.rate == AUDIO_RATE) {
+        return wav.samples;
+    }
+    double step = static_cast<double>(wav.rate) / AUDIO_RATE;
+    for (double pos = 0; pos + 1 < wav.samples.size(); pos += step) {
+        size_t i = static_cast<size_t>(pos);
+        double f = pos - i;
+        out.push_back(static_cast<int16_t>(std::lround(wav.samples[i] * (1 - f) + wav.samples[i + 1] * f)));
+    }
+    return out;
+}
+
+// Runs the decoder over 16 kHz samples and two seconds of silence after
+// them, so the last letter and word end. Returns the decoded text.
+std::string decode(const std::vector<int16_t> &pcm, AudioStats &stats) {
+    AudioDecoder decoder;
+    std::vector<int16_t> padded = pcm;
+
+    padded.resize(pcm.size() + 2 * AUDIO_RATE);
+    text.clear();
+    fsm_init(&fsm, emitSymbol, emitText);
+    audio_init(&decoder, emitEvent);
+
+    auto started = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < padded.size(); i += kBlock) {
+        uint16_t n = static_cast<uint16_t>(std::min<size_t>(kBlock, padded.size() - i));
+        audio_process(&decoder, &padded[i], n, static_cast<uint32_t>(i * 1000000 / AUDIO_RATE));
+    }
+    busyS += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    audio_stats(&decoder, &stats);
+    while (!text.empty() && text.back() == ' ') {
+        text.pop_back();
+    }
+    return text;
+}
+
+// Upper case with single spaces, so only letters count
+std::string normalize(const std::string &s) {
+    std::istringstream words(s);
+    std::string word, out;
+
+    while (words >> word) {
+        out += (out.empty() ? "" : " ") + word;
+    }
+    for (char &c : out) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+// 1 - edit distance / expected length
+double accuracy(const std::string &expected, const std::string &decoded) {
+    std::string a = normalize(expected), b = normalize(decoded);
+    std::vector<size_t> row(b.size() + 1);
+
+    for (size_t j = 0; j <= b.size(); j++) {
+        row[j] = j;
+    }
+    for (size_t i = 1; i <= a.size(); i++) {
+        size_t diag = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            size_t up = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1])});
+            diag = up;
+        }
+    }
+    return a.empty() ? 1.0 : std::max(0.0, 1.0 - static_cast<double>(row[b.size()]) / a.size());
+}
+
+// Keyed text at PARIS timing, half a second of noise before and after
+Wav synthesize(const std::string &message, double wpm, double hz, double snrDb, std::mt19937 &rng) {
+    std::vector<std::pair<bool, double>> keying;    // key down, units
+    double unitS = 1.2 / wpm;
+    char code[MORSE_MAX_SYMBOLS + 1];
+    Wav wav;
+
+    keying.push_back({false, 0.5 / unitS});
+    for (char c : message) {
+        if (c == ' ') {
+            keying.back().second += 4;
+            continue;
+        }
+        int n = encodeMorse(c, code);
+        for (int i = 0; i < n; i++) {
+            keying.push_back({true, code[i] == '-' ? 3.0 : 1.0});
+            keying.push_back({false, i == n - 1 ? 3.0 : 1.0});
+        }
+    }
+    keying.back().second += 0.5 / unitS;
+
+    double noisePower = kAmplitude * kAmplitude / 2 / std::pow(10, snrDb / 10) / (kNoiseBandHz / (AUDIO_RATE / 2));
+    std::normal_distribution<double> noise(0, std::sqrt(noisePower));
+    double t = 0;
+
+    wav.rate = AUDIO_RATE;
+    for (const auto &k : keying) {
+        size_t n = static_cast<size_t>(k.second * unitS * AUDIO_RATE);
+        for (size_t i = 0; i < n; i++, t += 1.0 / AUDIO_RATE) {
+            double in = i / static_cast<double>(AUDIO_RATE), left = (n - i) / static_cast<double>(AUDIO_RATE);
+            double gain = 0;
+            if (k.first) {
+                gain = std::min({1.0, in / kEdgeS, left / kEdgeS});
+                gain = (1 - std::cos(M_PI * gain)) / 2;
+            }
+            double v = gain * kAmplitude * std::sin(2 * M_PI * hz * t) + noise(rng);
+            wav.samples.push_back(static_cast<int16_t>(std::lround(std::max(-32768.0, std::min(32767.0, v)))));
+        }
+    }
+    return wav;
+}
+
+std::vector<double> parseList(const char *arg) {
+    std::vector<double> values;
+    std::istringstream in(arg);
+    std::string item;
+
+    while (std::getline(in, item, ',')) {
+        values.push_back(std::strtod(item.c_str(), nullptr));
+    }
+    return values;
+}
+
+void printStats(const AudioStats &st) {
+    std::fprintf(stderr, "tone %u Hz, %u wpm, %lu marks, %lu glitches, signal %lu noise %lu\n", st.freq_hz,
+                 st.wpm, (unsigned long)st.marks, (unsigned long)st.glitches, (unsigned long)st.signal,
+                 (unsigned long)st.noise);
+}
+
+int sweep(const std::string &message, const std::vector<double> &speeds, const std::vector<double> &snrs,
+          double hz, uint32_t seed, const char *dir) {
+    std::mt19937 rng(seed);
+    double audioS = 0;
+
+    std::printf("accuracy %% at %.0f Hz, SNR in %.0f Hz\n%8s", hz, kNoiseBandHz, "snr dB");
+    for (double wpm : speeds) {
+        std::printf(" %6.0f wpm", wpm);
+    }
+    std::printf("\n");
+    for (double snr : snrs) {
+        std::printf("%8.1f", snr);
+        for (double wpm : speeds) {
+            Wav wav = synthesize(message, wpm, hz, snr, rng);
+            AudioStats st;
+            std::string decoded = decode(wav.samples, st);
+
+            audioS += static_cast<double>(wav.samples.size()) / AUDIO_RATE + 2;
+            std::printf(" %10.1f", 100 * accuracy(message, decoded));
+            if (verbose) {
+                std::printf("\n%s\n", decoded.c_str());
+            }
+            if (dir) {
+                char path[256];
+                std::snprintf(path, sizeof(path), "%s/cw_%.0fwpm_%+.0fdb.wav", dir, wpm, snr);
+                if (!writeWav(path, wav)) {
+                    std::fprintf(stderr, "%s: cannot write\n", path);
+                    return 1;
+                }
+            }
+        }
+        std::printf("\n");
+    }
+    std::fprintf(stderr, "kernel: %.1f us per %d us hop on this host\n",
+                 busyS * 1e6 / (audioS * 1e6 / AUDIO_HOP_US), AUDIO_HOP_US);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *path = nullptr, *expected = nullptr, *dir = nullptr;
+    std::vector<double> speeds = {10, 15, 20, 25, 30, 40};
+    std::vector<double> snrs = {20, 10, 6, 3, 0, -3, -6};
+    double hz = 700;
+    uint32_t seed = 1;
+    bool sweeping = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-s")) {
+            sweeping = true;
+        } else if (!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+            expected = argv[++i];
+        } else if (!std::strcmp(argv[i], "-w") && i + 1 < argc) {
+            speeds = parseList(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-n") && i + 1 < argc) {
+            snrs = parseList(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            hz = std::strtod(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "-r") && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (!std::strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else if (!path && !sweeping) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            sweeping = false;
+            break;
+        }
+    }
+    if (sweeping == (path != nullptr)) {
+        std::fprintf(stderr,
+                     "usage: %s <file.wav> [-t text] [-v]\n"
+                     "       %s -s [-t text] [-w wpm,...] [-n snr,...] [-f hz] [-r seed] [-o dir] [-v]\n",
+                     argv[0], argv[0]);
+        return 2;
+    }
+    if (sweeping) {
+        return sweep(expected ? expected : kDefaultText, speeds, snrs, hz, seed, dir);
+    }
+
+    Wav wav;
+    std::string error;
+    if (!readWav(path, wav, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    AudioStats st;
+    std::string decoded = decode(resample(wav), st);
+    std::printf("text: %s\n", decoded.c_str());
+    if (expected) {
+        std::printf("accuracy: %.1f%%\n", 100 * accuracy(expected, decoded));
+    }
+    printStats(st);
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * baroeval.cpp
+ *
+ *  baroeval: run the board's altitude gesture detector (baro.h) over
+ *  recorded pressure, and score it against the gestures that were made.
+ *
+ *  Usage: baroeval [-l lift_cm] [-w window_ms] [-v] <file>...
+ *
+ *  A file is a trace (.mtr) with pressure records, recorded with the
+ *  board's baro_ms set, or a CSV of time_ms,pressure_pa rows with an
+ *  optional third cell naming a gesture that starts at that row; a header
+ *  line is skipped. In a trace the gestures are notes (`note lift`, `note
+ *  lower`) made as the board starts to move. "lift", "up" and "space" are
+ *  a gap, "lower", "down" and "end" the end of the message.
+ *
+ *  The detector runs at lift_cm (default 40, the board's lift_cm). A
+ *  detection of the right kind within window_ms (default 5000, the longest
+ *  gesture and a second) after an unmatched gesture is a hit, any other
+ *  detection a false alarm, and a gesture without one a miss. For each
+ *  file prints
+ *    - readings, their rate and the reading noise (rms of successive
+ *      differences over the square root of 2)
+ *    - the drift of the baseline over the file, in Pa an hour
+ *    - hits, misses, false alarms, rejected excursions and the mean and
+ *      worst latency from the gesture to its event
+ *  With -v each detection and each miss too. Exits with 1 on a miss or a
+ *  false alarm.
+ *
+ *  Build: see CMakeLists.txt at the top of the repository.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "baro.h"
+#include "fsm.h"
+#include "trace_file.h"
+
+using namespace morsecap;
+
+namespace {
+
+struct Reading {
+    uint64_t t_us;
+    int32_t pressure;       // Pa, BARO_FRAC fraction bits
+};
+
+struct Gesture {
+    uint64_t t_us;
+    int event;
+    bool matched = false;
+};
+
+struct Recording {
+    std::vector<Reading> readings;
+    std::vector<Gesture> gestures;
+};
+
+bool verbose = false;
+
+bool hasSuffix(const std::string &s, const char *suffix) {
+    size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// The event a gesture name stands for, -1 if none
+int gestureEvent(const std::string &name) {
+    if (name == "lift" || name == "up" || name == "space") {
+        return FSM_EV_GAP;
+    }
+    if (name == "lower" || name == "down" || name == "end") {
+        return FSM_EV_END;
+    }
+    return -1;
+}
+
+const char *eventName(int event) {
+    return event == FSM_EV_GAP ? "gap" : "end";
+}
+
+bool loadTrace(const std::string &path, Recording &rec) {
+    TraceFile file;
+
+    if (!file.open(path)) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), file.error().c_str());
+        return false;
+    }
+    file.visit([&](const TraceRecord &r, uint64_t t) {
+        if (r.type == TRACE_REC_PRESSURE) {
+            rec.readings.push_back({t, r.u.pressure});
+        } else if (r.type == TRACE_REC_NOTE) {
+            int event = gestureEvent(std::string(r.u.note.text, r.u.note.len));
+            if (event >= 0) {
+                rec.gestures.push_back({t, event});
+            }
+        }
+    });
+    return true;
+}
+
+bool loadCsv(const std::string &path, Recording &rec) {
+    std::ifstream in(path);
+    std::string line;
+
+    if (!in) {
+        std::fprintf(stderr, "%s: cannot open\n", path.c_str());
+        return false;
+    }
+    while (std::getline(in, line)) {
+        std::stringstream cells(line);
+        std::string time, pressure, name;
+        char *end1, *end2;
+
+        std::getline(cells, time, ',');
+        std::getline(cells, pressure, ',');
+        std::getline(cells, name, ',');
+        double ms = std::strtod(time.c_str(), &end1);
+        double pa = std::strtod(pressure.c_str(), &end2);
+        if (end1 == time.c_str() || end2 == pressure.c_str()) {
+            continue;
+        }
+        uint64_t t = static_cast<uint64_t>(ms * 1000.0);
+        rec.readings.push_back({t, static_cast<int32_t>(std::lround(pa * (1 << BARO_FRAC)))});
+        while (!name.empty() && (name.back() == '\r' || name.back() == ' ')) {
+            name.pop_back();
+        }
+        int event = gestureEvent(name);
+        if (event >= 0) {
+            rec.gestures.push_back({t, event});
+        }
+    }
+    return true;
+}
+
+int run(const std::string &path, Recording &rec, int32_t liftCm, uint32_t windowMs) {
+    const std::vector<Reading> &r = rec.readings;
+
+    if (r.size() < 2) {
+        std::fprintf(stderr, "%s: no pressure readings\n", path.c_str());
+        return 1;
+    }
+
+    BaroDetector d;
+    int32_t threshold = baro_threshold(liftCm);
+    unsigned hits = 0, falseAlarms = 0, misses = 0;
+    double latencySum = 0, latencyMax = 0, squares = 0;
+    int64_t firstBase = 0;
+
+    baro_init(&d);
+    for (size_t i = 0; i < r.size(); i++) {
+        int event = baro_update(&d, static_cast<uint32_t>(r[i].t_us / 1000), r[i].pressure, threshold);
+        if (i == 0) {
+            firstBase = d.base;
+        } else {
+            double diff = (r[i].pressure - r[i - 1].pressure) / double(1 << BARO_FRAC);
+            squares += diff * diff;
+        }
+        if (event < 0) {
+            continue;
+        }
+
+        Gesture *match = nullptr;
+        for (Gesture &g : rec.gestures) {
+            if (!g.matched && g.event == event && g.t_us <= r[i].t_us && r[i].t_us - g.t_us <= windowMs * 1000ull) {
+                match = &g;
+                break;
+            }
+        }
+        if (match) {
+            double latency = (r[i].t_us - match->t_us) / 1000.0;
+            match->matched = true;
+            hits++;
+            latencySum += latency;
+            latencyMax = std::max(latencyMax, latency);
+        } else {
+            falseAlarms++;
+        }
+        if (verbose) {
+            std::printf("%10.3f s  %-3s %s\n", r[i].t_us / 1e6, eventName(event), match ? "hit" : "false alarm");
+        }
+    }
+    for (const Gesture &g : rec.gestures) {
+        if (!g.matched) {
+            misses++;
+            if (verbose) {
+                std::printf("%10.3f s  %-3s missed\n", g.t_us / 1e6, eventName(g.event));
+            }
+        }
+    }
+
+    double seconds = (r.back().t_us - r.front().t_us) / 1e6;
+    double drift = (d.base - firstBase) / double(int64_t(1) << (BARO_FRAC + 16));
+    std::printf("%s: %zu readings, %.1f Hz, noise %.2f Pa rms\n", path.c_str(), r.size(),
+                seconds > 0 ? (r.size() - 1) / seconds : 0.0, std::sqrt(squares / (r.size() - 1) / 2));
+    std::printf("  baseline drift %+.1f Pa/h over %.0f s\n", seconds > 0 ? drift * 3600 / seconds : 0.0, seconds);
+    std::printf("  lift %d cm: %u/%zu gestures hit, %u missed, %u false alarms, %u rejected",
+                liftCm, hits, rec.gestures.size(), misses, falseAlarms, d.rejected);
+    if (hits) {
+        std::printf(", latency %.0f ms mean %.0f ms worst", latencySum / hits, latencyMax);
+    }
+    std::printf("\n");
+    return misses || falseAlarms ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    long liftCm = 40;
+    unsigned long windowMs = BARO_MAX_MS + 1000;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-l") && i + 1 < argc) {
+            liftCm = std::strtol(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-w") && i + 1 < argc) {
+            windowMs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+    if (files.empty() || liftCm <= 0) {
+        std::fprintf(stderr, "usage: %s [-l lift_cm] [-w window_ms] [-v] <file>...\n", argv[0]);
+        return 2;
+    }
+
+    int status = 0;
+    for (const std::string &path : files) {
+        Recording rec;
+        if (!(hasSuffix(path, ".mtr") ? loadTrace(path, rec) : loadCsv(path, rec))) {
+            status = 1;
+            continue;
+        }
+        status |= run(path, rec, static_cast<int32_t>(liftCm), static_cast<uint32_t>(windowMs));
+    }
+    return status;
+}
@@ -0,0 +1,107 @@
+/*
+ * chrome_trace.cpp
+ */
+
+#include <cstdio>
+
+#include "chrome_trace.h"
+
+namespace morsecap {
+
+namespace {
+
+enum Track { kSensor = 1, kApp, kInterrupts, kI2c, kUart };
+
+const char *const kTrackNames[] = {"", "sensor stage", "app stage", "interrupts", "i2c", "uart tx"};
+
+int trackOf(uint8_t source) {
+    switch (source) {
+    case EVTRACE_SRC_SENSOR: return kSensor;
+    case EVTRACE_SRC_APP:
+    case EVTRACE_SRC_AUDIO: return kApp;
+    case EVTRACE_SRC_I2C: return kI2c;
+    case EVTRACE_SRC_UART_TX: return kUart;
+    default: return kInterrupts;
+    }
+}
+
+} // namespace
+
+bool EventDump::add(const Frame &frame) {
+    EvtraceRecord records[EVTRACE_DUMP_MAX];
+    uint32_t freq;
+    uint16_t total, first;
+    int n = evtrace_parse_dump(frame.payload.data(), static_cast<uint16_t>(frame.payload.size()), &freq,
+                               &total, &first, records);
+
+    if (n < 0) {
+        return false;
+    }
+    if (first == 0) {
+        records_.clear();
+        freq_ = freq;
+        broken_ = false;
+    } else if (broken_ || first != records_.size() || freq != freq_) {
+        if (!broken_) {
+            dropped_++;
+        }
+        broken_ = true;
+        return false;
+    }
+    records_.insert(records_.end(), records, records + n);
+    if (records_.size() < total) {
+        return false;
+    }
+    broken_ = true;  // the next dump starts at 0
+    return true;
+}
+
+void writeChromeTrace(std::ostream &out, const std::vector<EvtraceRecord> &records, uint32_t freq_hz) {
+    char line[256];
+    int open[EVTRACE_SRC_COUNT] = {};
+    uint64_t t = 0;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SensorTag\"}}";
+    for (int track = kSensor; track <= kUart; track++) {
+        std::snprintf(line, sizeof(line),
+                      ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}"
+                      ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                      "\"args\":{\"sort_index\":%d}}",
+                      track, kTrackNames[track], track, track);
+        out << line;
+    }
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const EvtraceRecord &r = records[i];
+        uint8_t source = EVTRACE_SOURCE(r.id);
+        bool begin = EVTRACE_PHASE(r.id) == EVTRACE_BEGIN;
+        char args[48] = "";
+
+        if (i > 0) {
+            t += static_cast<uint32_t>(r.time - records[i - 1].time);
+        }
+        if (source >= EVTRACE_SRC_COUNT || (!begin && EVTRACE_PHASE(r.id) != EVTRACE_END)) {
+            continue;
+        }
+        // The ring may have lost the beginning of what was running
+        if (!begin && open[source] == 0) {
+            continue;
+        }
+        open[source] += begin ? 1 : -1;
+
+        if (source == EVTRACE_SRC_I2C) {
+            std::snprintf(args, sizeof(args), ",\"args\":{\"address\":\"0x%02x\"%s}", r.arg & 0xFF,
+                          !begin && (r.arg & 0x100) ? ",\"failed\":true" : "");
+        } else if (source == EVTRACE_SRC_UART_TX && begin) {
+            std::snprintf(args, sizeof(args), ",\"args\":{\"bytes\":%u}", r.arg);
+        }
+        std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d%s}",
+                      evtraceSourceNames[source], begin ? 'B' : 'E',
+                      static_cast<double>(t) * 1e6 / freq_hz, trackOf(source), args);
+        out << line;
+    }
+    out << "\n]}\n";
+}
+
+} // namespace morsecap
@@ -0,0 +1,44 @@
+/*
+ * chrome_trace.h
+ *
+ *  Event trace dumps (see evtrace.h in the firmware) put back together from
+ *  their PROTO_MSG_EVTRACE frames and written as Chrome trace JSON, for
+ *  chrome://tracing or ui.perfetto.dev.
+ */
+
+#ifndef CHROME_TRACE_H_
+#define CHROME_TRACE_H_
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "evtrace.h"
+#include "frame_decoder.h"
+
+namespace morsecap {
+
+class EventDump {
+public:
+    // Returns true when the frame completes a dump. A dump missing a frame
+    // is dropped.
+    bool add(const Frame &frame);
+
+    const std::vector<EvtraceRecord> &records() const { return records_; }
+    uint32_t freq() const { return freq_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    std::vector<EvtraceRecord> records_;
+    uint32_t freq_ = 0;
+    bool broken_ = true;
+    uint64_t dropped_ = 0;
+};
+
+// One track per stage, one for interrupts and clocks and one each for the
+// I2C bus and UART output. Time 0 is the oldest record.
+void writeChromeTrace(std::ostream &out, const std::vector<EvtraceRecord> &records, uint32_t freq_hz);
+
+} // namespace morsecap
+
+#endif /* CHROME_TRACE_H_ */
@@ -0,0 +1,126 @@
+/*
+ * flash_model.cpp
+ */
+
+#include <algorithm>
+
+#include "flash_model.h"
+
+namespace morsecap {
+
+FlashModel::FlashModel(uint32_t size, uint32_t seed)
+    : data_(size, 0xFF), sectorErases_(size / kSector), rng_(seed) {
+}
+
+bool FlashModel::accept(uint64_t now, uint32_t addr) {
+    if (!powered_) {
+        return false;
+    }
+    if (now < busyUntil_ || addr >= data_.size()) {
+        stats_.refused++;
+        return false;
+    }
+    return true;
+}
+
+// Counts down to the cut, true for the operation it falls in
+bool FlashModel::tearing() {
+    if (cutIn_ == 0 || --cutIn_ > 0) {
+        return false;
+    }
+    powered_ = false;
+    stats_.cuts++;
+    return true;
+}
+
+bool FlashModel::read(uint64_t now, uint32_t addr, uint8_t *out, size_t len) {
+    if (!accept(now, addr) || addr + len > data_.size()) {
+        return false;
+    }
+    std::copy(data_.begin() + addr, data_.begin() + addr + len, out);
+    stats_.reads++;
+    stats_.bytesRead += len;
+    return true;
+}
+
+bool FlashModel::program(uint64_t now, uint32_t addr, const uint8_t *data, size_t len) {
+    uint32_t page = addr & ~(kPage - 1);
+    bool torn;
+
+    if (!accept(now, addr)) {
+        return false;
+    }
+    torn = tearing();
+    for (size_t i = 0; i < len; i++) {
+        uint8_t &cell = data_[page + (addr + i) % kPage];
+        uint8_t bits = data[i];
+
+        if (torn) {
+            switch (rng_() % 3) {
+            case 0:
+                break;
+            case 1:
+                bits = 0xFF;
+                break;
+            default:
+                bits |= static_cast<uint8_t>(rng_());
+                break;
+            }
+        }
+        cell &= bits;
+    }
+    if (torn) {
+        return false;
+    }
+    busyUntil_ = now + timing_.programUs;
+    stats_.programs++;
+    stats_.bytesProgrammed += len;
+    return true;
+}
+
+bool FlashModel::erase(uint64_t now, uint32_t addr) {
+    uint32_t sector = addr & ~(kSector - 1);
+    bool torn;
+
+    if (!accept(now, addr)) {
+        return false;
+    }
+    torn = tearing();
+    for (uint32_t i = 0; i < kSector; i++) {
+        uint8_t &cell = data_[sector + i];
+
+        if (!torn) {
+            cell = 0xFF;
+            continue;
+        }
+        switch (rng_() % 3) {
+        case 0:
+            break;
+        case 1:
+            cell = 0xFF;
+            break;
+        default:
+            cell |= static_cast<uint8_t>(rng_());
+            break;
+        }
+    }
+    if (torn) {
+        return false;
+    }
+    sectorErases_[sector / kSector]++;
+    busyUntil_ = now + timing_.eraseUs;
+    stats_.erases++;
+    return true;
+}
+
+void FlashModel::cutAfter(uint64_t operations) {
+    cutIn_ = operations;
+}
+
+void FlashModel::powerOn() {
+    powered_ = true;
+    cutIn_ = 0;
+    busyUntil_ = 0;
+}
+
+} // namespace morsecap
@@ -0,0 +1,89 @@
+/*
+ * flash_model.h
+ *
+ *  SPI NOR flash for the log store harness (flashbench.cpp) and the
+ *  simulator, at the level of the chip's commands: page program within a
+ *  256 byte page, wrapping inside it like the chip does, only clearing
+ *  bits; 4 KB sector erase; reads. Program and erase take the typical
+ *  times of the MX25R8035F on the SensorTag, the chip ignores commands
+ *  while busy.
+ *
+ *  Power cuts: cutAfter(n) makes the n-th program or erase from now the
+ *  one the power fails in. A torn program leaves each byte programmed,
+ *  untouched or with some of its bits, a torn erase leaves each byte
+ *  erased, untouched or with some bits set. Then nothing works until
+ *  powerOn().
+ */
+
+#ifndef FLASH_MODEL_H_
+#define FLASH_MODEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace morsecap {
+
+class FlashModel {
+public:
+    static constexpr uint32_t kPage = 256;
+    static constexpr uint32_t kSector = 4096;
+
+    struct Timing {
+        uint64_t programUs = 850;
+        uint64_t eraseUs = 40000;
+    };
+
+    struct Stats {
+        uint64_t reads = 0;
+        uint64_t bytesRead = 0;
+        uint64_t programs = 0;
+        uint64_t bytesProgrammed = 0;
+        uint64_t erases = 0;
+        uint64_t refused = 0;   // commands while busy or out of range
+        uint64_t cuts = 0;
+    };
+
+    explicit FlashModel(uint32_t size, uint32_t seed = 1);
+
+    uint32_t size() const { return static_cast<uint32_t>(data_.size()); }
+    const Timing &timing() const { return timing_; }
+    void setTiming(const Timing &timing) { timing_ = timing; }
+
+    // Times are the caller's microseconds, they only go forward
+    bool busy(uint64_t now) const { return powered_ && now < busyUntil_; }
+    uint64_t busyUntil() const { return busyUntil_; }
+
+    // Each returns false if the chip did not take the command
+    bool read(uint64_t now, uint32_t addr, uint8_t *out, size_t len);
+    bool program(uint64_t now, uint32_t addr, const uint8_t *data, size_t len);
+    bool erase(uint64_t now, uint32_t addr);
+
+    void cutAfter(uint64_t operations);
+    bool powered() const { return powered_; }
+    void powerOn();
+
+    const Stats &stats() const { return stats_; }
+    const std::vector<uint32_t> &sectorErases() const { return sectorErases_; }
+
+    // The array, for checks that bypass the commands
+    const uint8_t *data() const { return data_.data(); }
+
+private:
+    bool accept(uint64_t now, uint32_t addr);
+    bool tearing();
+
+    std::vector<uint8_t> data_;
+    std::vector<uint32_t> sectorErases_;
+    Timing timing_;
+    uint64_t busyUntil_ = 0;
+    uint64_t cutIn_ = 0;        // operations until the cut, 0 for none
+    bool powered_ = true;
+    std::mt19937 rng_;
+    Stats stats_;
+};
+
+} // namespace morsecap
+
+#endif /* FLASH_MODEL_H_ */
@@ -0,0 +1,159 @@
+/*
+ * frame_decoder.cpp
+ */
+
+#include "frame_decoder.h"
+#include "tscodec.h"
+
+namespace morsecap {
+
+namespace {
+
+uint16_t get16(const uint8_t *p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t get32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // namespace
+
+void FrameDecoder::feed(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == 0x00) {
+            finishFrame();
+            continue;
+        }
+        if (buf_.size() >= PROTO_MAX_FRAME) {
+            overrun_ = true;
+            continue;
+        }
+        buf_.push_back(data[i]);
+    }
+}
+
+void FrameDecoder::finishFrame() {
+    uint8_t raw[PROTO_MAX_FRAME];
+    uint8_t type, seq;
+    const uint8_t *payload;
+
+    if (buf_.empty()) {
+        overrun_ = false;
+        return;
+    }
+    if (overrun_) {
+        stats_.overruns++;
+    } else {
+        uint16_t n = protocol_cobs_decode(buf_.data(), static_cast<uint16_t>(buf_.size()), raw);
+        int16_t plen = n ? protocol_parse_frame(raw, n, &type, &seq, &payload) : -1;
+
+        if (n == 0) {
+            stats_.cobs_errors++;
+        } else if (plen < 0) {
+            stats_.crc_errors++;
+        } else {
+            if (haveSeq_ && seq != nextSeq_) {
+                stats_.seq_gaps++;
+            }
+            haveSeq_ = true;
+            nextSeq_ = static_cast<uint8_t>(seq + 1);
+            stats_.frames++;
+            handler_(Frame{type, seq, std::vector<uint8_t>(payload, payload + plen)});
+        }
+    }
+    buf_.clear();
+    overrun_ = false;
+}
+
+bool parseImuBatch(const Frame &frame, std::vector<ImuSample> &out) {
+    const std::vector<uint8_t> &p = frame.payload;
+
+    if (frame.type != PROTO_MSG_IMU_BATCH || p.size() < PROTO_IMU_BATCH_HDR) {
+        return false;
+    }
+    uint32_t t0 = get32(&p[0]);
+    uint16_t period = get16(&p[4]);
+    uint8_t count = p[6];
+    if (p.size() != PROTO_IMU_BATCH_HDR + static_cast<size_t>(count) * PROTO_IMU_AXES * 2) {
+        return false;
+    }
+
+    const uint8_t *s = &p[PROTO_IMU_BATCH_HDR];
+    for (uint8_t i = 0; i < count; i++) {
+        ImuSample sample;
+        sample.timestamp_us = t0 + static_cast<uint32_t>(i) * period;
+        for (int axis = 0; axis < PROTO_IMU_AXES; axis++, s += 2) {
+            sample.axis[axis] = static_cast<int16_t>(get16(s));
+        }
+        out.push_back(sample);
+    }
+    return true;
+}
+
+bool parseImuPacked(const Frame &frame, std::vector<ImuSample> &out) {
+    const std::vector<uint8_t> &p = frame.payload;
+    int32_t values[255 * PROTO_IMU_AXES];
+    uint8_t channels, count;
+
+    if (frame.type != PROTO_MSG_IMU_PACKED || p.size() < PROTO_IMU_PACKED_HDR) {
+        return false;
+    }
+    const uint8_t *block = &p[PROTO_IMU_PACKED_HDR];
+    uint16_t len = static_cast<uint16_t>(p.size() - PROTO_IMU_PACKED_HDR);
+    if (tscodec_peek(block, len, &channels, &count) != 0 || channels != PROTO_IMU_AXES
+        || tscodec_decode(block, len, values, sizeof(values) / sizeof(values[0])) != count) {
+        return false;
+    }
+    uint32_t t0 = get32(&p[0]);
+    uint16_t period = get16(&p[4]);
+
+    const int32_t *v = values;
+    for (uint8_t i = 0; i < count; i++) {
+        ImuSample sample;
+        sample.timestamp_us = t0 + static_cast<uint32_t>(i) * period;
+        for (int axis = 0; axis < PROTO_IMU_AXES; axis++) {
+            sample.axis[axis] = static_cast<int16_t>(*v++);
+        }
+        out.push_back(sample);
+    }
+    return true;
+}
+
+bool parseTelemetry(const Frame &frame, Telemetry &out) {
+    const std::vector<uint8_t> &p = frame.payload;
+
+    if (frame.type != PROTO_MSG_TELEMETRY || p.size() < PROTO_TELEMETRY_LEN) {
+        return false;
+    }
+    out.uptime_ms = get32(&p[0]);
+    out.samples = get32(&p[4]);
+    out.frames = get32(&p[8]);
+    out.tx_errors = get32(&p[12]);
+    return true;
+}
+
+bool parseEnv(const Frame &frame, EnvReport &out) {
+    const std::vector<uint8_t> &p = frame.payload;
+
+    if (frame.type != PROTO_MSG_ENV || p.size() < PROTO_ENV_LEN || p[4] >= PROTO_ENV_CHANNELS ||
+        (p[5] != PROTO_ENV_CHANGE && p[5] != PROTO_ENV_SUMMARY)) {
+        return false;
+    }
+    out.time_ms = get32(&p[0]);
+    out.channel = p[4];
+    out.kind = p[5];
+    out.count = get16(&p[6]);
+    out.min = static_cast<int32_t>(get32(&p[8]));
+    out.max = static_cast<int32_t>(get32(&p[12]));
+    out.mean = static_cast<int32_t>(get32(&p[16]));
+    out.variance = get32(&p[20]);
+    return true;
+}
+
+std::string parseText(const Frame &frame) {
+    return std::string(frame.payload.begin(), frame.payload.end());
+}
+
+} // namespace morsecap
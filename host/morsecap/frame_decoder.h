@@ -0,0 +1,91 @@
+/*
+ * frame_decoder.h
+ *
+ *  Host side decoder for the SensorTag binary UART stream. Splits the byte
+ *  stream on 0x00 delimiters, un-COBSes and CRC-checks each frame and hands
+ *  out typed messages. Framing helpers come from the firmware's protocol.c.
+ */
+
+#ifndef FRAME_DECODER_H_
+#define FRAME_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+
+namespace morsecap {
+
+struct Frame {
+    uint8_t type;
+    uint8_t seq;
+    std::vector<uint8_t> payload;
+};
+
+struct ImuSample {
+    uint32_t timestamp_us;
+    int16_t axis[PROTO_IMU_AXES];
+};
+
+struct Telemetry {
+    uint32_t uptime_ms;
+    uint32_t samples;
+    uint32_t frames;
+    uint32_t tx_errors;
+};
+
+// A PROTO_MSG_ENV frame, see protocol.h
+struct EnvReport {
+    uint32_t time_ms;
+    uint8_t channel;
+    uint8_t kind;
+    uint16_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+    uint32_t variance;
+};
+
+struct DecoderStats {
+    uint64_t frames = 0;
+    uint64_t crc_errors = 0;
+    uint64_t cobs_errors = 0;
+    uint64_t overruns = 0;
+    uint64_t seq_gaps = 0;
+};
+
+class FrameDecoder {
+public:
+    using Handler = std::function<void(const Frame &)>;
+
+    explicit FrameDecoder(Handler handler) : handler_(std::move(handler)) {}
+
+    // Feed any number of bytes as they arrive from the link
+    void feed(const uint8_t *data, size_t len);
+
+    const DecoderStats &stats() const { return stats_; }
+
+private:
+    void finishFrame();
+
+    Handler handler_;
+    std::vector<uint8_t> buf_;
+    bool overrun_ = false;
+    bool haveSeq_ = false;
+    uint8_t nextSeq_ = 0;
+    DecoderStats stats_;
+};
+
+// Payload parsers, return false if the payload is malformed
+bool parseImuBatch(const Frame &frame, std::vector<ImuSample> &out);
+bool parseImuPacked(const Frame &frame, std::vector<ImuSample> &out);
+bool parseTelemetry(const Frame &frame, Telemetry &out);
+bool parseEnv(const Frame &frame, EnvReport &out);
+std::string parseText(const Frame &frame);
+
+} // namespace morsecap
+
+#endif /* FRAME_DECODER_H_ */
@@ -0,0 +1,218 @@
+/*
+ * main.cpp
+ *
+ *  morsecap: capture the SensorTag binary UART stream to files.
+ *
+ *  Usage: morsecap <device|-> [-b baud] [-o prefix]
+ *
+ *  Reads from a serial device or pty (or stdin with "-") and writes
+ *    <prefix>_imu.csv        timestamp_us,ax,ay,az,gx,gy,gz (raw counts, from
+ *                            plain or packed batches)
+ *    <prefix>_symbols.txt    one keyed symbol per line
+ *    <prefix>_text.txt       decoded text
+ *    <prefix>_telemetry.csv  uptime_ms,samples,frames,tx_errors
+ *    <prefix>_env.csv        time_ms,channel,kind,count,min,max,mean,variance
+ *                            (environmental changes and window summaries,
+ *                            lux, Pa and 0.01 C)
+ *    <prefix>.mtr            trace blocks, if the board records a trace
+ *                            (replay with mtrplay, see replay.cpp)
+ *    <prefix>_events_<n>.json  the n-th event trace dump ("events dump"
+ *                            on the board) as Chrome trace JSON
+ *
+ *  Build: see CMakeLists.txt at the top of the repository.
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "chrome_trace.h"
+#include "frame_decoder.h"
+#include "trace.h"
+
+using namespace morsecap;
+
+static volatile std::sig_atomic_t running = 1;
+
+static void onSignal(int) {
+    running = 0;
+}
+
+static speed_t baudConstant(long baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+    }
+}
+
+static int openSerial(const char *path, long baud) {
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        std::perror(path);
+        return -1;
+    }
+    // Plain files and pipes are fine too, only configure real terminals
+    if (isatty(fd)) {
+        struct termios tio;
+        speed_t speed = baudConstant(baud);
+        if (speed == 0) {
+            std::fprintf(stderr, "unsupported baud rate %ld\n", baud);
+            close(fd);
+            return -1;
+        }
+        tcgetattr(fd, &tio);
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+int main(int argc, char **argv) {
+    const char *device = nullptr;
+    std::string prefix = "capture";
+    long baud = 115200;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc) {
+            baud = std::strtol(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) {
+            prefix = argv[++i];
+        } else if (!device) {
+            device = argv[i];
+        } else {
+            device = nullptr;
+            break;
+        }
+    }
+    if (!device) {
+        std::fprintf(stderr, "usage: %s <device|-> [-b baud] [-o prefix]\n", argv[0]);
+        return 2;
+    }
+
+    int fd = std::strcmp(device, "-") ? openSerial(device, baud) : STDIN_FILENO;
+    if (fd < 0) {
+        return 1;
+    }
+
+    std::ofstream imu(prefix + "_imu.csv");
+    std::ofstream symbols(prefix + "_symbols.txt");
+    std::ofstream text(prefix + "_text.txt");
+    std::ofstream telemetry(prefix + "_telemetry.csv");
+    std::ofstream env(prefix + "_env.csv");
+    std::ofstream trace;  // created on the first trace block
+    imu << "timestamp_us,ax,ay,az,gx,gy,gz\n";
+    telemetry << "uptime_ms,samples,frames,tx_errors\n";
+    env << "time_ms,channel,kind,count,min,max,mean,variance\n";
+
+    uint64_t samples = 0;
+    std::vector<ImuSample> batch;
+    EventDump events;
+    int eventDumps = 0;
+
+    FrameDecoder decoder([&](const Frame &frame) {
+        static const char *const channels[PROTO_ENV_CHANNELS] = {"light", "pressure", "air", "object"};
+        Telemetry t;
+        EnvReport e;
+        switch (frame.type) {
+        case PROTO_MSG_IMU_BATCH:
+        case PROTO_MSG_IMU_PACKED:
+            batch.clear();
+            if (frame.type == PROTO_MSG_IMU_BATCH ? parseImuBatch(frame, batch) : parseImuPacked(frame, batch)) {
+                for (const ImuSample &s : batch) {
+                    imu << s.timestamp_us;
+                    for (int16_t v : s.axis) {
+                        imu << ',' << v;
+                    }
+                    imu << '\n';
+                }
+                samples += batch.size();
+            }
+            break;
+        case PROTO_MSG_SYMBOL:
+            symbols << parseText(frame) << '\n';
+            break;
+        case PROTO_MSG_TEXT:
+            text << parseText(frame) << std::flush;
+            break;
+        case PROTO_MSG_REPLY:
+            std::fputs(parseText(frame).c_str(), stdout);
+            std::fflush(stdout);
+            break;
+        case PROTO_MSG_TRACE:
+            if (!trace.is_open()) {
+                const char header[TRACE_FILE_HEADER_LEN] = {'M', 'T', 'R', 'C', TRACE_VERSION, 0, 0, 0};
+                trace.open(prefix + ".mtr", std::ios::binary);
+                trace.write(header, sizeof(header));
+            }
+            trace.put(static_cast<char>(frame.payload.size() & 0xFF));
+            trace.put(static_cast<char>(frame.payload.size() >> 8));
+            trace.write(reinterpret_cast<const char *>(frame.payload.data()),
+                        static_cast<std::streamsize>(frame.payload.size()));
+            trace.flush();
+            break;
+        case PROTO_MSG_EVTRACE:
+            if (events.add(frame)) {
+                std::ofstream json(prefix + "_events_" + std::to_string(++eventDumps) + ".json");
+                writeChromeTrace(json, events.records(), events.freq());
+            }
+            break;
+        case PROTO_MSG_ENV:
+            if (parseEnv(frame, e)) {
+                env << e.time_ms << ',' << channels[e.channel] << ','
+                    << (e.kind == PROTO_ENV_CHANGE ? "change" : "summary") << ',' << e.count << ',' << e.min
+                    << ',' << e.max << ',' << e.mean << ',' << e.variance << '\n' << std::flush;
+            }
+            break;
+        case PROTO_MSG_TELEMETRY:
+            if (parseTelemetry(frame, t)) {
+                telemetry << t.uptime_ms << ',' << t.samples << ',' << t.frames << ','
+                          << t.tx_errors << '\n';
+            }
+            break;
+        default:
+            break;
+        }
+    });
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    uint8_t buf[512];
+    while (running) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        decoder.feed(buf, static_cast<size_t>(n));
+    }
+
+    const DecoderStats &st = decoder.stats();
+    std::fprintf(stderr, "frames %llu, samples %llu, crc errors %llu, cobs errors %llu, "
+                 "overruns %llu, sequence gaps %llu\n",
+                 (unsigned long long)st.frames, (unsigned long long)samples,
+                 (unsigned long long)st.crc_errors, (unsigned long long)st.cobs_errors,
+                 (unsigned long long)st.overruns, (unsigned long long)st.seq_gaps);
+    if (eventDumps || events.dropped()) {
+        std::fprintf(stderr, "event dumps %d, incomplete %llu\n", eventDumps,
+                     (unsigned long long)events.dropped());
+    }
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * packbench.cpp
+ *
+ *  packbench: run the board's time series compressor (tscodec.h) over
+ *  recorded sensor data, for compression ratio and speed.
+ *
+ *  Usage: packbench [-b samples] [-s columns] [-u baud] <file>...
+ *
+ *  A file is a trace (.mtr, its IMU records) or a CSV of integer columns
+ *  such as morsecap's <prefix>_imu.csv, whose first s columns (default 1,
+ *  the timestamp) are skipped; a header line is skipped too. Values that
+ *  fit 16 bits are coded as such, like the board's IMU counts.
+ *
+ *  For each file the series is cut into blocks of b samples (default 25,
+ *  the board's PACK_BATCH) and reported as
+ *    - block bytes against the raw values, and the modes the encoder chose
+ *    - the same split into frames as the board's packed stream does, and
+ *      the sample rate either stream sustains at u baud (default 9600,
+ *      10 bits a byte, 6 bytes of framing a frame)
+ *    - encode time per sample, in ns and, on x86, TSC cycles
+ *    - decode throughput in values and MB of int32 output per second
+ *  Every block is decoded and compared; exits with 1 on a mismatch.
+ *
+ *  Build: see CMakeLists.txt at the top of the repository.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "protocol.h"
+#include "trace_file.h"
+#include "tscodec.h"
+
+using namespace morsecap;
+
+namespace {
+
+constexpr unsigned kFramingBytes = 6;   // seq, type, CRC, COBS, delimiter
+constexpr double kMinSeconds = 0.2;     // per timing loop
+
+struct Series {
+    unsigned channels = 0;
+    std::vector<int32_t> values;        // sample after sample
+    std::vector<int16_t> narrow;        // the same, if all fit int16
+
+    size_t samples() const { return channels ? values.size() / channels : 0; }
+};
+
+bool hasSuffix(const std::string &s, const char *suffix) {
+    size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool loadTrace(const std::string &path, Series &series) {
+    TraceFile file;
+
+    if (!file.open(path)) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), file.error().c_str());
+        return false;
+    }
+    series.channels = TRACE_AXES;
+    file.visit([&](const TraceRecord &rec, uint64_t) {
+        if (rec.type == TRACE_REC_IMU) {
+            series.values.insert(series.values.end(), rec.u.imu, rec.u.imu + TRACE_AXES);
+        }
+    });
+    return true;
+}
+
+bool loadCsv(const std::string &path, unsigned skip, Series &series) {
+    std::ifstream in(path);
+    std::string line;
+
+    if (!in) {
+        std::fprintf(stderr, "%s: cannot open\n", path.c_str());
+        return false;
+    }
+    while (std::getline(in, line)) {
+        std::vector<int32_t> row;
+        std::stringstream cells(line);
+        std::string cell;
+        bool numeric = true;
+
+        for (unsigned column = 0; std::getline(cells, cell, ','); column++) {
+            char *end;
+            long v = std::strtol(cell.c_str(), &end, 10);
+            if (end == cell.c_str()) {
+                numeric = false;
+                break;
+            }
+            if (column >= skip) {
+                row.push_back(static_cast<int32_t>(v));
+            }
+        }
+        if (!numeric || row.empty()) {
+            continue;
+        }
+        if (series.channels == 0) {
+            series.channels = static_cast<unsigned>(row.size());
+        }
+        if (row.size() != series.channels) {
+            std::fprintf(stderr, "%s: rows of %u and %zu values\n", path.c_str(), series.channels, row.size());
+            return false;
+        }
+        series.values.insert(series.values.end(), row.begin(), row.end());
+    }
+    return true;
+}
+
+// Encodes count samples from first into out, as the board would
+uint16_t encode(const Series &series, size_t first, unsigned count, uint8_t *out, uint16_t size) {
+    const int16_t *rows16[255];
+    const int32_t *rows32[255];
+
+    if (!series.narrow.empty()) {
+        for (unsigned i = 0; i < count; i++) {
+            rows16[i] = &series.narrow[(first + i) * series.channels];
+        }
+        return tscodec_encode16(out, size, rows16, static_cast<uint8_t>(series.channels),
+                                static_cast<uint8_t>(count));
+    }
+    for (unsigned i = 0; i < count; i++) {
+        rows32[i] = &series.values[(first + i) * series.channels];
+    }
+    return tscodec_encode32(out, size, rows32, static_cast<uint8_t>(series.channels), static_cast<uint8_t>(count));
+}
+
+// Walks the channel headers of a block
+void countModes(const uint8_t *block, uint64_t *modes) {
+    const uint8_t *p = block + TSCODEC_BLOCK_HDR;
+
+    for (unsigned c = 0; c < block[1]; c++) {
+        bool dod = (*p++ & TSCODEC_MODE_DOD) != 0;
+        for (int varints = dod ? 2 : 1; varints > 0; varints--) {
+            while (*p++ & 0x80) {
+            }
+        }
+        modes[dod ? 1 : 0]++;
+    }
+}
+
+double seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+int run(const std::string &path, const Series &series, unsigned block, unsigned long baud) {
+    const size_t samples = series.samples();
+    const unsigned valueBytes = series.narrow.empty() ? 4 : 2;
+    const size_t rawBytes = series.values.size() * valueBytes;
+    const uint16_t kUnlimited = 65535;
+    std::vector<std::vector<uint8_t>> blocks;
+    std::vector<uint8_t> buf(kUnlimited);
+    size_t packedBytes = 0;
+    uint64_t modes[2] = {0, 0};
+
+    if (samples == 0) {
+        std::printf("%s: no samples\n", path.c_str());
+        return 0;
+    }
+    if (series.channels > TSCODEC_MAX_CHANNELS) {
+        std::fprintf(stderr, "%s: %u channels, at most %d\n", path.c_str(), series.channels, TSCODEC_MAX_CHANNELS);
+        return 1;
+    }
+
+    for (size_t first = 0; first < samples; first += block) {
+        unsigned count = static_cast<unsigned>(std::min<size_t>(block, samples - first));
+        uint16_t len = encode(series, first, count, buf.data(), kUnlimited);
+
+        countModes(buf.data(), modes);
+        blocks.emplace_back(buf.begin(), buf.begin() + len);
+        packedBytes += len;
+    }
+
+    // The board's packed stream: a whole batch per frame, else halves
+    size_t frames = 0, frameBytes = 0;
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    for (size_t first = 0; first < samples;) {
+        unsigned n = static_cast<unsigned>(std::min<size_t>(block, samples - first));
+        uint16_t len;
+        while ((len = encode(series, first, n, payload, PROTO_MAX_PAYLOAD - PROTO_IMU_PACKED_HDR)) == 0) {
+            n = (n + 1) / 2;
+        }
+        frames++;
+        frameBytes += PROTO_IMU_PACKED_HDR + len + kFramingBytes;
+        first += n;
+    }
+    unsigned rawPerFrame = (PROTO_MAX_PAYLOAD - PROTO_IMU_BATCH_HDR) / (series.channels * valueBytes);
+    double rawFrames = static_cast<double>(samples) / rawPerFrame;
+    double rawWire = rawFrames * (PROTO_IMU_BATCH_HDR + kFramingBytes) + static_cast<double>(rawBytes);
+
+    // Encode speed
+    auto start = std::chrono::steady_clock::now();
+    uint64_t passes = 0;
+#ifdef HAVE_TSC
+    uint64_t tsc = __rdtsc();
+#endif
+    do {
+        for (size_t first = 0; first < samples; first += block) {
+            encode(series, first, static_cast<unsigned>(std::min<size_t>(block, samples - first)),
+                   buf.data(), kUnlimited);
+        }
+        passes++;
+    } while (seconds(std::chrono::steady_clock::now() - start) < kMinSeconds);
+#ifdef HAVE_TSC
+    double cycles = static_cast<double>(__rdtsc() - tsc) / (passes * samples);
+#endif
+    double encodeNs = seconds(std::chrono::steady_clock::now() - start) * 1e9 / (passes * samples);
+
+    // Round trip, then decode speed
+    std::vector<int32_t> out(static_cast<size_t>(block) * series.channels);
+    size_t at = 0;
+    for (const std::vector<uint8_t> &b : blocks) {
+        int16_t n = tscodec_decode(b.data(), static_cast<uint16_t>(b.size()), out.data(),
+                                   static_cast<uint16_t>(out.size()));
+        size_t values = static_cast<size_t>(n) * series.channels;
+        if (n <= 0 || !std::equal(out.begin(), out.begin() + values, series.values.begin() + at)) {
+            std::fprintf(stderr, "%s: block at sample %zu does not decode to its input\n", path.c_str(),
+                         at / series.channels);
+            return 1;
+        }
+        at += values;
+    }
+    start = std::chrono::steady_clock::now();
+    passes = 0;
+    do {
+        for (const std::vector<uint8_t> &b : blocks) {
+            tscodec_decode(b.data(), static_cast<uint16_t>(b.size()), out.data(), static_cast<uint16_t>(out.size()));
+        }
+        passes++;
+    } while (seconds(std::chrono::steady_clock::now() - start) < kMinSeconds);
+    double decodeRate = passes * static_cast<double>(series.values.size())
+                        / seconds(std::chrono::steady_clock::now() - start);
+
+    double bytesPerSecond = baud / 10.0;
+    std::printf("%s: %zu samples of %u channels, %zu bytes raw (%u-bit values)\n", path.c_str(), samples,
+                series.channels, rawBytes, valueBytes * 8);
+    std::printf("  blocks   %zu of %u samples, %zu bytes, ratio %.2f, %.2f bits a value, "
+                "delta %llu / delta-of-delta %llu channels\n",
+                blocks.size(), block, packedBytes, static_cast<double>(rawBytes) / packedBytes,
+                8.0 * packedBytes / series.values.size(), (unsigned long long)modes[0],
+                (unsigned long long)modes[1]);
+    std::printf("  link     packed %zu frames, %zu bytes, ratio %.2f to raw frames; at %lu baud "
+                "raw %.0f, packed %.0f samples/s\n",
+                frames, frameBytes, rawWire / frameBytes, baud, bytesPerSecond * samples / rawWire,
+                bytesPerSecond * samples / frameBytes);
+#ifdef HAVE_TSC
+    std::printf("  encode   %.1f ns, %.0f TSC cycles a sample\n", encodeNs, cycles);
+#else
+    std::printf("  encode   %.1f ns a sample\n", encodeNs);
+#endif
+    std::printf("  decode   %.0f Mvalues/s, %.0f MB/s\n", decodeRate / 1e6, decodeRate * 4 / 1e6);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    unsigned long block = 25, skip = 1, baud = 9600;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc) {
+            block = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-s") && i + 1 < argc) {
+            skip = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-u") && i + 1 < argc) {
+            baud = std::strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+    if (files.empty() || block < 1 || block > 255 || baud == 0) {
+        std::fprintf(stderr, "usage: %s [-b samples] [-s columns] [-u baud] <file>...\n", argv[0]);
+        return 2;
+    }
+
+    int status = 0;
+    for (const std::string &path : files) {
+        Series series;
+        if (!(hasSuffix(path, ".mtr") ? loadTrace(path, series) : loadCsv(path, static_cast<unsigned>(skip), series))) {
+            status = 1;
+            continue;
+        }
+        if (std::all_of(series.values.begin(), series.values.end(),
+                        [](int32_t v) { return v >= INT16_MIN && v <= INT16_MAX; })) {
+            series.narrow.assign(series.values.begin(), series.values.end());
+        }
+        status |= run(path, series, static_cast<unsigned>(block), baud);
+    }
+    return status;
+}
@@ -0,0 +1,155 @@
+/*
+ * powermodel.cpp
+ *
+ *  powermodel: estimate the board's average supply current from its
+ *  residency counters, and how long a coin cell lasts at that rate.
+ *
+ *  Usage: powermodel [-b mAh] [-e uA] [-v] <file>...
+ *
+ *  A file is text the board sent on its serial link, from a terminal log
+ *  or morsesim -u, holding the replies to `power` and `tasks`; the last
+ *  of each counts. From them:
+ *    - uptime, time in standby and standby entries (`power`)
+ *    - the CPU idle share (`tasks`), the rest is active
+ *  The MCU draws the currents of standby.h in each state, the board's own
+ *  estimate uses the same figures. On top of the board's figure the model
+ *  charges every standby exit the 151 us wake-up of the datasheet at the
+ *  active current, and e uA (default 0) for the rest of the board, e.g.
+ *  the sensors left powered.
+ *
+ *  Prints the share and current of each state, the average and the
+ *  board's estimate, and the life of a b mAh cell (default 240, a CR2032)
+ *  at that average. With -v the counters read. Exits with 1 if a file
+ *  lacks either reply.
+ *
+ *  Build: see CMakeLists.txt at the top of the repository.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "standby.h"
+
+namespace {
+
+constexpr double kWakeUs = 151;    // standby to active, CC2650 datasheet
+
+bool verbose = false;
+
+struct Counters {
+    bool havePower = false;
+    bool haveTasks = false;
+    double uptimeMs = 0;
+    double standbyMs = 0;
+    double entries = 0;
+    double estimateUa = -1;
+    double idlePercent = 0;
+};
+
+bool load(const std::string &path, Counters &c) {
+    static const std::regex power(R"(uptime_ms=(\d+) standby_ms=(\d+) entries=(\d+))");
+    static const std::regex estimate(R"(estimate_ua=(\d+))");
+    static const std::regex cpu(R"(^cpu .*idle=(\d+)\.(\d)%)");
+    std::ifstream in(path);
+    std::string line;
+    std::smatch m;
+
+    if (!in) {
+        std::fprintf(stderr, "%s: cannot open\n", path.c_str());
+        return false;
+    }
+    while (std::getline(in, line)) {
+        if (std::regex_search(line, m, power)) {
+            c.havePower = true;
+            c.uptimeMs = std::stod(m[1]);
+            c.standbyMs = std::stod(m[2]);
+            c.entries = std::stod(m[3]);
+        } else if (std::regex_search(line, m, estimate)) {
+            c.estimateUa = std::stod(m[1]);
+        } else if (std::regex_search(line, m, cpu)) {
+            c.haveTasks = true;
+            c.idlePercent = std::stod(m[1]) + std::stod(m[2]) / 10;
+        }
+    }
+    if (!c.havePower || !c.haveTasks || c.uptimeMs <= 0) {
+        std::fprintf(stderr, "%s: needs the replies to power and tasks\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void report(const std::string &path, const Counters &c, double cellMah, double extraUa) {
+    double standby = c.standbyMs / c.uptimeMs;
+    double active = 1 - c.idlePercent / 100;
+    if (active + standby > 1) {
+        active = 1 - standby;
+    }
+    double idle = 1 - active - standby;
+    double wakeUa = c.entries / (c.uptimeMs / 1000) * kWakeUs * 1e-6 * STANDBY_ACTIVE_UA;
+
+    double activeUa = active * STANDBY_ACTIVE_UA;
+    double idleUa = idle * STANDBY_IDLE_UA;
+    double standbyUa = standby * STANDBY_SLEEP_UA;
+    double average = activeUa + idleUa + standbyUa + wakeUa + extraUa;
+
+    if (verbose) {
+        std::printf("%s: uptime_ms=%.0f standby_ms=%.0f entries=%.0f idle=%.1f%%\n", path.c_str(), c.uptimeMs,
+                    c.standbyMs, c.entries, c.idlePercent);
+    }
+    std::printf("%s: %.1f s, %.0f standby entries (%.2f/s)\n", path.c_str(), c.uptimeMs / 1000, c.entries,
+                c.entries / (c.uptimeMs / 1000));
+    std::printf("  active   %5.1f%%  %8.1f uA\n", active * 100, activeUa);
+    std::printf("  idle     %5.1f%%  %8.1f uA\n", idle * 100, idleUa);
+    std::printf("  standby  %5.1f%%  %8.1f uA\n", standby * 100, standbyUa);
+    std::printf("  wake-ups          %8.1f uA\n", wakeUa);
+    if (extraUa > 0) {
+        std::printf("  board             %8.1f uA\n", extraUa);
+    }
+    std::printf("  average           %8.1f uA", average);
+    if (c.estimateUa >= 0) {
+        std::printf(", the board estimates %.0f uA", c.estimateUa);
+    }
+    std::printf("\n  %.0f mAh cell: %.0f days\n", cellMah, cellMah * 1000 / average / 24);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    double cellMah = 240, extraUa = 0;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc) {
+            cellMah = std::strtod(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "-e") && i + 1 < argc) {
+            extraUa = std::strtod(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+    if (files.empty() || cellMah <= 0 || extraUa < 0) {
+        std::fprintf(stderr, "usage: %s [-b mAh] [-e uA] [-v] <file>...\n", argv[0]);
+        return 2;
+    }
+
+    int status = 0;
+    for (const std::string &path : files) {
+        Counters c;
+        if (!load(path, c)) {
+            status = 1;
+            continue;
+        }
+        report(path, c, cellMah, extraUa);
+    }
+    return status;
+}
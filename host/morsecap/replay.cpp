@@ -0,0 +1,185 @@
+/*
+ * replay.cpp
+ *
+ *  mtrplay: run a recorded trace through the board's gesture classifier
+ *  and keying state machine, to tune thresholds without the board.
+ *
+ *  Usage: mtrplay <trace.mtr> [-t tilt_mg] [-h hold_ms] [-c click_ms]
+ *                 [-l lift_cm] [-v]
+ *
+ *  IMU and button records go through the board's keying classifier
+ *  (keyer.h), pressure records through its altitude gesture detector
+ *  (baro.h), and the resulting events through fsm_dispatch(). Prints the
+ *  keyed symbols and decoded text; -v also prints every event and note
+ *  with its time.
+ *
+ *  Build: see CMakeLists.txt at the top of the repository.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "baro.h"
+#include "fsm.h"
+#include "keyer.h"
+#include "trace_file.h"
+
+using namespace morsecap;
+
+namespace {
+
+// Defaults match settings.c
+int32_t tiltMg = 1000;
+uint32_t holdUs = 500000;
+uint32_t clickUs = 500000;
+int32_t liftCm = 40;
+bool verbose = false;
+
+std::string symbols;
+std::string text;
+
+void emitSymbol(char symbol) {
+    symbols += symbol;
+}
+
+void emitText(char c) {
+    text += c;
+}
+
+const char *eventName(int event) {
+    static const char *const names[] = {"dot", "dash", "gap", "reset", "end"};
+    return names[event];
+}
+
+class Replay {
+public:
+    Replay() {
+        fsm_init(&fsm_, emitSymbol, emitText);
+        keyer_init(&keyer_);
+        baro_init(&baro_);
+    }
+
+    void record(const TraceRecord &rec, uint64_t t) {
+        expireClicks(t);
+        last_ = t;
+        switch (rec.type) {
+        case TRACE_REC_CONFIG:
+            config_ = rec.u.config;
+            haveConfig_ = true;
+            break;
+        case TRACE_REC_IMU:
+            imu(rec.u.imu, t);
+            break;
+        case TRACE_REC_BUTTON:
+            // Button 1 keys by click count, button 0 only toggles the LED
+            if (rec.u.button.button == 1 && rec.u.button.level == 0) {
+                keyer_click(&keyer_, static_cast<uint32_t>(t), clickUs);
+            }
+            break;
+        case TRACE_REC_PRESSURE: {
+            int event = baro_update(&baro_, static_cast<uint32_t>(t / 1000), rec.u.pressure, baro_threshold(liftCm));
+            if (event >= 0) {
+                dispatch(event, t);
+            }
+            break;
+        }
+        case TRACE_REC_NOTE:
+            if (verbose) {
+                std::printf("%10.3f note %s\n", t / 1e6, rec.u.note.text);
+            }
+            break;
+        }
+    }
+
+    void finish() { expireClicks(last_ + clickUs); }
+
+    const Fsm &fsm() const { return fsm_; }
+
+private:
+    void imu(const int16_t *raw, uint64_t t) {
+        if (!haveConfig_) {
+            return;
+        }
+        float accel[3];
+        for (int i = 0; i < 3; i++) {
+            accel[i] = raw[i] * (config_.accel_ng / 1e9f) - config_.accel_bias_mg[i] / 1000.0f;
+        }
+        int event = keyer_tilt(&keyer_, static_cast<uint32_t>(t), accel, tiltMg, holdUs);
+        if (event >= 0) {
+            dispatch(event, t);
+        }
+    }
+
+    // The board's button Clock fires at the deadline, events carry that time
+    void expireClicks(uint64_t t) {
+        uint32_t late = static_cast<uint32_t>(t) - keyer_.clickDeadline;
+        int event = keyer_expire(&keyer_, static_cast<uint32_t>(t));
+        if (event >= 0) {
+            dispatch(event, t - late);
+        }
+    }
+
+    void dispatch(int event, uint64_t t) {
+        if (verbose) {
+            std::printf("%10.3f %s\n", t / 1e6, eventName(event));
+        }
+        fsm_dispatch(&fsm_, static_cast<FsmEvent>(event));
+    }
+
+    Fsm fsm_;
+    TraceConfig config_{};
+    bool haveConfig_ = false;
+    Keyer keyer_;
+    BaroDetector baro_;
+    uint64_t last_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+            tiltMg = std::strtol(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-h") && i + 1 < argc) {
+            holdUs = std::strtoul(argv[++i], nullptr, 10) * 1000;
+        } else if (!std::strcmp(argv[i], "-c") && i + 1 < argc) {
+            clickUs = std::strtoul(argv[++i], nullptr, 10) * 1000;
+        } else if (!std::strcmp(argv[i], "-l") && i + 1 < argc) {
+            liftCm = std::strtol(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "usage: %s <trace.mtr> [-t tilt_mg] [-h hold_ms] [-c click_ms] [-l lift_cm] [-v]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    TraceFile trace;
+    if (!trace.open(path)) {
+        std::fprintf(stderr, "%s\n", trace.error().c_str());
+        return 1;
+    }
+
+    Replay replay;
+    trace.visit([&](const TraceRecord &rec, uint64_t t) { replay.record(rec, t); });
+    replay.finish();
+
+    std::printf("symbols: %s\ntext: %s\n", symbols.c_str(), text.c_str());
+
+    const TraceStats &st = trace.stats();
+    std::fprintf(stderr, "blocks %llu, records %llu, corrupt blocks %llu, rejected events %lu\n",
+                 (unsigned long long)st.blocks, (unsigned long long)st.records,
+                 (unsigned long long)st.corrupt_blocks, (unsigned long)replay.fsm().rejected);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * trace_file.cpp
+ */
+
+#include "trace_file.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace morsecap {
+
+TraceFile::~TraceFile() {
+    if (data_) {
+        munmap(const_cast<uint8_t *>(data_), size_);
+    }
+}
+
+bool TraceFile::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < TRACE_FILE_HEADER_LEN) {
+        error_ = path + ": not a trace file";
+        close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error_ = path + ": " + std::strerror(errno);
+        return false;
+    }
+    // Visited front to back, once
+    madvise(map, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    data_ = static_cast<const uint8_t *>(map);
+    size_ = static_cast<size_t>(st.st_size);
+    if (std::memcmp(data_, TRACE_MAGIC, 4) != 0 || data_[4] != TRACE_VERSION) {
+        error_ = path + ": not a version " + std::to_string(TRACE_VERSION) + " trace file";
+        return false;
+    }
+    return true;
+}
+
+void TraceFile::visit(const Visitor &visitor) {
+    size_t pos = TRACE_FILE_HEADER_LEN;
+    uint64_t epoch = 0;
+    uint32_t last = 0;
+    bool first = true;
+
+    stats_ = TraceStats();
+    while (pos + 2 <= size_) {
+        size_t len = data_[pos] | (data_[pos + 1] << 8);
+        pos += 2;
+        if (pos + len > size_) {
+            stats_.corrupt_blocks++;  // truncated at the end of a capture
+            break;
+        }
+
+        TraceReader reader;
+        TraceRecord rec;
+        int rc;
+        stats_.blocks++;
+        if (trace_reader_start(&reader, data_ + pos, static_cast<uint16_t>(len)) != 0) {
+            stats_.corrupt_blocks++;
+            pos += len;
+            continue;
+        }
+        while ((rc = trace_next(&reader, &rec)) == 1) {
+            // Board timestamps are 32-bit microseconds, wrapping every 71 minutes
+            if (!first && rec.timestamp_us < last && last - rec.timestamp_us > 0x80000000u) {
+                epoch += 0x100000000ull;
+            }
+            first = false;
+            last = rec.timestamp_us;
+            stats_.records++;
+            visitor(rec, epoch + rec.timestamp_us);
+        }
+        if (rc < 0) {
+            stats_.corrupt_blocks++;
+        }
+        pos += len;
+    }
+}
+
+} // namespace morsecap
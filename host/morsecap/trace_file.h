@@ -0,0 +1,55 @@
+/*
+ * trace_file.h
+ *
+ *  Read-only view of a trace file (see trace.h in the firmware). The file
+ *  is memory-mapped, so opening a multi-hour trace costs nothing up front
+ *  and records are decoded straight from the mapping as they are visited.
+ */
+
+#ifndef TRACE_FILE_H_
+#define TRACE_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "trace.h"
+
+namespace morsecap {
+
+struct TraceStats {
+    uint64_t blocks = 0;
+    uint64_t records = 0;
+    uint64_t corrupt_blocks = 0;
+};
+
+class TraceFile {
+public:
+    // Called per record with the timestamp extended to 64 bits
+    using Visitor = std::function<void(const TraceRecord &, uint64_t timestamp_us)>;
+
+    TraceFile() = default;
+    ~TraceFile();
+    TraceFile(const TraceFile &) = delete;
+    TraceFile &operator=(const TraceFile &) = delete;
+
+    // Returns false with a message in error() if the file cannot be used
+    bool open(const std::string &path);
+    const std::string &error() const { return error_; }
+
+    size_t size() const { return size_; }
+
+    void visit(const Visitor &visitor);
+    const TraceStats &stats() const { return stats_; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    std::string error_;
+    TraceStats stats_;
+};
+
+} // namespace morsecap
+
+#endif /* TRACE_FILE_H_ */
@@ -0,0 +1,106 @@
+/*
+ * wav_file.cpp
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "wav_file.h"
+
+namespace morsecap {
+
+namespace {
+
+uint16_t get16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+uint32_t get32(const uint8_t *p) {
+    return get16(p) | static_cast<uint32_t>(get16(p + 2)) << 16;
+}
+
+void put16(std::string &out, uint16_t v) {
+    out += static_cast<char>(v & 0xFF);
+    out += static_cast<char>(v >> 8);
+}
+
+void put32(std::string &out, uint32_t v) {
+    put16(out, v & 0xFFFF);
+    put16(out, v >> 16);
+}
+
+} // namespace
+
+bool readWav(const std::string &path, Wav &wav, std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    uint16_t channels = 0, bits = 0, format = 0;
+    bool haveFormat = false;
+    size_t pos = 12;
+
+    if (!in) {
+        error = path + ": cannot open";
+        return false;
+    }
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (file.size() < 12 || std::memcmp(file.data(), "RIFF", 4) || std::memcmp(file.data() + 8, "WAVE", 4)) {
+        error = path + ": not a WAV file";
+        return false;
+    }
+    // Chunks are word aligned, a truncated data chunk keeps what is there
+    while (pos + 8 <= file.size()) {
+        const uint8_t *chunk = file.data() + pos;
+        size_t len = get32(chunk + 4);
+        size_t avail = std::min(len, file.size() - pos - 8);
+
+        if (!std::memcmp(chunk, "fmt ", 4) && avail >= 16) {
+            format = get16(chunk + 8);
+            channels = get16(chunk + 10);
+            wav.rate = get32(chunk + 12);
+            bits = get16(chunk + 22);
+            haveFormat = true;
+        } else if (!std::memcmp(chunk, "data", 4)) {
+            if (!haveFormat || format != 1 || bits != 16 || channels == 0 || wav.rate == 0) {
+                error = path + ": only 16-bit PCM is supported";
+                return false;
+            }
+            wav.samples.clear();
+            for (size_t i = 0; i + 2 * channels <= avail; i += 2 * channels) {
+                wav.samples.push_back(static_cast<int16_t>(get16(chunk + 8 + i)));
+            }
+            return true;
+        }
+        pos += 8 + len + (len & 1);
+    }
+    error = path + ": no data chunk";
+    return false;
+}
+
+bool writeWav(const std::string &path, const Wav &wav) {
+    std::ofstream out(path, std::ios::binary);
+    std::string header = "RIFF";
+    uint32_t dataLen = static_cast<uint32_t>(wav.samples.size() * 2);
+
+    put32(header, 36 + dataLen);
+    header += "WAVEfmt ";
+    put32(header, 16);
+    put16(header, 1);           // PCM
+    put16(header, 1);           // mono
+    put32(header, wav.rate);
+    put32(header, wav.rate * 2);
+    put16(header, 2);
+    put16(header, 16);
+    header += "data";
+    put32(header, dataLen);
+
+    out.write(header.data(), header.size());
+    for (int16_t s : wav.samples) {
+        std::string bytes;
+        put16(bytes, static_cast<uint16_t>(s));
+        out.write(bytes.data(), 2);
+    }
+    return static_cast<bool>(out);
+}
+
+} // namespace morsecap
@@ -0,0 +1,30 @@
+/*
+ * wav_file.h
+ *
+ *  16-bit PCM WAV files for the audio harness (audio.cpp). Reading keeps
+ *  the first channel of a multi-channel file.
+ */
+
+#ifndef WAV_FILE_H_
+#define WAV_FILE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace morsecap {
+
+struct Wav {
+    uint32_t rate = 0;
+    std::vector<int16_t> samples;
+};
+
+// Returns false with a message in error on a file that is not 16-bit PCM
+bool readWav(const std::string &path, Wav &wav, std::string &error);
+
+// Mono
+bool writeWav(const std::string &path, const Wav &wav);
+
+} // namespace morsecap
+
+#endif /* WAV_FILE_H_ */
@@ -0,0 +1,89 @@
+# ramreport.cmake
+#
+#  RAM comparison of the two-task and the single-task firmware (SINGLE_TASK
+#  in project_main.c), from the static data of the host build's objects:
+#
+#      cmake -DNM=nm -DBEFORE=<objects> -DAFTER=<objects> -DOUT=<file>
+#            [-DMIN_SAVED=<bytes>] -P ramreport.cmake
+#
+#  Object lists are separated by '|'. Lists every variable whose size
+#  differs, then the totals. Byte arrays such as task stacks have the
+#  board's sizes; structs holding pointers are larger on a 64-bit host,
+#  and const tables with pointers land in data here but in flash on the
+#  board, which is the same in both builds. With MIN_SAVED the script
+#  fails unless the single-task build saves at least that many bytes.
+#
+#  Run by the ramreport target and the ram_report test, see
+#  CMakeLists.txt at the top of the repository.
+
+function(static_data objects prefix)
+    string(REPLACE "|" ";" objects "${objects}")
+    execute_process(COMMAND ${NM} -S -t d ${objects} OUTPUT_VARIABLE listing RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "nm failed on ${objects}")
+    endif()
+    string(REPLACE "\n" ";" lines "${listing}")
+    set(names "")
+    set(total 0)
+    foreach(line IN LISTS lines)
+        # value size type name; bss, data and common symbols are RAM
+        if(line MATCHES "^[0-9]+ ([0-9]+) [bBdDC] (.+)$")
+            math(EXPR size "${CMAKE_MATCH_1}")
+            set(name "${CMAKE_MATCH_2}")
+            if(NOT DEFINED ${prefix}_${name})
+                list(APPEND names "${name}")
+                set(${prefix}_${name} 0)
+            endif()
+            math(EXPR ${prefix}_${name} "${${prefix}_${name}} + ${size}")
+            set(${prefix}_${name} ${${prefix}_${name}} PARENT_SCOPE)
+            math(EXPR total "${total} + ${size}")
+        endif()
+    endforeach()
+    set(${prefix}_names "${names}" PARENT_SCOPE)
+    set(${prefix}_total ${total} PARENT_SCOPE)
+endfunction()
+
+static_data("${BEFORE}" before)
+static_data("${AFTER}" after)
+
+set(names ${before_names} ${after_names})
+list(REMOVE_DUPLICATES names)
+list(SORT names)
+
+set(report "RAM, static data of the firmware objects, host build\n\n")
+string(APPEND report "variable                      two-task  single-task\n")
+foreach(name IN LISTS names)
+    set(b 0)
+    set(a 0)
+    if(DEFINED before_${name})
+        set(b ${before_${name}})
+    endif()
+    if(DEFINED after_${name})
+        set(a ${after_${name}})
+    endif()
+    if(NOT b EQUAL a)
+        string(LENGTH "${name}" len)
+        math(EXPR pad "30 - ${len}")
+        if(pad LESS 1)
+            set(pad 1)
+        endif()
+        string(REPEAT " " ${pad} spaces)
+        string(LENGTH "${b}" blen)
+        math(EXPR bpad "8 - ${blen}")
+        string(REPEAT " " ${bpad} bspaces)
+        string(LENGTH "${a}" alen)
+        math(EXPR apad "13 - ${alen}")
+        string(REPEAT " " ${apad} aspaces)
+        string(APPEND report "${name}${spaces}${bspaces}${b}${aspaces}${a}\n")
+    endif()
+endforeach()
+math(EXPR saved "${before_total} - ${after_total}")
+string(APPEND report "\ntotal                         ${before_total} -> ${after_total} bytes, ${saved} saved\n")
+
+message("${report}")
+if(OUT)
+    file(WRITE "${OUT}" "${report}")
+endif()
+if(DEFINED MIN_SAVED AND saved LESS MIN_SAVED)
+    message(FATAL_ERROR "the single-task build saves ${saved} bytes, expected at least ${MIN_SAVED}")
+endif()
@@ -0,0 +1,1039 @@
+/*
+ * drivers.cpp
+ *
+ *  TI driver stand-ins on the simulator kernel: PIN, I2C with timed
+ *  transfers to the attached device models, SPI to the external flash,
+ *  UART at the configured baud rate, Watchdog, CPUdelay, the GPT0 PWM
+ *  behind the buzzer, the GPTimerCC26XX timers and the PDM microphone.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <driverlib/cpu.h>
+#include <driverlib/timer.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/SPI.h>
+#include <ti/drivers/UART.h>
+#include <ti/drivers/Watchdog.h>
+#include <ti/drivers/pdm/PDMCC26XX.h>
+#include <ti/drivers/pin/PINCC26XX.h>
+#include <ti/drivers/timer/GPTimerCC26XX.h>
+
+#include "Board.h"
+#include "sim.h"
+
+using namespace morsesim;
+
+namespace {
+
+constexpr int kPins = 32;
+
+struct Pin {
+    PIN_Handle owner;
+    PIN_Config cfg;
+    bool input = true;  // pulled up, buttons released and the RX line idle
+    bool output;
+    int32_t mux = IOC_PORT_GPIO;
+    bool shown;         // level last reported to the output watch
+};
+
+// Timer A of GPT0, the rest of the GPTs are not used through driverlib
+struct Pwm {
+    bool enabled;
+    uint32_t load;
+    uint32_t prescale;
+};
+
+Pin pins[kPins];
+BusStats bus{};
+std::map<uint8_t, I2cDevice *> i2cDevices;
+std::map<uint8_t, uint64_t> i2cBitsByAddress;
+struct I2cFaultRun {
+    I2cFault fault;
+    unsigned count;     // transfers left, 0 for no limit
+};
+std::map<uint8_t, I2cFaultRun> i2cFaults;   // 0 for any address
+unsigned sdaHeld;       // SCL clocks until the slave lets go
+std::function<void(const uint8_t *, size_t)> uartSink;
+std::function<void(uint8_t, bool)> outputWatch;
+std::function<void(uint32_t)> toneWatch;
+Pwm gpt0a;
+uint32_t toneHz;
+
+// What the microphone hears, levels of full scale
+constexpr uint32_t kMicRate = 16000;
+uint32_t micHz;
+double micLevel;
+double micNoise;
+double micPhase;
+std::mt19937 micRng(1);
+
+// The MX25R8035F on SPI0, the commands extflash.c uses. A command starts
+// when its chip select goes low and program and erase take effect when it
+// goes high, with write enable latched before.
+class SpiFlash {
+public:
+    SpiFlash() : model_(1 << 20) {}
+
+    void select(bool on) {
+        if (selected_ && !on) {
+            finish();
+        }
+        selected_ = on;
+        in_.clear();
+    }
+
+    bool selected() const { return selected_; }
+
+    uint8_t exchange(uint8_t byte) {
+        uint8_t out = 0;
+
+        in_.push_back(byte);
+        if (in_[0] == kRead && in_.size() > 4) {
+            if (!model_.read(now(), address() + static_cast<uint32_t>(in_.size() - 5), &out, 1)) {
+                out = 0xFF;
+            }
+        } else if (in_[0] == kReadStatus && in_.size() > 1) {
+            out = (model_.busy(now()) ? 0x01 : 0) | (wel_ ? 0x02 : 0);
+        } else if (in_[0] == kJedecId && in_.size() > 1 && in_.size() <= 4) {
+            out = kId[in_.size() - 2];
+        } else if (in_[0] == kWake && in_.size() > 4) {
+            out = kId[2];
+        }
+        return out;
+    }
+
+    morsecap::FlashModel &model() { return model_; }
+
+private:
+    static constexpr uint8_t kProgram = 0x02, kRead = 0x03, kReadStatus = 0x05, kWriteEnable = 0x06,
+                             kErase = 0x20, kJedecId = 0x9F, kWake = 0xAB;
+    static constexpr uint8_t kId[3] = {0xC2, 0x28, 0x14};
+
+    uint32_t address() const { return in_[1] << 16 | in_[2] << 8 | in_[3]; }
+
+    void finish() {
+        if (in_.empty()) {
+            return;
+        }
+        if (in_[0] == kWriteEnable && !model_.busy(now())) {
+            wel_ = true;
+        } else if (in_[0] == kProgram && in_.size() > 4 && wel_) {
+            if (model_.program(now(), address(), &in_[4], in_.size() - 4)) {
+                wel_ = false;
+            }
+        } else if (in_[0] == kErase && in_.size() == 4 && wel_) {
+            if (model_.erase(now(), address())) {
+                wel_ = false;
+            }
+        }
+    }
+
+    morsecap::FlashModel model_;
+    bool selected_ = false;
+    bool wel_ = false;
+    std::vector<uint8_t> in_;
+};
+
+SpiFlash spiFlash;
+
+bool pinLevel(const Pin &p);
+
+Pin &pinAt(PIN_Id id) {
+    if (id >= kPins) {
+        fail("pin %u does not exist", id);
+    }
+    return pins[id];
+}
+
+void applyConfig(PIN_Id id, PIN_Config mask, PIN_Config cfg) {
+    Pin &p = pinAt(id);
+
+    p.cfg = (p.cfg & ~mask) | (cfg & mask);
+    if (mask & PIN_GPIO_HIGH) {
+        p.output = (cfg & PIN_GPIO_HIGH) != 0;
+        p.shown = pinLevel(p);
+    }
+}
+
+// Reports a change of what the pin drives, the GPIO output or a PWM that
+// is on for any part of its period
+void updateOutput(PIN_Id id) {
+    Pin &p = pins[id];
+    bool level = pinLevel(p);
+
+    if (level != p.shown) {
+        p.shown = level;
+        if (id == Board_SPI_FLASH_CS) {
+            spiFlash.select(!level && p.owner);
+            return;
+        }
+        log("pin %u %s", id, level ? "high" : "low");
+        if (id == Board_I2C0_SCL0 && level && sdaHeld && --sdaHeld == 0) {
+            setPinInput(Board_I2C0_SDA0, true);
+        }
+        if (outputWatch) {
+            outputWatch(id, level);
+        }
+    }
+}
+
+void updateOutputs() {
+    for (PIN_Id id = 0; id < kPins; id++) {
+        updateOutput(id);
+    }
+}
+
+// A tone sounds while timer A runs and some pin carries its event
+void updateTone() {
+    uint32_t ticks = gpt0a.load | gpt0a.prescale << 16;
+    uint32_t hz = 0;
+
+    for (const Pin &p : pins) {
+        if (p.mux == IOC_PORT_MCU_PORT_EVENT0 && gpt0a.enabled && ticks > 0) {
+            hz = static_cast<uint32_t>(kCpuHz / ticks);
+        }
+    }
+    if (hz != toneHz) {
+        toneHz = hz;
+        log("tone %u Hz", hz);
+        if (toneWatch) {
+            toneWatch(hz);
+        }
+    }
+}
+
+} // namespace
+
+struct I2C_Config {
+    bool open;
+    I2C_BitRate bitRate;
+};
+
+struct SPI_Config {
+    bool open;
+    uint32_t bitRate;
+};
+
+struct UART_Config {
+    bool open;
+    UART_Params params;
+    uint8_t *rxBuf;
+    size_t rxWant;
+    size_t rxGot;
+    bool reading;
+};
+
+struct Watchdog_Config {
+    bool open;
+    Watchdog_Params params;
+    uint64_t gen;
+    bool expired;       // first timeout seen, the second one resets
+};
+
+struct GPTimerCC26XX_Config {
+    bool open;
+    GPTimerCC26XX_Params params;
+    GPTimerCC26XX_Value load;
+    GPTimerCC26XX_Value match;
+    bool running;
+    uint64_t gen;
+    GPTimerCC26XX_HwiFxn callback;
+    GPTimerCC26XX_IntMask intMask;
+};
+
+struct PDMCC26XX_Config {
+    bool open;
+    bool streaming;
+    PDMCC26XX_Params params;
+    uint64_t gen;
+    std::deque<PDMCC26XX_pcmBuffer *> ready;
+    uint8_t seq;
+    bool overflow;      // a block was lost since the last one delivered
+};
+
+static constexpr int kTimerParts = 8;
+
+static I2C_Config i2cPort;
+static SPI_Config spiPort;
+static UART_Config uartPort;
+static Watchdog_Config watchdog;
+static GPTimerCC26XX_Config timers[kTimerParts];
+static PDMCC26XX_Config pdmPort;
+
+namespace {
+
+// Counting down from the load, the PWM output is high until the match
+uint32_t pwmDuty(const GPTimerCC26XX_Config &t) {
+    if (!t.open || !t.running || t.params.mode != GPT_MODE_PWM || t.match > t.load) {
+        return 0;
+    }
+    return static_cast<uint32_t>(uint64_t(t.load + 1 - t.match) * 1000 / (t.load + 1));
+}
+
+bool pinLevel(const Pin &p) {
+    if (p.mux == IOC_PORT_GPIO) {
+        return p.output;
+    }
+    if (p.mux > GPT_PIN_0A && p.mux <= GPT_PIN_3B) {
+        return pwmDuty(timers[p.mux - GPT_PIN_0A]) > 0;
+    }
+    return false;   // GPT0A through driverlib is the buzzer, see updateTone()
+}
+
+} // namespace
+
+namespace morsesim {
+
+void attachI2c(uint8_t address, I2cDevice *device) {
+    i2cDevices[address] = device;
+}
+
+void setI2cFault(uint8_t address, I2cFault fault, unsigned count) {
+    i2cFaults[address] = {fault, count};
+}
+
+void holdI2cData(unsigned clocks) {
+    sdaHeld = clocks;
+    setPinInput(Board_I2C0_SDA0, clocks == 0);
+}
+
+const BusStats &busStats() {
+    return bus;
+}
+
+morsecap::FlashModel &externalFlash() {
+    return spiFlash.model();
+}
+
+uint64_t i2cBits(uint8_t address) {
+    auto it = i2cBitsByAddress.find(address);
+
+    return it == i2cBitsByAddress.end() ? 0 : it->second;
+}
+
+void setPinInput(uint8_t id, bool level) {
+    Pin &p = pinAt(id);
+    bool old = p.input;
+
+    p.input = level;
+    if (old == level || !p.owner || !p.owner->cb) {
+        return;
+    }
+    if ((!level && (p.cfg & PIN_IRQ_NEGEDGE)) || (level && (p.cfg & PIN_IRQ_POSEDGE))) {
+        p.owner->cb(p.owner, id);
+    }
+}
+
+// A byte while the UART is closed only pulls the RX pin low and is lost,
+// like the real link waking from standby
+void uartReceive(uint8_t byte) {
+    UART_Config &u = uartPort;
+
+    bus.uartRxBytes++;
+    if (!u.open) {
+        bus.uartRxLost++;
+        setPinInput(Board_UART_RX, false);
+        setPinInput(Board_UART_RX, true);
+        return;
+    }
+    if (!u.reading) {
+        bus.uartRxLost++;
+        return;
+    }
+    u.rxBuf[u.rxGot++] = byte;
+    if (u.rxGot == u.rxWant) {
+        u.reading = false;
+        u.params.readCallback(&u, u.rxBuf, u.rxGot);
+    }
+}
+
+void setUartOutput(std::function<void(const uint8_t *, size_t)> sink) {
+    uartSink = std::move(sink);
+}
+
+void watchOutputs(std::function<void(uint8_t, bool)> watch) {
+    outputWatch = std::move(watch);
+}
+
+void watchTone(std::function<void(uint32_t)> watch) {
+    toneWatch = std::move(watch);
+}
+
+void setMicTone(uint32_t hz, double level) {
+    micHz = hz;
+    micLevel = level;
+}
+
+void setMicNoise(double rms) {
+    micNoise = rms;
+}
+
+} // namespace morsesim
+
+extern "C" {
+
+const PIN_Config BoardGpioInitTable[] = {
+    PIN_TERMINATE
+};
+
+/* PIN */
+
+int PIN_init(const PIN_Config aPinConfig[]) {
+    for (const PIN_Config *c = aPinConfig; PIN_ID(*c) != PIN_TERMINATE; c++) {
+        applyConfig(PIN_ID(*c), PIN_BM_ALL, *c);
+    }
+    return PIN_SUCCESS;
+}
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config aPinList[]) {
+    const PIN_Config *c;
+
+    for (c = aPinList; PIN_ID(*c) != PIN_TERMINATE; c++) {
+        if (pinAt(PIN_ID(*c)).owner) {
+            return NULL;
+        }
+    }
+    *state = PIN_State{};
+    for (c = aPinList; PIN_ID(*c) != PIN_TERMINATE; c++) {
+        PIN_Id id = PIN_ID(*c);
+        pins[id].owner = state;
+        state->pins |= 1ull << id;
+        applyConfig(id, PIN_BM_ALL, *c);
+    }
+    return state;
+}
+
+void PIN_close(PIN_Handle handle) {
+    for (int id = 0; id < kPins; id++) {
+        if (handle->pins & (1ull << id)) {
+            pins[id].owner = NULL;
+        }
+    }
+    handle->pins = 0;
+}
+
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callbackFxn) {
+    handle->cb = callbackFxn;
+    return PIN_SUCCESS;
+}
+
+int PIN_setConfig(PIN_Handle handle, PIN_Config bmMask, PIN_Config pinCfg) {
+    PIN_Id id = PIN_ID(pinCfg);
+
+    if (pinAt(id).owner != handle) {
+        return PIN_NO_ACCESS;
+    }
+    applyConfig(id, bmMask, pinCfg);
+    return PIN_SUCCESS;
+}
+
+int PIN_setInterrupt(PIN_Handle handle, PIN_Config pinCfg) {
+    return PIN_setConfig(handle, PIN_BM_IRQ, pinCfg);
+}
+
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val) {
+    Pin &p = pinAt(pinId);
+
+    if (p.owner != handle) {
+        return PIN_NO_ACCESS;
+    }
+    p.output = val != 0;
+    updateOutput(pinId);
+    return PIN_SUCCESS;
+}
+
+uint32_t PIN_getOutputValue(PIN_Id pinId) {
+    return pinAt(pinId).output;
+}
+
+// Nothing drives the lines but the pull-ups and the scenario
+uint32_t PIN_getInputValue(PIN_Id pinId) {
+    return pinAt(pinId).input;
+}
+
+int PINCC26XX_setMux(PIN_Handle handle, PIN_Id pinId, int32_t mux) {
+    Pin &p = pinAt(pinId);
+
+    if (p.owner != handle) {
+        return PIN_NO_ACCESS;
+    }
+    p.mux = mux;
+    updateTone();
+    updateOutput(pinId);
+    return PIN_SUCCESS;
+}
+
+/* I2C */
+
+void I2C_init(void) {
+}
+
+void I2C_Params_init(I2C_Params *params) {
+    *params = I2C_Params{};
+    params->bitRate = I2C_100kHz;
+}
+
+I2C_Handle I2C_open(unsigned int, I2C_Params *params) {
+    if (i2cPort.open) {
+        return NULL;
+    }
+    i2cPort.open = true;
+    i2cPort.bitRate = params ? params->bitRate : I2C_100kHz;
+    return &i2cPort;
+}
+
+void I2C_close(I2C_Handle handle) {
+    handle->open = false;
+}
+
+// The fault on the next transfer to address, it uses up one of a run
+static I2cFault i2cFault(uint8_t address) {
+    auto it = i2cFaults.find(address);
+    if (it == i2cFaults.end() || it->second.fault == I2cFault::None) {
+        it = i2cFaults.find(0);
+    }
+    if (it == i2cFaults.end() || it->second.fault == I2cFault::None) {
+        return I2cFault::None;
+    }
+    I2cFault fault = it->second.fault;
+    if (it->second.count && --it->second.count == 0) {
+        it->second.fault = I2cFault::None;
+    }
+    return fault;
+}
+
+// Start, address and data bytes with their acks, a repeated start and
+// address before the reads, and the stop. A missing device NACKs its
+// address.
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *t) {
+    auto it = i2cDevices.find(t->slaveAddress);
+    I2cDevice *dev = it == i2cDevices.end() ? nullptr : it->second;
+    uint64_t bits = 1 + 9 + 1;
+    bool ok = dev != nullptr;
+
+    if (!handle->open) {
+        fail("I2C_transfer() on a closed port");
+    }
+    if (sdaHeld) {
+        bus.i2cBlocked++;
+        log("i2c 0x%02x blocked, SDA low", t->slaveAddress);
+        transfer(1000000 / (handle->bitRate == I2C_400kHz ? 400000 : 100000));
+        return false;
+    }
+    I2cFault fault = i2cFault(t->slaveAddress);
+    if (fault == I2cFault::Hang) {
+        log("i2c 0x%02x hangs", t->slaveAddress);
+        transfer(kForever);
+    }
+    if (fault == I2cFault::Nack) {
+        ok = false;
+    }
+    if (ok && t->writeCount) {
+        ok = dev->write(static_cast<const uint8_t *>(t->writeBuf), t->writeCount);
+        bits += 9 * t->writeCount;
+    }
+    if (ok && t->readCount) {
+        ok = dev->read(static_cast<uint8_t *>(t->readBuf), t->readCount);
+        bits += 1 + 9 + 9 * t->readCount;
+    }
+
+    Time duration = bits * 1000000 / (handle->bitRate == I2C_400kHz ? 400000 : 100000);
+    bus.i2cTransfers++;
+    bus.i2cBits += bits;
+    i2cBitsByAddress[t->slaveAddress] += bits;
+    bus.i2cBusy += duration;
+    if (!ok) {
+        bus.i2cNacks++;
+        log("i2c 0x%02x nack", t->slaveAddress);
+    }
+    transfer(duration);
+    return ok;
+}
+
+/* SPI */
+
+void SPI_init(void) {
+}
+
+void SPI_Params_init(SPI_Params *params) {
+    *params = SPI_Params{};
+    params->transferMode = SPI_MODE_BLOCKING;
+    params->mode = SPI_MASTER;
+    params->bitRate = 1000000;
+    params->dataSize = 8;
+}
+
+SPI_Handle SPI_open(unsigned int index, SPI_Params *params) {
+    if (index != Board_SPI0 || spiPort.open) {
+        return NULL;
+    }
+    if (params && params->transferMode != SPI_MODE_BLOCKING) {
+        fail("SPI_open(): only blocking mode is simulated");
+    }
+    spiPort.open = true;
+    spiPort.bitRate = params ? params->bitRate : 1000000;
+    return &spiPort;
+}
+
+void SPI_close(SPI_Handle handle) {
+    handle->open = false;
+}
+
+// Full duplex, the flash answers while its chip select is low
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *t) {
+    const uint8_t *tx = static_cast<const uint8_t *>(t->txBuf);
+    uint8_t *rx = static_cast<uint8_t *>(t->rxBuf);
+
+    if (!handle->open) {
+        fail("SPI_transfer() on a closed port");
+    }
+    for (size_t i = 0; i < t->count; i++) {
+        uint8_t in = spiFlash.selected() ? spiFlash.exchange(tx ? tx[i] : 0) : 0;
+        if (rx) {
+            rx[i] = in;
+        }
+    }
+
+    Time duration = (t->count * 8 * 1000000 + handle->bitRate - 1) / handle->bitRate;
+    bus.spiTransfers++;
+    bus.spiBytes += t->count;
+    bus.spiBusy += duration;
+    t->status = SPI_TRANSFER_COMPLETED;
+    transfer(duration);
+    return true;
+}
+
+/* UART */
+
+void UART_init(void) {
+}
+
+void UART_Params_init(UART_Params *params) {
+    *params = UART_Params{};
+    params->readTimeout = UART_WAIT_FOREVER;
+    params->writeTimeout = UART_WAIT_FOREVER;
+    params->readReturnMode = UART_RETURN_NEWLINE;
+    params->readDataMode = UART_DATA_TEXT;
+    params->writeDataMode = UART_DATA_TEXT;
+    params->readEcho = UART_ECHO_ON;
+    params->baudRate = 115200;
+    params->dataLength = UART_LEN_8;
+}
+
+UART_Handle UART_open(unsigned int, UART_Params *params) {
+    if (uartPort.open) {
+        return NULL;
+    }
+    if (params->readMode != UART_MODE_CALLBACK || !params->readCallback) {
+        fail("UART_open(): only callback reads are simulated");
+    }
+    uartPort = UART_Config{};
+    uartPort.open = true;
+    uartPort.params = *params;
+    log("uart open");
+    return &uartPort;
+}
+
+// The pending read completes with what it has, as on the board
+void UART_close(UART_Handle handle) {
+    if (handle->reading) {
+        handle->reading = false;
+        handle->params.readCallback(handle, handle->rxBuf, handle->rxGot);
+    }
+    handle->open = false;
+    log("uart closed");
+}
+
+int UART_write(UART_Handle handle, const void *buffer, size_t size) {
+    if (!handle->open) {
+        fail("UART_write() on a closed port");
+    }
+    if (uartSink) {
+        uartSink(static_cast<const uint8_t *>(buffer), size);
+    }
+    bus.uartTxBytes += size;
+    transfer(size * 10 * 1000000 / handle->params.baudRate);
+    return static_cast<int>(size);
+}
+
+int UART_read(UART_Handle handle, void *buffer, size_t size) {
+    if (handle->reading) {
+        return UART_ERROR;
+    }
+    handle->rxBuf = static_cast<uint8_t *>(buffer);
+    handle->rxWant = size;
+    handle->rxGot = 0;
+    handle->reading = size > 0;
+    return 0;
+}
+
+void UART_readCancel(UART_Handle handle) {
+    if (handle->reading) {
+        handle->reading = false;
+        handle->params.readCallback(handle, handle->rxBuf, handle->rxGot);
+    }
+}
+
+/* Watchdog, the reload value of CC2650STK.c */
+
+static constexpr Time kWatchdogUs = 1000000;
+
+static void watchdogArm() {
+    uint64_t gen = ++watchdog.gen;
+
+    schedule(now() + kWatchdogUs, Context::Hwi, [gen] {
+        if (!watchdog.open || watchdog.gen != gen) {
+            return;
+        }
+        if (watchdog.expired) {
+            if (watchdog.params.resetMode == Watchdog_RESET_ON) {
+                log("watchdog reset");
+                stop("watchdog reset");
+                return;
+            }
+        } else {
+            watchdog.expired = true;
+            log("watchdog timeout");
+            if (watchdog.params.callbackFxn) {
+                watchdog.params.callbackFxn(reinterpret_cast<UArg>(&watchdog));
+            }
+        }
+        watchdogArm();
+    });
+}
+
+void Watchdog_init(void) {
+}
+
+void Watchdog_Params_init(Watchdog_Params *params) {
+    *params = Watchdog_Params{};
+    params->resetMode = Watchdog_RESET_ON;
+    params->debugStallMode = Watchdog_DEBUG_STALL_ON;
+}
+
+Watchdog_Handle Watchdog_open(unsigned int, Watchdog_Params *params) {
+    if (watchdog.open) {
+        return NULL;
+    }
+    watchdog.open = true;
+    watchdog.params = *params;
+    watchdog.expired = false;
+    watchdogArm();
+    return &watchdog;
+}
+
+void Watchdog_clear(Watchdog_Handle handle) {
+    handle->expired = false;
+    watchdogArm();
+}
+
+void Watchdog_close(Watchdog_Handle handle) {
+    handle->open = false;
+}
+
+/* GPTimerCC26XX */
+
+static GPTimerCC26XX_Config &timerOf(GPTimerCC26XX_Handle handle) {
+    if (!handle->open) {
+        fail("GPTimerCC26XX call on a closed timer");
+    }
+    return *handle;
+}
+
+// Full-width timers count both halves, which have to be free
+GPTimerCC26XX_Handle GPTimerCC26XX_open(unsigned int index, const GPTimerCC26XX_Params *params) {
+    bool wide = params->width == GPT_CONFIG_32BIT;
+
+    if (index >= kTimerParts || (wide && index % 2 != 0) || timers[index].open ||
+        (timers[index ^ 1].open && (wide || timers[index ^ 1].params.width == GPT_CONFIG_32BIT))) {
+        return NULL;
+    }
+    if (params->mode == GPT_MODE_EDGE_COUNT || params->mode == GPT_MODE_EDGE_TIME) {
+        fail("GPTimerCC26XX_open(): edge modes are not simulated");
+    }
+    timers[index] = GPTimerCC26XX_Config{};
+    timers[index].open = true;
+    timers[index].params = *params;
+    timers[index].load = wide ? 0xFFFFFFFF : 0xFFFF;
+    return &timers[index];
+}
+
+void GPTimerCC26XX_Params_init(GPTimerCC26XX_Params *params) {
+    *params = GPTimerCC26XX_Params{};
+    params->width = GPT_CONFIG_16BIT;
+    params->mode = GPT_MODE_PERIODIC;
+    params->debugStallMode = GPTimerCC26XX_DEBUG_STALL_OFF;
+}
+
+void GPTimerCC26XX_close(GPTimerCC26XX_Handle handle) {
+    GPTimerCC26XX_stop(handle);
+    handle->open = false;
+}
+
+static void logPwm(const GPTimerCC26XX_Config &t) {
+    int part = static_cast<int>(&t - timers);
+
+    log("gpt%d%c pwm %u.%u%%", part / 2, part % 2 ? 'b' : 'a', pwmDuty(t) / 10, pwmDuty(t) % 10);
+}
+
+// The timeout comes load + 1 counts after the start
+static void timerArm(GPTimerCC26XX_Config &t) {
+    uint64_t gen = ++t.gen;
+    Time period = (static_cast<Time>(t.load) + 1) * 1000000 / kCpuHz;
+
+    schedule(now() + (period > 0 ? period : 1), Context::Hwi, [&t, gen] {
+        if (!t.open || !t.running || t.gen != gen) {
+            return;
+        }
+        if (t.params.mode == GPT_MODE_ONESHOT) {
+            t.running = false;
+        } else {
+            timerArm(t);
+        }
+        if (t.callback && (t.intMask & GPT_INT_TIMEOUT)) {
+            t.callback(&t, GPT_INT_TIMEOUT);
+        }
+    });
+}
+
+void GPTimerCC26XX_start(GPTimerCC26XX_Handle handle) {
+    GPTimerCC26XX_Config &t = timerOf(handle);
+
+    if (t.running) {
+        return;
+    }
+    t.running = true;
+    if (t.params.mode == GPT_MODE_PWM) {
+        logPwm(t);
+        updateOutputs();
+    } else {
+        timerArm(t);
+    }
+}
+
+void GPTimerCC26XX_stop(GPTimerCC26XX_Handle handle) {
+    GPTimerCC26XX_Config &t = timerOf(handle);
+
+    t.running = false;
+    t.gen++;
+    updateOutputs();
+}
+
+// Takes effect at the next start, a running one-shot keeps its timeout
+void GPTimerCC26XX_setLoadValue(GPTimerCC26XX_Handle handle, GPTimerCC26XX_Value loadValue) {
+    GPTimerCC26XX_Config &t = timerOf(handle);
+
+    t.load = t.params.width == GPT_CONFIG_32BIT ? loadValue : loadValue & 0xFFFFFF;
+    updateOutputs();
+}
+
+void GPTimerCC26XX_setMatchValue(GPTimerCC26XX_Handle handle, GPTimerCC26XX_Value matchValue) {
+    GPTimerCC26XX_Config &t = timerOf(handle);
+
+    t.match = matchValue;
+    if (t.running && t.params.mode == GPT_MODE_PWM) {
+        logPwm(t);
+    }
+    updateOutputs();
+}
+
+void GPTimerCC26XX_registerInterrupt(GPTimerCC26XX_Handle handle, GPTimerCC26XX_HwiFxn callback,
+                                     GPTimerCC26XX_IntMask intMask) {
+    GPTimerCC26XX_Config &t = timerOf(handle);
+
+    t.callback = callback;
+    t.intMask = intMask;
+}
+
+GPTimerCC26XX_PinMux GPTimerCC26XX_getPinMux(GPTimerCC26XX_Handle handle) {
+    return static_cast<GPTimerCC26XX_PinMux>(GPT_PIN_0A + (&timerOf(handle) - timers));
+}
+
+/* PDMCC26XX */
+
+static PDMCC26XX_Config &pdmOf(PDMCC26XX_Handle handle) {
+    if (!handle->open) {
+        fail("PDMCC26XX call on a closed driver");
+    }
+    return *handle;
+}
+
+static size_t pdmSamples(const PDMCC26XX_Config &p) {
+    return (p.params.retBufSizeInBytes - sizeof(PDMCC26XX_metaData)) / sizeof(int16_t);
+}
+
+static void pdmFill(int16_t *pcm, size_t count) {
+    std::normal_distribution<double> noise(0, micNoise * 32767);
+
+    for (size_t i = 0; i < count; i++) {
+        double v = micLevel * 32767 * std::sin(micPhase) + (micNoise > 0 ? noise(micRng) : 0);
+        micPhase = std::fmod(micPhase + 2 * M_PI * micHz / kMicRate, 2 * M_PI);
+        pcm[i] = static_cast<int16_t>(std::lround(std::max(-32768.0, std::min(32767.0, v))));
+    }
+}
+
+// One block per period while streaming, lost if the allocator has no buffer
+static void pdmArm(PDMCC26XX_Config &p) {
+    uint64_t gen = ++p.gen;
+    Time period = pdmSamples(p) * 1000000 / kMicRate;
+
+    schedule(now() + period, Context::Swi, [&p, gen] {
+        if (!p.open || !p.streaming || p.gen != gen) {
+            return;
+        }
+        pdmArm(p);
+
+        auto *block = static_cast<PDMCC26XX_pcmBuffer *>(p.params.mallocFxn(p.params.retBufSizeInBytes));
+        if (block == nullptr) {
+            if (!p.overflow) {
+                log("pdm overflow");
+            }
+            p.overflow = true;
+            return;
+        }
+        block->metaData.attrib = 0;
+        block->metaData.seqNum = p.seq++;
+        pdmFill(block->pBuffer, pdmSamples(p));
+        p.ready.push_back(block);
+
+        PDMCC26XX_StreamNotification notification{};
+        notification.status =
+            p.overflow ? PDMCC26XX_STREAM_BLOCK_READY_BUT_PDM_OVERFLOW : PDMCC26XX_STREAM_BLOCK_READY;
+        p.overflow = false;
+        p.params.callbackFxn(&p, &notification);
+    });
+}
+
+void PDMCC26XX_Params_init(PDMCC26XX_Params *params) {
+    *params = PDMCC26XX_Params{};
+    params->useDefaultFilter = true;
+    params->micGain = PDMCC26XX_GAIN_18;
+    params->micPowerActiveHigh = true;
+    params->applyCompression = true;
+}
+
+PDMCC26XX_Handle PDMCC26XX_open(PDMCC26XX_Params *params) {
+    if (pdmPort.open) {
+        return NULL;
+    }
+    if (params->applyCompression) {
+        fail("PDMCC26XX_open(): compression is not simulated");
+    }
+    if (!params->callbackFxn || !params->mallocFxn || !params->freeFxn ||
+        params->retBufSizeInBytes <= sizeof(PDMCC26XX_metaData)) {
+        fail("PDMCC26XX_open(): callback, allocator and buffer size are required");
+    }
+    pdmPort = PDMCC26XX_Config{};
+    pdmPort.open = true;
+    pdmPort.params = *params;
+    return &pdmPort;
+}
+
+void PDMCC26XX_close(PDMCC26XX_Handle handle) {
+    PDMCC26XX_Config &p = pdmOf(handle);
+
+    PDMCC26XX_stopStream(handle);
+    for (PDMCC26XX_pcmBuffer *block : p.ready) {
+        p.params.freeFxn(block, p.params.retBufSizeInBytes);
+    }
+    p.ready.clear();
+    p.open = false;
+}
+
+bool PDMCC26XX_startStream(PDMCC26XX_Handle handle) {
+    PDMCC26XX_Config &p = pdmOf(handle);
+
+    if (p.streaming) {
+        return false;
+    }
+    log("pdm start");
+    p.streaming = true;
+    pdmArm(p);
+    return true;
+}
+
+bool PDMCC26XX_stopStream(PDMCC26XX_Handle handle) {
+    PDMCC26XX_Config &p = pdmOf(handle);
+
+    if (!p.streaming) {
+        return false;
+    }
+    log("pdm stop");
+    p.streaming = false;
+    p.gen++;
+    return true;
+}
+
+bool PDMCC26XX_requestBuffer(PDMCC26XX_Handle handle, PDMCC26XX_BufferRequest *bufferRequest) {
+    PDMCC26XX_Config &p = pdmOf(handle);
+
+    if (p.ready.empty()) {
+        return false;
+    }
+    bufferRequest->buffer = p.ready.front();
+    bufferRequest->status = PDMCC26XX_STREAM_BLOCK_READY;
+    p.ready.pop_front();
+    return true;
+}
+
+void PDMCC26XX_releaseBuffer(PDMCC26XX_Handle handle, PDMCC26XX_BufferRelease *bufferRelease) {
+    PDMCC26XX_Config &p = pdmOf(handle);
+
+    p.params.freeFxn(bufferRelease->bufferHandle, p.params.retBufSizeInBytes);
+}
+
+/* driverlib */
+
+void TimerConfigure(uint32_t base, uint32_t) {
+    if (base == GPT0_BASE) {
+        gpt0a = Pwm{};
+        updateTone();
+    }
+}
+
+void TimerEnable(uint32_t base, uint32_t timer) {
+    if (base == GPT0_BASE && (timer & TIMER_A)) {
+        gpt0a.enabled = true;
+        updateTone();
+    }
+}
+
+void TimerDisable(uint32_t base, uint32_t timer) {
+    if (base == GPT0_BASE && (timer & TIMER_A)) {
+        gpt0a.enabled = false;
+        updateTone();
+    }
+}
+
+void TimerLoadSet(uint32_t base, uint32_t timer, uint32_t value) {
+    if (base == GPT0_BASE && (timer & TIMER_A)) {
+        gpt0a.load = value & 0xFFFF;
+    }
+}
+
+void TimerPrescaleSet(uint32_t base, uint32_t timer, uint32_t value) {
+    if (base == GPT0_BASE && (timer & TIMER_A)) {
+        gpt0a.prescale = value & 0xFF;
+    }
+}
+
+// Only the duty cycle, the tone does not depend on it
+void TimerMatchSet(uint32_t, uint32_t, uint32_t) {
+}
+
+void TimerPrescaleMatchSet(uint32_t, uint32_t, uint32_t) {
+}
+
+void CPUdelay(uint32_t ui32Count) {
+    spin(static_cast<Time>(ui32Count) * 3 * 1000000 / kCpuHz);
+}
+
+} // extern "C"
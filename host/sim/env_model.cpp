@@ -0,0 +1,443 @@
+/*
+ * env_model.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "env_model.h"
+
+namespace morsesim {
+
+namespace {
+
+// OPT3001
+enum : uint8_t {
+    OPT_RESULT = 0x00,
+    OPT_CONFIG = 0x01,
+    OPT_MANUFACTURER_ID = 0x7E,
+    OPT_DEVICE_ID = 0x7F,
+};
+constexpr uint16_t kOptCt = 0x0800;         // 800 ms conversions
+constexpr uint16_t kOptModeMask = 0x0600;
+constexpr uint16_t kOptModeSingle = 0x0200;
+constexpr uint16_t kOptReady = 0x0080;
+
+// TMP007
+enum : uint8_t {
+    TMP_DIE = 0x01,
+    TMP_CONFIG = 0x02,
+    TMP_OBJECT = 0x03,
+    TMP_DEVICE_ID = 0x1F,
+};
+
+// BMP280
+enum : uint8_t {
+    BMP_CALIB = 0x88,
+    BMP_ID = 0xD0,
+    BMP_RESET = 0xE0,
+    BMP_STATUS = 0xF3,
+    BMP_CTRL_MEAS = 0xF4,
+    BMP_CONFIG = 0xF5,
+    BMP_PRESS_MSB = 0xF7,
+};
+
+// The trimming of the datasheet's compensation example
+constexpr uint16_t kT1 = 27504;
+constexpr int16_t kT2 = 26435, kT3 = -1000;
+constexpr uint16_t kP1 = 36477;
+constexpr int16_t kP2 = -10685, kP3 = 3024, kP4 = 2855, kP5 = 140, kP6 = -7, kP7 = 15500, kP8 = -14600,
+                  kP9 = 6000;
+
+constexpr Time kStandbyUs[8] = {500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000};
+constexpr int kFilterHistory = 64;  // measurements that still matter to the filter
+
+// Pressure noise channel, apart from the MPU9250's axes
+constexpr int kPressureNoise = 16;
+
+uint8_t oversampling(uint8_t osrs) {
+    return osrs == 0 ? 0 : osrs >= 5 ? 16 : 1 << (osrs - 1);
+}
+
+// Mask of the count bits that a conversion resolves: 16 at 1x, one more
+// for each doubling
+int32_t resolution(uint8_t count) {
+    int bits = 16;
+
+    while (count > 1) {
+        count >>= 1;
+        bits++;
+    }
+    return ~((1 << (20 - bits)) - 1) & 0xFFFFF;
+}
+
+// The datasheet's compensation, temperature in 0.01 degrees
+int32_t compensateT(int32_t adc, int32_t &tFine) {
+    int32_t var1 = ((((adc >> 3) - (static_cast<int32_t>(kT1) << 1))) * kT2) >> 11;
+    int32_t var2 = (((((adc >> 4) - kT1) * ((adc >> 4) - kT1)) >> 12) * kT3) >> 14;
+
+    tFine = var1 + var2;
+    return (tFine * 5 + 128) >> 8;
+}
+
+// Pressure in Pa with 8 fraction bits
+int64_t compensateP(int32_t adc, int32_t tFine) {
+    int64_t var1 = static_cast<int64_t>(tFine) - 128000;
+    int64_t var2 = var1 * var1 * kP6;
+    int64_t p;
+
+    var2 = var2 + ((var1 * kP5) << 17);
+    var2 = var2 + (static_cast<int64_t>(kP4) << 35);
+    var1 = ((var1 * var1 * kP3) >> 8) + ((var1 * kP2) << 12);
+    var1 = ((static_cast<int64_t>(1) << 47) + var1) * kP1 >> 33;
+    p = 1048576 - adc;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (static_cast<int64_t>(kP9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (static_cast<int64_t>(kP8) * p) >> 19;
+    return ((p + var1 + var2) >> 8) + (static_cast<int64_t>(kP7) << 4);
+}
+
+// The 20 bit counts that compensate closest to the temperature and
+// pressure, the temperature rising with its count, the pressure falling
+void rawCounts(double celsius, double pa, int32_t &adcT, int32_t &adcP) {
+    int32_t target = static_cast<int32_t>(std::lround(celsius * 100));
+    int64_t targetP = std::llround(pa * 256);
+    int32_t lo = 0, hi = (1 << 20) - 1, tFine;
+
+    while (lo < hi) {
+        int32_t mid = (lo + hi) / 2;
+        if (compensateT(mid, tFine) < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    adcT = lo;
+    compensateT(adcT, tFine);
+
+    lo = 0;
+    hi = (1 << 20) - 1;
+    while (lo < hi) {
+        int32_t mid = (lo + hi) / 2;
+        if (compensateP(mid, tFine) > targetP) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    adcP = lo;
+}
+
+void putCounts(uint8_t *regs, int32_t adc) {
+    regs[0] = static_cast<uint8_t>(adc >> 12);
+    regs[1] = static_cast<uint8_t>(adc >> 4);
+    regs[2] = static_cast<uint8_t>(adc << 4);
+}
+
+// Exponent and mantissa of 0.01 lux * 2^E * R
+uint16_t luxWord(double lux) {
+    double counts = std::max(lux, 0.0) * 100;
+    int e = 0;
+
+    while (e < 11 && counts / (1 << e) >= 4095.5) {
+        e++;
+    }
+    long r = std::min(std::lround(counts / (1 << e)), 4095L);
+    return static_cast<uint16_t>(e << 12 | r);
+}
+
+// Register words of the TI parts are big endian, the pointer stays put
+bool readWord(uint16_t word, uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        data[i] = static_cast<uint8_t>(i % 2 ? word : word >> 8);
+    }
+    return true;
+}
+
+} // namespace
+
+Environment::Environment() {
+    keys_[0] = State{300, 101325, 22, 24, 1.3};    // an office desk
+}
+
+void Environment::set(Time t, const State &state) {
+    keys_[t] = state;
+}
+
+Environment::State Environment::at(Time t) const {
+    return std::prev(keys_.upper_bound(t))->second;
+}
+
+void Environment::add(Time t, Time len, Time step, double State::*field, double delta) {
+    for (Time k = t; k < t + len + step; k += step) {
+        Time key = std::min(k, t + len);
+        keys_.emplace(key, at(key));
+    }
+    for (auto it = keys_.upper_bound(t); it != keys_.end(); ++it) {
+        Time into = it->first - t;
+        it->second.*field += into >= len ? delta : delta * into / len;
+    }
+}
+
+Opt3001Model::Opt3001Model(const Environment &env)
+    : env_(env), ptr_(0), config_(0xC810), result_(0), epoch_(0), done_(0), reads_(0) {
+}
+
+// Completes the conversions that fell due, the last one is the result
+void Opt3001Model::advance() {
+    Time period = (config_ & kOptCt) ? 800000 : 100000;
+    uint64_t due;
+
+    if (!(config_ & kOptModeMask)) {
+        return;
+    }
+    due = (now() - epoch_) / period;
+    if ((config_ & kOptModeMask) == kOptModeSingle) {
+        due = std::min<uint64_t>(due, 1);
+    }
+    if (due > done_) {
+        result_ = luxWord(env_.at(epoch_ + due * period).lux);
+        config_ |= kOptReady;
+        done_ = due;
+        if ((config_ & kOptModeMask) == kOptModeSingle) {
+            config_ &= ~kOptModeMask;
+        }
+    }
+}
+
+bool Opt3001Model::write(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    advance();
+    ptr_ = data[0];
+    if (len >= 3 && ptr_ == OPT_CONFIG) {
+        uint16_t old = config_;
+        config_ = static_cast<uint16_t>((data[1] << 8 | data[2]) & ~kOptReady);
+        if ((config_ & kOptModeMask) && (config_ & (kOptModeMask | kOptCt)) != (old & (kOptModeMask | kOptCt))) {
+            epoch_ = now();
+            done_ = 0;
+        }
+    }
+    return true;
+}
+
+bool Opt3001Model::read(uint8_t *data, size_t len) {
+    uint16_t word;
+
+    advance();
+    reads_++;
+    switch (ptr_) {
+    case OPT_RESULT:
+        word = result_;
+        break;
+    case OPT_CONFIG:
+        word = config_;
+        config_ &= ~kOptReady;
+        break;
+    case OPT_MANUFACTURER_ID:
+        word = 0x5449;
+        break;
+    case OPT_DEVICE_ID:
+        word = 0x3001;
+        break;
+    default:
+        word = 0;
+        break;
+    }
+    return readWord(word, data, len);
+}
+
+Tmp007Model::Tmp007Model(const Environment &env) : env_(env), ptr_(0), config_(0x1440), reads_(0) {
+}
+
+bool Tmp007Model::write(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    ptr_ = data[0];
+    if (len >= 3 && ptr_ == TMP_CONFIG) {
+        config_ = static_cast<uint16_t>(data[1] << 8 | data[2]);
+    }
+    return true;
+}
+
+// Temperatures as of the last conversion, 1/32 degree above two flag bits
+bool Tmp007Model::read(uint8_t *data, size_t len) {
+    static const Time kPeriodUs[5] = {260000, 510000, 1010000, 2010000, 4010000};
+    Time period = kPeriodUs[std::min((config_ >> 9) & 7, 4)];
+    Environment::State s = env_.at(now() / period * period);
+    uint16_t word;
+
+    reads_++;
+    switch (ptr_) {
+    case TMP_DIE:
+        word = static_cast<uint16_t>(std::lround(s.airC / 0.03125) << 2);
+        break;
+    case TMP_CONFIG:
+        word = config_;
+        break;
+    case TMP_OBJECT:
+        word = static_cast<uint16_t>(std::lround(s.objectC / 0.03125) << 2);
+        break;
+    case TMP_DEVICE_ID:
+        word = 0x0078;
+        break;
+    default:
+        word = 0;
+        break;
+    }
+    return readWord(word, data, len);
+}
+
+Bmp280Model::Bmp280Model(const Environment &env) : env_(env), stats_{} {
+    reset();
+}
+
+void Bmp280Model::reset() {
+    const uint16_t calib[12] = {kT1,
+                                static_cast<uint16_t>(kT2),
+                                static_cast<uint16_t>(kT3),
+                                kP1,
+                                static_cast<uint16_t>(kP2),
+                                static_cast<uint16_t>(kP3),
+                                static_cast<uint16_t>(kP4),
+                                static_cast<uint16_t>(kP5),
+                                static_cast<uint16_t>(kP6),
+                                static_cast<uint16_t>(kP7),
+                                static_cast<uint16_t>(kP8),
+                                static_cast<uint16_t>(kP9)};
+
+    std::memset(regs_, 0, sizeof(regs_));
+    for (int i = 0; i < 12; i++) {
+        regs_[BMP_CALIB + 2 * i] = static_cast<uint8_t>(calib[i]);
+        regs_[BMP_CALIB + 2 * i + 1] = static_cast<uint8_t>(calib[i] >> 8);
+    }
+    regs_[BMP_ID] = 0x58;
+    putCounts(&regs_[BMP_PRESS_MSB], 0x80000);
+    putCounts(&regs_[BMP_PRESS_MSB + 3], 0x80000);
+    ptr_ = 0;
+    epoch_ = 0;
+    done_ = 0;
+    filled_ = false;
+    pressure_ = 0;
+    temperature_ = 0;
+}
+
+// Typical conversion time at the oversampling of CTRL_MEAS
+Time Bmp280Model::measureTime() const {
+    uint8_t t = oversampling(regs_[BMP_CTRL_MEAS] >> 5);
+    uint8_t p = oversampling((regs_[BMP_CTRL_MEAS] >> 2) & 7);
+
+    return 1000 + 2000 * t + (p ? 2000 * p + 500 : 0);
+}
+
+Time Bmp280Model::standbyTime() const {
+    return kStandbyUs[regs_[BMP_CONFIG] >> 5];
+}
+
+// A measurement cycle begins now
+void Bmp280Model::start() {
+    epoch_ = now() + measureTime();
+    done_ = 0;
+}
+
+// Takes the measurements that completed since the last access; the older
+// ones are gone from the filter long before a run can read them
+void Bmp280Model::advance() {
+    uint8_t mode = regs_[BMP_CTRL_MEAS] & 3;
+    Time cycle = measureTime() + standbyTime();
+    uint64_t due;
+
+    if (mode == 0 || now() < epoch_) {
+        return;
+    }
+    due = mode == 3 ? (now() - epoch_) / cycle + 1 : 1;
+    for (uint64_t n = std::max<uint64_t>(done_, due > kFilterHistory ? due - kFilterHistory : 0); n < due; n++) {
+        measure(epoch_ + n * cycle);
+    }
+    stats_.measurements += due - done_;
+    done_ = due;
+    if (mode != 3) {
+        regs_[BMP_CTRL_MEAS] &= ~3;     // forced mode goes back to sleep
+    }
+}
+
+void Bmp280Model::measure(Time t) {
+    Environment::State s = env_.at(t);
+    uint8_t osrsT = oversampling(regs_[BMP_CTRL_MEAS] >> 5);
+    uint8_t osrsP = oversampling((regs_[BMP_CTRL_MEAS] >> 2) & 7);
+    uint8_t filter = regs_[BMP_CONFIG] >> 2 & 7;
+    uint8_t coefficient = filter == 0 ? 1 : filter >= 4 ? 16 : 1 << filter;
+    double p = osrsP ? s.pressure + s.pressureNoise / std::sqrt(osrsP) * noise(t, kPressureNoise) : 0;
+    int32_t adcT, adcP;
+
+    if (!filled_ || coefficient == 1) {
+        pressure_ = p;
+        temperature_ = s.airC;
+        filled_ = true;
+    } else {
+        pressure_ += (p - pressure_) / coefficient;
+        temperature_ += (s.airC - temperature_) / coefficient;
+    }
+    rawCounts(temperature_, pressure_, adcT, adcP);
+
+    putCounts(&regs_[BMP_PRESS_MSB + 3], osrsT ? adcT & resolution(osrsT) : 0x80000);
+    putCounts(&regs_[BMP_PRESS_MSB], osrsP ? adcP & (coefficient > 1 ? 0xFFFFF : resolution(osrsP)) : 0x80000);
+}
+
+void Bmp280Model::writeReg(uint8_t reg, uint8_t value) {
+    if (reg == BMP_RESET) {
+        if (value == 0xB6) {
+            reset();
+        }
+        return;
+    }
+    if (reg != BMP_CTRL_MEAS && reg != BMP_CONFIG) {
+        return;     // read only
+    }
+
+    advance();
+    uint8_t old = regs_[reg];
+    regs_[reg] = value;
+    if (reg == BMP_CONFIG) {
+        regs_[reg] &= ~0x02;
+        if ((old ^ value) & 0xE0 && (regs_[BMP_CTRL_MEAS] & 3) == 3) {
+            start();
+        }
+    } else if ((value & 3) && (value != old || (value & 3) != 3)) {
+        start();
+    }
+}
+
+// Register and value pairs; a lone register sets the pointer for a read
+bool Bmp280Model::write(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    ptr_ = data[0];
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        writeReg(data[i], data[i + 1]);
+    }
+    return true;
+}
+
+// A burst reads one measurement, the pointer auto-increments
+bool Bmp280Model::read(uint8_t *data, size_t len) {
+    advance();
+    stats_.reads++;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t reg = static_cast<uint8_t>(ptr_ + i);
+        if (reg == BMP_STATUS) {
+            Time cycle = measureTime() + standbyTime();
+            bool measuring = (regs_[BMP_CTRL_MEAS] & 3) && now() + measureTime() >= epoch_ + done_ * cycle;
+            data[i] = measuring ? 0x08 : 0x00;
+        } else {
+            data[i] = regs_[reg];
+        }
+    }
+    return true;
+}
+
+} // namespace morsesim
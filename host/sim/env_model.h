@@ -0,0 +1,129 @@
+/*
+ * env_model.h
+ *
+ *  Register-level stand-ins for the slow sensors on the simulated bus, as
+ *  far as sensors/opt3001.c, bmp280.c and tmp007.c use them:
+ *
+ *    - OPT3001: the result register in exponent and mantissa, updated at
+ *      the end of each 100 or 800 ms conversion in continuous mode
+ *    - BMP280: calibration words (the datasheet's example part), forced
+ *      and normal mode at the oversampling and standby time of CTRL_MEAS
+ *      and CONFIG, the IIR filter and the resolution that go with them;
+ *      the data registers hold the raw counts that the compensation turns
+ *      back into the environment's pressure and temperature
+ *    - TMP007: the object temperature register, one conversion a second
+ *
+ *  Readings come from the environment timeline. The pressure noise is the
+ *  rms of a single conversion, oversampling divides it by the square root
+ *  of the count. Like the MPU9250 model, noise depends only on the time of
+ *  the conversion, so runs repeat exactly.
+ */
+
+#ifndef MORSESIM_ENV_MODEL_H_
+#define MORSESIM_ENV_MODEL_H_
+
+#include <map>
+
+#include "sim.h"
+
+namespace morsesim {
+
+// What the board's surroundings do over time, held from one keyframe to
+// the next
+class Environment {
+public:
+    struct State {
+        double lux;
+        double pressure;        // Pa
+        double airC;            // at the BMP280
+        double objectC;         // what the TMP007 looks at
+        double pressureNoise;   // Pa rms at 1x oversampling
+    };
+
+    Environment();
+
+    void set(Time t, const State &state);
+    State at(Time t) const;
+
+    // Adds delta to a field from t on, reached in a straight line over len
+    // with keyframes every step, over whatever the keyframes already do
+    void add(Time t, Time len, Time step, double State::*field, double delta);
+
+private:
+    std::map<Time, State> keys_;
+};
+
+class Opt3001Model : public I2cDevice {
+public:
+    explicit Opt3001Model(const Environment &env);
+
+    bool write(const uint8_t *data, size_t len) override;
+    bool read(uint8_t *data, size_t len) override;
+
+    uint64_t reads() const { return reads_; }
+
+private:
+    void advance();
+
+    const Environment &env_;
+    uint8_t ptr_;
+    uint16_t config_;
+    uint16_t result_;
+    Time epoch_;            // conversion n ends at epoch_ + n * period
+    uint64_t done_;
+    uint64_t reads_;
+};
+
+class Tmp007Model : public I2cDevice {
+public:
+    explicit Tmp007Model(const Environment &env);
+
+    bool write(const uint8_t *data, size_t len) override;
+    bool read(uint8_t *data, size_t len) override;
+
+    uint64_t reads() const { return reads_; }
+
+private:
+    const Environment &env_;
+    uint8_t ptr_;
+    uint16_t config_;
+    uint64_t reads_;
+};
+
+class Bmp280Model : public I2cDevice {
+public:
+    struct Stats {
+        uint64_t reads;
+        uint64_t measurements;
+    };
+
+    explicit Bmp280Model(const Environment &env);
+
+    bool write(const uint8_t *data, size_t len) override;
+    bool read(uint8_t *data, size_t len) override;
+
+    const Stats &stats() const { return stats_; }
+
+private:
+    void reset();
+    Time measureTime() const;
+    Time standbyTime() const;
+    void start();
+    void advance();
+    void measure(Time t);
+    void writeReg(uint8_t reg, uint8_t value);
+
+    const Environment &env_;
+    uint8_t regs_[256];
+    uint8_t ptr_;
+    Time epoch_;            // measurement n ends at epoch_ + n * cycle
+    uint64_t done_;
+    bool filled_;           // the filter holds a measurement
+    double pressure_;       // filter outputs
+    double temperature_;
+    Stats stats_;
+};
+
+} // namespace morsesim
+
+#endif /* MORSESIM_ENV_MODEL_H_ */
@@ -0,0 +1,23 @@
+/*
+ * driverlib/aon_rtc.h
+ *
+ *  Simulator shim, the RTC counter from virtual time in whole 32768 Hz
+ *  periods, seconds in the upper word and the fraction in the lower.
+ */
+
+#ifndef SIM_DRIVERLIB_AON_RTC_H_
+#define SIM_DRIVERLIB_AON_RTC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t AONRTCCurrent64BitValueGet(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_DRIVERLIB_AON_RTC_H_ */
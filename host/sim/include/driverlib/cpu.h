@@ -0,0 +1,23 @@
+/*
+ * driverlib/cpu.h
+ *
+ *  Simulator shim, the delay advances virtual time without yielding.
+ */
+
+#ifndef SIM_DRIVERLIB_CPU_H_
+#define SIM_DRIVERLIB_CPU_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Three CPU cycles per count at 48 MHz
+void CPUdelay(uint32_t ui32Count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_DRIVERLIB_CPU_H_ */
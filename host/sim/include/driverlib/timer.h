@@ -0,0 +1,43 @@
+/*
+ * driverlib/timer.h
+ *
+ *  Simulator shim, the GPT calls buzzer.c makes. Timer A of GPT0 in PWM
+ *  mode on a pin muxed to its event is reported as a tone, see
+ *  watchTone() in sim.h.
+ */
+
+#ifndef SIM_DRIVERLIB_TIMER_H_
+#define SIM_DRIVERLIB_TIMER_H_
+
+#include <stdint.h>
+
+#define GPT0_BASE               0x40010000
+#define GPT1_BASE               0x40011000
+#define GPT2_BASE               0x40012000
+#define GPT3_BASE               0x40013000
+
+#define TIMER_A                 0x000000FF
+#define TIMER_B                 0x0000FF00
+#define TIMER_BOTH              0x0000FFFF
+
+#define TIMER_CFG_SPLIT_PAIR    0x04000000
+#define TIMER_CFG_A_PWM         0x0000000A
+#define TIMER_CFG_B_PWM         0x00000A00
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config);
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer);
+void TimerDisable(uint32_t ui32Base, uint32_t ui32Timer);
+void TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+void TimerPrescaleSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+void TimerMatchSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+void TimerPrescaleMatchSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_DRIVERLIB_TIMER_H_ */
@@ -0,0 +1,16 @@
+/*
+ * inc/hw_cpu_dwt.h
+ *
+ *  Simulator shim, the DWT cycle counter. It counts virtual time at
+ *  48 MHz while enabled, see sim_hwreg().
+ */
+
+#ifndef SIM_INC_HW_CPU_DWT_H_
+#define SIM_INC_HW_CPU_DWT_H_
+
+#define CPU_DWT_O_CTRL              0x00000000
+#define CPU_DWT_O_CYCCNT            0x00000004
+
+#define CPU_DWT_CTRL_CYCCNTENA      0x00000001
+
+#endif /* SIM_INC_HW_CPU_DWT_H_ */
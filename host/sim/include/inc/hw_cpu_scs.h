@@ -0,0 +1,14 @@
+/*
+ * inc/hw_cpu_scs.h
+ *
+ *  Simulator shim, the trace enable bit the DWT needs.
+ */
+
+#ifndef SIM_INC_HW_CPU_SCS_H_
+#define SIM_INC_HW_CPU_SCS_H_
+
+#define CPU_SCS_O_DEMCR             0x00000DFC
+
+#define CPU_SCS_DEMCR_TRCENA        0x01000000
+
+#endif /* SIM_INC_HW_CPU_SCS_H_ */
@@ -0,0 +1,13 @@
+/*
+ * inc/hw_memmap.h
+ *
+ *  Simulator shim, the base addresses hal_tirtos.c uses.
+ */
+
+#ifndef SIM_INC_HW_MEMMAP_H_
+#define SIM_INC_HW_MEMMAP_H_
+
+#define CPU_DWT_BASE            0xE0001000
+#define CPU_SCS_BASE            0xE000E000
+
+#endif /* SIM_INC_HW_MEMMAP_H_ */
@@ -0,0 +1,25 @@
+/*
+ * inc/hw_types.h
+ *
+ *  Simulator shim, register access goes through sim_hwreg() in
+ *  kernel.cpp, which keeps the registers the firmware touches.
+ */
+
+#ifndef SIM_INC_HW_TYPES_H_
+#define SIM_INC_HW_TYPES_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+volatile uint32_t *sim_hwreg(uint32_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define HWREG(x)    (*sim_hwreg(x))
+
+#endif /* SIM_INC_HW_TYPES_H_ */
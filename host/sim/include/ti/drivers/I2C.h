@@ -0,0 +1,57 @@
+/*
+ * ti/drivers/I2C.h
+ *
+ *  Simulator shim. Blocking mode only, a transfer blocks the calling task
+ *  for its duration on the bus and goes to the device model at its
+ *  address (host/sim/sim.h).
+ */
+
+#ifndef SIM_TI_DRIVERS_I2C_H_
+#define SIM_TI_DRIVERS_I2C_H_
+
+#include <xdc/std.h>
+
+typedef struct I2C_Config *I2C_Handle;
+
+typedef enum {
+    I2C_100kHz = 0,
+    I2C_400kHz = 1
+} I2C_BitRate;
+
+typedef enum {
+    I2C_MODE_BLOCKING,
+    I2C_MODE_CALLBACK
+} I2C_TransferMode;
+
+typedef struct {
+    void *writeBuf;
+    size_t writeCount;
+    void *readBuf;
+    size_t readCount;
+    uint8_t slaveAddress;
+    void *arg;
+    void *nextPtr;
+} I2C_Transaction;
+
+typedef struct {
+    I2C_TransferMode transferMode;
+    void *transferCallbackFxn;
+    I2C_BitRate bitRate;
+    void *custom;
+} I2C_Params;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void I2C_init(void);
+void I2C_Params_init(I2C_Params *params);
+I2C_Handle I2C_open(unsigned int index, I2C_Params *params);
+void I2C_close(I2C_Handle handle);
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_I2C_H_ */
@@ -0,0 +1,79 @@
+/*
+ * ti/drivers/PIN.h
+ *
+ *  Simulator shim. Inputs are driven by the scenario, edges call the
+ *  registered callback in Hwi context. The config bit layout is the
+ *  simulator's own, firmware only combines the named flags.
+ */
+
+#ifndef SIM_TI_DRIVERS_PIN_H_
+#define SIM_TI_DRIVERS_PIN_H_
+
+#include <xdc/std.h>
+
+typedef uint32_t PIN_Config;
+typedef uint8_t PIN_Id;
+
+#define PIN_ID(cfg)             ((PIN_Id)((cfg) & 0xFF))
+#define PIN_TERMINATE           0xFE
+#define PIN_UNASSIGNED          0xFF
+#define PIN_SUCCESS             0
+#define PIN_ALREADY_ALLOCATED   1
+#define PIN_NO_ACCESS           2
+
+#define PIN_INPUT_DIS           0
+#define PIN_INPUT_EN            (1u << 8)
+#define PIN_NOPULL              0
+#define PIN_PULLUP              (1u << 9)
+#define PIN_PULLDOWN            (1u << 10)
+#define PIN_IRQ_DIS             0
+#define PIN_IRQ_NEGEDGE         (1u << 11)
+#define PIN_IRQ_POSEDGE         (1u << 12)
+#define PIN_IRQ_BOTHEDGES       (PIN_IRQ_NEGEDGE | PIN_IRQ_POSEDGE)
+#define PIN_GPIO_OUTPUT_DIS     0
+#define PIN_GPIO_OUTPUT_EN      (1u << 13)
+#define PIN_GPIO_LOW            0
+#define PIN_GPIO_HIGH           (1u << 14)
+#define PIN_PUSHPULL            0
+#define PIN_OPENDRAIN           (1u << 15)
+#define PIN_OPENSOURCE          (1u << 16)
+#define PIN_DRVSTR_MIN          0
+#define PIN_DRVSTR_MED          (1u << 17)
+#define PIN_DRVSTR_MAX          (2u << 17)
+#define PIN_HYSTERESIS          (1u << 19)
+
+#define PIN_BM_INPUT_MODE       (PIN_INPUT_EN | PIN_PULLUP | PIN_PULLDOWN | PIN_HYSTERESIS)
+#define PIN_BM_IRQ              PIN_IRQ_BOTHEDGES
+#define PIN_BM_OUTPUT_MODE      (PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH | PIN_OPENDRAIN | PIN_OPENSOURCE | PIN_DRVSTR_MAX)
+#define PIN_BM_ALL              0xFFFFFF00u
+
+typedef struct PIN_State PIN_State;
+typedef PIN_State *PIN_Handle;
+
+typedef void (*PIN_IntCb)(PIN_Handle handle, PIN_Id pinId);
+
+struct PIN_State {
+    uint64_t pins;      // bit per owned pin
+    PIN_IntCb cb;
+    UArg userArg;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int PIN_init(const PIN_Config aPinConfig[]);
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config aPinList[]);
+void PIN_close(PIN_Handle handle);
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callbackFxn);
+int PIN_setConfig(PIN_Handle handle, PIN_Config bmMask, PIN_Config pinCfg);
+int PIN_setInterrupt(PIN_Handle handle, PIN_Config pinCfg);
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val);
+uint32_t PIN_getOutputValue(PIN_Id pinId);
+uint32_t PIN_getInputValue(PIN_Id pinId);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_PIN_H_ */
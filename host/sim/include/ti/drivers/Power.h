@@ -0,0 +1,43 @@
+/*
+ * ti/drivers/Power.h
+ *
+ *  Simulator shim. The simulator enters standby when every task is
+ *  blocked long enough and no constraint forbids it.
+ */
+
+#ifndef SIM_TI_DRIVERS_POWER_H_
+#define SIM_TI_DRIVERS_POWER_H_
+
+#include <xdc/std.h>
+
+#define Power_SOK           0
+#define Power_EFAIL         (-1)
+#define Power_NOTIFYDONE    0
+#define Power_NOTIFYERROR   (-1)
+
+typedef int (*Power_NotifyFxn)(unsigned int eventType, uintptr_t eventArg, uintptr_t clientArg);
+
+typedef struct Power_NotifyObj {
+    struct Power_NotifyObj *next;
+    unsigned int eventTypes;
+    Power_NotifyFxn notifyFxn;
+    uintptr_t clientArg;
+} Power_NotifyObj;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int Power_init(void);
+int Power_setConstraint(unsigned int constraintId);
+int Power_releaseConstraint(unsigned int constraintId);
+unsigned int Power_getConstraintMask(void);
+int Power_setDependency(unsigned int resourceId);
+int Power_releaseDependency(unsigned int resourceId);
+int Power_registerNotify(Power_NotifyObj *notifyObj, unsigned int eventTypes, Power_NotifyFxn notifyFxn, uintptr_t clientArg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_POWER_H_ */
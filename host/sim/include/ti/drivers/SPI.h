@@ -0,0 +1,75 @@
+/*
+ * ti/drivers/SPI.h
+ *
+ *  Simulator shim. Master, blocking mode only, a transfer blocks the
+ *  calling task for its duration at the bit rate. The bytes go to the
+ *  flash model on SPI0 while its chip select pin is low, the only device
+ *  on the bus (host/sim/sim.h).
+ */
+
+#ifndef SIM_TI_DRIVERS_SPI_H_
+#define SIM_TI_DRIVERS_SPI_H_
+
+#include <xdc/std.h>
+
+typedef struct SPI_Config *SPI_Handle;
+
+typedef enum {
+    SPI_POL0_PHA0 = 0,
+    SPI_POL0_PHA1 = 1,
+    SPI_POL1_PHA0 = 2,
+    SPI_POL1_PHA1 = 3
+} SPI_FrameFormat;
+
+typedef enum {
+    SPI_MASTER = 0,
+    SPI_SLAVE = 1
+} SPI_Mode;
+
+typedef enum {
+    SPI_MODE_BLOCKING,
+    SPI_MODE_CALLBACK
+} SPI_TransferMode;
+
+typedef enum {
+    SPI_TRANSFER_COMPLETED = 0,
+    SPI_TRANSFER_STARTED,
+    SPI_TRANSFER_CANCELED,
+    SPI_TRANSFER_FAILED,
+    SPI_TRANSFER_CSN_DEASSERT
+} SPI_Status;
+
+typedef struct {
+    size_t count;
+    void *txBuf;        // NULL sends zeros
+    void *rxBuf;        // NULL discards
+    void *arg;
+    SPI_Status status;
+} SPI_Transaction;
+
+typedef struct {
+    SPI_TransferMode transferMode;
+    uint32_t transferTimeout;
+    void *transferCallbackFxn;
+    SPI_Mode mode;
+    uint32_t bitRate;
+    uint32_t dataSize;
+    SPI_FrameFormat frameFormat;
+    void *custom;
+} SPI_Params;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void SPI_init(void);
+void SPI_Params_init(SPI_Params *params);
+SPI_Handle SPI_open(unsigned int index, SPI_Params *params);
+void SPI_close(SPI_Handle handle);
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_SPI_H_ */
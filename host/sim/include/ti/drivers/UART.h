@@ -0,0 +1,62 @@
+/*
+ * ti/drivers/UART.h
+ *
+ *  Simulator shim. Writes block, reads complete through the callback with
+ *  bytes the scenario sends. Transfers take their time at the baud rate.
+ */
+
+#ifndef SIM_TI_DRIVERS_UART_H_
+#define SIM_TI_DRIVERS_UART_H_
+
+#include <xdc/std.h>
+
+typedef struct UART_Config *UART_Handle;
+
+typedef void (*UART_Callback)(UART_Handle handle, void *buf, size_t count);
+
+typedef enum { UART_MODE_BLOCKING, UART_MODE_CALLBACK } UART_Mode;
+typedef enum { UART_RETURN_PARTIAL, UART_RETURN_FULL, UART_RETURN_NEWLINE } UART_ReturnMode;
+typedef enum { UART_DATA_BINARY, UART_DATA_TEXT } UART_DataMode;
+typedef enum { UART_ECHO_OFF, UART_ECHO_ON } UART_Echo;
+typedef enum { UART_LEN_5, UART_LEN_6, UART_LEN_7, UART_LEN_8 } UART_LEN;
+typedef enum { UART_STOP_ONE, UART_STOP_TWO } UART_STOP;
+typedef enum { UART_PAR_NONE, UART_PAR_EVEN, UART_PAR_ODD, UART_PAR_ZERO, UART_PAR_ONE } UART_PAR;
+
+typedef struct {
+    UART_Mode readMode;
+    UART_Mode writeMode;
+    uint32_t readTimeout;
+    uint32_t writeTimeout;
+    UART_Callback readCallback;
+    UART_Callback writeCallback;
+    UART_ReturnMode readReturnMode;
+    UART_DataMode readDataMode;
+    UART_DataMode writeDataMode;
+    UART_Echo readEcho;
+    uint32_t baudRate;
+    UART_LEN dataLength;
+    UART_STOP stopBits;
+    UART_PAR parityType;
+    void *custom;
+} UART_Params;
+
+#define UART_ERROR          (-1)
+#define UART_WAIT_FOREVER   (~(0U))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void UART_init(void);
+void UART_Params_init(UART_Params *params);
+UART_Handle UART_open(unsigned int index, UART_Params *params);
+void UART_close(UART_Handle handle);
+int UART_write(UART_Handle handle, const void *buffer, size_t size);
+int UART_read(UART_Handle handle, void *buffer, size_t size);
+void UART_readCancel(UART_Handle handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_UART_H_ */
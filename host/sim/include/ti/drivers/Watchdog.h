@@ -0,0 +1,42 @@
+/*
+ * ti/drivers/Watchdog.h
+ *
+ *  Simulator shim with the CC26XX behaviour: the callback at the first
+ *  timeout, a reset at the second unless cleared. The reload value is
+ *  the 1000 ms from CC2650STK.c. A reset ends the simulation.
+ */
+
+#ifndef SIM_TI_DRIVERS_WATCHDOG_H_
+#define SIM_TI_DRIVERS_WATCHDOG_H_
+
+#include <xdc/std.h>
+
+typedef struct Watchdog_Config *Watchdog_Handle;
+
+typedef void (*Watchdog_Callback)(UArg handle);
+
+typedef enum { Watchdog_RESET_OFF, Watchdog_RESET_ON } Watchdog_ResetMode;
+typedef enum { Watchdog_DEBUG_STALL_ON, Watchdog_DEBUG_STALL_OFF } Watchdog_DebugMode;
+
+typedef struct {
+    Watchdog_Callback callbackFxn;
+    Watchdog_ResetMode resetMode;
+    Watchdog_DebugMode debugStallMode;
+    void *custom;
+} Watchdog_Params;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void Watchdog_init(void);
+void Watchdog_Params_init(Watchdog_Params *params);
+Watchdog_Handle Watchdog_open(unsigned int index, Watchdog_Params *params);
+void Watchdog_clear(Watchdog_Handle handle);
+void Watchdog_close(Watchdog_Handle handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_WATCHDOG_H_ */
@@ -0,0 +1,94 @@
+/*
+ * ti/drivers/pdm/PDMCC26XX.h
+ *
+ *  Simulator shim. The stream delivers a block of 16 kHz PCM from the
+ *  microphone model every retBufSizeInBytes worth of samples, see
+ *  setMicTone() in sim.h. Compression, custom decimation filters and the
+ *  startup delay are not simulated.
+ */
+
+#ifndef SIM_TI_DRIVERS_PDM_PDMCC26XX_H_
+#define SIM_TI_DRIVERS_PDM_PDMCC26XX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct PDMCC26XX_Config *PDMCC26XX_Handle;
+
+typedef enum {
+    PDMCC26XX_GAIN_24,
+    PDMCC26XX_GAIN_18,
+    PDMCC26XX_GAIN_12,
+    PDMCC26XX_GAIN_6,
+    PDMCC26XX_GAIN_0,
+    PDMCC26XX_GAIN_END
+} PDMCC26XX_Gain;
+
+typedef enum {
+    PDMCC26XX_STREAM_IDLE,
+    PDMCC26XX_STREAM_BLOCK_READY,
+    PDMCC26XX_STREAM_BLOCK_READY_BUT_PDM_OVERFLOW,
+    PDMCC26XX_STREAM_ERROR,
+    PDMCC26XX_STREAM_STOPPING,
+    PDMCC26XX_STREAM_STOPPED,
+    PDMCC26XX_STREAM_FAILED_TO_STOP
+} PDMCC26XX_StreamStatus;
+
+typedef struct {
+    uint8_t attrib;
+    uint8_t seqNum;
+} PDMCC26XX_metaData;
+
+typedef struct {
+    PDMCC26XX_metaData metaData;
+    int16_t pBuffer[];
+} PDMCC26XX_pcmBuffer;
+
+typedef struct {
+    PDMCC26XX_pcmBuffer *buffer;
+    PDMCC26XX_StreamStatus status;
+} PDMCC26XX_BufferRequest;
+
+typedef struct {
+    void *bufferHandle;
+} PDMCC26XX_BufferRelease;
+
+typedef struct {
+    void *arg;
+    PDMCC26XX_StreamStatus status;
+} PDMCC26XX_StreamNotification;
+
+typedef void (*PDMCC26XX_CallbackFxn)(PDMCC26XX_Handle handle, PDMCC26XX_StreamNotification *notification);
+typedef void *(*PDMCC26XX_MallocFxn)(size_t size);
+typedef void (*PDMCC26XX_FreeFxn)(void *block, size_t size);
+
+typedef struct {
+    PDMCC26XX_CallbackFxn callbackFxn;
+    bool useDefaultFilter;
+    PDMCC26XX_Gain micGain;
+    bool micPowerActiveHigh;
+    bool applyCompression;
+    uint16_t retBufSizeInBytes;
+    PDMCC26XX_MallocFxn mallocFxn;
+    PDMCC26XX_FreeFxn freeFxn;
+    void *custom;
+} PDMCC26XX_Params;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void PDMCC26XX_Params_init(PDMCC26XX_Params *params);
+PDMCC26XX_Handle PDMCC26XX_open(PDMCC26XX_Params *params);
+void PDMCC26XX_close(PDMCC26XX_Handle handle);
+bool PDMCC26XX_startStream(PDMCC26XX_Handle handle);
+bool PDMCC26XX_stopStream(PDMCC26XX_Handle handle);
+bool PDMCC26XX_requestBuffer(PDMCC26XX_Handle handle, PDMCC26XX_BufferRequest *bufferRequest);
+void PDMCC26XX_releaseBuffer(PDMCC26XX_Handle handle, PDMCC26XX_BufferRelease *bufferRelease);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_PDM_PDMCC26XX_H_ */
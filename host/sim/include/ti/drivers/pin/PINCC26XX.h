@@ -0,0 +1,32 @@
+/*
+ * ti/drivers/pin/PINCC26XX.h
+ *
+ *  Simulator shim.
+ */
+
+#ifndef SIM_TI_DRIVERS_PIN_PINCC26XX_H_
+#define SIM_TI_DRIVERS_PIN_PINCC26XX_H_
+
+#include <ti/drivers/PIN.h>
+
+#define IOC_PORT_GPIO               0x00
+#define IOC_PORT_MCU_PORT_EVENT0    0x17
+#define IOC_PORT_MCU_PORT_EVENT1    0x18
+#define IOC_PORT_MCU_PORT_EVENT2    0x19
+#define IOC_PORT_MCU_PORT_EVENT3    0x1A
+#define IOC_PORT_MCU_PORT_EVENT4    0x1B
+#define IOC_PORT_MCU_PORT_EVENT5    0x1C
+#define IOC_PORT_MCU_PORT_EVENT6    0x1D
+#define IOC_PORT_MCU_PORT_EVENT7    0x1E
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int PINCC26XX_setMux(PIN_Handle handle, PIN_Id pinId, int32_t mux);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_PIN_PINCC26XX_H_ */
@@ -0,0 +1,29 @@
+/*
+ * ti/drivers/power/PowerCC26XX.h
+ *
+ *  Simulator shim.
+ */
+
+#ifndef SIM_TI_DRIVERS_POWER_POWERCC26XX_H_
+#define SIM_TI_DRIVERS_POWER_POWERCC26XX_H_
+
+#include <ti/drivers/Power.h>
+
+// Constraints, indexes into the constraint counters
+#define PowerCC26XX_SB_DISALLOW         0
+#define PowerCC26XX_IDLE_PD_DISALLOW    1
+#define PowerCC26XX_SD_DISALLOW         2
+#define PowerCC26XX_NUMCONSTRAINTS      3
+
+// Notification events, a bit mask
+#define PowerCC26XX_ENTERING_STANDBY    0x1
+#define PowerCC26XX_ENTERING_SHUTDOWN   0x2
+#define PowerCC26XX_AWAKE_STANDBY       0x4
+#define PowerCC26XX_AWAKE_STANDBY_LATE  0x8
+
+#define PowerCC26XX_PERIPH_GPT0         0
+#define PowerCC26XX_PERIPH_GPT1         1
+#define PowerCC26XX_PERIPH_GPT2         2
+#define PowerCC26XX_PERIPH_GPT3         3
+
+#endif /* SIM_TI_DRIVERS_POWER_POWERCC26XX_H_ */
@@ -0,0 +1,80 @@
+/*
+ * ti/drivers/timer/GPTimerCC26XX.h
+ *
+ *  Simulator shim. One-shot and periodic timers raise their timeout
+ *  interrupt from the 48 MHz count, a PWM timer drives the pins muxed to
+ *  its event, see watchOutputs() in sim.h. Captures and edge counting are
+ *  not simulated.
+ */
+
+#ifndef SIM_TI_DRIVERS_TIMER_GPTIMERCC26XX_H_
+#define SIM_TI_DRIVERS_TIMER_GPTIMERCC26XX_H_
+
+#include <stdint.h>
+
+#include <ti/drivers/pin/PINCC26XX.h>
+
+typedef struct GPTimerCC26XX_Config *GPTimerCC26XX_Handle;
+
+typedef uint32_t GPTimerCC26XX_Value;
+typedef uint16_t GPTimerCC26XX_IntMask;
+
+typedef enum { GPT_CONFIG_32BIT, GPT_CONFIG_16BIT } GPTimerCC26XX_Width;
+
+typedef enum {
+    GPT_MODE_ONESHOT,
+    GPT_MODE_PERIODIC,
+    GPT_MODE_EDGE_COUNT,
+    GPT_MODE_EDGE_TIME,
+    GPT_MODE_PWM
+} GPTimerCC26XX_Mode;
+
+typedef enum { GPTimerCC26XX_DEBUG_STALL_OFF, GPTimerCC26XX_DEBUG_STALL_ON } GPTimerCC26XX_DebugMode;
+
+typedef enum {
+    GPT_INT_TIMEOUT = 1 << 0,
+    GPT_INT_CAPTURE_MATCH = 1 << 1,
+    GPT_INT_CAPTURE = 1 << 2,
+    GPT_INT_MATCH = 1 << 4
+} GPTimerCC26XX_Interrupt;
+
+// Port event of each timer part, in Board_GPTIMERxx order
+typedef enum {
+    GPT_PIN_0A = IOC_PORT_MCU_PORT_EVENT0,
+    GPT_PIN_0B = IOC_PORT_MCU_PORT_EVENT1,
+    GPT_PIN_1A = IOC_PORT_MCU_PORT_EVENT2,
+    GPT_PIN_1B = IOC_PORT_MCU_PORT_EVENT3,
+    GPT_PIN_2A = IOC_PORT_MCU_PORT_EVENT4,
+    GPT_PIN_2B = IOC_PORT_MCU_PORT_EVENT5,
+    GPT_PIN_3A = IOC_PORT_MCU_PORT_EVENT6,
+    GPT_PIN_3B = IOC_PORT_MCU_PORT_EVENT7
+} GPTimerCC26XX_PinMux;
+
+typedef void (*GPTimerCC26XX_HwiFxn)(GPTimerCC26XX_Handle handle, GPTimerCC26XX_IntMask interruptMask);
+
+typedef struct {
+    GPTimerCC26XX_Width width;
+    GPTimerCC26XX_Mode mode;
+    GPTimerCC26XX_DebugMode debugStallMode;
+} GPTimerCC26XX_Params;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void GPTimerCC26XX_Params_init(GPTimerCC26XX_Params *params);
+GPTimerCC26XX_Handle GPTimerCC26XX_open(unsigned int index, const GPTimerCC26XX_Params *params);
+void GPTimerCC26XX_close(GPTimerCC26XX_Handle handle);
+void GPTimerCC26XX_start(GPTimerCC26XX_Handle handle);
+void GPTimerCC26XX_stop(GPTimerCC26XX_Handle handle);
+void GPTimerCC26XX_setLoadValue(GPTimerCC26XX_Handle handle, GPTimerCC26XX_Value loadValue);
+void GPTimerCC26XX_setMatchValue(GPTimerCC26XX_Handle handle, GPTimerCC26XX_Value matchValue);
+void GPTimerCC26XX_registerInterrupt(GPTimerCC26XX_Handle handle, GPTimerCC26XX_HwiFxn callback,
+                                     GPTimerCC26XX_IntMask intMask);
+GPTimerCC26XX_PinMux GPTimerCC26XX_getPinMux(GPTimerCC26XX_Handle handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_DRIVERS_TIMER_GPTIMERCC26XX_H_ */
@@ -0,0 +1,25 @@
+/*
+ * ti/sysbios/BIOS.h
+ *
+ *  Simulator shim. BIOS_start() runs the scenario and returns at its end.
+ */
+
+#ifndef SIM_TI_SYSBIOS_BIOS_H_
+#define SIM_TI_SYSBIOS_BIOS_H_
+
+#include <xdc/std.h>
+
+#define BIOS_WAIT_FOREVER   (~(0U))
+#define BIOS_NO_WAIT        (0U)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BIOS_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_SYSBIOS_BIOS_H_ */
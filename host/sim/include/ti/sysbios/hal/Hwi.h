@@ -0,0 +1,31 @@
+/*
+ * ti/sysbios/hal/Hwi.h
+ *
+ *  Simulator shim. Interrupts are only delivered between scheduling
+ *  points, so disabling them just counts the nesting.
+ */
+
+#ifndef SIM_TI_SYSBIOS_HAL_HWI_H_
+#define SIM_TI_SYSBIOS_HAL_HWI_H_
+
+#include <xdc/std.h>
+
+typedef struct {
+    size_t hwiStackPeak;
+    size_t hwiStackSize;
+    Ptr hwiStackBase;
+} Hwi_StackInfo;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+UInt Hwi_disable(void);
+void Hwi_restore(UInt key);
+Bool Hwi_getStackInfo(Hwi_StackInfo *stkInfo, Bool computeStackDepth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_SYSBIOS_HAL_HWI_H_ */
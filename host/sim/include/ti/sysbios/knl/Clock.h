@@ -0,0 +1,47 @@
+/*
+ * ti/sysbios/knl/Clock.h
+ *
+ *  Simulator shim. Clock functions run in Swi context on virtual tick
+ *  boundaries, Clock_tickPeriod is 10 us as in empty.cfg.
+ */
+
+#ifndef SIM_TI_SYSBIOS_KNL_CLOCK_H_
+#define SIM_TI_SYSBIOS_KNL_CLOCK_H_
+
+#include <xdc/std.h>
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+typedef struct {
+    UInt32 period;
+    Bool startFlag;
+    UArg arg;
+} Clock_Params;
+
+typedef struct Clock_Struct {
+    void *impl;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern UInt32 Clock_tickPeriod;
+
+void Clock_Params_init(Clock_Params *params);
+void Clock_construct(Clock_Struct *obj, Clock_FuncPtr fxn, UInt timeout, const Clock_Params *params);
+Clock_Handle Clock_handle(Clock_Struct *obj);
+void Clock_start(Clock_Handle handle);
+void Clock_stop(Clock_Handle handle);
+void Clock_setTimeout(Clock_Handle handle, UInt32 timeout);
+void Clock_setPeriod(Clock_Handle handle, UInt32 period);
+Bool Clock_isActive(Clock_Handle handle);
+UInt32 Clock_getTicks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_SYSBIOS_KNL_CLOCK_H_ */
@@ -0,0 +1,43 @@
+/*
+ * ti/sysbios/knl/Mailbox.h
+ *
+ *  Simulator shim. The buffer given in Mailbox_Params is not used.
+ */
+
+#ifndef SIM_TI_SYSBIOS_KNL_MAILBOX_H_
+#define SIM_TI_SYSBIOS_KNL_MAILBOX_H_
+
+#include <xdc/std.h>
+
+typedef struct {
+    Ptr next;
+    Ptr prev;
+} Mailbox_MbxElem;
+
+typedef struct {
+    Ptr buf;
+    UInt bufSize;
+} Mailbox_Params;
+
+typedef struct Mailbox_Struct {
+    void *impl;
+} Mailbox_Struct;
+
+typedef Mailbox_Struct *Mailbox_Handle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void Mailbox_Params_init(Mailbox_Params *params);
+void Mailbox_construct(Mailbox_Struct *obj, size_t msgSize, UInt numMsgs, const Mailbox_Params *params, Error_Block *eb);
+Mailbox_Handle Mailbox_handle(Mailbox_Struct *obj);
+Bool Mailbox_post(Mailbox_Handle handle, Ptr msg, UInt32 timeout);
+Bool Mailbox_pend(Mailbox_Handle handle, Ptr msg, UInt32 timeout);
+Int Mailbox_getNumPendingMsgs(Mailbox_Handle handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_SYSBIOS_KNL_MAILBOX_H_ */
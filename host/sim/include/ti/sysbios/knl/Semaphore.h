@@ -0,0 +1,41 @@
+/*
+ * ti/sysbios/knl/Semaphore.h
+ *
+ *  Simulator shim.
+ */
+
+#ifndef SIM_TI_SYSBIOS_KNL_SEMAPHORE_H_
+#define SIM_TI_SYSBIOS_KNL_SEMAPHORE_H_
+
+#include <xdc/std.h>
+
+typedef enum {
+    Semaphore_Mode_COUNTING,
+    Semaphore_Mode_BINARY
+} Semaphore_Mode;
+
+typedef struct {
+    Semaphore_Mode mode;
+} Semaphore_Params;
+
+typedef struct Semaphore_Struct {
+    void *impl;
+} Semaphore_Struct;
+
+typedef Semaphore_Struct *Semaphore_Handle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void Semaphore_Params_init(Semaphore_Params *params);
+void Semaphore_construct(Semaphore_Struct *obj, Int count, const Semaphore_Params *params);
+Semaphore_Handle Semaphore_handle(Semaphore_Struct *obj);
+Bool Semaphore_pend(Semaphore_Handle handle, UInt32 timeout);
+void Semaphore_post(Semaphore_Handle handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_SYSBIOS_KNL_SEMAPHORE_H_ */
@@ -0,0 +1,53 @@
+/*
+ * ti/sysbios/knl/Task.h
+ *
+ *  Simulator shim. Tasks are coroutines with their own host stacks, the
+ *  stack given in Task_Params only sets the reported size.
+ */
+
+#ifndef SIM_TI_SYSBIOS_KNL_TASK_H_
+#define SIM_TI_SYSBIOS_KNL_TASK_H_
+
+#include <xdc/std.h>
+
+typedef void (*Task_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct {
+    UArg arg0;
+    UArg arg1;
+    Int priority;
+    Ptr stack;
+    size_t stackSize;
+    String instance_name;
+} Task_Params;
+
+typedef struct {
+    Int priority;
+    Int mode;
+    Ptr env;
+    size_t stackSize;
+    Ptr stack;
+    size_t used;
+} Task_Stat;
+
+typedef struct Task_Object *Task_Handle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void Task_Params_init(Task_Params *params);
+Task_Handle Task_create(Task_FuncPtr fxn, const Task_Params *params, Error_Block *eb);
+void Task_sleep(UInt32 nticks);
+void Task_yield(void);
+Task_Handle Task_self(void);
+Task_Handle Task_getIdleTask(void);
+void Task_stat(Task_Handle handle, Task_Stat *statbuf);
+UInt Task_disable(void);
+void Task_restore(UInt key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TI_SYSBIOS_KNL_TASK_H_ */
@@ -0,0 +1,24 @@
+/*
+ * xdc/runtime/System.h
+ *
+ *  Simulator shim, output goes to the simulator log.
+ */
+
+#ifndef SIM_XDC_RUNTIME_SYSTEM_H_
+#define SIM_XDC_RUNTIME_SYSTEM_H_
+
+#include <xdc/std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+Int System_printf(const char *fmt, ...);
+void System_flush(void);
+void System_abort(const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_XDC_RUNTIME_SYSTEM_H_ */
@@ -0,0 +1,24 @@
+/*
+ * xdc/runtime/Timestamp.h
+ *
+ *  Simulator shim, counts CPU cycles of virtual time at 48 MHz.
+ */
+
+#ifndef SIM_XDC_RUNTIME_TIMESTAMP_H_
+#define SIM_XDC_RUNTIME_TIMESTAMP_H_
+
+#include <xdc/runtime/Types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+Bits32 Timestamp_get32(void);
+void Timestamp_get64(Types_Timestamp64 *result);
+void Timestamp_getFreq(Types_FreqHz *freq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_XDC_RUNTIME_TIMESTAMP_H_ */
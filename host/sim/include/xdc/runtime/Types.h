@@ -0,0 +1,22 @@
+/*
+ * xdc/runtime/Types.h
+ *
+ *  Simulator shim.
+ */
+
+#ifndef SIM_XDC_RUNTIME_TYPES_H_
+#define SIM_XDC_RUNTIME_TYPES_H_
+
+#include <xdc/std.h>
+
+typedef struct {
+    Bits32 hi;
+    Bits32 lo;
+} Types_FreqHz;
+
+typedef struct {
+    Bits32 hi;
+    Bits32 lo;
+} Types_Timestamp64;
+
+#endif /* SIM_XDC_RUNTIME_TYPES_H_ */
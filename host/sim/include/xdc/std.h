@@ -0,0 +1,40 @@
+/*
+ * xdc/std.h
+ *
+ *  Simulator shim (see host/sim/kernel.cpp). Only what the firmware uses.
+ */
+
+#ifndef SIM_XDC_STD_H_
+#define SIM_XDC_STD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef char Char;
+typedef unsigned char UChar;
+typedef short Short;
+typedef unsigned short UShort;
+typedef int Int;
+typedef unsigned int UInt;
+typedef long Long;
+typedef unsigned long ULong;
+typedef int8_t Int8;
+typedef uint8_t UInt8;
+typedef int16_t Int16;
+typedef uint16_t UInt16;
+typedef int32_t Int32;
+typedef uint32_t UInt32;
+typedef uint32_t Bits32;
+typedef uintptr_t UArg;
+typedef bool Bool;
+typedef void *Ptr;
+typedef const char *String;
+typedef void Void;
+
+#define TRUE 1
+#define FALSE 0
+
+typedef struct Error_Block Error_Block;
+
+#endif /* SIM_XDC_STD_H_ */
@@ -0,0 +1,764 @@
+/*
+ * kernel.cpp
+ *
+ *  SYS/BIOS on virtual time: tasks as ucontext coroutines with strict
+ *  priority scheduling, Clock, Semaphore, Mailbox, Hwi, Timestamp, the
+ *  RTC and DWT cycle counters, System and the Power standby policy. See
+ *  sim.h.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <ucontext.h>
+
+#include <ti/drivers/power/PowerCC26XX.h>
+#include <driverlib/aon_rtc.h>
+#include <inc/hw_cpu_dwt.h>
+#include <inc/hw_cpu_scs.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_types.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Mailbox.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Timestamp.h>
+
+#include "sim.h"
+
+using namespace morsesim;
+
+UInt32 Clock_tickPeriod = 10;  // empty.cfg
+
+// Host stack per task, the firmware's own stack arrays are not used
+static constexpr size_t kHostStack = 256 * 1024;
+
+// Shortest idle period the power policy spends in standby
+static constexpr Time kStandbyMinUs = 1000;
+
+struct Task_Object {
+    enum State { Ready, Blocked, Done };
+
+    ucontext_t ctx;
+    std::vector<char> stack;
+    Task_FuncPtr fxn;
+    UArg arg0;
+    UArg arg1;
+    Int priority;
+    size_t stackSize;
+    const char *name;
+    State state;
+    int64_t order;          // FIFO position among ready tasks of one priority
+    uint64_t waitGen;       // invalidates stale timeouts
+    bool timedOut;
+};
+
+namespace {
+
+struct Event {
+    Time t;
+    uint64_t seq;
+    Context ctx;
+    std::function<void()> fn;
+
+    bool operator>(const Event &o) const { return t != o.t ? t > o.t : seq > o.seq; }
+};
+
+Time nowUs = 0;
+Time endTime = kForever;
+Context ctx = Context::Main;
+std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+uint64_t eventSeq = 0;
+std::vector<Task_Object *> tasks;
+Task_Object *current = nullptr;
+Task_Object idleTask{};
+ucontext_t schedCtx;
+int64_t readySeq = 0;
+int64_t frontSeq = 0;
+UInt hwiDisabled = 0;
+UInt taskDisabled = 0;
+KernelStats stats{};
+bool verboseLog = false;
+
+Int constraints[PowerCC26XX_NUMCONSTRAINTS];
+Power_NotifyObj *notifyList = nullptr;
+
+Time ticksToUs(UInt32 ticks) {
+    return static_cast<Time>(ticks) * Clock_tickPeriod;
+}
+
+Time deadlineFor(UInt32 timeout) {
+    return timeout == BIOS_WAIT_FOREVER ? kForever : nowUs + ticksToUs(timeout);
+}
+
+void requireTask(const char *what) {
+    if (ctx != Context::Task) {
+        fail("%s outside a task", what);
+    }
+}
+
+void toScheduler() {
+    swapcontext(&current->ctx, &schedCtx);
+}
+
+void makeReady(Task_Object *t) {
+    t->state = Task_Object::Ready;
+    t->order = ++readySeq;
+    t->waitGen++;
+}
+
+Task_Object *pickReady() {
+    Task_Object *best = nullptr;
+
+    for (Task_Object *t : tasks) {
+        if (t->state == Task_Object::Ready &&
+            (!best || t->priority > best->priority || (t->priority == best->priority && t->order < best->order))) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+// A task woken from task context runs at once if it outranks the caller,
+// unless the caller has interrupts or the scheduler disabled
+void maybePreempt() {
+    if (ctx != Context::Task || hwiDisabled || taskDisabled) {
+        return;
+    }
+    Task_Object *next = pickReady();
+    if (next && next->priority > current->priority) {
+        current->state = Task_Object::Ready;
+        current->order = --frontSeq;  // stays at the head of its priority
+        toScheduler();
+    }
+}
+
+void wake(Task_Object *t) {
+    makeReady(t);
+    maybePreempt();
+}
+
+// Blocks the current task until woken or the deadline, false on timeout
+bool block(Time deadline) {
+    Task_Object *self = current;
+    uint64_t gen = ++self->waitGen;
+
+    self->state = Task_Object::Blocked;
+    self->timedOut = false;
+    if (deadline != kForever) {
+        schedule(deadline, Context::Swi, [self, gen] {
+            if (self->state == Task_Object::Blocked && self->waitGen == gen) {
+                self->timedOut = true;
+                makeReady(self);
+            }
+        });
+    }
+    toScheduler();
+    return !self->timedOut;
+}
+
+void taskEntry() {
+    Task_Object *self = current;
+
+    self->fxn(self->arg0, self->arg1);
+    self->state = Task_Object::Done;
+    toScheduler();
+}
+
+void notify(unsigned int event) {
+    Context saved = ctx;
+
+    ctx = Context::Hwi;
+    for (Power_NotifyObj *n = notifyList; n; n = n->next) {
+        if (n->eventTypes & event) {
+            n->notifyFxn(event, 0, n->clientArg);
+        }
+    }
+    ctx = saved;
+}
+
+// Nothing to run until `until`, the power policy decides on standby
+void idle(Time until) {
+    Time span = until - nowUs;
+
+    stats.idle += span;
+    if (span >= kStandbyMinUs && constraints[PowerCC26XX_SB_DISALLOW] == 0) {
+        notify(PowerCC26XX_ENTERING_STANDBY);
+        nowUs = until;
+        stats.standby += span;
+        notify(PowerCC26XX_AWAKE_STANDBY);
+    }
+    nowUs = until;
+}
+
+void vlog(const char *prefix, const char *fmt, va_list args) {
+    std::fprintf(stderr, "%12.6f %s", nowUs / 1e6, prefix);
+    std::vfprintf(stderr, fmt, args);
+}
+
+// Firmware output arrives in pieces, the time goes in front of each line
+std::string systemLine;
+
+} // namespace
+
+namespace morsesim {
+
+Time now() {
+    return nowUs;
+}
+
+Context context() {
+    return ctx;
+}
+
+void schedule(Time t, Context c, std::function<void()> fn) {
+    events.push(Event{t < nowUs ? nowUs : t, eventSeq++, c, std::move(fn)});
+}
+
+void transfer(Time duration) {
+    requireTask("blocking driver call");
+    block(duration == kForever ? kForever : nowUs + duration);
+}
+
+void spin(Time duration) {
+    nowUs += duration;
+}
+
+void stop(const char *reason) {
+    if (!stats.stopReason) {
+        stats.stopReason = reason;
+    }
+}
+
+void fail(const char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    std::fprintf(stderr, "%12.6f morsesim: ", nowUs / 1e6);
+    std::vfprintf(stderr, fmt, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+    std::exit(1);
+}
+
+void log(const char *fmt, ...) {
+    va_list args;
+
+    if (!verboseLog) {
+        return;
+    }
+    va_start(args, fmt);
+    vlog("", fmt, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+}
+
+float noise(Time t, int channel) {
+    uint64_t z = t * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(channel + 1) * 0xBF58476D1CE4E5B9ull;
+    float sum = 0;
+
+    for (int i = 0; i < 4; i++) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        sum += (z >> 40) / 16777216.0f - 0.5f;
+    }
+    return sum * 1.7320508f;
+}
+
+void setVerbose(bool on) {
+    verboseLog = on;
+}
+
+bool verbose() {
+    return verboseLog;
+}
+
+const KernelStats &kernelStats() {
+    return stats;
+}
+
+void setEndTime(Time t) {
+    endTime = t;
+}
+
+void run(Time until) {
+    endTime = until;
+    getcontext(&schedCtx);
+
+    for (;;) {
+        while (!events.empty() && events.top().t <= nowUs) {
+            Event ev = events.top();
+            events.pop();
+            stats.events++;
+            ctx = ev.ctx;
+            ev.fn();
+            ctx = Context::Main;
+        }
+        if (stats.stopReason) {
+            break;
+        }
+
+        Task_Object *next = pickReady();
+        if (next) {
+            current = next;
+            ctx = Context::Task;
+            stats.switches++;
+            swapcontext(&schedCtx, &next->ctx);
+            current = nullptr;
+            ctx = Context::Main;
+            continue;
+        }
+
+        Time t = events.empty() ? kForever : events.top().t;
+        if (t > endTime) {
+            idle(endTime);
+            stop(events.empty() && t == kForever ? "nothing left to run" : "end of scenario");
+            break;
+        }
+        idle(t);
+    }
+}
+
+} // namespace morsesim
+
+extern "C" {
+
+void BIOS_start(void) {
+    run(endTime);
+}
+
+/* Task */
+
+void Task_Params_init(Task_Params *params) {
+    *params = Task_Params{};
+    params->priority = 1;
+    params->stackSize = 1024;
+}
+
+Task_Handle Task_create(Task_FuncPtr fxn, const Task_Params *params, Error_Block *) {
+    Task_Params defaults;
+    auto *t = new Task_Object{};
+
+    if (!params) {
+        Task_Params_init(&defaults);
+        params = &defaults;
+    }
+    t->fxn = fxn;
+    t->arg0 = params->arg0;
+    t->arg1 = params->arg1;
+    t->priority = params->priority;
+    t->stackSize = params->stackSize;
+    t->name = params->instance_name;
+    t->stack.resize(kHostStack);
+
+    getcontext(&t->ctx);
+    t->ctx.uc_stack.ss_sp = t->stack.data();
+    t->ctx.uc_stack.ss_size = t->stack.size();
+    t->ctx.uc_link = nullptr;
+    makecontext(&t->ctx, taskEntry, 0);
+
+    makeReady(t);
+    tasks.push_back(t);
+    return t;
+}
+
+// Wakes on the nticks-th tick boundary from now, like SYS/BIOS
+void Task_sleep(UInt32 nticks) {
+    requireTask("Task_sleep()");
+    if (nticks == BIOS_WAIT_FOREVER) {
+        block(kForever);
+    } else {
+        block((Clock_getTicks() + static_cast<Time>(nticks)) * Clock_tickPeriod);
+    }
+}
+
+void Task_yield(void) {
+    requireTask("Task_yield()");
+    makeReady(current);
+    toScheduler();
+}
+
+Task_Handle Task_self(void) {
+    return current;
+}
+
+Task_Handle Task_getIdleTask(void) {
+    idleTask.name = "idle";
+    idleTask.state = Task_Object::Blocked;
+    return &idleTask;
+}
+
+// Stack use is not modelled, host frames say nothing about the target
+void Task_stat(Task_Handle handle, Task_Stat *statbuf) {
+    *statbuf = Task_Stat{};
+    statbuf->priority = handle->priority;
+    statbuf->stackSize = handle->stackSize;
+    statbuf->used = 0;
+}
+
+UInt Task_disable(void) {
+    return taskDisabled++;
+}
+
+void Task_restore(UInt key) {
+    taskDisabled = key;
+    maybePreempt();
+}
+
+/* Hwi */
+
+UInt Hwi_disable(void) {
+    UInt key = hwiDisabled;
+
+    hwiDisabled = 1;
+    return key;
+}
+
+void Hwi_restore(UInt key) {
+    hwiDisabled = key;
+    maybePreempt();
+}
+
+Bool Hwi_getStackInfo(Hwi_StackInfo *stkInfo, Bool) {
+    *stkInfo = Hwi_StackInfo{};
+    return FALSE;
+}
+
+/* Clock */
+
+struct ClockObject {
+    Clock_FuncPtr fxn;
+    UArg arg;
+    UInt32 timeout;
+    UInt32 period;
+    bool active;
+    uint64_t gen;
+    Time expiry;        // ticks
+};
+
+static void clockArm(ClockObject *c) {
+    uint64_t gen = c->gen;
+
+    schedule(c->expiry * Clock_tickPeriod, Context::Swi, [c, gen] {
+        if (!c->active || c->gen != gen) {
+            return;
+        }
+        if (c->period) {
+            c->expiry += c->period;
+            clockArm(c);
+        } else {
+            c->active = false;
+        }
+        c->fxn(c->arg);
+    });
+}
+
+static ClockObject *clockObject(Clock_Handle handle) {
+    return static_cast<ClockObject *>(handle->impl);
+}
+
+void Clock_Params_init(Clock_Params *params) {
+    *params = Clock_Params{};
+}
+
+void Clock_construct(Clock_Struct *obj, Clock_FuncPtr fxn, UInt timeout, const Clock_Params *params) {
+    auto *c = new ClockObject{};
+
+    c->fxn = fxn;
+    c->timeout = timeout;
+    if (params) {
+        c->period = params->period;
+        c->arg = params->arg;
+    }
+    obj->impl = c;
+    if (params && params->startFlag) {
+        Clock_start(obj);
+    }
+}
+
+Clock_Handle Clock_handle(Clock_Struct *obj) {
+    return obj;
+}
+
+void Clock_start(Clock_Handle handle) {
+    ClockObject *c = clockObject(handle);
+
+    c->active = true;
+    c->gen++;
+    c->expiry = Clock_getTicks() + static_cast<Time>(c->timeout ? c->timeout : 1);
+    clockArm(c);
+}
+
+void Clock_stop(Clock_Handle handle) {
+    ClockObject *c = clockObject(handle);
+
+    c->active = false;
+    c->gen++;
+}
+
+void Clock_setTimeout(Clock_Handle handle, UInt32 timeout) {
+    clockObject(handle)->timeout = timeout;
+}
+
+void Clock_setPeriod(Clock_Handle handle, UInt32 period) {
+    clockObject(handle)->period = period;
+}
+
+Bool Clock_isActive(Clock_Handle handle) {
+    return clockObject(handle)->active;
+}
+
+UInt32 Clock_getTicks(void) {
+    return static_cast<UInt32>(nowUs / Clock_tickPeriod);
+}
+
+/* Semaphore */
+
+struct SemaphoreObject {
+    Int count;
+    bool binary;
+    std::deque<Task_Object *> waiters;
+
+    bool pend(UInt32 timeout) {
+        if (count > 0) {
+            count--;
+            return true;
+        }
+        if (timeout == BIOS_NO_WAIT) {
+            return false;
+        }
+        requireTask("blocking Semaphore_pend()");
+        waiters.push_back(current);
+        Task_Object *self = current;
+        if (!block(deadlineFor(timeout))) {
+            for (auto it = waiters.begin(); it != waiters.end(); ++it) {
+                if (*it == self) {
+                    waiters.erase(it);
+                    break;
+                }
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void post() {
+        if (!waiters.empty()) {
+            Task_Object *t = waiters.front();
+            waiters.pop_front();
+            wake(t);
+        } else if (binary) {
+            count = 1;
+        } else {
+            count++;
+        }
+    }
+};
+
+void Semaphore_Params_init(Semaphore_Params *params) {
+    params->mode = Semaphore_Mode_COUNTING;
+}
+
+void Semaphore_construct(Semaphore_Struct *obj, Int count, const Semaphore_Params *params) {
+    auto *s = new SemaphoreObject{};
+
+    s->binary = params && params->mode == Semaphore_Mode_BINARY;
+    s->count = s->binary && count > 1 ? 1 : count;
+    obj->impl = s;
+}
+
+Semaphore_Handle Semaphore_handle(Semaphore_Struct *obj) {
+    return obj;
+}
+
+Bool Semaphore_pend(Semaphore_Handle handle, UInt32 timeout) {
+    return static_cast<SemaphoreObject *>(handle->impl)->pend(timeout);
+}
+
+void Semaphore_post(Semaphore_Handle handle) {
+    static_cast<SemaphoreObject *>(handle->impl)->post();
+}
+
+/* Mailbox, two counting semaphores like the SYS/BIOS one */
+
+struct MailboxObject {
+    size_t msgSize;
+    std::deque<std::vector<uint8_t>> queue;
+    SemaphoreObject data;
+    SemaphoreObject free;
+};
+
+void Mailbox_Params_init(Mailbox_Params *params) {
+    *params = Mailbox_Params{};
+}
+
+void Mailbox_construct(Mailbox_Struct *obj, size_t msgSize, UInt numMsgs, const Mailbox_Params *, Error_Block *) {
+    auto *m = new MailboxObject{};
+
+    m->msgSize = msgSize;
+    m->free.count = numMsgs;
+    obj->impl = m;
+}
+
+Mailbox_Handle Mailbox_handle(Mailbox_Struct *obj) {
+    return obj;
+}
+
+Bool Mailbox_post(Mailbox_Handle handle, Ptr msg, UInt32 timeout) {
+    auto *m = static_cast<MailboxObject *>(handle->impl);
+    const uint8_t *p = static_cast<const uint8_t *>(msg);
+
+    if (!m->free.pend(timeout)) {
+        return FALSE;
+    }
+    m->queue.emplace_back(p, p + m->msgSize);
+    m->data.post();
+    return TRUE;
+}
+
+Bool Mailbox_pend(Mailbox_Handle handle, Ptr msg, UInt32 timeout) {
+    auto *m = static_cast<MailboxObject *>(handle->impl);
+
+    if (!m->data.pend(timeout)) {
+        return FALSE;
+    }
+    std::copy(m->queue.front().begin(), m->queue.front().end(), static_cast<uint8_t *>(msg));
+    m->queue.pop_front();
+    m->free.post();
+    return TRUE;
+}
+
+Int Mailbox_getNumPendingMsgs(Mailbox_Handle handle) {
+    return static_cast<Int>(static_cast<MailboxObject *>(handle->impl)->queue.size());
+}
+
+/* Timestamp, CPU cycles */
+
+Bits32 Timestamp_get32(void) {
+    return static_cast<Bits32>(nowUs * (kCpuHz / 1000000));
+}
+
+void Timestamp_get64(Types_Timestamp64 *result) {
+    uint64_t cycles = nowUs * (kCpuHz / 1000000);
+
+    result->hi = static_cast<Bits32>(cycles >> 32);
+    result->lo = static_cast<Bits32>(cycles);
+}
+
+void Timestamp_getFreq(Types_FreqHz *freq) {
+    freq->hi = 0;
+    freq->lo = kCpuHz;
+}
+
+/* RTC, seconds and 32768ths of them */
+
+uint64_t AONRTCCurrent64BitValueGet(void) {
+    uint64_t ticks = nowUs * 32768 / 1000000;
+
+    return (ticks / 32768) << 32 | (ticks % 32768) << 17;
+}
+
+/* Core registers, plain memory but for CYCCNT, which reads virtual time
+   in CPU cycles while the trace unit and the counter are on */
+
+volatile uint32_t *sim_hwreg(uint32_t addr) {
+    static std::map<uint32_t, uint32_t> regs;
+    uint32_t &reg = regs[addr];
+
+    if (addr == CPU_DWT_BASE + CPU_DWT_O_CYCCNT && (regs[CPU_SCS_BASE + CPU_SCS_O_DEMCR] & CPU_SCS_DEMCR_TRCENA) &&
+        (regs[CPU_DWT_BASE + CPU_DWT_O_CTRL] & CPU_DWT_CTRL_CYCCNTENA)) {
+        reg = Timestamp_get32();
+    }
+    return &reg;
+}
+
+/* System */
+
+Int System_printf(const char *fmt, ...) {
+    char buf[256];
+    va_list args;
+    int n;
+
+    va_start(args, fmt);
+    n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (verboseLog) {
+        for (const char *p = buf; *p; p++) {
+            if (*p == '\n') {
+                std::fprintf(stderr, "%12.6f sys %s\n", nowUs / 1e6, systemLine.c_str());
+                systemLine.clear();
+            } else {
+                systemLine += *p;
+            }
+        }
+    }
+    return n;
+}
+
+void System_flush(void) {
+}
+
+void System_abort(const char *str) {
+    fail("System_abort: %s", str);
+}
+
+/* Power */
+
+int Power_init(void) {
+    return Power_SOK;
+}
+
+int Power_setConstraint(unsigned int constraintId) {
+    constraints[constraintId]++;
+    return Power_SOK;
+}
+
+int Power_releaseConstraint(unsigned int constraintId) {
+    if (constraints[constraintId] == 0) {
+        fail("Power_releaseConstraint(%u) without a matching set", constraintId);
+    }
+    constraints[constraintId]--;
+    return Power_SOK;
+}
+
+unsigned int Power_getConstraintMask(void) {
+    unsigned int mask = 0;
+
+    for (unsigned int i = 0; i < PowerCC26XX_NUMCONSTRAINTS; i++) {
+        if (constraints[i]) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+int Power_setDependency(unsigned int) {
+    return Power_SOK;
+}
+
+int Power_releaseDependency(unsigned int) {
+    return Power_SOK;
+}
+
+int Power_registerNotify(Power_NotifyObj *notifyObj, unsigned int eventTypes, Power_NotifyFxn notifyFxn,
+                         uintptr_t clientArg) {
+    notifyObj->eventTypes = eventTypes;
+    notifyObj->notifyFxn = notifyFxn;
+    notifyObj->clientArg = clientArg;
+    notifyObj->next = notifyList;
+    notifyList = notifyObj;
+    return Power_SOK;
+}
+
+} // extern "C"
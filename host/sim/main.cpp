@@ -0,0 +1,270 @@
+/*
+ * main.cpp
+ *
+ *  morsesim: run the unmodified firmware on the host in virtual time.
+ *
+ *  Usage: morsesim <scenario> [-u file|-] [-r file] [-l] [-v]
+ *
+ *  The firmware (project_main.c and friends) is compiled against the
+ *  TI-RTOS stand-ins in include/ and runs on the kernel in kernel.cpp,
+ *  with the MPU9250, OPT3001, BMP280 and TMP007 models on the sensor bus. The scenario (scenario.h)
+ *  presses buttons, types into the serial link and moves the board. An
+ *  hour of device time takes seconds.
+ *
+ *    -u    write what the board sends on the UART to a file, or stdout
+ *          with "-"; feed it to morsecap to decode the stream
+ *    -r    retained RAM: the firmware's .noinit section (noinit.ld) is
+ *          read from the file before boot, if it exists, and written to
+ *          it at the end. A run after one that ended in a watchdog reset
+ *          then boots as the board does after the reset.
+ *    -l    end-to-end latency: each symbol line the board writes on the
+ *          plain text link is matched with the latest click, tilt or
+ *          lift of the scenario before it, not matched yet; prints the
+ *          time from that input to the write, by kind of input
+ *    -v    log pin changes, bus errors and System_printf() output with
+ *          the virtual time on stderr
+ *
+ *  A summary of CPU, power and bus use, of what the drivers did with the
+ *  sensors and of the LED and buzzer goes to stderr at the end. Exit status is 0 when the
+ *  scenario ran to its end, 3 on a watchdog reset.
+ *
+ *  Build: see CMakeLists.txt at the top of the repository.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "env_model.h"
+#include "mpu9250_model.h"
+#include "scenario.h"
+#include "sim.h"
+
+using namespace morsesim;
+
+extern "C" int firmware_main(void);
+extern "C" char __noinit_start[], __noinit_end[];
+
+static double seconds(Time t) {
+    return t / 1e6;
+}
+
+// Pairs each symbol with the newest unmatched input before it, a click
+// group with its last click
+static void reportLatency(const std::vector<Time> &symbols) {
+    struct Kind {
+        unsigned count = 0;
+        Time sum = 0, min = kForever, max = 0;
+    };
+    std::map<std::string, Kind> kinds;
+    const std::vector<Stimulus> &inputs = stimuli();
+    size_t next = 0, unmatched = 0;
+
+    for (Time at : symbols) {
+        size_t found = inputs.size();
+        while (next < inputs.size() && inputs[next].t <= at) {
+            found = next++;
+        }
+        if (found == inputs.size()) {
+            unmatched++;
+            continue;
+        }
+        Kind &k = kinds[inputs[found].kind];
+        Time latency = at - inputs[found].t;
+        k.count++;
+        k.sum += latency;
+        k.min = std::min(k.min, latency);
+        k.max = std::max(k.max, latency);
+    }
+    for (const auto &[name, k] : kinds) {
+        std::fprintf(stderr, "latency: %-5s %u symbols, %.1f ms mean, %.1f..%.1f ms\n", name.c_str(), k.count,
+                     k.sum / 1e3 / k.count, k.min / 1e3, k.max / 1e3);
+    }
+    std::fprintf(stderr, "latency: %zu symbols without an input\n", unmatched);
+}
+
+int main(int argc, char **argv) {
+    const char *scenario = nullptr;
+    const char *uartPath = nullptr;
+    const char *retainedPath = nullptr;
+    bool latency = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-u") && i + 1 < argc) {
+            uartPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-r") && i + 1 < argc) {
+            retainedPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-l")) {
+            latency = true;
+        } else if (!std::strcmp(argv[i], "-v")) {
+            setVerbose(true);
+        } else if (!scenario) {
+            scenario = argv[i];
+        } else {
+            scenario = nullptr;
+            break;
+        }
+    }
+    if (!scenario) {
+        std::fprintf(stderr, "usage: %s <scenario> [-u file|-] [-r file] [-l] [-v]\n", argv[0]);
+        return 2;
+    }
+
+    Motion motion;
+    Mpu9250Model mpu(motion);
+    Environment env;
+    Opt3001Model opt(env);
+    Bmp280Model bmp(env);
+    Tmp007Model tmp(env);
+    Time end;
+    std::string error;
+    if (!loadScenario(scenario, motion, env, end, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    attachI2c(Board_MPU9250_ADDR, &mpu);
+    attachI2c(Board_OPT3001_ADDR, &opt);
+    attachI2c(Board_BMP280_ADDR, &bmp);
+    attachI2c(Board_TMP007_ADDR, &tmp);
+
+    FILE *uart = nullptr;
+    if (uartPath) {
+        uart = std::strcmp(uartPath, "-") ? std::fopen(uartPath, "wb") : stdout;
+        if (!uart) {
+            std::perror(uartPath);
+            return 1;
+        }
+    }
+
+    // A symbol is a line of one '.', '-' or ' ', timed at its first byte
+    std::vector<Time> symbols;
+    std::string line;
+    Time lineStart = 0;
+    if (uart || latency) {
+        setUartOutput([&](const uint8_t *buf, size_t len) {
+            if (uart) {
+                std::fwrite(buf, 1, len, uart);
+            }
+            for (size_t i = 0; latency && i < len; i++) {
+                if (line.empty()) {
+                    lineStart = now();
+                }
+                line += static_cast<char>(buf[i]);
+                if (buf[i] == '\n') {
+                    if (line.size() == 3 && std::strchr(".- ", line[0]) && line[1] == '\r') {
+                        symbols.push_back(lineStart);
+                    }
+                    line.clear();
+                }
+            }
+        });
+    }
+
+    uint64_t flashes = 0;
+    Time ledOn = 0, ledSince = 0;
+    bool lit = false;
+    watchOutputs([&](uint8_t pin, bool level) {
+        if (pin != Board_LED0) {
+            return;
+        }
+        if (level && !lit) {
+            flashes++;
+            ledSince = now();
+        } else if (!level && lit) {
+            ledOn += now() - ledSince;
+        }
+        lit = level;
+    });
+
+    uint64_t tones = 0;
+    Time toneOn = 0, toneSince = 0;
+    uint32_t pitch = 0;
+    watchTone([&](uint32_t hz) {
+        if (hz && !pitch) {
+            tones++;
+            toneSince = now();
+        } else if (!hz && pitch) {
+            toneOn += now() - toneSince;
+        }
+        pitch = hz;
+    });
+
+    size_t retainedSize = __noinit_end - __noinit_start;
+    if (retainedPath) {
+        if (FILE *f = std::fopen(retainedPath, "rb")) {
+            if (std::fread(__noinit_start, 1, retainedSize, f) != retainedSize) {
+                std::fprintf(stderr, "%s: not %zu bytes of retained RAM\n", retainedPath, retainedSize);
+                std::fclose(f);
+                return 2;
+            }
+            std::fclose(f);
+        }
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    setEndTime(end);
+    firmware_main();
+    double host = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (lit) {
+        ledOn += now() - ledSince;
+    }
+    if (pitch) {
+        toneOn += now() - toneSince;
+    }
+    if (uart && uart != stdout) {
+        std::fclose(uart);
+    }
+    if (retainedPath) {
+        FILE *f = std::fopen(retainedPath, "wb");
+        if (!f || std::fwrite(__noinit_start, 1, retainedSize, f) != retainedSize) {
+            std::perror(retainedPath);
+        }
+        if (f) {
+            std::fclose(f);
+        }
+    }
+
+    const KernelStats &k = kernelStats();
+    const BusStats &b = busStats();
+    std::fprintf(stderr, "simulated %.3f s in %.3f s (%.0fx)\n", seconds(now()), host,
+                 host > 0 ? seconds(now()) / host : 0.0);
+    std::fprintf(stderr, "cpu: %llu switches, %llu events, idle %.1f%%, standby %.1f%%\n",
+                 (unsigned long long)k.switches, (unsigned long long)k.events,
+                 now() ? 100.0 * k.idle / now() : 0.0, now() ? 100.0 * k.standby / now() : 0.0);
+    std::fprintf(stderr, "i2c: %llu transfers, %llu nacks, %llu blocked, %llu bits, busy %.3f s\n",
+                 (unsigned long long)b.i2cTransfers, (unsigned long long)b.i2cNacks,
+                 (unsigned long long)b.i2cBlocked,
+                 (unsigned long long)b.i2cBits, seconds(b.i2cBusy));
+    const Mpu9250Model::Stats &m = mpu.stats();
+    std::fprintf(stderr, "mpu9250: %llu writes, %llu reads, %llu bytes read (%llu from FIFO), %llu bits\n",
+                 (unsigned long long)m.writes, (unsigned long long)m.reads, (unsigned long long)m.bytesRead,
+                 (unsigned long long)m.fifoBytesRead, (unsigned long long)i2cBits(Board_MPU9250_ADDR));
+    std::fprintf(stderr, "mpu9250: %llu samples, %llu never read, FIFO %llu bytes overflowed, %llu underrun\n",
+                 (unsigned long long)m.samples, (unsigned long long)m.samplesMissed,
+                 (unsigned long long)m.fifoOverflow, (unsigned long long)m.fifoUnderrun);
+    std::fprintf(stderr, "env: opt3001 %llu reads, tmp007 %llu reads, bmp280 %llu reads of %llu measurements\n",
+                 (unsigned long long)opt.reads(), (unsigned long long)tmp.reads(),
+                 (unsigned long long)bmp.stats().reads, (unsigned long long)bmp.stats().measurements);
+    const morsecap::FlashModel::Stats &f = externalFlash().stats();
+    std::fprintf(stderr, "spi: %llu transfers, %llu bytes, busy %.3f s\n", (unsigned long long)b.spiTransfers,
+                 (unsigned long long)b.spiBytes, seconds(b.spiBusy));
+    std::fprintf(stderr, "flash: %llu pages programmed, %llu bytes, %llu sectors erased\n",
+                 (unsigned long long)f.programs, (unsigned long long)f.bytesProgrammed,
+                 (unsigned long long)f.erases);
+    std::fprintf(stderr, "uart: %llu bytes out, %llu in, %llu lost\n", (unsigned long long)b.uartTxBytes,
+                 (unsigned long long)b.uartRxBytes, (unsigned long long)b.uartRxLost);
+    std::fprintf(stderr, "led: %llu flashes, on %.3f s\n", (unsigned long long)flashes, seconds(ledOn));
+    std::fprintf(stderr, "buzzer: %llu tones, on %.3f s\n", (unsigned long long)tones, seconds(toneOn));
+    std::fprintf(stderr, "stopped: %s\n", k.stopReason ? k.stopReason : "firmware returned");
+    if (latency) {
+        reportLatency(symbols);
+    }
+
+    return k.stopReason && !std::strcmp(k.stopReason, "watchdog reset") ? 3 : 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * mpu9250_model.cpp
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include "mpu9250_model.h"
+
+namespace morsesim {
+
+namespace {
+
+enum : uint8_t {
+    SELF_TEST_X_GYRO = 0x00,
+    SELF_TEST_X_ACCEL = 0x0D,
+    XG_OFFSET_H = 0x13,
+    SMPLRT_DIV = 0x19,
+    CONFIG = 0x1A,
+    GYRO_CONFIG = 0x1B,
+    ACCEL_CONFIG = 0x1C,
+    FIFO_EN = 0x23,
+    INT_PIN_CFG = 0x37,
+    INT_STATUS = 0x3A,
+    ACCEL_XOUT_H = 0x3B,
+    GYRO_ZOUT_L = 0x48,
+    USER_CTRL = 0x6A,
+    PWR_MGMT_1 = 0x6B,
+    FIFO_COUNTH = 0x72,
+    FIFO_COUNTL = 0x73,
+    FIFO_R_W = 0x74,
+    WHO_AM_I = 0x75,
+};
+
+constexpr size_t kFifoSize = 512;
+
+// Factory self-test codes, accel x, y, z then gyro x, y, z
+constexpr uint8_t kSelfTestCode[6] = {100, 102, 98, 105, 103, 101};
+
+int16_t saturate(float v) {
+    v = std::round(v);
+    return v > 32767 ? 32767 : v < -32768 ? -32768 : static_cast<int16_t>(v);
+}
+
+// The response in LSB at the most sensitive range that a code promises,
+// the same formula the driver checks against
+float selfTestResponse(uint8_t code) {
+    return 2620.0f * std::pow(1.01f, code - 1.0f);
+}
+
+} // namespace
+
+Motion::Motion() {
+    keys_[0] = State{{0, 0, 1}, {0, 0, 0}, 0, 0};  // flat on the table
+}
+
+void Motion::set(Time t, const State &state) {
+    keys_[t] = state;
+}
+
+Motion::State Motion::at(Time t) const {
+    return std::prev(keys_.upper_bound(t))->second;
+}
+
+Mpu9250Model::Mpu9250Model(const Motion &motion) : motion_(motion), stats_{} {
+    reset();
+}
+
+// Register values after power-on or a PWR_MGMT_1 reset
+void Mpu9250Model::reset() {
+    std::memset(regs_, 0, sizeof(regs_));
+    regs_[PWR_MGMT_1] = 0x01;
+    regs_[WHO_AM_I] = 0x71;
+    for (int i = 0; i < 3; i++) {
+        regs_[SELF_TEST_X_ACCEL + i] = kSelfTestCode[i];
+        regs_[SELF_TEST_X_GYRO + i] = kSelfTestCode[3 + i];
+    }
+    ptr_ = 0;
+    fifo_.clear();
+    intStatus_ = 0;
+    restartSampling();
+}
+
+bool Mpu9250Model::awake() const {
+    return !(regs_[PWR_MGMT_1] & 0x40);
+}
+
+bool Mpu9250Model::fifoEnabled() const {
+    return (regs_[USER_CTRL] & 0x40) && fifoSampleBytes();
+}
+
+size_t Mpu9250Model::fifoSampleBytes() const {
+    uint8_t en = regs_[FIFO_EN];
+
+    return ((en & 0x80) ? 2 : 0) + ((en & 0x40) ? 2 : 0) + ((en & 0x20) ? 2 : 0) + ((en & 0x10) ? 2 : 0) +
+           ((en & 0x08) ? 6 : 0);
+}
+
+// 1 kHz internal rate with the DLPF on, 8 kHz without
+Time Mpu9250Model::samplePeriod() const {
+    uint8_t dlpf = regs_[CONFIG] & 0x07;
+    Time base = (dlpf == 0 || dlpf == 7) ? 125 : 1000;
+
+    return base * (1 + regs_[SMPLRT_DIV]);
+}
+
+void Mpu9250Model::restartSampling() {
+    epoch_ = now();
+    period_ = samplePeriod();
+    taken_ = 0;
+    lastRead_ = 0;
+}
+
+// Takes the samples that fell due since the last access
+void Mpu9250Model::advance() {
+    uint64_t due;
+
+    if (!awake()) {
+        return;
+    }
+    due = (now() - epoch_) / period_;
+    if (due <= taken_) {
+        return;
+    }
+    stats_.samples += due - taken_;
+    intStatus_ |= 0x01;
+
+    if (fifoEnabled()) {
+        size_t bytes = fifoSampleBytes();
+        uint64_t fits = kFifoSize / bytes + 1;
+        uint64_t i = taken_ + 1;
+
+        // Without FIFO_MODE the newest samples win, skip the ones that
+        // would only be pushed out again
+        if (!(regs_[CONFIG] & 0x40) && due - taken_ > fits) {
+            stats_.fifoOverflow += (due - taken_ - fits) * bytes;
+            intStatus_ |= 0x10;
+            i = due - fits + 1;
+        }
+        for (; i <= due; i++) {
+            if ((regs_[CONFIG] & 0x40) && fifo_.size() + bytes > kFifoSize) {
+                stats_.fifoOverflow += (due - i + 1) * bytes;
+                intStatus_ |= 0x10;
+                break;
+            }
+            pushFifo(i);
+        }
+        lastRead_ = due;    // delivered through the FIFO
+    }
+    taken_ = due;
+}
+
+void Mpu9250Model::pushFifo(uint64_t index) {
+    uint8_t en = regs_[FIFO_EN];
+    int16_t s[7];
+
+    sample(index, s);
+    for (int i = 0; i < 7; i++) {
+        bool on = i < 3 ? (en & 0x08) : i == 3 ? (en & 0x80) : (en & (0x40 >> (i - 4)));
+        if (on) {
+            fifo_.push_back(static_cast<uint8_t>(s[i] >> 8));
+            fifo_.push_back(static_cast<uint8_t>(s[i]));
+        }
+    }
+    while (fifo_.size() > kFifoSize) {
+        fifo_.pop_front();
+        stats_.fifoOverflow++;
+        intStatus_ |= 0x10;
+    }
+}
+
+// ax, ay, az, temperature, gx, gy, gz in register order
+void Mpu9250Model::sample(uint64_t index, int16_t *out) const {
+    Time t = epoch_ + index * period_;
+    Motion::State s = motion_.at(t);
+    int accelShift = (regs_[ACCEL_CONFIG] >> 3) & 3;
+    int gyroShift = (regs_[GYRO_CONFIG] >> 3) & 3;
+    float accelLsb = 16384.0f / (1 << accelShift);
+    float gyroLsb = 131.072f / (1 << gyroShift);
+
+    for (int i = 0; i < 3; i++) {
+        int16_t offset = static_cast<int16_t>(regs_[XG_OFFSET_H + 2 * i] << 8 | regs_[XG_OFFSET_H + 2 * i + 1]);
+        float a = (s.accel[i] + s.accelNoise * noise(t, i)) * accelLsb;
+        float g = (s.gyro[i] + s.gyroNoise * noise(t, 3 + i)) * gyroLsb + (offset * 4 >> gyroShift);
+
+        if (regs_[ACCEL_CONFIG] & (0x80 >> i)) {
+            a += selfTestResponse(regs_[SELF_TEST_X_ACCEL + i]) / (1 << accelShift);
+        }
+        if (regs_[GYRO_CONFIG] & (0x80 >> i)) {
+            g += selfTestResponse(regs_[SELF_TEST_X_GYRO + i]) / (1 << gyroShift);
+        }
+        out[i] = saturate(a);
+        out[4 + i] = saturate(g);
+    }
+    out[3] = 0;  // 21 degrees
+}
+
+void Mpu9250Model::writeReg(uint8_t reg, uint8_t value) {
+    reg &= 0x7F;
+    if (reg == PWR_MGMT_1 && (value & 0x80)) {
+        reset();
+        return;
+    }
+    if (reg == FIFO_R_W || reg == INT_STATUS || (reg >= ACCEL_XOUT_H && reg <= GYRO_ZOUT_L) ||
+        reg == FIFO_COUNTH || reg == FIFO_COUNTL || reg == WHO_AM_I) {
+        return;     // read only
+    }
+
+    advance();
+    bool wasAwake = awake();
+    uint8_t old = regs_[reg];
+    if (reg == USER_CTRL && (value & 0x04)) {
+        fifo_.clear();
+    }
+    if (reg == USER_CTRL) {
+        value &= ~0x07;     // resets clear themselves
+    }
+    regs_[reg] = value;
+
+    if (awake() != wasAwake || (reg == SMPLRT_DIV && old != value) ||
+        (reg == CONFIG && (old & 0x07) != (value & 0x07))) {
+        advance();
+        restartSampling();
+    }
+}
+
+uint8_t Mpu9250Model::readReg(uint8_t reg) {
+    uint8_t v;
+
+    switch (reg) {
+    case INT_STATUS:
+        v = intStatus_;
+        intStatus_ = 0;
+        return v;
+    case FIFO_COUNTH:
+        return static_cast<uint8_t>(fifo_.size() >> 8);
+    case FIFO_COUNTL:
+        return static_cast<uint8_t>(fifo_.size());
+    case FIFO_R_W:
+        if (fifo_.empty()) {
+            stats_.fifoUnderrun++;
+            return 0;
+        }
+        v = fifo_.front();
+        fifo_.pop_front();
+        stats_.fifoBytesRead++;
+        return v;
+    default:
+        return regs_[reg & 0x7F];
+    }
+}
+
+// The first byte sets the register pointer, the rest auto-increment
+bool Mpu9250Model::write(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    ptr_ = data[0] & 0x7F;
+    if (len > 1) {
+        stats_.writes++;
+    }
+    for (size_t i = 1; i < len; i++) {
+        writeReg(ptr_, data[i]);
+        ptr_ = (ptr_ + 1) & 0x7F;
+    }
+    return true;
+}
+
+// A burst sees one sample in the data registers. FIFO_R_W does not
+// advance the pointer.
+bool Mpu9250Model::read(uint8_t *data, size_t len) {
+    advance();
+    stats_.reads++;
+    stats_.bytesRead += len;
+
+    if (ptr_ <= GYRO_ZOUT_L && ptr_ + len > ACCEL_XOUT_H && awake()) {
+        int16_t s[7];
+        sample(taken_, s);
+        for (int i = 0; i < 7; i++) {
+            regs_[ACCEL_XOUT_H + 2 * i] = static_cast<uint8_t>(s[i] >> 8);
+            regs_[ACCEL_XOUT_H + 2 * i + 1] = static_cast<uint8_t>(s[i]);
+        }
+        if (taken_ > lastRead_ + 1) {
+            stats_.samplesMissed += taken_ - lastRead_ - 1;
+        }
+        if (taken_ > lastRead_) {
+            lastRead_ = taken_;
+        }
+    }
+    for (size_t i = 0; i < len; i++) {
+        data[i] = readReg(ptr_);
+        if (ptr_ != FIFO_R_W) {
+            ptr_ = (ptr_ + 1) & 0x7F;
+        }
+    }
+    if (regs_[INT_PIN_CFG] & 0x10) {
+        intStatus_ = 0;
+    }
+    return true;
+}
+
+} // namespace morsesim
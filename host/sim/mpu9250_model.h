@@ -0,0 +1,98 @@
+/*
+ * mpu9250_model.h
+ *
+ *  Register-level stand-in for the MPU9250 on the simulated sensor bus,
+ *  the part of the register map that sensors/mpu9250.c uses:
+ *
+ *    - reset and sleep through PWR_MGMT_1, WHO_AM_I
+ *    - sampling at the internal rate (CONFIG) divided by SMPLRT_DIV, the
+ *      data registers hold the latest sample, a burst reads one sample
+ *    - full scale ranges, gyro offset registers
+ *    - the 512 byte FIFO with FIFO_EN, FIFO_MODE, reset, counts and
+ *      overflow
+ *    - INT_STATUS data ready and FIFO overflow, cleared on read of
+ *      INT_STATUS or any read with INT_ANYRD_2CLEAR
+ *    - self test: the enable bits add the response that the factory codes
+ *      in the SELF_TEST registers promise, so the driver's check passes
+ *
+ *  The INT pin is not driven. Samples come from the motion timeline, plus
+ *  noise that depends only on the sample time, so runs repeat exactly.
+ */
+
+#ifndef MORSESIM_MPU9250_MODEL_H_
+#define MORSESIM_MPU9250_MODEL_H_
+
+#include <deque>
+#include <map>
+
+#include "sim.h"
+
+namespace morsesim {
+
+// What the board feels over time, held from one keyframe to the next
+class Motion {
+public:
+    struct State {
+        float accel[3];     // g
+        float gyro[3];      // deg/s
+        float accelNoise;   // g rms
+        float gyroNoise;    // deg/s rms
+    };
+
+    Motion();
+
+    void set(Time t, const State &state);
+    State at(Time t) const;
+
+private:
+    std::map<Time, State> keys_;
+};
+
+class Mpu9250Model : public I2cDevice {
+public:
+    struct Stats {
+        uint64_t writes;        // transfers with register writes
+        uint64_t reads;         // transfers with a read phase
+        uint64_t bytesRead;
+        uint64_t fifoBytesRead;
+        uint64_t fifoUnderrun;  // FIFO_R_W reads of an empty FIFO
+        uint64_t fifoOverflow;  // bytes lost to a full FIFO
+        uint64_t samples;
+        uint64_t samplesMissed; // replaced in the data registers unread
+    };
+
+    explicit Mpu9250Model(const Motion &motion);
+
+    bool write(const uint8_t *data, size_t len) override;
+    bool read(uint8_t *data, size_t len) override;
+
+    const Stats &stats() const { return stats_; }
+
+private:
+    void reset();
+    bool awake() const;
+    bool fifoEnabled() const;
+    size_t fifoSampleBytes() const;
+    Time samplePeriod() const;
+    void restartSampling();
+    void advance();
+    void pushFifo(uint64_t index);
+    void sample(uint64_t index, int16_t *out) const;
+    void writeReg(uint8_t reg, uint8_t value);
+    uint8_t readReg(uint8_t reg);
+
+    const Motion &motion_;
+    uint8_t regs_[128];
+    uint8_t ptr_;
+    std::deque<uint8_t> fifo_;
+    Time epoch_;            // sample n is taken at epoch_ + n * period_
+    Time period_;
+    uint64_t taken_;        // samples since epoch_
+    uint64_t lastRead_;     // sample last read from the data registers
+    uint8_t intStatus_;
+    Stats stats_;
+};
+
+} // namespace morsesim
+
+#endif /* MORSESIM_MPU9250_MODEL_H_ */
@@ -0,0 +1,342 @@
+/*
+ * scenario.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "Board.h"
+#include "morse.h"
+#include "scenario.h"
+#include "trace_file.h"
+
+namespace morsesim {
+
+namespace {
+
+constexpr Time kPressUs = 50000;
+constexpr Time kByteUs = 87;    // 10 bits at 115200 baud
+constexpr Time kStepUs = 1000;  // keyframes of ramps and shakes, the fastest sample rate
+constexpr Time kEnvStepUs = 10000;  // keyframes of environment ramps
+constexpr double kPaPerCm = 0.118;  // air at 20 C near sea level
+
+std::vector<Stimulus> inputs;
+
+// Keys the tone at PARIS timing, returns the time after the last mark
+Time keyText(Time t, uint32_t hz, double level, double wpm, const std::string &text) {
+    Time unit = static_cast<Time>(1200000 / wpm);
+    char code[MORSE_MAX_SYMBOLS + 1];
+
+    for (char c : text) {
+        if (c == ' ') {
+            t += 4 * unit;
+            continue;
+        }
+        int n = encodeMorse(c, code);
+        for (int i = 0; i < n; i++) {
+            Time mark = (code[i] == '-' ? 3 : 1) * unit;
+            schedule(t, Context::Hwi, [hz, level] { setMicTone(hz, level); });
+            schedule(t + mark, Context::Hwi, [] { setMicTone(0, 0); });
+            t += mark + (i == n - 1 ? 3 : 1) * unit;
+        }
+    }
+    return t;
+}
+
+// Moves one quantity of the environment to value, at once or in a
+// straight line over len ms
+void envRamp(Environment &env, Time t, double len, double Environment::State::*field, double value) {
+    Environment::State s = env.at(t);
+    double from = s.*field;
+    Time steps = static_cast<Time>(len * 1000) / kEnvStepUs;
+
+    for (Time i = 1; i <= steps; i++) {
+        s = env.at(t + i * kEnvStepUs);
+        s.*field = from + (value - from) * i / steps;
+        env.set(t + i * kEnvStepUs, s);
+    }
+    if (steps == 0) {
+        s.*field = value;
+        env.set(t, s);
+    }
+}
+
+void press(Time t, int button) {
+    uint8_t pin = button ? Board_BUTTON1 : Board_BUTTON0;
+
+    schedule(t, Context::Hwi, [pin] { setPinInput(pin, false); });
+    schedule(t + kPressUs, Context::Hwi, [pin] { setPinInput(pin, true); });
+    if (button) {
+        inputs.push_back({t, "press"});
+    }
+}
+
+// The trace's first record lands at t, the IMU samples and pressures
+// become keyframes
+bool loadTrace(const std::string &path, Time t, Motion &motion, Environment &env, std::string &error) {
+    morsecap::TraceFile file;
+    TraceConfig config{};
+    bool haveConfig = false;
+    bool first = true;
+    uint64_t start = 0;
+
+    if (!file.open(path)) {
+        error = file.error();
+        return false;
+    }
+    file.visit([&](const TraceRecord &rec, uint64_t ts) {
+        if (first) {
+            start = ts;
+            first = false;
+        }
+        Time at = t + (ts - start);
+        switch (rec.type) {
+        case TRACE_REC_CONFIG:
+            config = rec.u.config;
+            haveConfig = true;
+            break;
+        case TRACE_REC_IMU:
+            if (haveConfig) {
+                Motion::State s = motion.at(at);
+                for (int i = 0; i < 3; i++) {
+                    s.accel[i] = rec.u.imu[i] * (config.accel_ng / 1e9f);
+                    s.gyro[i] = rec.u.imu[3 + i] * (config.gyro_udps / 1e6f);
+                }
+                motion.set(at, s);
+            }
+            break;
+        case TRACE_REC_BUTTON:
+            if (rec.u.button.level == 0) {
+                press(at, rec.u.button.button);
+            }
+            break;
+        case TRACE_REC_PRESSURE: {
+            Environment::State s = env.at(at);
+            s.pressure = rec.u.pressure / 256.0;
+            env.set(at, s);
+            break;
+        }
+        default:
+            break;
+        }
+    });
+    return true;
+}
+
+} // namespace
+
+bool loadScenario(const std::string &path, Motion &motion, Environment &env, Time &end, std::string &error) {
+    std::ifstream in(path);
+    std::string dir = path.substr(0, path.find_last_of('/') + 1);
+    std::string line;
+    int lineNo = 0;
+
+    if (!in) {
+        error = path + ": cannot open";
+        return false;
+    }
+    end = 0;
+    while (std::getline(in, line)) {
+        std::string word;
+        double ms;
+
+        lineNo++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        auto bad = [&](const std::string &what) {
+            error = path + ":" + std::to_string(lineNo) + ": " + what;
+            return false;
+        };
+
+        if (!(words >> word)) {
+            continue;
+        }
+        if (word == "run") {
+            if (!(words >> ms) || ms <= 0) {
+                return bad("run needs a length in ms");
+            }
+            end = static_cast<Time>(ms * 1000);
+            continue;
+        }
+        if (word != "at" || !(words >> ms >> word) || ms < 0) {
+            return bad("expected 'run <ms>' or 'at <ms> <command>'");
+        }
+
+        Time t = static_cast<Time>(ms * 1000);
+        if (word == "press") {
+            int button;
+            if (!(words >> button) || (button != 0 && button != 1)) {
+                return bad("press needs button 0 or 1");
+            }
+            press(t, button);
+        } else if (word == "send") {
+            std::string text;
+            std::getline(words >> std::ws, text);
+            text += '\r';
+            for (size_t i = 0; i < text.size(); i++) {
+                uint8_t byte = static_cast<uint8_t>(text[i]);
+                schedule(t + i * kByteUs, Context::Hwi, [byte] { uartReceive(byte); });
+            }
+        } else if (word == "tilt") {
+            Motion::State s = motion.at(t);
+            if (!(words >> s.accel[0] >> s.accel[1] >> s.accel[2])) {
+                return bad("tilt needs x, y and z in g");
+            }
+            motion.set(t, s);
+            inputs.push_back({t, "tilt"});
+        } else if (word == "ramp") {
+            Motion::State from = motion.at(t), s = from;
+            float to[3];
+            double len;
+            if (!(words >> len >> to[0] >> to[1] >> to[2]) || len <= 0) {
+                return bad("ramp needs a length in ms and x, y and z in g");
+            }
+            Time steps = static_cast<Time>(len * 1000) / kStepUs;
+            for (Time i = 1; i <= steps; i++) {
+                for (int a = 0; a < 3; a++) {
+                    s.accel[a] = from.accel[a] + (to[a] - from.accel[a]) * i / steps;
+                }
+                motion.set(t + i * kStepUs, s);
+            }
+        } else if (word == "shake") {
+            std::string axis;
+            double g, hz, len;
+            if (!(words >> axis >> g >> hz >> len) || axis.size() != 1 || axis[0] < 'x' || axis[0] > 'z' ||
+                hz <= 0 || len <= 0) {
+                return bad("shake needs an axis x, y or z, amplitude in g, frequency and length in ms");
+            }
+            Motion::State rest = motion.at(t), s = rest;
+            Time steps = static_cast<Time>(len * 1000) / kStepUs;
+            int a = axis[0] - 'x';
+            for (Time i = 0; i < steps; i++) {
+                s.accel[a] = rest.accel[a] + g * std::sin(2 * M_PI * hz * (i * kStepUs) / 1e6);
+                motion.set(t + i * kStepUs, s);
+            }
+            motion.set(t + steps * kStepUs, rest);
+        } else if (word == "rotate") {
+            Motion::State s = motion.at(t);
+            if (!(words >> s.gyro[0] >> s.gyro[1] >> s.gyro[2])) {
+                return bad("rotate needs x, y and z in deg/s");
+            }
+            motion.set(t, s);
+        } else if (word == "noise") {
+            Motion::State s = motion.at(t);
+            if (!(words >> s.accelNoise >> s.gyroNoise) || s.accelNoise < 0 || s.gyroNoise < 0) {
+                return bad("noise needs g and deg/s rms");
+            }
+            motion.set(t, s);
+        } else if (word == "tone") {
+            uint32_t hz;
+            double level;
+            if (!(words >> hz >> level) || level < 0 || level > 1) {
+                return bad("tone needs a frequency and a level of full scale, 0 to 1");
+            }
+            schedule(t, Context::Hwi, [hz, level] { setMicTone(hz, level); });
+        } else if (word == "cw") {
+            uint32_t hz;
+            double level, wpm;
+            std::string text;
+            if (!(words >> hz >> level >> wpm) || level < 0 || level > 1 || wpm <= 0) {
+                return bad("cw needs a frequency, a level of full scale, wpm and text");
+            }
+            std::getline(words >> std::ws, text);
+            keyText(t, hz, level, wpm, text);
+        } else if (word == "hiss") {
+            double rms;
+            if (!(words >> rms) || rms < 0) {
+                return bad("hiss needs an rms level of full scale");
+            }
+            schedule(t, Context::Hwi, [rms] { setMicNoise(rms); });
+        } else if (word == "light") {
+            double lux, len = 0;
+            if (!(words >> lux) || lux < 0 || ((words >> len) && len < 0)) {
+                return bad("light needs lux and optionally a time in ms to get there");
+            }
+            envRamp(env, t, len, &Environment::State::lux, lux);
+        } else if (word == "air") {
+            double hpa, celsius, len = 0;
+            if (!(words >> hpa >> celsius) || hpa <= 0 || ((words >> len) && len < 0)) {
+                return bad("air needs hPa, degrees C and optionally a time in ms to get there");
+            }
+            envRamp(env, t, len, &Environment::State::pressure, hpa * 100);
+            envRamp(env, t, len, &Environment::State::airC, celsius);
+        } else if (word == "object") {
+            double celsius, len = 0;
+            if (!(words >> celsius) || ((words >> len) && len < 0)) {
+                return bad("object needs degrees C and optionally a time in ms to get there");
+            }
+            envRamp(env, t, len, &Environment::State::objectC, celsius);
+        } else if (word == "baro") {
+            Environment::State s = env.at(t);
+            if (!(words >> s.pressureNoise) || s.pressureNoise < 0) {
+                return bad("baro needs the pressure noise in Pa rms");
+            }
+            env.set(t, s);
+        } else if (word == "lift") {
+            double cm, len;
+            if (!(words >> cm >> len) || len < 0) {
+                return bad("lift needs a height in cm and a time in ms");
+            }
+            env.add(t, static_cast<Time>(len * 1000), kEnvStepUs, &Environment::State::pressure, -cm * kPaPerCm);
+            inputs.push_back({t, "lift"});
+        } else if (word == "i2c") {
+            std::string name;
+            unsigned address = 0, count = 0;
+            I2cFault fault;
+            if (!(words >> name)) {
+                return bad("i2c needs a fault: hang, nack, ok or stuck");
+            }
+            if (name == "stuck") {
+                if (!(words >> count) || count < 1 || count > 9) {
+                    return bad("i2c stuck needs the SCL clocks, 1 to 9");
+                }
+                schedule(t, Context::Hwi, [count] { holdI2cData(count); });
+                continue;
+            }
+            if (name == "hang") {
+                fault = I2cFault::Hang;
+            } else if (name == "nack") {
+                fault = I2cFault::Nack;
+            } else if (name == "ok") {
+                fault = I2cFault::None;
+            } else {
+                return bad("i2c needs a fault: hang, nack, ok or stuck");
+            }
+            words >> std::hex >> address >> std::dec >> count;
+            if (address > 0x7f) {
+                return bad("i2c needs a 7-bit address");
+            }
+            schedule(t, Context::Hwi, [address, fault, count] {
+                setI2cFault(static_cast<uint8_t>(address), fault, count);
+            });
+        } else if (word == "trace") {
+            std::string file;
+            if (!(words >> file)) {
+                return bad("trace needs a file");
+            }
+            if (file[0] != '/') {
+                file = dir + file;
+            }
+            std::string traceError;
+            if (!loadTrace(file, t, motion, env, traceError)) {
+                return bad(traceError);
+            }
+        } else {
+            return bad("unknown command '" + word + "'");
+        }
+    }
+    if (end == 0) {
+        error = path + ": no run length";
+        return false;
+    }
+    std::stable_sort(inputs.begin(), inputs.end(), [](const Stimulus &a, const Stimulus &b) { return a.t < b.t; });
+    return true;
+}
+
+const std::vector<Stimulus> &stimuli() {
+    return inputs;
+}
+
+} // namespace morsesim
@@ -0,0 +1,71 @@
+/*
+ * scenario.h
+ *
+ *  Scenario files drive a simulator run, one command per line, times in
+ *  milliseconds since boot, '#' starts a comment:
+ *
+ *      run <ms>                    length of the run
+ *      at <ms> press <0|1>         click button 0 (LED) or 1 (keying), 50 ms
+ *      at <ms> send <text>         text and a CR into the serial link
+ *      at <ms> tilt <x> <y> <z>    hold the board at this acceleration in g
+ *      at <ms> ramp <ms> <x> <y> <z>
+ *                                  move there in a straight line
+ *      at <ms> shake <x|y|z> <g> <hz> <ms>
+ *                                  sine on one axis, then back to rest
+ *      at <ms> rotate <x> <y> <z>  gyro rates in deg/s
+ *      at <ms> noise <g> <dps>     sensor noise, rms
+ *      at <ms> trace <file.mtr>    IMU motion, clicks and pressure of a
+ *                                  recorded trace, path relative to this
+ *                                  file
+ *      at <ms> tone <hz> <level>   what the microphone hears, level of
+ *                                  full scale, 0 for silence
+ *      at <ms> cw <hz> <level> <wpm> <text>
+ *                                  the tone keyed with text at PARIS timing
+ *      at <ms> hiss <rms>          microphone noise, of full scale
+ *      at <ms> light <lux> [ms]    ambient light, reached in a straight
+ *                                  line over ms if given
+ *      at <ms> air <hPa> <C> [ms]  pressure and temperature of the air
+ *      at <ms> object <C> [ms]     temperature of what the TMP007 sees
+ *      at <ms> baro <Pa>           pressure noise, rms at 1x oversampling
+ *      at <ms> lift <cm> <ms>      raise the board (lower it, negative) in
+ *                                  a straight line over ms
+ *      at <ms> i2c <fault> [addr] [n]
+ *                                  transfers to the device at addr (hex,
+ *                                  default any) fail the next n times, or
+ *                                  until ok: hang never completes, nack
+ *                                  is not acknowledged
+ *      at <ms> i2c stuck <clocks>  a slave holds SDA low until SCL is
+ *                                  clocked by hand, 1 to 9 times
+ *
+ *  Motion and environment commands apply in file order, each starts from
+ *  what the lines above left at its time. A lift adds to the pressure from
+ *  then on, also over air changes further up the file.
+ */
+
+#ifndef MORSESIM_SCENARIO_H_
+#define MORSESIM_SCENARIO_H_
+
+#include <string>
+#include <vector>
+
+#include "env_model.h"
+#include "mpu9250_model.h"
+
+namespace morsesim {
+
+// Schedules the inputs and adds to the motion and environment timelines.
+// Returns false with a message in error, naming the line, on a bad file.
+bool loadScenario(const std::string &path, Motion &motion, Environment &env, Time &end, std::string &error);
+
+// An input of the loaded scenario that can key a symbol: a click of the
+// keying button ("press", also from traces), a tilt or a lift. In time
+// order, for the latency report.
+struct Stimulus {
+    Time t;
+    const char *kind;
+};
+const std::vector<Stimulus> &stimuli();
+
+} // namespace morsesim
+
+#endif /* MORSESIM_SCENARIO_H_ */
@@ -0,0 +1,136 @@
+/*
+ * sim.h
+ *
+ *  Virtual-time simulator behind the TI-RTOS shim in include/. Everything
+ *  happens at virtual microseconds since boot. Task code runs in zero
+ *  time; time passes only while tasks are blocked, in Task_sleep(),
+ *  semaphore and mailbox waits and driver transfers. Events (Clock
+ *  expiries, scripted inputs, transfer completions) run between
+ *  scheduling points in interrupt context, so a run is fully
+ *  deterministic.
+ */
+
+#ifndef MORSESIM_SIM_H_
+#define MORSESIM_SIM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "flash_model.h"
+
+namespace morsesim {
+
+using Time = uint64_t;  // virtual microseconds
+
+constexpr Time kForever = ~Time(0);
+constexpr uint32_t kCpuHz = 48000000;
+
+// Execution context of the code calling into the shim
+enum class Context { Main, Task, Swi, Hwi };
+
+Time now();
+Context context();
+
+// Runs fn in the given interrupt context at virtual time t (>= now)
+void schedule(Time t, Context ctx, std::function<void()> fn);
+
+// Blocks the calling task for a driver transfer, for good with kForever
+void transfer(Time duration);
+
+// Busy wait, time passes but nothing else runs until the next scheduling point
+void spin(Time duration);
+
+// Ends BIOS_start() at the next scheduling point
+void stop(const char *reason);
+
+// Fails the run, e.g. a blocking call outside a task
+[[noreturn]] void fail(const char *fmt, ...);
+
+// Unit variance noise from a time and channel alone, so that sensor
+// models repeat exactly from run to run
+float noise(Time t, int channel);
+
+// Event log on stderr with the virtual time, only when verbose
+void log(const char *fmt, ...);
+void setVerbose(bool on);
+bool verbose();
+
+struct KernelStats {
+    Time idle;              // no task ready
+    Time standby;           // of that, in standby
+    uint64_t switches;      // task context switches
+    uint64_t events;
+    const char *stopReason;
+};
+const KernelStats &kernelStats();
+
+// Runs the scheduler until endTime, called by BIOS_start()
+void run(Time endTime);
+void setEndTime(Time endTime);
+
+// Devices on the simulated I2C bus. A transfer writes, then reads; return
+// false to NACK.
+class I2cDevice {
+public:
+    virtual ~I2cDevice() = default;
+    virtual bool write(const uint8_t *data, size_t len) = 0;
+    virtual bool read(uint8_t *data, size_t len) = 0;
+};
+
+void attachI2c(uint8_t address, I2cDevice *device);
+
+// Bus faults for the scenario, on the transfers to one address or, with
+// 0, to any, for the next count transfers or with 0 until changed. Hang:
+// a transfer never completes, as when a slave stretches SCL for good.
+// Nack: the address is not acknowledged.
+enum class I2cFault { None, Hang, Nack };
+void setI2cFault(uint8_t address, I2cFault fault, unsigned count = 0);
+
+// A slave holds SDA low, as after a reset in the middle of its read,
+// until SCL has been clocked that many times through the PIN driver;
+// transfers fail until then
+void holdI2cData(unsigned clocks);
+
+struct BusStats {
+    uint64_t i2cTransfers;
+    uint64_t i2cNacks;
+    uint64_t i2cBlocked;    // no START, SDA held low
+    uint64_t i2cBits;       // SCL cycles including start, stop and acks
+    Time i2cBusy;
+    uint64_t spiTransfers;
+    uint64_t spiBytes;
+    Time spiBusy;
+    uint64_t uartTxBytes;
+    uint64_t uartRxBytes;
+    uint64_t uartRxLost;    // link asleep or no read pending
+};
+const BusStats &busStats();
+
+// The external flash behind SPI0, erased at the start of a run
+morsecap::FlashModel &externalFlash();
+
+// SCL cycles of the transfers to one device
+uint64_t i2cBits(uint8_t address);
+
+// Scenario inputs, called from interrupt context
+void setPinInput(uint8_t pin, bool level);
+void uartReceive(uint8_t byte);
+
+// UART output sink
+void setUartOutput(std::function<void(const uint8_t *, size_t)> sink);
+
+// Called on every change of a GPIO output, e.g. the LED
+void watchOutputs(std::function<void(uint8_t pin, bool level)> watch);
+
+// Called when the buzzer PWM starts, changes pitch or stops (0 Hz)
+void watchTone(std::function<void(uint32_t hz)> watch);
+
+// What the PDM microphone hears, called from interrupt context: a tone at
+// level (of full scale, 0 is silence) and white noise of rms (same)
+void setMicTone(uint32_t hz, double level);
+void setMicNoise(double rms);
+
+} // namespace morsesim
+
+#endif /* MORSESIM_SIM_H_ */
@@ -0,0 +1,126 @@
+/*
+ * aggregate_test.cpp
+ *
+ *  Unit tests of core/aggregate.c against double precision statistics.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "aggregate.h"
+
+namespace {
+
+TEST(Aggregate, SummaryMatchesTwoPassStatistics) {
+    std::mt19937 rng(9);
+    std::normal_distribution<double> pressure(101325, 40);
+    std::vector<int32_t> values;
+    Aggregate a;
+    AggregateSummary s;
+
+    aggregate_init(&a, 60000, 0);
+    for (int i = 0; i < 500; i++) {
+        values.push_back(static_cast<int32_t>(std::lround(pressure(rng))));
+        EXPECT_EQ(aggregate_add(&a, values.back(), i * 100, &s), 0);
+    }
+    aggregate_summary(&a, &s);
+
+    double mean = 0, m2 = 0;
+    for (int32_t v : values) {
+        mean += v;
+    }
+    mean /= values.size();
+    for (int32_t v : values) {
+        m2 += (v - mean) * (v - mean);
+    }
+    EXPECT_EQ(s.count, values.size());
+    EXPECT_EQ(s.min, *std::min_element(values.begin(), values.end()));
+    EXPECT_EQ(s.max, *std::max_element(values.begin(), values.end()));
+    EXPECT_NEAR(s.mean, mean, 1.0);
+    EXPECT_NEAR(s.variance, m2 / (values.size() - 1), m2 / (values.size() - 1) * 0.01 + 1);
+}
+
+TEST(Aggregate, NegativeValuesRoundAwayFromZero) {
+    Aggregate a;
+    AggregateSummary s;
+
+    aggregate_init(&a, 1000, 0);
+    aggregate_add(&a, -3, 0, &s);
+    aggregate_add(&a, -4, 1, &s);
+    aggregate_summary(&a, &s);
+    EXPECT_EQ(s.mean, -4);
+    EXPECT_EQ(s.min, -4);
+    EXPECT_EQ(s.max, -3);
+    EXPECT_EQ(s.variance, 1u);      // 0.5 rounded
+}
+
+TEST(Aggregate, WindowClosesAtTheFirstValueAfterIt) {
+    Aggregate a;
+    AggregateSummary closed;
+
+    aggregate_init(&a, 1000, 0);
+    EXPECT_EQ(aggregate_add(&a, 10, 500, &closed), 0);
+    EXPECT_EQ(aggregate_add(&a, 20, 1499, &closed), 0);
+    EXPECT_EQ(aggregate_add(&a, 30, 1500, &closed), AGGREGATE_WINDOW);
+    EXPECT_EQ(closed.start_ms, 500u);
+    EXPECT_EQ(closed.count, 2);
+    EXPECT_EQ(closed.mean, 15);
+
+    AggregateSummary open;
+    aggregate_summary(&a, &open);
+    EXPECT_EQ(open.start_ms, 1500u);
+    EXPECT_EQ(open.count, 1);
+    EXPECT_EQ(open.variance, 0u);
+}
+
+TEST(Aggregate, DeadbandReportsChanges) {
+    Aggregate a;
+    AggregateSummary s;
+
+    aggregate_init(&a, 100000, 5);
+    EXPECT_EQ(aggregate_add(&a, 100, 0, &s), AGGREGATE_CHANGE) << "the first value always is";
+    EXPECT_EQ(aggregate_add(&a, 105, 1, &s), 0);
+    EXPECT_EQ(aggregate_add(&a, 94, 2, &s), AGGREGATE_CHANGE);
+    EXPECT_EQ(aggregate_add(&a, 99, 3, &s), 0) << "measured from the last report";
+    EXPECT_EQ(aggregate_add(&a, 100, 4, &s), AGGREGATE_CHANGE);
+}
+
+TEST(Aggregate, ZeroDeadbandNeverReports) {
+    Aggregate a;
+    AggregateSummary s;
+
+    aggregate_init(&a, 100000, 0);
+    EXPECT_EQ(aggregate_add(&a, 1, 0, &s), 0);
+    EXPECT_EQ(aggregate_add(&a, 1000000, 1, &s), 0);
+}
+
+TEST(Aggregate, WideSwingsKeepTheirPrecision) {
+    Aggregate a;
+    AggregateSummary s;
+
+    aggregate_init(&a, UINT32_MAX, 0);
+    for (int i = 0; i < 60000; i++) {
+        aggregate_add(&a, 101325 + (i % 2 ? 30000 : -30000), i, &s);
+    }
+    aggregate_summary(&a, &s);
+    EXPECT_NEAR(s.mean, 101325, 1);
+    EXPECT_NEAR(s.variance, 900000000.0 * 60000 / 59999, 100);
+}
+
+TEST(Aggregate, VarianceSaturates) {
+    Aggregate a;
+    AggregateSummary s;
+
+    aggregate_init(&a, UINT32_MAX, 0);
+    for (int i = 0; i < 100; i++) {
+        aggregate_add(&a, i % 2 ? (1 << 23) : -(1 << 23), i, &s);
+    }
+    aggregate_summary(&a, &s);
+    EXPECT_EQ(s.variance, UINT32_MAX);
+}
+
+} // namespace
@@ -0,0 +1,226 @@
+/*
+ * command_fuzz.cpp
+ *
+ *  Feeds arbitrary bytes through command_feed() (core/command.c) and
+ *  checks what the shell may never do, whatever arrives on the UART:
+ *    - keep more of a line than CMD_LINE_MAX - 1 characters
+ *    - hand a handler more than CMD_MAX_ARGS arguments, fewer or more
+ *      than its table entry allows, or a word outside the line buffer,
+ *      empty, or holding a space or a control character
+ *    - write a reply line longer than CMD_PRINTF_MAX - 1 bytes, or one
+ *      that does not end in \r\n
+ *
+ *  Built as a libFuzzer target with -DMORSE_LIBFUZZER=ON (clang only).
+ *  Otherwise main() runs the files given, or random inputs:
+ *
+ *  Usage: command_fuzz [-n runs] [-s seed] [file]...
+ *
+ *  An input is split into lines and words over a small dictionary
+ *  (command names, numbers, line ends, backspace) mixed with random
+ *  bytes, so most of them reach the handlers. Aborts, after printing the
+ *  input in hex, on the first violation. Configure with
+ *  -DMORSE_SANITIZE=address,undefined to run it under AddressSanitizer
+ *  and UBSan.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "command.h"
+
+namespace {
+
+CommandShell shell;
+std::string pending;        // reply bytes since the last line end
+const uint8_t *input;
+size_t inputLen;
+
+[[noreturn]] void fail(const char *what) {
+    std::fprintf(stderr, "command_fuzz: %s\ninput (%zu bytes):", what, inputLen);
+    for (size_t i = 0; i < inputLen; i++) {
+        std::fprintf(stderr, "%s%02x", i % 32 ? " " : "\n  ", input[i]);
+    }
+    std::fprintf(stderr, "\n");
+    std::abort();
+}
+
+void write(const char *text, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        pending.push_back(text[i]);
+        if (text[i] == '\n') {
+            if (pending.size() < 2 || pending[pending.size() - 2] != '\r') {
+                fail("reply line without \\r\\n");
+            }
+            if (pending.size() > CMD_PRINTF_MAX - 1) {
+                fail("reply line longer than CMD_PRINTF_MAX - 1");
+            }
+            pending.clear();
+        }
+    }
+}
+
+void checkArgs(CommandShell *sh, int argc, char **argv) {
+    const Command *cmd = nullptr;
+
+    for (uint8_t i = 0; i < sh->count; i++) {
+        if (std::strcmp(sh->commands[i].name, argv[0]) == 0) {
+            cmd = &sh->commands[i];
+        }
+    }
+    if (!cmd || argc - 1 < cmd->minArgs || argc - 1 > cmd->maxArgs || argc > CMD_MAX_ARGS + 1) {
+        fail("handler called with the wrong arguments");
+    }
+    for (int i = 0; i < argc; i++) {
+        if (argv[i] < sh->line || argv[i] >= sh->line + CMD_LINE_MAX) {
+            fail("word outside the line buffer");
+        }
+        size_t n = strnlen(argv[i], sh->line + CMD_LINE_MAX - argv[i]);
+        if (n == 0 || argv[i] + n == sh->line + CMD_LINE_MAX) {
+            fail("empty or unterminated word");
+        }
+        for (size_t j = 0; j < n; j++) {
+            if (argv[i][j] <= ' ' || argv[i][j] > '~') {
+                fail("space or control character in a word");
+            }
+        }
+    }
+}
+
+// Handlers in the style of the firmware's: parse, then reply
+void setFxn(CommandShell *sh, int argc, char **argv) {
+    int32_t value;
+
+    checkArgs(sh, argc, argv);
+    if (command_parse_int(argv[2], &value) != 0) {
+        command_printf(sh, "ERR bad value: %s\r\n", argv[2]);
+        return;
+    }
+    command_printf(sh, "OK %s = %ld\r\n", argv[1], (long)value);
+}
+
+void echoFxn(CommandShell *sh, int argc, char **argv) {
+    checkArgs(sh, argc, argv);
+    for (int i = 1; i < argc; i++) {
+        command_printf(sh, "%s%s", argv[i], i + 1 < argc ? " " : "\r\n");
+    }
+}
+
+void helpFxn(CommandShell *sh, int argc, char **argv) {
+    checkArgs(sh, argc, argv);
+    command_help(sh, argc, argv);
+}
+
+void statsFxn(CommandShell *sh, int argc, char **argv) {
+    checkArgs(sh, argc, argv);
+    command_printf(sh, "lines %lu errors %lu\r\n", (unsigned long)sh->lines, (unsigned long)sh->errors);
+}
+
+const Command kCommands[] = {
+    {"set", 2, 2, setFxn, "<name> <value>"},
+    {"echo", 1, CMD_MAX_ARGS, echoFxn, "<words>"},
+    {"help", 0, 0, helpFxn, "this list"},
+    {"stats", 0, 0, statsFxn, "counters"},
+};
+
+void run(const uint8_t *data, size_t len) {
+    input = data;
+    inputLen = len;
+    pending.clear();
+    command_init(&shell, kCommands, sizeof(kCommands) / sizeof(kCommands[0]), write);
+
+    for (size_t i = 0; i < len; i++) {
+        command_feed(&shell, static_cast<char>(data[i]));
+        if (shell.len > CMD_LINE_MAX - 1) {
+            fail("line longer than CMD_LINE_MAX - 1");
+        }
+    }
+    command_feed(&shell, '\r');
+    if (!pending.empty()) {
+        fail("reply not ended by a line end");
+    }
+}
+
+const char *const kWords[] = {
+    "set", "echo", "help", "stats", "tilt_mg", "0", "-1", "600", "-", "--5", "2147483647",
+    "999999999", "1000000000", "12a", " ", "  ", "\t", "\r", "\n", "\r\n", "\b", "\x7f",
+};
+
+std::vector<uint8_t> randomInput(std::mt19937 &rng) {
+    std::vector<uint8_t> v;
+    size_t target = rng() % 160;
+
+    while (v.size() < target) {
+        switch (rng() % 4) {
+        case 0:
+            v.push_back(static_cast<uint8_t>(rng()));
+            break;
+        case 1:
+            // A run that overflows the line
+            v.insert(v.end(), rng() % (2 * CMD_LINE_MAX), static_cast<uint8_t>('a' + rng() % 26));
+            break;
+        default: {
+            const char *w = kWords[rng() % (sizeof(kWords) / sizeof(kWords[0]))];
+            v.insert(v.end(), w, w + std::strlen(w));
+            v.push_back(' ');
+            break;
+        }
+        }
+    }
+    return v;
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    run(data, size);
+    return 0;
+}
+
+#ifndef MORSE_LIBFUZZER
+int main(int argc, char **argv) {
+    unsigned long runs = 100000, seed = 1;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-n") && i + 1 < argc) {
+            runs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [-n runs] [-s seed] [file]...\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!files.empty()) {
+        for (const std::string &path : files) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                std::fprintf(stderr, "%s: cannot open\n", path.c_str());
+                return 1;
+            }
+            std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            run(data.data(), data.size());
+        }
+        std::printf("%zu files\n", files.size());
+        return 0;
+    }
+
+    std::mt19937 rng(seed);
+    for (unsigned long i = 0; i < runs; i++) {
+        std::vector<uint8_t> data = randomInput(rng);
+        run(data.data(), data.size());
+    }
+    std::printf("%lu random inputs, seed %lu\n", runs, seed);
+    return 0;
+}
+#endif
@@ -0,0 +1,158 @@
+/*
+ * command_test.cpp
+ *
+ *  Unit tests of core/command.c: line assembly, splitting, dispatch and
+ *  number parsing.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "command.h"
+
+namespace {
+
+std::string output;
+std::vector<std::string> args;
+
+void write(const char *text, uint16_t len) {
+    output.append(text, len);
+}
+
+void record(CommandShell *, int argc, char **argv) {
+    args.assign(argv, argv + argc);
+}
+
+void longLine(CommandShell *sh, int, char **) {
+    command_printf(sh, "%0*d\r\n", CMD_PRINTF_MAX + 20, 7);
+}
+
+const Command kCommands[] = {
+    {"set", 2, 2, record, "<name> <value>"},
+    {"stats", 0, 0, record, "counters"},
+    {"note", 1, CMD_MAX_ARGS, record, "<text>"},
+    {"long", 0, 0, longLine, "a line longer than the buffer"},
+};
+
+class CommandTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        output.clear();
+        args.clear();
+        command_init(&sh_, kCommands, sizeof(kCommands) / sizeof(kCommands[0]), write);
+    }
+
+    void feed(const std::string &bytes) {
+        for (char c : bytes) {
+            command_feed(&sh_, c);
+        }
+    }
+
+    CommandShell sh_;
+};
+
+TEST_F(CommandTest, SplitsOnSpacesAndTabs) {
+    feed("  set\ttilt_mg   600 \r");
+    ASSERT_EQ(args.size(), 3u);
+    EXPECT_EQ(args[0], "set");
+    EXPECT_EQ(args[1], "tilt_mg");
+    EXPECT_EQ(args[2], "600");
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(sh_.lines, 1u);
+    EXPECT_EQ(sh_.errors, 0u);
+}
+
+TEST_F(CommandTest, EitherLineEndWorksAndEmptyLinesAreIgnored) {
+    feed("stats\n\r\n\r");
+    EXPECT_EQ(args.size(), 1u);
+    EXPECT_EQ(sh_.lines, 1u);
+}
+
+TEST_F(CommandTest, ChecksArgumentCounts) {
+    feed("set tilt_mg\r");
+    EXPECT_TRUE(args.empty());
+    EXPECT_EQ(output, "ERR usage: set <name> <value>\r\n");
+    EXPECT_EQ(sh_.errors, 1u);
+}
+
+TEST_F(CommandTest, RejectsTooManyWords) {
+    feed("note a b c d e\r");
+    EXPECT_TRUE(args.empty());
+    EXPECT_EQ(output, "ERR too many arguments\r\n");
+}
+
+TEST_F(CommandTest, RejectsUnknownCommands) {
+    feed("sett a b\r");
+    EXPECT_EQ(output, "ERR unknown command\r\n");
+    EXPECT_EQ(sh_.errors, 1u);
+}
+
+TEST_F(CommandTest, BackspaceEditsTheLine) {
+    feed("statz\bs\r");
+    ASSERT_EQ(args.size(), 1u);
+    EXPECT_EQ(args[0], "stats");
+}
+
+TEST_F(CommandTest, DropsControlCharacters) {
+    feed(std::string("st\x01" "a\x1b" "ts\r", 8));
+    ASSERT_EQ(args.size(), 1u);
+    EXPECT_EQ(args[0], "stats");
+}
+
+TEST_F(CommandTest, OverlongLineIsRejectedWhole) {
+    feed("note " + std::string(CMD_LINE_MAX, 'x') + "\r");
+    EXPECT_TRUE(args.empty());
+    EXPECT_EQ(output, "ERR line too long\r\n");
+
+    output.clear();
+    feed("stats\r");
+    EXPECT_EQ(args.size(), 1u) << "the next line is fine again";
+}
+
+TEST_F(CommandTest, LongestLineFits) {
+    feed("note " + std::string(CMD_LINE_MAX - 1 - 5, 'x') + "\r");
+    ASSERT_EQ(args.size(), 2u);
+    EXPECT_EQ(args[1].size(), static_cast<size_t>(CMD_LINE_MAX - 1 - 5));
+}
+
+TEST_F(CommandTest, CutPrintfLineKeepsItsEnd) {
+    feed("long\r");
+    ASSERT_EQ(output.size(), static_cast<size_t>(CMD_PRINTF_MAX - 1));
+    EXPECT_EQ(output.substr(output.size() - 2), "\r\n");
+}
+
+TEST_F(CommandTest, HelpListsTheTable) {
+    command_help(&sh_, 1, nullptr);
+    EXPECT_NE(output.find("set      <name> <value>\r\n"), std::string::npos);
+    EXPECT_NE(output.find("stats    counters\r\n"), std::string::npos);
+}
+
+TEST(CommandParseInt, AcceptsDecimals) {
+    int32_t v = 0;
+
+    EXPECT_EQ(command_parse_int("0", &v), 0);
+    EXPECT_EQ(v, 0);
+    EXPECT_EQ(command_parse_int("600", &v), 0);
+    EXPECT_EQ(v, 600);
+    EXPECT_EQ(command_parse_int("-25", &v), 0);
+    EXPECT_EQ(v, -25);
+    EXPECT_EQ(command_parse_int("999999999", &v), 0);
+    EXPECT_EQ(v, 999999999);
+}
+
+TEST(CommandParseInt, RejectsEverythingElse) {
+    int32_t v = 42;
+
+    EXPECT_NE(command_parse_int("", &v), 0);
+    EXPECT_NE(command_parse_int("-", &v), 0);
+    EXPECT_NE(command_parse_int("12a", &v), 0);
+    EXPECT_NE(command_parse_int("+5", &v), 0);
+    EXPECT_NE(command_parse_int(" 5", &v), 0);
+    EXPECT_NE(command_parse_int("0x10", &v), 0);
+    EXPECT_NE(command_parse_int("9999999999", &v), 0);     // would overflow
+    EXPECT_EQ(v, 42) << "untouched on failure";
+}
+
+} // namespace
@@ -0,0 +1,187 @@
+/*
+ * fsm_test.cpp
+ *
+ *  Unit tests of core/fsm.c: keying letters and words, and every event
+ *  from every state against a table of what it has to do.
+ */
+
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "fsm.h"
+
+namespace {
+
+std::string symbols;
+std::string text;
+
+void emitSymbol(char c) {
+    symbols += c;
+}
+
+void emitText(char c) {
+    text += c;
+}
+
+class FsmTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        symbols.clear();
+        text.clear();
+        fsm_init(&fsm_, emitSymbol, emitText);
+    }
+
+    // Keys a code such as ".-" followed by a gap
+    void key(const char *code) {
+        for (; *code; code++) {
+            ASSERT_EQ(fsm_dispatch(&fsm_, *code == '.' ? FSM_EV_DOT : FSM_EV_DASH), 1);
+        }
+        ASSERT_EQ(fsm_dispatch(&fsm_, FSM_EV_GAP), 1);
+    }
+
+    Fsm fsm_;
+};
+
+TEST_F(FsmTest, StartsIdle) {
+    EXPECT_EQ(fsm_.state, FSM_IDLE);
+    EXPECT_EQ(fsm_.length, 0);
+    EXPECT_EQ(fsm_.rejected, 0u);
+}
+
+TEST_F(FsmTest, KeysWords) {
+    key("...");
+    key("---");
+    key("...");
+    ASSERT_EQ(fsm_dispatch(&fsm_, FSM_EV_GAP), 1);
+    key(".-");
+
+    EXPECT_EQ(symbols, "... --- ...  .- ");
+    EXPECT_EQ(text, "SOS A");
+    EXPECT_EQ(fsm_.state, FSM_IDLE);
+}
+
+TEST_F(FsmTest, UnknownCodeDecodesToQuestionMark) {
+    key("..--");
+    EXPECT_EQ(text, "?");
+}
+
+TEST_F(FsmTest, ResetDropsTheLetter) {
+    fsm_dispatch(&fsm_, FSM_EV_DASH);
+    ASSERT_EQ(fsm_dispatch(&fsm_, FSM_EV_RESET), 1);
+    EXPECT_EQ(fsm_.state, FSM_IDLE);
+    EXPECT_EQ(fsm_.length, 0);
+    key(".");
+    EXPECT_EQ(text, "E");
+}
+
+TEST_F(FsmTest, EndClosesLetterAndMessage) {
+    fsm_dispatch(&fsm_, FSM_EV_DOT);
+    ASSERT_EQ(fsm_dispatch(&fsm_, FSM_EV_END), 1);
+    EXPECT_EQ(symbols, ".   ");
+    EXPECT_EQ(text, "E\n");
+}
+
+TEST_F(FsmTest, OutOfRangeEventIsRejected) {
+    EXPECT_EQ(fsm_dispatch(&fsm_, static_cast<FsmEvent>(FSM_EVENT_COUNT)), 0);
+    EXPECT_EQ(fsm_.rejected, 1u);
+    EXPECT_EQ(fsm_.state, FSM_IDLE);
+}
+
+// Where a case starts: the symbols keyed since the last gap, "" for idle
+struct Case {
+    const char *keyed;
+    FsmEvent event;
+    int accepted;
+    FsmState next;
+    const char *letter;     // afterwards
+    const char *symbols;    // emitted by the event
+    const char *text;
+};
+
+const Case kCases[] = {
+    // Idle
+    {"", FSM_EV_DOT, 1, FSM_LETTER, ".", ".", ""},
+    {"", FSM_EV_DASH, 1, FSM_LETTER, "-", "-", ""},
+    {"", FSM_EV_GAP, 1, FSM_IDLE, "", " ", " "},
+    {"", FSM_EV_RESET, 1, FSM_IDLE, "", "", ""},
+    {"", FSM_EV_END, 1, FSM_IDLE, "", "  ", "\n"},
+    // A letter with room
+    {"-.", FSM_EV_DOT, 1, FSM_LETTER, "-..", ".", ""},
+    {"-.", FSM_EV_DASH, 1, FSM_LETTER, "-.-", "-", ""},
+    {"-.", FSM_EV_GAP, 1, FSM_IDLE, "", " ", "N"},
+    {"-.", FSM_EV_RESET, 1, FSM_IDLE, "", "", ""},
+    {"-.", FSM_EV_END, 1, FSM_IDLE, "", "   ", "N\n"},
+    // A letter one symbol short of full
+    {"....", FSM_EV_DASH, 1, FSM_LETTER, "....-", "-", ""},
+    // A full letter: hasRoom rejects a sixth symbol, the rest still work
+    {".....", FSM_EV_DOT, 0, FSM_LETTER, ".....", "", ""},
+    {".....", FSM_EV_DASH, 0, FSM_LETTER, ".....", "", ""},
+    {".....", FSM_EV_GAP, 1, FSM_IDLE, "", " ", "5"},
+    {".....", FSM_EV_RESET, 1, FSM_IDLE, "", "", ""},
+    {".....", FSM_EV_END, 1, FSM_IDLE, "", "   ", "5\n"},
+};
+
+const char *const kEventNames[FSM_EVENT_COUNT] = {"Dot", "Dash", "Gap", "Reset", "End"};
+
+std::string caseName(const Case &c) {
+    std::string state = *c.keyed ? "Letter" + std::to_string(std::strlen(c.keyed)) : "Idle";
+    return state + kEventNames[c.event];
+}
+
+void PrintTo(const Case &c, std::ostream *os) {
+    *os << caseName(c);
+}
+
+class FsmTableTest : public FsmTest, public ::testing::WithParamInterface<Case> {};
+
+TEST_P(FsmTableTest, EventFromState) {
+    const Case &c = GetParam();
+
+    for (const char *p = c.keyed; *p; p++) {
+        ASSERT_EQ(fsm_dispatch(&fsm_, *p == '.' ? FSM_EV_DOT : FSM_EV_DASH), 1);
+    }
+    ASSERT_EQ(fsm_.state, *c.keyed ? FSM_LETTER : FSM_IDLE);
+    symbols.clear();
+    text.clear();
+
+    EXPECT_EQ(fsm_dispatch(&fsm_, c.event), c.accepted);
+    EXPECT_EQ(fsm_.state, c.next);
+    EXPECT_STREQ(fsm_.letter, c.letter);
+    EXPECT_EQ(fsm_.length, std::strlen(c.letter));
+    EXPECT_EQ(symbols, c.symbols);
+    EXPECT_EQ(text, c.text);
+    EXPECT_EQ(fsm_.rejected, c.accepted ? 0u : 1u);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllTransitions, FsmTableTest, ::testing::ValuesIn(kCases),
+                         [](const ::testing::TestParamInfo<Case> &info) { return caseName(info.param); });
+
+// The table above has to cover every handled pair of the real one
+TEST(FsmTable, CasesCoverEveryStateAndEvent) {
+    for (int state = FSM_IDLE; state < FSM_STATE_COUNT; state++) {
+        for (int event = 0; event < FSM_EVENT_COUNT; event++) {
+            bool covered = false;
+            for (const Case &c : kCases) {
+                covered |= (*c.keyed ? FSM_LETTER : FSM_IDLE) == state && c.event == event;
+            }
+            EXPECT_NE(fsmTransitions[state][event].next, FSM_NONE) << fsmStates[state].name << " " << event;
+            EXPECT_TRUE(covered) << fsmStates[state].name << " " << event;
+        }
+    }
+}
+
+// A state outside the table rejects everything without touching the letter
+TEST_F(FsmTest, CorruptStateRejectsEveryEvent) {
+    fsm_.state = FSM_STATE_COUNT;
+    for (int event = 0; event < FSM_EVENT_COUNT; event++) {
+        EXPECT_EQ(fsm_dispatch(&fsm_, static_cast<FsmEvent>(event)), 0);
+    }
+    EXPECT_EQ(fsm_.rejected, static_cast<uint32_t>(FSM_EVENT_COUNT));
+    EXPECT_TRUE(symbols.empty());
+    EXPECT_TRUE(text.empty());
+}
+
+} // namespace
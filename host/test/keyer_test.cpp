@@ -0,0 +1,75 @@
+/*
+ * keyer_test.cpp
+ *
+ *  Unit tests of core/keyer.c and the gesture thresholds it uses.
+ */
+
+#include <gtest/gtest.h>
+
+#include "fsm.h"
+#include "keyer.h"
+
+namespace {
+
+constexpr uint32_t kClickUs = 500000;
+constexpr uint32_t kHoldUs = 1000000;
+constexpr int32_t kTiltMg = 500;
+
+int clicks(Keyer &k, int n, uint32_t start) {
+    for (int i = 0; i < n; i++) {
+        keyer_click(&k, start + i * 100000, kClickUs);
+    }
+    uint32_t last = start + (n - 1) * 100000;
+    EXPECT_EQ(keyer_expire(&k, last + kClickUs - 1), -1) << "closed early";
+    return keyer_expire(&k, last + kClickUs);
+}
+
+TEST(Keyer, ClickGroupsKeyDotDashGap) {
+    Keyer k;
+
+    keyer_init(&k);
+    EXPECT_EQ(clicks(k, 1, 1000), FSM_EV_DOT);
+    EXPECT_EQ(clicks(k, 2, 2000000), FSM_EV_DASH);
+    EXPECT_EQ(clicks(k, 3, 4000000), FSM_EV_GAP);
+}
+
+TEST(Keyer, FourClicksAreDropped) {
+    Keyer k;
+
+    keyer_init(&k);
+    EXPECT_EQ(clicks(k, 4, 1000), -1);
+    EXPECT_EQ(k.clicks, 0);
+}
+
+TEST(Keyer, NothingToExpireWithoutClicks) {
+    Keyer k;
+
+    keyer_init(&k);
+    EXPECT_EQ(keyer_expire(&k, 123456789), -1);
+}
+
+TEST(Keyer, ClickDeadlineSurvivesTheWrap) {
+    Keyer k;
+
+    keyer_init(&k);
+    keyer_click(&k, UINT32_MAX - 100000, kClickUs);
+    EXPECT_EQ(keyer_expire(&k, UINT32_MAX), -1);
+    EXPECT_EQ(keyer_expire(&k, kClickUs - 100000), FSM_EV_DOT);
+}
+
+TEST(Keyer, TiltDirectionsAndHold) {
+    const float right[3] = {0.8f, 0.0f, 0.6f};
+    const float left[3] = {-0.8f, 0.0f, 0.6f};
+    const float up[3] = {0.0f, 0.0f, 0.9f};
+    const float level[3] = {0.1f, 0.2f, 0.3f};
+    Keyer k;
+
+    keyer_init(&k);
+    EXPECT_EQ(keyer_tilt(&k, 0, level, kTiltMg, kHoldUs), -1);
+    EXPECT_EQ(keyer_tilt(&k, 1000, right, kTiltMg, kHoldUs), FSM_EV_DOT);
+    EXPECT_EQ(keyer_tilt(&k, 1000 + kHoldUs - 1, left, kTiltMg, kHoldUs), -1) << "within the hold";
+    EXPECT_EQ(keyer_tilt(&k, 1000 + kHoldUs, left, kTiltMg, kHoldUs), FSM_EV_DASH);
+    EXPECT_EQ(keyer_tilt(&k, 3000000, up, kTiltMg, kHoldUs), FSM_EV_GAP);
+}
+
+} // namespace
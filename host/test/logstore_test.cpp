@@ -0,0 +1,214 @@
+/*
+ * logstore_test.cpp
+ *
+ *  Unit tests of core/logstore.c on the SPI flash model
+ *  (host/morsecap/flash_model.h). flashbench covers throughput and long
+ *  power-cut campaigns, these pin down the behaviour one case at a time.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flash_model.h"
+#include "logstore.h"
+
+using morsecap::FlashModel;
+
+namespace {
+
+constexpr uint16_t kSectors = 4;
+
+FlashModel *flash;
+uint64_t clockUs;
+
+int flashRead(uint32_t addr, void *buf, uint16_t len) {
+    clockUs = std::max(clockUs, flash->busyUntil()) + len;
+    return flash->read(clockUs, addr, static_cast<uint8_t *>(buf), len) ? 0 : -1;
+}
+
+int flashProgram(uint32_t addr, const void *buf, uint16_t len) {
+    clockUs += len;
+    return flash->program(clockUs, addr, static_cast<const uint8_t *>(buf), len) ? 0 : -1;
+}
+
+int flashErase(uint32_t addr) {
+    clockUs += 10;
+    return flash->erase(clockUs, addr) ? 0 : -1;
+}
+
+int flashBusy(void) {
+    clockUs += 10;
+    return flash->busy(clockUs);
+}
+
+const LogFlash kFlash = {flashRead, flashProgram, flashErase, flashBusy};
+
+class LogStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        model_ = std::make_unique<FlashModel>(kSectors * FlashModel::kSector);
+        flash = model_.get();
+        clockUs = 0;
+        ASSERT_EQ(logstore_mount(&store_, &kFlash, 0, kSectors, 0), 0);
+    }
+
+    void drain() {
+        while (flash->powered() && logstore_work(&store_) != LOGSTORE_IDLE) {
+            clockUs = std::max(clockUs, flash->busyUntil());
+        }
+    }
+
+    // Record i holds i in its first four bytes
+    void append(uint32_t i, uint8_t len, uint32_t now_ms) {
+        uint8_t payload[LOGSTORE_MAX_PAYLOAD] = {};
+        std::memcpy(payload, &i, sizeof(i));
+        int r = logstore_append(&store_, LOGSTORE_REC_TEXT, payload, len, now_ms);
+        ASSERT_GE(r, 0);
+        if (r > 0) {
+            drain();
+        }
+    }
+
+    void commit() {
+        if (logstore_commit(&store_) > 0) {
+            drain();
+        }
+    }
+
+    // The numbers of all records from from_ms on
+    std::vector<uint32_t> readAll(LogStore &store, uint32_t from_ms = 0) {
+        std::vector<uint32_t> seen;
+        LogCursor cursor;
+        LogRecord record;
+        uint8_t payload[LOGSTORE_MAX_PAYLOAD];
+
+        if (logstore_seek(&store, from_ms, &cursor) != 0) {
+            return seen;
+        }
+        while (logstore_next(&store, &cursor, &record, payload)) {
+            uint32_t i;
+            std::memcpy(&i, payload, sizeof(i));
+            seen.push_back(i);
+        }
+        return seen;
+    }
+
+    std::unique_ptr<FlashModel> model_;
+    LogStore store_;
+};
+
+TEST_F(LogStoreTest, EmptyLogHasNothingToSeek) {
+    LogCursor cursor;
+
+    EXPECT_EQ(logstore_seek(&store_, 0, &cursor), -1);
+}
+
+TEST_F(LogStoreTest, RecordsInRamAreReadable) {
+    append(0, 10, 5);
+    append(1, 10, 6);
+    EXPECT_EQ(readAll(store_), (std::vector<uint32_t>{0, 1}));
+    EXPECT_EQ(model_->stats().programs, 0u) << "not programmed before the page fills or commits";
+}
+
+TEST_F(LogStoreTest, CommittedRecordsSurviveRemount) {
+    for (uint32_t i = 0; i < 100; i++) {
+        append(i, 20, i * 10);
+    }
+    commit();
+
+    LogStore again;
+    ASSERT_EQ(logstore_mount(&again, &kFlash, 0, kSectors, 0), 0);
+    std::vector<uint32_t> seen = readAll(again);
+    ASSERT_EQ(seen.size(), 100u);
+    for (uint32_t i = 0; i < 100; i++) {
+        EXPECT_EQ(seen[i], i);
+    }
+}
+
+TEST_F(LogStoreTest, TimeContinuesAcrossRemount) {
+    append(0, 4, 5000);
+    commit();
+
+    LogStore again;
+    ASSERT_EQ(logstore_mount(&again, &kFlash, 0, kSectors, 0), 0);
+    uint8_t payload[4] = {1};
+    ASSERT_GE(logstore_append(&again, LOGSTORE_REC_TEXT, payload, 4, 0), 0);
+
+    LogCursor cursor;
+    LogRecord first, second;
+    uint8_t out[LOGSTORE_MAX_PAYLOAD];
+    ASSERT_EQ(logstore_seek(&again, 0, &cursor), 0);
+    ASSERT_EQ(logstore_next(&again, &cursor, &first, out), 1);
+    ASSERT_EQ(logstore_next(&again, &cursor, &second, out), 1);
+    EXPECT_GE(second.time_ms, first.time_ms);
+}
+
+TEST_F(LogStoreTest, SeekFindsTheFirstRecordAtOrAfter) {
+    for (uint32_t i = 0; i < 300; i++) {
+        append(i, 30, i * 100);
+    }
+    commit();
+    for (uint32_t t : {0u, 50u, 100u, 12345u, 29900u}) {
+        std::vector<uint32_t> seen = readAll(store_, t);
+        ASSERT_FALSE(seen.empty()) << t;
+        EXPECT_EQ(seen.front(), (t + 99) / 100) << t;
+    }
+    EXPECT_TRUE(readAll(store_, 30000).empty());
+}
+
+TEST_F(LogStoreTest, RingDropsTheOldestSectorAndWearsEvenly) {
+    uint32_t n = 0;
+
+    for (; n < 2000; n++) {
+        append(n, 40, n);
+    }
+    commit();
+
+    std::vector<uint32_t> seen = readAll(store_);
+    ASSERT_FALSE(seen.empty());
+    EXPECT_GT(seen.front(), 0u) << "the oldest records were erased";
+    EXPECT_EQ(seen.back(), n - 1);
+    for (size_t i = 1; i < seen.size(); i++) {
+        ASSERT_EQ(seen[i], seen[i - 1] + 1) << "gap in the middle";
+    }
+
+    uint16_t used;
+    uint32_t lo, hi;
+    ASSERT_EQ(logstore_wear(&store_, &used, &lo, &hi), 0);
+    EXPECT_EQ(used, kSectors);
+    EXPECT_LE(hi - lo, 1u);
+}
+
+TEST_F(LogStoreTest, RejectsOverlongRecords) {
+    uint8_t payload[LOGSTORE_MAX_PAYLOAD + 1] = {};
+
+    EXPECT_EQ(logstore_append(&store_, LOGSTORE_REC_TEXT, payload, LOGSTORE_MAX_PAYLOAD + 1, 0), -1);
+    EXPECT_EQ(store_.stats.dropped, 1u);
+}
+
+TEST_F(LogStoreTest, TornProgramKeepsCommittedRecords) {
+    for (uint32_t i = 0; i < 10; i++) {
+        append(i, 20, i);
+    }
+    commit();
+    for (uint32_t i = 10; i < 20; i++) {
+        append(i, 20, i);
+    }
+    model_->cutAfter(1);
+    commit();
+    model_->powerOn();
+
+    LogStore again;
+    ASSERT_EQ(logstore_mount(&again, &kFlash, 0, kSectors, 0), 0);
+    std::vector<uint32_t> seen = readAll(again);
+    ASSERT_GE(seen.size(), 10u);
+    for (uint32_t i = 0; i < seen.size(); i++) {
+        EXPECT_EQ(seen[i], i);
+    }
+}
+
+} // namespace
@@ -0,0 +1,80 @@
+/*
+ * morse_test.cpp
+ *
+ *  Unit tests of core/morse.c.
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "morse.h"
+
+namespace {
+
+const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+TEST(Morse, DecodesKnownCodes) {
+    EXPECT_EQ(decodeMorse(".-"), 'A');
+    EXPECT_EQ(decodeMorse("-..."), 'B');
+    EXPECT_EQ(decodeMorse("..."), 'S');
+    EXPECT_EQ(decodeMorse("---"), 'O');
+    EXPECT_EQ(decodeMorse("-----"), '0');
+    EXPECT_EQ(decodeMorse(".----"), '1');
+}
+
+TEST(Morse, RejectsUnknownCodes) {
+    EXPECT_EQ(decodeMorse(""), '?');
+    EXPECT_EQ(decodeMorse("..--"), '?');
+    EXPECT_EQ(decodeMorse("......"), '?');      // longer than any code
+    EXPECT_EQ(decodeMorse(".x"), '?');
+    EXPECT_EQ(decodeMorse(" "), '?');
+}
+
+TEST(Morse, EncodeDecodeRoundTrip) {
+    char code[MORSE_MAX_SYMBOLS + 1];
+
+    for (const char *c = kAlphabet; *c; c++) {
+        int len = encodeMorse(*c, code);
+        ASSERT_GT(len, 0) << *c;
+        EXPECT_EQ(len, static_cast<int>(std::string(code).size()));
+        EXPECT_EQ(decodeMorse(code), *c) << code;
+    }
+}
+
+TEST(Morse, EncodesLowerCase) {
+    char code[MORSE_MAX_SYMBOLS + 1];
+
+    EXPECT_EQ(encodeMorse('q', code), 4);
+    EXPECT_STREQ(code, "--.-");
+}
+
+TEST(Morse, EncodesNothingForOtherCharacters) {
+    char code[MORSE_MAX_SYMBOLS + 1] = "x";
+
+    EXPECT_EQ(encodeMorse('?', code), 0);
+    EXPECT_STREQ(code, "");
+    EXPECT_EQ(encodeMorse('#', code), 0);
+    EXPECT_EQ(encodeMorse(' ', code), 0);
+}
+
+// Every code of up to MORSE_MAX_SYMBOLS symbols decodes to '?' or to the
+// one letter that encodes back to it
+TEST(Morse, EveryCodeIsConsistent) {
+    for (int len = 1; len <= MORSE_MAX_SYMBOLS; len++) {
+        for (int bits = 0; bits < (1 << len); bits++) {
+            std::string code;
+            for (int i = len - 1; i >= 0; i--) {
+                code += (bits >> i) & 1 ? '-' : '.';
+            }
+            char letter = decodeMorse(code.c_str());
+            if (letter != '?') {
+                char back[MORSE_MAX_SYMBOLS + 1];
+                encodeMorse(letter, back);
+                EXPECT_EQ(code, back);
+            }
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,102 @@
+/*
+ * pipeline_test.cpp
+ *
+ *  Unit tests of core/pipeline.c: fan-out and reference counting.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "pipeline.h"
+#include "pool.h"
+
+namespace {
+
+std::vector<Sample *> seen;
+std::vector<Sample *> held;
+
+void look(Sample *sample) {
+    seen.push_back(sample);
+}
+
+void hold(Sample *sample) {
+    pipeline_retain(sample);
+    held.push_back(sample);
+}
+
+uint16_t smallUsed() {
+    PoolStats s;
+    pool_stats(0, &s);
+    return s.used;
+}
+
+class PipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        pool_init();
+        pipeline_init();
+        seen.clear();
+        held.clear();
+    }
+};
+
+TEST_F(PipelineTest, EverySubscriberGetsTheSameBuffer) {
+    ASSERT_EQ(pipeline_subscribe(look), 0);
+    ASSERT_EQ(pipeline_subscribe(look), 0);
+
+    Sample *s = pipeline_acquire(1234);
+    ASSERT_NE(s, nullptr);
+    EXPECT_EQ(s->timestamp_us, 1234u);
+    EXPECT_EQ(s->refs, 1);
+    s->raw[0] = 42;
+    pipeline_publish(s);
+
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0], s);
+    EXPECT_EQ(seen[1], s);
+    EXPECT_EQ(smallUsed(), 0) << "back in the pool after publishing";
+    EXPECT_EQ(pipeline_stats()->published, 1u);
+}
+
+TEST_F(PipelineTest, RetainedSampleOutlivesThePublish) {
+    pipeline_subscribe(hold);
+    pipeline_subscribe(hold);
+
+    Sample *s = pipeline_acquire(0);
+    pipeline_publish(s);
+    EXPECT_EQ(s->refs, 2);
+    EXPECT_EQ(smallUsed(), 1);
+
+    pipeline_release(held[0]);
+    EXPECT_EQ(smallUsed(), 1);
+    pipeline_release(held[1]);
+    EXPECT_EQ(smallUsed(), 0);
+}
+
+TEST_F(PipelineTest, DropsWhenThePoolIsEmpty) {
+    std::vector<Sample *> taken;
+
+    pipeline_subscribe(hold);
+    for (int i = 0; i < POOL_SMALL_COUNT; i++) {
+        Sample *s = pipeline_acquire(i);
+        ASSERT_NE(s, nullptr);
+        pipeline_publish(s);
+    }
+    EXPECT_EQ(pipeline_acquire(0), nullptr);
+    EXPECT_EQ(pipeline_stats()->drops, 1u);
+
+    for (Sample *s : held) {
+        pipeline_release(s);
+    }
+    EXPECT_NE(pipeline_acquire(0), nullptr);
+}
+
+TEST_F(PipelineTest, SubscriberTableIsBounded) {
+    for (int i = 0; i < PIPELINE_MAX_SUBSCRIBERS; i++) {
+        EXPECT_EQ(pipeline_subscribe(look), 0);
+    }
+    EXPECT_EQ(pipeline_subscribe(look), -1);
+}
+
+} // namespace
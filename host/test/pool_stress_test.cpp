@@ -0,0 +1,239 @@
+/*
+ * pool_stress_test.cpp
+ *
+ *  core/pool.c and core/pipeline.c under contention: several producer
+ *  and consumer threads, serialised only by hal_lock() like the board's
+ *  tasks, Swis and Hwis. Every block handed out is claimed in an owner
+ *  table and stamped, so a block given to two holders at once fails the
+ *  claim or the stamp. Afterwards the counters have to add up.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "pipeline.h"
+#include "pool.h"
+
+namespace {
+
+constexpr int kThreads = 4;
+constexpr int kRounds = 20000;
+
+const uint16_t kSizes[POOL_CLASS_COUNT] = {POOL_SMALL_SIZE, POOL_AUDIO_SIZE, POOL_FRAME_SIZE};
+const uint16_t kCounts[POOL_CLASS_COUNT] = {POOL_SMALL_COUNT, POOL_AUDIO_COUNT, POOL_FRAME_COUNT};
+
+PoolStats stats(uint8_t cls) {
+    PoolStats s;
+    pool_stats(cls, &s);
+    return s;
+}
+
+// Every block of every class, found by draining the pools once. owner[i]
+// is the thread holding block i plus one, 0 while it is free.
+class Blocks {
+public:
+    Blocks() {
+        for (uint8_t c = 0; c < POOL_CLASS_COUNT; c++) {
+            std::vector<void *> all;
+            for (uint16_t i = 0; i < kCounts[c]; i++) {
+                all.push_back(pool_alloc(kSizes[c]));
+            }
+            for (void *block : all) {
+                index_[block] = static_cast<int>(index_.size());
+                pool_free(block);
+            }
+        }
+        owner_ = std::make_unique<std::atomic<int>[]>(index_.size());
+        for (size_t i = 0; i < index_.size(); i++) {
+            owner_[i] = 0;
+        }
+    }
+
+    size_t size() const { return index_.size(); }
+
+    // False if the block is not one of the pools' or someone holds it
+    bool claim(void *block, int thread) {
+        auto it = index_.find(block);
+        int expected = 0;
+        return it != index_.end() && owner_[it->second].compare_exchange_strong(expected, thread + 1);
+    }
+
+    bool release(void *block, int thread) {
+        int expected = thread + 1;
+        return owner_[index_.at(block)].compare_exchange_strong(expected, 0);
+    }
+
+private:
+    std::map<void *, int> index_;
+    std::unique_ptr<std::atomic<int>[]> owner_;
+};
+
+TEST(PoolStress, ProducersNeverShareABlock) {
+    pool_init();
+    Blocks blocks;
+    ASSERT_EQ(blocks.size(), size_t(POOL_SMALL_COUNT + POOL_AUDIO_COUNT + POOL_FRAME_COUNT));
+
+    std::atomic<uint32_t> refused[POOL_CLASS_COUNT] = {};
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t + 1);
+            std::vector<std::pair<uint32_t *, uint8_t>> held;
+
+            for (int round = 0; round < kRounds; round++) {
+                // Hold up to a few blocks, so the classes run dry now and then
+                if (held.size() < 6 && rng() % 2) {
+                    uint8_t c = rng() % POOL_CLASS_COUNT;
+                    auto *block = static_cast<uint32_t *>(pool_alloc(kSizes[c]));
+                    if (!block) {
+                        refused[c]++;
+                        continue;
+                    }
+                    if (!blocks.claim(block, t)) {
+                        errors++;
+                        continue;
+                    }
+                    uint32_t stamp = (t << 24) | round;
+                    for (uint16_t w = 0; w < kSizes[c] / 4; w++) {
+                        block[w] = stamp;
+                    }
+                    held.push_back({block, c});
+                } else if (!held.empty()) {
+                    size_t i = rng() % held.size();
+                    auto [block, c] = held[i];
+                    for (uint16_t w = 1; w < kSizes[c] / 4; w++) {
+                        if (block[w] != block[0]) {
+                            errors++;
+                            break;
+                        }
+                    }
+                    if (block[0] >> 24 != uint32_t(t) || !blocks.release(block, t)) {
+                        errors++;
+                    }
+                    pool_free(block);
+                    held.erase(held.begin() + i);
+                }
+            }
+            for (auto [block, c] : held) {
+                blocks.release(block, t);
+                pool_free(block);
+            }
+        });
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(errors, 0) << "a block was handed out twice";
+    for (uint8_t c = 0; c < POOL_CLASS_COUNT; c++) {
+        PoolStats s = stats(c);
+        EXPECT_EQ(s.used, 0) << int(c);
+        EXPECT_LE(s.peak, kCounts[c]) << int(c);
+        EXPECT_GT(s.peak, 0) << int(c);
+        EXPECT_EQ(s.failures, refused[c]) << int(c);
+    }
+}
+
+// Consumers take the samples a subscriber retained, in other threads
+std::mutex queueLock;
+std::condition_variable queueReady;
+std::deque<Sample *> queue;
+std::atomic<uint32_t> delivered;
+
+void enqueue(Sample *sample) {
+    pipeline_retain(sample);
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        queue.push_back(sample);
+    }
+    queueReady.notify_one();
+}
+
+void count(Sample *) {
+    delivered++;
+}
+
+TEST(PipelineStress, ProducersAndConsumersBalance) {
+    pool_init();
+    pipeline_init();
+    delivered = 0;
+    ASSERT_EQ(pipeline_subscribe(enqueue), 0);
+    ASSERT_EQ(pipeline_subscribe(count), 0);
+
+    std::atomic<uint32_t> attempts{0}, consumed{0};
+    std::atomic<int> errors{0}, producing{kThreads};
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < kRounds; round++) {
+                attempts++;
+                Sample *s = pipeline_acquire((t << 24) | round);
+                if (!s) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (int a = 0; a < PROTO_IMU_AXES; a++) {
+                    s->raw[a] = static_cast<int16_t>(round + a);
+                }
+                pipeline_publish(s);
+            }
+            producing--;
+            queueReady.notify_all();
+        });
+    }
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([&] {
+            for (;;) {
+                Sample *s;
+                {
+                    std::unique_lock<std::mutex> guard(queueLock);
+                    queueReady.wait(guard, [&] { return !queue.empty() || producing == 0; });
+                    if (queue.empty()) {
+                        return;
+                    }
+                    s = queue.front();
+                    queue.pop_front();
+                }
+                int16_t round = static_cast<int16_t>(s->timestamp_us & 0xFFFFFF);
+                for (int a = 0; a < PROTO_IMU_AXES; a++) {
+                    if (s->raw[a] != static_cast<int16_t>(round + a)) {
+                        errors++;
+                        break;
+                    }
+                }
+                consumed++;
+                pipeline_release(s);
+            }
+        });
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    const PipelineStats *ps = pipeline_stats();
+    EXPECT_EQ(errors, 0) << "a sample changed while a consumer held it";
+    EXPECT_EQ(ps->published + ps->drops, attempts.load());
+    EXPECT_EQ(delivered, ps->published);
+    EXPECT_EQ(consumed, ps->published);
+    EXPECT_GT(ps->published, 0u);
+
+    PoolStats s = stats(0);
+    EXPECT_EQ(s.used, 0);
+    EXPECT_EQ(s.failures, ps->drops);
+    EXPECT_LE(s.peak, POOL_SMALL_COUNT);
+}
+
+} // namespace
@@ -0,0 +1,104 @@
+/*
+ * pool_test.cpp
+ *
+ *  Unit tests of core/pool.c.
+ */
+
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "pool.h"
+
+namespace {
+
+const uint16_t kSizes[POOL_CLASS_COUNT] = {POOL_SMALL_SIZE, POOL_AUDIO_SIZE, POOL_FRAME_SIZE};
+const uint16_t kCounts[POOL_CLASS_COUNT] = {POOL_SMALL_COUNT, POOL_AUDIO_COUNT, POOL_FRAME_COUNT};
+
+class PoolTest : public ::testing::Test {
+protected:
+    void SetUp() override { pool_init(); }
+
+    PoolStats stats(uint8_t cls) {
+        PoolStats s;
+        pool_stats(cls, &s);
+        return s;
+    }
+};
+
+TEST_F(PoolTest, SmallestFittingClass) {
+    for (uint8_t c = 0; c < POOL_CLASS_COUNT; c++) {
+        void *block = pool_alloc(kSizes[c]);
+        ASSERT_NE(block, nullptr);
+        EXPECT_EQ(stats(c).used, 1) << int(c);
+        pool_free(block);
+        EXPECT_EQ(stats(c).used, 0);
+    }
+    EXPECT_EQ(pool_alloc(POOL_FRAME_SIZE + 4), nullptr) << "larger than every class";
+}
+
+TEST_F(PoolTest, BlocksAreWordAlignedAndDistinct) {
+    std::vector<uint8_t *> blocks;
+
+    for (int i = 0; i < POOL_SMALL_COUNT; i++) {
+        uint8_t *b = static_cast<uint8_t *>(pool_alloc(1));
+        ASSERT_NE(b, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 4, 0u);
+        for (uint8_t *other : blocks) {
+            EXPECT_GE(std::abs(b - other), POOL_SMALL_SIZE);
+        }
+        blocks.push_back(b);
+    }
+    for (uint8_t *b : blocks) {
+        pool_free(b);
+    }
+}
+
+TEST_F(PoolTest, ExhaustionCountsFailuresAndDoesNotBorrow) {
+    std::vector<void *> blocks;
+
+    for (int i = 0; i < POOL_SMALL_COUNT; i++) {
+        blocks.push_back(pool_alloc(POOL_SMALL_SIZE));
+    }
+    EXPECT_EQ(pool_alloc(POOL_SMALL_SIZE), nullptr);
+    EXPECT_EQ(pool_alloc(8), nullptr);
+
+    PoolStats s = stats(0);
+    EXPECT_EQ(s.used, POOL_SMALL_COUNT);
+    EXPECT_EQ(s.peak, POOL_SMALL_COUNT);
+    EXPECT_EQ(s.failures, 2u);
+    EXPECT_EQ(stats(1).used, 0) << "the audio class was not touched";
+
+    pool_free(blocks.back());
+    blocks.pop_back();
+    void *again = pool_alloc(POOL_SMALL_SIZE);
+    EXPECT_NE(again, nullptr);
+    blocks.push_back(again);
+    for (void *b : blocks) {
+        pool_free(b);
+    }
+    EXPECT_EQ(stats(0).used, 0);
+    EXPECT_EQ(stats(0).peak, POOL_SMALL_COUNT);
+}
+
+TEST_F(PoolTest, StatsDescribeEveryClass) {
+    for (uint8_t c = 0; c < POOL_CLASS_COUNT; c++) {
+        PoolStats s = stats(c);
+        EXPECT_GE(s.blockSize, kSizes[c]);
+        EXPECT_EQ(s.blockSize % 4, 0);
+        EXPECT_EQ(s.count, kCounts[c]);
+        EXPECT_EQ(s.used, 0);
+        EXPECT_EQ(s.peak, 0);
+        EXPECT_EQ(s.failures, 0u);
+    }
+}
+
+TEST_F(PoolTest, FreeingForeignPointerIsIgnored) {
+    int local;
+
+    pool_free(&local);
+    EXPECT_EQ(stats(0).used, 0);
+}
+
+} // namespace
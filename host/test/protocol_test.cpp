@@ -0,0 +1,154 @@
+/*
+ * protocol_test.cpp
+ *
+ *  Unit tests of core/protocol.c: CRC, COBS and frames.
+ */
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "protocol.h"
+
+namespace {
+
+std::vector<uint8_t> cobsRoundTrip(const std::vector<uint8_t> &in) {
+    std::vector<uint8_t> encoded(in.size() + in.size() / 254 + 2);
+    std::vector<uint8_t> decoded(in.size() + 1);
+
+    uint16_t n = protocol_cobs_encode(in.data(), static_cast<uint16_t>(in.size()), encoded.data());
+    EXPECT_LE(n, encoded.size());
+    for (uint16_t i = 0; i < n; i++) {
+        EXPECT_NE(encoded[i], 0) << "delimiter inside the frame at " << i;
+    }
+    uint16_t m = protocol_cobs_decode(encoded.data(), n, decoded.data());
+    decoded.resize(m);
+    return decoded;
+}
+
+// The CCITT-FALSE check value
+TEST(Protocol, Crc16CheckValue) {
+    const char *check = "123456789";
+
+    EXPECT_EQ(protocol_crc16(reinterpret_cast<const uint8_t *>(check), 9, 0xFFFF), 0x29B1);
+}
+
+TEST(Protocol, Crc16Continues) {
+    const uint8_t data[] = {1, 2, 3, 4, 5, 6};
+
+    EXPECT_EQ(protocol_crc16(data + 2, 4, protocol_crc16(data, 2, 0xFFFF)), protocol_crc16(data, 6, 0xFFFF));
+}
+
+TEST(Protocol, CobsKnownEncodings) {
+    const uint8_t zero[] = {0x00};
+    const uint8_t mixed[] = {0x11, 0x22, 0x00, 0x33};
+    uint8_t out[8];
+
+    ASSERT_EQ(protocol_cobs_encode(zero, 1, out), 2);
+    EXPECT_EQ(out[0], 0x01);
+    EXPECT_EQ(out[1], 0x01);
+    ASSERT_EQ(protocol_cobs_encode(mixed, 4, out), 5);
+    const uint8_t expect[] = {0x03, 0x11, 0x22, 0x02, 0x33};
+    EXPECT_EQ(std::memcmp(out, expect, 5), 0);
+}
+
+TEST(Protocol, CobsRoundTripsEdgeLengths) {
+    for (size_t len : {0, 1, 253, 254, 255, 508, 600}) {
+        std::vector<uint8_t> ones(len, 0x5A), zeros(len, 0x00);
+        EXPECT_EQ(cobsRoundTrip(ones), ones) << len;
+        EXPECT_EQ(cobsRoundTrip(zeros), zeros) << len;
+    }
+}
+
+TEST(Protocol, CobsRoundTripsRandomData) {
+    std::mt19937 rng(7);
+
+    for (int i = 0; i < 500; i++) {
+        std::vector<uint8_t> data(rng() % PROTO_MAX_RAW);
+        for (uint8_t &b : data) {
+            b = rng() % 4 == 0 ? 0 : static_cast<uint8_t>(rng());
+        }
+        EXPECT_EQ(cobsRoundTrip(data), data);
+    }
+}
+
+TEST(Protocol, CobsRejectsZeroCodeAndOverrun) {
+    const uint8_t zero[] = {0x01, 0x00};   // the second code is 0
+    const uint8_t overrun[] = {0x05, 0x11, 0x22};
+    uint8_t out[8];
+
+    EXPECT_EQ(protocol_cobs_decode(zero, 2, out), 0);
+    EXPECT_EQ(protocol_cobs_decode(overrun, 3, out), 0);
+}
+
+TEST(Protocol, FrameRoundTrip) {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    uint8_t frame[PROTO_MAX_FRAME];
+    uint8_t raw[PROTO_MAX_FRAME];
+
+    for (int i = 0; i < PROTO_MAX_PAYLOAD; i++) {
+        payload[i] = static_cast<uint8_t>(i * 7);
+    }
+    uint16_t n = protocol_build_frame(PROTO_MSG_TELEMETRY, payload, PROTO_MAX_PAYLOAD, frame);
+    ASSERT_GT(n, 0);
+    ASSERT_LE(n, PROTO_MAX_FRAME);
+    EXPECT_EQ(frame[n - 1], 0x00);
+    EXPECT_EQ(std::memchr(frame, 0, n - 1), nullptr);
+
+    uint16_t m = protocol_cobs_decode(frame, n - 1, raw);
+    uint8_t type, seq;
+    const uint8_t *p;
+    ASSERT_EQ(protocol_parse_frame(raw, m, &type, &seq, &p), PROTO_MAX_PAYLOAD);
+    EXPECT_EQ(type, PROTO_MSG_TELEMETRY);
+    EXPECT_EQ(std::memcmp(p, payload, PROTO_MAX_PAYLOAD), 0);
+
+    raw[5] ^= 0x10;
+    EXPECT_EQ(protocol_parse_frame(raw, m, &type, &seq, &p), -1) << "CRC catches a flipped bit";
+}
+
+TEST(Protocol, FrameSequenceCounts) {
+    uint8_t frame[PROTO_MAX_FRAME], raw[PROTO_MAX_FRAME];
+    uint8_t type, first = 0, seq;
+    const uint8_t *p;
+
+    for (int i = 0; i < 300; i++) {
+        uint16_t n = protocol_build_frame(PROTO_MSG_SYMBOL, reinterpret_cast<const uint8_t *>("."), 1, frame);
+        uint16_t m = protocol_cobs_decode(frame, n - 1, raw);
+        ASSERT_EQ(protocol_parse_frame(raw, m, &type, &seq, &p), 1);
+        if (i == 0) {
+            first = seq;
+        }
+        EXPECT_EQ(seq, static_cast<uint8_t>(first + i));
+    }
+}
+
+TEST(Protocol, RejectsOversizedPayloadAndShortFrames) {
+    uint8_t payload[PROTO_MAX_PAYLOAD + 1] = {};
+    uint8_t frame[PROTO_MAX_FRAME + 4];
+    uint8_t type, seq;
+    const uint8_t *p;
+
+    EXPECT_EQ(protocol_build_frame(PROTO_MSG_TEXT, payload, PROTO_MAX_PAYLOAD + 1, frame), 0);
+    EXPECT_EQ(protocol_parse_frame(payload, PROTO_HEADER_LEN + PROTO_CRC_LEN - 1, &type, &seq, &p), -1);
+}
+
+TEST(Protocol, PacksImuBatchLittleEndian) {
+    int16_t a[PROTO_IMU_AXES] = {1, -1, 0x1234, 0, 0, 0};
+    const int16_t *rows[] = {a};
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+
+    ASSERT_EQ(protocol_pack_imu_batch(payload, 0x01020304, 5000, rows, 1), PROTO_IMU_BATCH_HDR + 12);
+    EXPECT_EQ(payload[0], 0x04);
+    EXPECT_EQ(payload[3], 0x01);
+    EXPECT_EQ(payload[4] | payload[5] << 8, 5000);
+    EXPECT_EQ(payload[6], 1);
+    EXPECT_EQ(payload[7], 0x01);
+    EXPECT_EQ(payload[9], 0xFF);
+    EXPECT_EQ(payload[10], 0xFF);
+    EXPECT_EQ(payload[11], 0x34);
+    EXPECT_EQ(payload[12], 0x12);
+}
+
+} // namespace
@@ -0,0 +1,147 @@
+/*
+ * tscodec_test.cpp
+ *
+ *  Unit tests of core/tscodec.c: round trips, mode choice and corrupt
+ *  blocks.
+ */
+
+#include <climits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tscodec.h"
+
+namespace {
+
+constexpr uint16_t kBuf = 4096;
+
+// Encodes count rows of channels values, decodes and compares
+template <typename T>
+uint16_t roundTrip(const std::vector<T> &values, uint8_t channels) {
+    uint8_t count = static_cast<uint8_t>(values.size() / channels);
+    std::vector<const T *> rows;
+    std::vector<uint8_t> block(kBuf);
+    std::vector<int32_t> out(values.size() + 1);
+    uint16_t len;
+
+    for (uint8_t i = 0; i < count; i++) {
+        rows.push_back(&values[i * channels]);
+    }
+    if constexpr (sizeof(T) == 2) {
+        len = tscodec_encode16(block.data(), kBuf, rows.data(), channels, count);
+    } else {
+        len = tscodec_encode32(block.data(), kBuf, rows.data(), channels, count);
+    }
+    EXPECT_GT(len, 0);
+
+    uint8_t c, n;
+    EXPECT_EQ(tscodec_peek(block.data(), len, &c, &n), 0);
+    EXPECT_EQ(c, channels);
+    EXPECT_EQ(n, count);
+    EXPECT_EQ(tscodec_decode(block.data(), len, out.data(), static_cast<uint16_t>(out.size())), count);
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_EQ(out[i], values[i]) << "value " << i;
+    }
+    return len;
+}
+
+TEST(Tscodec, RoundTripsNoisy16BitAxes) {
+    std::mt19937 rng(3);
+    std::vector<int16_t> v;
+
+    for (int i = 0; i < 25 * 6; i++) {
+        v.push_back(static_cast<int16_t>(rng()));
+    }
+    roundTrip(v, 6);
+}
+
+TEST(Tscodec, RoundTripsExtremes) {
+    std::vector<int32_t> v = {INT_MIN, INT_MAX, INT_MIN, 0, INT_MAX, -1, 1, INT_MIN};
+    std::vector<int16_t> w = {SHRT_MIN, SHRT_MAX, SHRT_MIN, 0, SHRT_MAX, -1};
+
+    roundTrip(v, 1);
+    roundTrip(v, 2);
+    roundTrip(w, 1);
+}
+
+TEST(Tscodec, RoundTripsOneAndTwoSamples) {
+    roundTrip(std::vector<int32_t>{5, -7, 9}, 3);
+    roundTrip(std::vector<int32_t>{5, -7, 9, 6, -8, 10}, 3);
+}
+
+TEST(Tscodec, ConstantChannelCostsOnlyItsHeader) {
+    std::vector<int32_t> v(200, 101325);
+
+    uint16_t len = roundTrip(v, 1);
+    EXPECT_LE(len, TSCODEC_BLOCK_HDR + 1 + 3 + 1);    // mode, first value, a zero delta
+}
+
+TEST(Tscodec, RampUsesDeltaOfDelta) {
+    std::vector<int32_t> v;
+    uint8_t block[kBuf];
+    const int32_t *rows[100];
+
+    for (int i = 0; i < 100; i++) {
+        v.push_back(100000 + 37 * i);
+    }
+    for (int i = 0; i < 100; i++) {
+        rows[i] = &v[i];
+    }
+    ASSERT_GT(tscodec_encode32(block, kBuf, rows, 1, 100), 0);
+    EXPECT_TRUE(block[TSCODEC_BLOCK_HDR] & TSCODEC_MODE_DOD);
+    EXPECT_EQ(block[TSCODEC_BLOCK_HDR] & TSCODEC_WIDTH_MASK, 0);
+    roundTrip(v, 1);
+}
+
+TEST(Tscodec, RefusesBlocksThatDoNotFit) {
+    std::mt19937 rng(5);
+    std::vector<int32_t> v(50);
+    const int32_t *rows[50];
+    uint8_t block[64];
+
+    for (int i = 0; i < 50; i++) {
+        v[i] = static_cast<int32_t>(rng());
+        rows[i] = &v[i];
+    }
+    EXPECT_EQ(tscodec_encode32(block, sizeof(block), rows, 1, 50), 0);
+}
+
+TEST(Tscodec, DecodeChecksSpaceAndLength) {
+    std::vector<int32_t> v(60);
+    std::vector<const int32_t *> rows;
+    uint8_t block[kBuf];
+    int32_t out[60];
+
+    for (int i = 0; i < 60; i++) {
+        v[i] = i * i;
+    }
+    for (int i = 0; i < 20; i++) {
+        rows.push_back(&v[i * 3]);
+    }
+    uint16_t len = tscodec_encode32(block, kBuf, rows.data(), 3, 20);
+    ASSERT_GT(len, 0);
+    EXPECT_EQ(tscodec_decode(block, len, out, 59), -1) << "one value short";
+    EXPECT_EQ(tscodec_decode(block, len - 1, out, 60), -1) << "truncated";
+    EXPECT_EQ(tscodec_decode(block, 1, out, 60), -1);
+    EXPECT_EQ(tscodec_decode(block, len, out, 60), 20);
+}
+
+TEST(Tscodec, GarbageNeverOverrunsTheOutput) {
+    std::mt19937 rng(11);
+    uint8_t junk[64];
+    int32_t out[32 + 1];
+
+    for (int i = 0; i < 20000; i++) {
+        for (uint8_t &b : junk) {
+            b = static_cast<uint8_t>(rng());
+        }
+        out[32] = 0x5A5A5A5A;
+        int16_t n = tscodec_decode(junk, static_cast<uint16_t>(rng() % sizeof(junk)), out, 32);
+        EXPECT_LE(n, 32);
+        EXPECT_EQ(out[32], 0x5A5A5A5A);
+    }
+}
+
+} // namespace